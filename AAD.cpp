@@ -0,0 +1,106 @@
+// vim:ts=2:et
+//===========================================================================//
+//                                 "AAD.cpp":                                //
+//         Reverse-Mode Adjoint Algorithmic Differentiation: Implementation  //
+//===========================================================================//
+#include "AAD.h"
+#include <mutex>
+#include <stdexcept>
+
+namespace AAD
+{
+  namespace
+  {
+    //-----------------------------------------------------------------------//
+    // The Pool of Tapes (for "TapeScope"):                                  //
+    //-----------------------------------------------------------------------//
+    // The Tapes are never freed (their number is bounded by the max number
+    // of threads valuating at the same time):
+    //
+    std::mutex                         s_poolMtx;
+    std::vector<std::unique_ptr<Tape>> s_pool;
+  }
+
+  //=========================================================================//
+  // "Tape::Grow":                                                           //
+  //=========================================================================//
+  void Tape::Grow()
+  {
+    // The node indices must fit in 32 bits (NoNode excluded):
+    if (Capacity() + BlockSize > size_t(NoNode))
+      throw std::length_error("AAD::Tape: Too Many Nodes");
+    m_blocks.emplace_back(new Node[BlockSize]);
+  }
+
+  //=========================================================================//
+  // "Tape::Sweep":                                                          //
+  //=========================================================================//
+  void Tape::Sweep(ADouble const& a_y)
+  {
+    if (!a_y.IsActive())
+    {
+      // A constant: all derivatives are 0:
+      for (size_t i = 0; i < m_size; ++i)
+        At(i).m_adj = 0.0;
+      return;
+    }
+    size_t n = size_t(a_y.Idx()) + 1;
+    assert(n <= m_size);
+
+    for (size_t i = 0; i < n; ++i)
+      At(i).m_adj = 0.0;
+    At(n - 1).m_adj = 1.0;
+
+    // In the reverse topological order; the nodes with 0 adjoints (not on a
+    // path to "a_y") are skipped:
+    for (size_t i = n; i-- > 0; )
+    {
+      Node const& node = At(i);
+      double      adj  = node.m_adj;
+      if (adj == 0.0)
+        continue;
+      if (node.m_arg[0] != NoNode)
+        At(node.m_arg[0]).m_adj += node.m_d[0] * adj;
+      if (node.m_arg[1] != NoNode)
+        At(node.m_arg[1]).m_adj += node.m_d[1] * adj;
+    }
+  }
+
+  //=========================================================================//
+  // "TapeScope" Default Ctor and Dtor:                                      //
+  //=========================================================================//
+  TapeScope::TapeScope()
+  : m_tape  (Tape::Active()),
+    m_mark  (0),
+    m_pooled(false)
+  {
+    if (m_tape != nullptr)
+    {
+      m_mark = m_tape->Size();
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(s_poolMtx);
+      if (!s_pool.empty())
+      {
+        m_tape = s_pool.back().release();
+        s_pool.pop_back();
+      }
+    }
+    if (m_tape == nullptr)
+      m_tape = new Tape;
+    m_pooled = true;
+    Tape::SetActive(m_tape);
+  }
+
+  TapeScope::~TapeScope()
+  {
+    m_tape->Rewind(m_mark);
+    if (!m_pooled)
+      return;
+    Tape::SetActive(nullptr);
+    std::lock_guard<std::mutex> lock(s_poolMtx);
+    s_pool.emplace_back(m_tape);
+  }
+}
+// End namespace AAD
@@ -0,0 +1,370 @@
+// vim:ts=2:et
+//===========================================================================//
+//                                  "AAD.h":                                 //
+//       Reverse-Mode Adjoint Algorithmic Differentiation (Tape-Based)       //
+//===========================================================================//
+// "ADouble" is a drop-in replacement for "double" in the pricing formulas:
+// each arithmetic op or elementary function on an active "ADouble" records
+// a node (the local partial derivatives w.r.t. its args) on the "Tape" of
+// the current thread; one backward sweep from the result then gives its
+// derivatives w.r.t. ALL inputs, at a small constant multiple of the cost
+// of the forward calculation.
+// The Tape is an arena: the nodes are stored in fixed-size blocks which are
+// kept when the Tape is rewound, so once it has grown to the size of one
+// valuation, recording (eg a Monte Carlo path) allocates nothing:
+//
+#pragma once
+#include "BSM.h"
+#include "MonteCarlo.h"
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace AAD
+{
+  class ADouble;
+
+  //=========================================================================//
+  // "Tape" Class:                                                           //
+  //=========================================================================//
+  // Each node has (at most) 2 args; node "i" only refers to nodes < i, so the
+  // nodes are in a topological order. NOT thread-safe: each thread records
+  // on its own Tape (see "TapeScope"):
+  //
+  class Tape
+  {
+  public:
+    static constexpr uint32_t NoNode = UINT32_MAX;
+
+  private:
+    //-----------------------------------------------------------------------//
+    // Types and Consts:                                                     //
+    //-----------------------------------------------------------------------//
+    struct Node
+    {
+      double   m_adj;       // The Adjoint (valid after "Sweep" only)
+      uint32_t m_arg[2];    // The args (NoNode if unused)
+      double   m_d  [2];    // The local partial derivatives w.r.t. the args
+    };
+
+    static constexpr int    BlockBits = 12;
+    static constexpr size_t BlockSize = size_t(1) << BlockBits;  // Nodes
+
+    //-----------------------------------------------------------------------//
+    // Data Flds:                                                            //
+    //-----------------------------------------------------------------------//
+    std::vector<std::unique_ptr<Node[]>> m_blocks;
+    size_t                               m_size;  // Nodes currently in use
+
+    // The Tape of the current thread (NOT owned):
+    static inline thread_local Tape*     s_active = nullptr;
+
+    Node&       At(size_t a_i)
+      { return m_blocks[a_i >> BlockBits][a_i & (BlockSize - 1)]; }
+    Node const& At(size_t a_i) const
+      { return m_blocks[a_i >> BlockBits][a_i & (BlockSize - 1)]; }
+
+    void Grow();
+
+  public:
+    Tape(): m_size(0) {}
+
+    Tape(Tape const&)            = delete;
+    Tape& operator=(Tape const&) = delete;
+
+    //-----------------------------------------------------------------------//
+    // Recording:                                                            //
+    //-----------------------------------------------------------------------//
+    // "Record": Appends a node, returns its index:
+    uint32_t Record
+    (
+      uint32_t a_arg0,
+      double   a_d0,
+      uint32_t a_arg1,
+      double   a_d1
+    )
+    {
+      if (m_size == m_blocks.size() * BlockSize)
+        Grow();
+      Node& node     = At(m_size);
+      node.m_arg[0]  = a_arg0;
+      node.m_arg[1]  = a_arg1;
+      node.m_d  [0]  = a_d0;
+      node.m_d  [1]  = a_d1;
+      return uint32_t(m_size++);
+    }
+
+    // "NewVar": An independent variable (input) recorded on this Tape:
+    ADouble NewVar(double a_val);
+
+    // The current size can be used as a mark to "Rewind" to (discarding all
+    // nodes recorded after it, but keeping the memory):
+    size_t Size()     const { return m_size;                      }
+    size_t Capacity() const { return m_blocks.size() * BlockSize; }
+    void   Clear()            { m_size = 0;                       }
+    void   Rewind(size_t a_mark)
+      { assert(a_mark <= m_size); m_size = a_mark; }
+
+    //-----------------------------------------------------------------------//
+    // Differentiation:                                                      //
+    //-----------------------------------------------------------------------//
+    // "Sweep": Computes the Adjoints (derivatives of "a_y") of all nodes up
+    // to "a_y"; "Adjoint" then returns dy/dx for any "x" recorded before it:
+    //
+    void   Sweep  (ADouble const& a_y);
+    double Adjoint(ADouble const& a_x) const;
+
+    //-----------------------------------------------------------------------//
+    // The Tape of the Current Thread:                                       //
+    //-----------------------------------------------------------------------//
+    static Tape* Active()                { return s_active;  }
+    static void  SetActive(Tape* a_tape) { s_active = a_tape; }
+  };
+
+  //=========================================================================//
+  // "TapeScope": RAII Access to a Tape for the Current Thread:              //
+  //=========================================================================//
+  // If the thread already has an active Tape, it is used (recording on top of
+  // what is already there, which is discarded again in the Dtor).  Otherwise,
+  // a Tape is taken from a process-wide pool (and returned to it in the Dtor),
+  // so the Tapes (and their memory) are re-used across valuations, even by
+  // short-lived threads. Callers in hot loops may avoid the pool (a mutex) by
+  // activating their own Tape with "Tape::SetActive":
+  //
+  class TapeScope
+  {
+  private:
+    Tape*  m_tape;
+    size_t m_mark;
+    bool   m_pooled;
+
+  public:
+    TapeScope();
+    ~TapeScope();
+
+    TapeScope(TapeScope const&)            = delete;
+    TapeScope& operator=(TapeScope const&) = delete;
+
+    Tape& Get() const { return *m_tape; }
+  };
+
+  //=========================================================================//
+  // "ADouble": The Active Number Type:                                      //
+  //=========================================================================//
+  // Constants (constructed from "double") are NOT recorded; ops on constants
+  // only give constants, so inactive parts of a calculation cost nothing on
+  // the Tape. Ops on active numbers require an active Tape (see "TapeScope"):
+  //
+  class ADouble
+  {
+  private:
+    double   m_val;
+    uint32_t m_idx;   // The node on the active Tape, or NoNode for constants
+
+  public:
+    ADouble(): m_val(0.0), m_idx(Tape::NoNode) {}
+
+    // Implicit, so that "double"s mix with "ADouble"s in formulas:
+    ADouble(double a_val): m_val(a_val), m_idx(Tape::NoNode) {}
+
+    ADouble(double a_val, uint32_t a_idx): m_val(a_val), m_idx(a_idx) {}
+
+    double   Val()      const { return m_val;                  }
+    uint32_t Idx()      const { return m_idx;                  }
+    bool     IsActive() const { return m_idx != Tape::NoNode;  }
+
+    //-----------------------------------------------------------------------//
+    // "Rec1", "Rec2": Result of a 1- or 2-arg op with the given partials:   //
+    //-----------------------------------------------------------------------//
+    static ADouble Rec1(double a_val, ADouble const& a_x, double a_dx)
+    {
+      if (!a_x.IsActive())
+        return ADouble(a_val);
+      assert(Tape::Active() != nullptr);
+      return ADouble
+        (a_val, Tape::Active()->Record(a_x.m_idx, a_dx, Tape::NoNode, 0.0));
+    }
+
+    static ADouble Rec2
+    (
+      double         a_val,
+      ADouble const& a_x,
+      double         a_dx,
+      ADouble const& a_y,
+      double         a_dy
+    )
+    {
+      if (!a_y.IsActive())
+        return Rec1(a_val, a_x, a_dx);
+      if (!a_x.IsActive())
+        return Rec1(a_val, a_y, a_dy);
+      assert(Tape::Active() != nullptr);
+      return ADouble
+        (a_val, Tape::Active()->Record(a_x.m_idx, a_dx, a_y.m_idx, a_dy));
+    }
+
+    //-----------------------------------------------------------------------//
+    // Arithmetic:                                                           //
+    //-----------------------------------------------------------------------//
+    friend ADouble operator-(ADouble const& a_x)
+      { return Rec1(- a_x.m_val, a_x, -1.0); }
+
+    friend ADouble operator+(ADouble const& a_x, ADouble const& a_y)
+      { return Rec2(a_x.m_val + a_y.m_val, a_x, 1.0, a_y,  1.0); }
+
+    friend ADouble operator-(ADouble const& a_x, ADouble const& a_y)
+      { return Rec2(a_x.m_val - a_y.m_val, a_x, 1.0, a_y, -1.0); }
+
+    friend ADouble operator*(ADouble const& a_x, ADouble const& a_y)
+      { return Rec2(a_x.m_val * a_y.m_val, a_x, a_y.m_val, a_y, a_x.m_val); }
+
+    friend ADouble operator/(ADouble const& a_x, ADouble const& a_y)
+    {
+      double inv = 1.0 / a_y.m_val;
+      double res = a_x.m_val * inv;
+      return Rec2(res, a_x, inv, a_y, - res * inv);
+    }
+
+    ADouble& operator+=(ADouble const& a_y) { return *this = *this + a_y; }
+    ADouble& operator-=(ADouble const& a_y) { return *this = *this - a_y; }
+    ADouble& operator*=(ADouble const& a_y) { return *this = *this * a_y; }
+    ADouble& operator/=(ADouble const& a_y) { return *this = *this / a_y; }
+
+    //-----------------------------------------------------------------------//
+    // Comparisons (of the values):                                          //
+    //-----------------------------------------------------------------------//
+    friend bool operator==(ADouble const& a_x, ADouble const& a_y)
+      { return a_x.m_val == a_y.m_val; }
+    friend bool operator!=(ADouble const& a_x, ADouble const& a_y)
+      { return a_x.m_val != a_y.m_val; }
+    friend bool operator< (ADouble const& a_x, ADouble const& a_y)
+      { return a_x.m_val <  a_y.m_val; }
+    friend bool operator<=(ADouble const& a_x, ADouble const& a_y)
+      { return a_x.m_val <= a_y.m_val; }
+    friend bool operator> (ADouble const& a_x, ADouble const& a_y)
+      { return a_x.m_val >  a_y.m_val; }
+    friend bool operator>=(ADouble const& a_x, ADouble const& a_y)
+      { return a_x.m_val >= a_y.m_val; }
+  };
+
+  //-------------------------------------------------------------------------//
+  // Elementary Functions:                                                   //
+  //-------------------------------------------------------------------------//
+  // Found by ADL, so the generic formulas can call "exp", "log" etc unquali-
+  // fied for both "double" and "ADouble":
+  //
+  inline ADouble exp(ADouble const& a_x)
+  {
+    double e = std::exp(a_x.Val());
+    return ADouble::Rec1(e, a_x, e);
+  }
+
+  inline ADouble log(ADouble const& a_x)
+    { return ADouble::Rec1(std::log(a_x.Val()), a_x, 1.0 / a_x.Val()); }
+
+  inline ADouble sqrt(ADouble const& a_x)
+  {
+    double s = std::sqrt(a_x.Val());
+    return ADouble::Rec1(s, a_x, 0.5 / s);
+  }
+
+  // NB: At the kink (x == y), the derivative is taken from "a_x":
+  inline ADouble max(ADouble const& a_x, ADouble const& a_y)
+    { return (a_x.Val() >= a_y.Val()) ? a_x : a_y; }
+
+  inline ADouble min(ADouble const& a_x, ADouble const& a_y)
+    { return (a_x.Val() <= a_y.Val()) ? a_x : a_y; }
+
+  // The Normal CDF of the given CDF Policy (see "BSM::CDFPhi"):
+  template<typename CDF>
+  inline ADouble CDFPhi(ADouble const& a_x)
+  {
+    return ADouble::Rec1
+           (CDF::Phi(a_x.Val()), a_x, CDF::NormPDF(a_x.Val()));
+  }
+
+  //-------------------------------------------------------------------------//
+  // "Tape::NewVar", "Tape::Adjoint":                                        //
+  //-------------------------------------------------------------------------//
+  inline ADouble Tape::NewVar(double a_val)
+    { return ADouble(a_val, Record(NoNode, 0.0, NoNode, 0.0)); }
+
+  inline double Tape::Adjoint(ADouble const& a_x) const
+  {
+    return (a_x.IsActive() && a_x.Idx() < m_size) ? At(a_x.Idx()).m_adj
+                                                  : 0.0;
+  }
+}
+// End namespace AAD
+
+namespace BSM
+{
+  //-------------------------------------------------------------------------//
+  // "PxGreeksAAD<PayoffType>": Closed-Form Px and Greeks via AAD:           //
+  //-------------------------------------------------------------------------//
+  // Evaluates the same closed-form as "Px<PayoffType>" (ie "PxCore") with
+  // "ADouble" args, and gets Delta, Vega, Theta and Rho from 1 backward sweep
+  // (Gamma, being 2nd-order, is NaN). Same args and exceptions as "Px".
+  // Mostly useful as a check of the AAD machinery, and as a template for
+  // pricers without hand-coded Greeks. Defined in "AAD.hpp":
+  //
+  template<PayoffType PT, typename CDF = CDFErf>
+  Greeks PxGreeksAAD
+  (
+    double a_K,     // Option Strike
+    double a_T,     // Opton Expiration Time, as Year Fraction
+    double a_r,     // Risk-Free Interest Rate
+    double a_D,     // Dividend Rate
+    double a_sigma, // Implied Volatility
+    double a_t,     // Pricing Time (as Year Fraction)
+    double a_St     // Underlying Px at Time "a_t"
+  );
+
+  //-------------------------------------------------------------------------//
+  // "PxGreeksMC": Monte Carlo Px and Pathwise Greeks via AAD:               //
+  //-------------------------------------------------------------------------//
+  // As "PxMC", but the paths are built (and "a_payoff" is invoked) on "ADoub-
+  // le"s, as
+  //   AAD::ADouble a_payoff(AAD::ADouble const* a_path, int a_nSteps),
+  // so a generic lambda (taking "auto const* a_path") serves both "PxMC" and
+  // "PxGreeksMC". After each path, 1 backward sweep gives the pathwise deriv-
+  // atives of its discounted payoff w.r.t. St, sigma, r and t;  the Greeks
+  // are their averages (with their own StdErrs).  So all Greeks come from a
+  // single simulation, at a few times the cost of the Px alone,  and without
+  // the noise of bump-and-reprice.
+  // NB: The pathwise method requires the payoff to be continuous in the path
+  // (eg NOT Digitals or Barriers); for discontinuous ones, the Greeks under-
+  // state (miss) the contribution of the jumps.
+  // Supported "MCParams": "m_nPaths", "m_nSteps", "m_seed", "m_nThreads",
+  // "m_sobol" (with "m_scramble" and "m_bridge") and "m_antithetic";  other
+  // modes (Control Variate, Adaptive) give "std::invalid_argument", as do
+  // invalid args (and a zero time to expiration).
+  // Each block of paths records on a Tape from the pool (see "TapeScope"),
+  // rewound after each path; the results are merged in the block order, so
+  // they are bit-identical for any "m_nThreads". Defined in "AAD.hpp":
+  //
+  struct MCGreeks
+  {
+    Greeks m_greeks;        // Px and Greeks (Gamma: NaN)
+    Greeks m_stdErrs;       // Their Standard Errors
+    long   m_nPaths = 0;    // Number of paths simulated
+    double m_time   = 0.0;  // Wall-clock time spent, sec
+  };
+
+  template<typename Payoff>
+  MCGreeks PxGreeksMC
+  (
+    Payoff const&   a_payoff,
+    double          a_T,      // Opton Expiration Time, as Year Fraction
+    double          a_r,      // Risk-Free Interest Rate
+    double          a_D,      // Dividend Rate
+    double          a_sigma,  // Volatility
+    double          a_t,      // Pricing Time (as Year Fraction)
+    double          a_St,     // Underlying Px at Time "a_t"
+    MCParams const& a_params = MCParams()
+  );
+}
+// End namespace BSM
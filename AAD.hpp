@@ -0,0 +1,220 @@
+// vim:ts=2:et
+//===========================================================================//
+//                                  "AAD.hpp":                               //
+//            Implementation of the Templated Pricers with AAD Greeks        //
+//===========================================================================//
+#pragma once
+
+#include "AAD.h"
+#include "BSM.hpp"
+#include "MonteCarlo.hpp"
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <vector>
+
+namespace BSM
+{
+  //=========================================================================//
+  // "PxGreeksAAD<PayoffType>":                                              //
+  //=========================================================================//
+  template<PayoffType PT, typename CDF>
+  Greeks PxGreeksAAD
+  (
+    double a_K,
+    double a_T,
+    double a_r,
+    double a_D,
+    double a_sigma,
+    double a_t,
+    double a_St
+  )
+  {
+    using AAD::ADouble;
+
+    if (a_T - a_t < 0.0)
+      throw std::invalid_argument("Negative Time to Expiration");
+
+    if (a_K <= 0.0 || a_St <= 0.0 || a_sigma <= 0.0)
+      throw std::invalid_argument
+            ("Non-Positive Strike / UnderlyingPx / Vol");
+
+    AAD::TapeScope scope;
+    AAD::Tape&     tape  = scope.Get();
+    ADouble        St    = tape.NewVar(a_St);
+    ADouble        sigma = tape.NewVar(a_sigma);
+    ADouble        r     = tape.NewVar(a_r);
+    ADouble        t     = tape.NewVar(a_t);
+
+    ADouble px = PxCore<PT, CDF, ADouble>
+                 (ADouble(a_K), ADouble(a_T) - t, r, ADouble(a_D), sigma, St);
+    tape.Sweep(px);
+
+    Greeks res;
+    res.m_px    = px.Val();
+    res.m_delta = tape.Adjoint(St);
+    res.m_vega  = tape.Adjoint(sigma);
+    res.m_theta = tape.Adjoint(t);
+    res.m_rho   = tape.Adjoint(r);
+    return res;
+  }
+
+  //=========================================================================//
+  // "PxGreeksMC":                                                           //
+  //=========================================================================//
+  template<typename Payoff>
+  MCGreeks PxGreeksMC
+  (
+    Payoff const&   a_payoff,
+    double          a_T,
+    double          a_r,
+    double          a_D,
+    double          a_sigma,
+    double          a_t,
+    double          a_St,
+    MCParams const& a_params
+  )
+  {
+    using AAD::ADouble;
+
+    //-----------------------------------------------------------------------//
+    // Check the args:                                                       //
+    //-----------------------------------------------------------------------//
+    double tau = a_T - a_t;
+
+    if (tau <  0.0)
+      throw std::invalid_argument("Negative Time to Expiration");
+
+    // (The pathwise Theta involves d sqrt(tau) / d tau):
+    if (tau == 0.0)
+      throw std::invalid_argument("PxGreeksMC: Zero Time to Expiration");
+
+    if (a_St <= 0.0 || a_sigma <= 0.0)
+      throw std::invalid_argument("Non-Positive UnderlyingPx / Vol");
+
+    if (a_params.m_nPaths <= 0 || a_params.m_nSteps <= 0)
+      throw std::invalid_argument("PxMC: Non-Positive NPaths / NSteps");
+
+    if (a_params.m_ctrlVar || a_params.m_tolCI > 0.0 ||
+        a_params.m_maxTime > 0.0)
+      throw std::invalid_argument("PxGreeksMC: Unsupported MCParams");
+
+    //-----------------------------------------------------------------------//
+    // Set-up (as in "PxMC"):                                                //
+    //-----------------------------------------------------------------------//
+    int       nSteps   = a_params.m_nSteps;
+    bool      anti     = a_params.m_antithetic;
+    MCNormals normals(a_params);
+    long      nSamples = normals.NSamples();
+
+    // The per-block moments of the discounted payoff and of its derivatives
+    // (Px, Delta, Vega, Theta, Rho):
+    constexpr int NOut = 5;
+    size_t nBlocks = size_t((nSamples + MCBlockSize - 1) / MCBlockSize);
+    std::vector<MCStats> blockStats(nBlocks * NOut);
+
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point start = Clock::now();
+
+    //-----------------------------------------------------------------------//
+    // Block Simulation:                                                     //
+    //-----------------------------------------------------------------------//
+    auto simBlock =
+      [&](size_t a_b)
+      {
+        size_t m = size_t(nSteps);
+        std::vector<double>  z   (m);
+        std::vector<ADouble> path(m + 1);
+        MCStats* stats = blockStats.data() + a_b * NOut;
+
+        // The inputs and the per-path constants are recorded once per block;
+        // each path is recorded on top of them, and discarded after its sweep:
+        AAD::TapeScope scope;
+        AAD::Tape&     tape  = scope.Get();
+        ADouble        St    = tape.NewVar(a_St);
+        ADouble        sigma = tape.NewVar(a_sigma);
+        ADouble        r     = tape.NewVar(a_r);
+        ADouble        t     = tape.NewVar(a_t);
+        ADouble        tauA  = ADouble(a_T) - t;
+        ADouble        dt    = tauA / double(nSteps);
+        ADouble        drift = (r - a_D - 0.5 * sigma * sigma) * dt;
+        ADouble        volDt = sigma * sqrt(dt);
+        ADouble        df    = exp(-r * tauA);
+        size_t         mark  = tape.Size();
+
+        long from = long(a_b) * MCBlockSize;
+        long to   = std::min(from + MCBlockSize, nSamples);
+        MCNormals::Cursor cursor(normals, from);
+
+        for (long s = from; s < to; ++s)
+        {
+          cursor.Get(s, z.data());
+
+          // path[k] = St * exp(k * drift + volDt * W[k]), where the Brownian
+          // increments W[k] are constants (not on the Tape):
+          ADouble y = 0.0;
+          for (int a = 0; a < (anti ? 2 : 1); ++a)
+          {
+            double sign = (a == 0) ? 1.0 : -1.0;
+            double W    = 0.0;
+            path[0]     = St;
+            for (size_t k = 1; k <= m; ++k)
+            {
+              W      += sign * z[k-1];
+              path[k] = St * exp(drift * double(k) + volDt * W);
+            }
+            y += ADouble(a_payoff(path.data(), nSteps));
+          }
+          if (anti)
+            y *= 0.5;
+          ADouble v = df * y;
+
+          tape.Sweep(v);
+          stats[0].Add(v.Val(),            0.0);
+          stats[1].Add(tape.Adjoint(St),    0.0);
+          stats[2].Add(tape.Adjoint(sigma), 0.0);
+          stats[3].Add(tape.Adjoint(t),     0.0);
+          stats[4].Add(tape.Adjoint(r),     0.0);
+          tape.Rewind(mark);
+        }
+      };
+
+    RunParallel(nBlocks, a_params.m_nThreads, simBlock);
+
+    //-----------------------------------------------------------------------//
+    // Merge the blocks (in the block order):                                //
+    //-----------------------------------------------------------------------//
+    MCStats total[NOut];
+    for (size_t b = 0; b < nBlocks; ++b)
+      for (int k = 0; k < NOut; ++k)
+        total[k].Merge(blockStats[b * NOut + size_t(k)]);
+
+    double est[NOut];
+    double err[NOut];
+    for (int k = 0; k < NOut; ++k)
+    {
+      MCRes r;
+      MCEstimate(total[k], false, 0.0, 1.0, &r);
+      est[k] = r.m_px;
+      err[k] = r.m_stdErr;
+    }
+
+    MCGreeks res;
+    res.m_greeks.m_px     = est[0];
+    res.m_greeks.m_delta  = est[1];
+    res.m_greeks.m_vega   = est[2];
+    res.m_greeks.m_theta  = est[3];
+    res.m_greeks.m_rho    = est[4];
+    res.m_stdErrs.m_px    = err[0];
+    res.m_stdErrs.m_delta = err[1];
+    res.m_stdErrs.m_vega  = err[2];
+    res.m_stdErrs.m_theta = err[3];
+    res.m_stdErrs.m_rho   = err[4];
+
+    long nDone   = long(total[0].m_n);
+    res.m_nPaths = anti ? 2 * nDone : nDone;
+    res.m_time   = std::chrono::duration<double>(Clock::now() - start).count();
+    return res;
+  }
+}
+// End namespace BSM
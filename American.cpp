@@ -0,0 +1,523 @@
+// vim:ts=2:et
+//===========================================================================//
+//                               "American.cpp":                             //
+//           Analytic American Approximations: Implementation                //
+//===========================================================================//
+#include "American.h"
+#include "FastMath.hpp"
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace BSM
+{
+  namespace
+  {
+    //-----------------------------------------------------------------------//
+    // "BivarNormal": Bivariate Normal CDF with a Fixed Correlation:         //
+    //-----------------------------------------------------------------------//
+    // A.Genz (2004), the |rho| < 0.925 case: 20-point Gauss-Legendre quadra-
+    // ture of Plackett's formula over [0, asin(rho)]. The quadrature nodes
+    // depend on "rho" only, so their "sin"s are pre-computed, and the sum is
+    // a vectorisable loop. In Bjerksund-Stensland, rho = +-sqrt(t1 / tau) =
+    // +-0.786 always:
+    //
+    class BivarNormal
+    {
+    private:
+      // Gauss-Legendre (10 points on [-1, 1], symmetric):
+      constexpr static double s_W[10] =
+      {
+        0.01761400713915212, 0.04060142980038694, 0.06267204833410906,
+        0.08327674157670475, 0.1019301198172404,  0.1181945319615184,
+        0.1316886384491766,  0.1420961093183821,  0.1491729864726037,
+        0.1527533871307259
+      };
+      constexpr static double s_X[10] =
+      {
+        -0.9931285991850949, -0.9639719272779138, -0.9122344282513259,
+        -0.8391169718222188, -0.7463319064601508, -0.6360536807265150,
+        -0.5108670019508271, -0.3737060887154196, -0.2277858511416451,
+        -0.07652652113349733
+      };
+      double m_c;          // asin(rho) / (4 * pi)
+      double m_w  [20];    // The weights, for both nodes of each pair
+      double m_sn [20];    // sin(asin(rho) * (1 +- x_i) / 2)
+      double m_inv[20];    // 1 / (1 - m_sn^2)
+
+    public:
+      explicit BivarNormal(double a_rho)
+      {
+        assert(std::fabs(a_rho) < 0.925);
+        double asr = asin(a_rho);
+        m_c        = asr / (4.0 * M_PI);
+        for (int i = 0; i < 10; ++i)
+        {
+          m_w [2*i]     = s_W[i];
+          m_w [2*i+1]   = s_W[i];
+          m_sn[2*i]     = sin(asr * (1.0 + s_X[i]) / 2.0);
+          m_sn[2*i+1]   = sin(asr * (1.0 - s_X[i]) / 2.0);
+          m_inv[2*i]    = 1.0 / (1.0 - m_sn[2*i]   * m_sn[2*i]);
+          m_inv[2*i+1]  = 1.0 / (1.0 - m_sn[2*i+1] * m_sn[2*i+1]);
+        }
+      }
+
+      // P(X < a_a, Y < a_b):
+      FASTMATH_INLINE double operator()(double a_a, double a_b) const
+      {
+        double hk  = a_a * a_b;
+        double hs  = 0.5 * (a_a * a_a + a_b * a_b);
+        double sum = 0.0;
+#       pragma omp simd reduction(+: sum)
+        for (int i = 0; i < 20; ++i)
+          sum += m_w[i] * FastMath::Exp((m_sn[i] * hk - hs) * m_inv[i]);
+        return sum * m_c + Phi(a_a) * Phi(a_b);
+      }
+    };
+
+    double const      RhoBS = sqrt(0.5 * (sqrt(5.0) - 1.0));
+    BivarNormal const BVNPlus (  RhoBS);
+    BivarNormal const BVNMinus(- RhoBS);
+
+    //-----------------------------------------------------------------------//
+    // "EuroN": European Px for K = 1:                                       //
+    //-----------------------------------------------------------------------//
+    inline double EuroN(AmerCrit const& a_c, double a_w, double a_x)
+    {
+      double d1 = log(a_x) / a_c.m_s + a_c.m_mu;
+      double d2 = d1 - a_c.m_s;
+      return a_w * (a_x * a_c.m_dfD * Phi(a_w * d1) -
+                    a_c.m_dfR * Phi(a_w * d2));
+    }
+
+    //-----------------------------------------------------------------------//
+    // "SolveBAW": The Critical Px for K = 1:                                //
+    //-----------------------------------------------------------------------//
+    // Newton iterations on
+    //   w * (S - 1) = European(S) + w * (1 - exp(-D*tau) * Phi(w*d1)) * S/q,
+    // with the starting point of Barone-Adesi-Whaley (1987):
+    //
+    void SolveBAW(double a_w, AmerCrit* a_c)
+    {
+      AmerCrit& c  = *a_c;
+      double tau   = c.m_tau;
+      double s     = c.m_s;
+      double b     = c.m_r - c.m_D;
+      double s2    = c.m_sigma * c.m_sigma;
+      double M     = 2.0 * c.m_r / s2;
+      double N1    = 2.0 * b / s2 - 1.0;
+      // M / (1 - exp(-r*tau)), with the limit at r = 0:
+      double MK    = (c.m_r != 0.0)
+                     ? M / (- expm1(- c.m_r * tau))
+                     : 2.0 / (s2 * tau);
+      double q     = 0.5 * (- N1 + a_w * sqrt(N1 * N1 + 4.0 * MK));
+
+      // The starting point (from the perpetual Critical Px):
+      double qInf  = 0.5 * (- N1 + a_w * sqrt(N1 * N1 + 4.0 * M));
+      double sInf  = 1.0 / (1.0 - 1.0 / qInf);
+      double h     = - (b * tau + a_w * 2.0 * s) / (sInf - 1.0);
+      double S     = 1.0 + (sInf - 1.0) * (1.0 - exp(h));
+
+      bool   done  = false;
+      for (int it = 0; it < 100 && !done; ++it)
+      {
+        double d1  = log(S) / s + c.m_mu;
+        double PhD = c.m_dfD * Phi(a_w * d1);
+        double rhs = EuroN(c, a_w, S) + a_w * (1.0 - PhD) * S / q;
+        double lhs = a_w * (S - 1.0);
+        done       = std::fabs(lhs - rhs) < 1e-13;
+
+        // The slope of "rhs" (and "lhs" has the slope "w"):
+        double bi  = a_w * PhD * (1.0 - 1.0 / q) +
+                     (a_w - c.m_dfD * NormPDF(d1) / s) / q;
+        S         -= (lhs - rhs) / (a_w - bi);
+      }
+      double d1    = log(S) / s + c.m_mu;
+      c.m_sStar    = S;
+      c.m_lnSStar  = log(S);
+      c.m_q        = q;
+      c.m_A        = a_w * (S / q) * (1.0 - c.m_dfD * Phi(a_w * d1));
+
+      if (!(done && std::isfinite(c.m_A) && S > 0.0))
+        throw std::invalid_argument("AmerCritical: No Solution for BAW");
+    }
+
+    //-----------------------------------------------------------------------//
+    // "SetupBS": Bjerksund-Stensland Exercise Boundaries for K = 1:         //
+    //-----------------------------------------------------------------------//
+    void SetupBS(AmerCrit* a_c)
+    {
+      AmerCrit& c = *a_c;
+      double r    = c.m_rr;
+      double b    = c.m_bb;
+      double s2   = c.m_sigma * c.m_sigma;
+      double y    = 0.5 - b / s2;
+      double beta = y + sqrt(y * y + 2.0 * r / s2);
+      double BInf = beta / (beta - 1.0);
+      double B0   = std::max(1.0, r / (r - b));
+      double t1   = 0.5 * (sqrt(5.0) - 1.0) * c.m_tau;
+      double den  = (BInf - B0) * B0;
+      double h1   = - (b * t1      + 2.0 * c.m_sigma * sqrt(t1))      / den;
+      double h2   = - (b * c.m_tau + 2.0 * c.m_sigma * sqrt(c.m_tau)) / den;
+
+      c.m_beta    = beta;
+      c.m_t1      = t1;
+      c.m_I1      = B0 + (BInf - B0) * (- expm1(h1));
+      c.m_I2      = B0 + (BInf - B0) * (- expm1(h2));
+      c.m_alpha1  = (c.m_I1 - 1.0) * pow(c.m_I1, - beta);
+      c.m_alpha2  = (c.m_I2 - 1.0) * pow(c.m_I2, - beta);
+
+      if (!(std::isfinite(c.m_alpha1) && std::isfinite(c.m_alpha2) &&
+            beta > 1.0))
+        throw std::invalid_argument
+              ("AmerCritical: No Solution for Bjerksund-Stensland");
+    }
+
+    //-----------------------------------------------------------------------//
+    // "PhiBS": "phi(x, t1, gamma, H, I)" of Bjerksund-Stensland:            //
+    //-----------------------------------------------------------------------//
+    // (With K = 1 and "a_lx" = log(x)):
+    //
+    FASTMATH_INLINE double PhiBS
+    (
+      AmerCrit const& a_c,
+      double          a_lx,
+      double          a_g,
+      double          a_H,
+      double          a_I
+    )
+    {
+      double b   = a_c.m_bb;
+      double s2  = a_c.m_sigma * a_c.m_sigma;
+      double t1  = a_c.m_t1;
+      double sT  = a_c.m_sigma * sqrt(t1);
+      double lam = (- a_c.m_rr + a_g * b + 0.5 * a_g * (a_g - 1.0) * s2) * t1;
+      double d   = - (a_lx - log(a_H) + (b + (a_g - 0.5) * s2) * t1) / sT;
+      double kap = 2.0 * b / s2 + 2.0 * a_g - 1.0;
+      double lIS = log(a_I) - a_lx;
+      return exp(lam + a_g * a_lx) *
+             (Phi(d) - exp(kap * lIS) * Phi(d - 2.0 * lIS / sT));
+    }
+
+    //-----------------------------------------------------------------------//
+    // "KsiBS": "ksi(x, tau, gamma, H, I2, I1, t1)" of Bjerksund-Stensland:  //
+    //-----------------------------------------------------------------------//
+    FASTMATH_INLINE double KsiBS
+    (
+      AmerCrit const& a_c,
+      double          a_lx,
+      double          a_g,
+      double          a_H
+    )
+    {
+      double b   = a_c.m_bb;
+      double s2  = a_c.m_sigma * a_c.m_sigma;
+      double tau = a_c.m_tau;
+      double t1  = a_c.m_t1;
+      double dr  = b + (a_g - 0.5) * s2;
+      double st1 = a_c.m_sigma * sqrt(t1);
+      double sT  = a_c.m_sigma * sqrt(tau);
+      double lx  = a_lx;
+      double lH  = log(a_H);
+      double l1  = log(a_c.m_I1);
+      double l2  = log(a_c.m_I2);
+      double e1  = (lx - l1                   + dr * t1)  / st1;
+      double e2  = (2.0 * l2 - lx - l1        + dr * t1)  / st1;
+      double e3  = (lx - l1                   - dr * t1)  / st1;
+      double e4  = (2.0 * l2 - lx - l1        - dr * t1)  / st1;
+      double f1  = (lx - lH                   + dr * tau) / sT;
+      double f2  = (2.0 * l2 - lx - lH        + dr * tau) / sT;
+      double f3  = (2.0 * l1 - lx - lH        + dr * tau) / sT;
+      double f4  = (lx + 2.0 * (l1 - l2) - lH + dr * tau) / sT;
+      double lam = - a_c.m_rr + a_g * b + 0.5 * a_g * (a_g - 1.0) * s2;
+      double kap = 2.0 * b / s2 + 2.0 * a_g - 1.0;
+      return exp(lam * tau + a_g * lx) *
+             (  BVNPlus (- e1, - f1)
+              - exp(kap * (l2 - lx)) * BVNPlus (- e2, - f2)
+              - exp(kap * (l1 - lx)) * BVNMinus(- e3, - f3)
+              + exp(kap * (l1 - l2)) * BVNMinus(- e4, - f4));
+    }
+
+    //-----------------------------------------------------------------------//
+    // "CallBS": Bjerksund-Stensland Call Px for K = 1:                      //
+    //-----------------------------------------------------------------------//
+    // The cost is dominated by the 20 bivariate normal CDFs, whose quadrature
+    // loops are vectorised:
+    //
+    FASTMATH_SIMD_KERNEL
+    double CallBS(AmerCrit const& a_c, double a_x)
+    {
+      if (a_x >= a_c.m_I2)
+        return a_x - 1.0;
+
+      double lx   = log(a_x);
+      double I1   = a_c.m_I1;
+      double I2   = a_c.m_I2;
+      double beta = a_c.m_beta;
+      double a1   = a_c.m_alpha1;
+      double a2   = a_c.m_alpha2;
+      double px   =
+          a2 * exp(beta * lx)
+        - a2 * PhiBS(a_c, lx, beta, I2, I2)
+        +      PhiBS(a_c, lx, 1.0,  I2, I2)
+        -      PhiBS(a_c, lx, 1.0,  I1, I2)
+        -      PhiBS(a_c, lx, 0.0,  I2, I2)
+        +      PhiBS(a_c, lx, 0.0,  I1, I2)
+        + a1 * PhiBS(a_c, lx, beta, I1, I2)
+        - a1 * KsiBS(a_c, lx, beta, I1)
+        +      KsiBS(a_c, lx, 1.0,  I1)
+        -      KsiBS(a_c, lx, 1.0,  1.0)
+        -      KsiBS(a_c, lx, 0.0,  I1)
+        +      KsiBS(a_c, lx, 0.0,  1.0);
+
+      // It is a lower bound, but must be above the intrinsic value:
+      return std::max(px, a_x - 1.0);
+    }
+
+    //-----------------------------------------------------------------------//
+    // "PxAmerBatchKernel": BAW (and European) Pxs:                          //
+    //-----------------------------------------------------------------------//
+    FASTMATH_SIMD_KERNEL
+    void PxAmerBatchKernel
+    (
+      AmerCrit const&          a_c,
+      double                   a_w,
+      size_t                   a_n,
+      double const* __restrict a_K,
+      double                   a_St,
+      double*       __restrict a_px
+    )
+    {
+      double s     = a_c.m_s;
+      double mu    = a_c.m_mu;
+      double dfD   = a_c.m_dfD;
+      double dfR   = a_c.m_dfR;
+      double sStar = a_c.m_sStar;
+      double lnS   = a_c.m_lnSStar;
+      double q     = a_c.m_q;
+      double A     = a_c.m_A;
+      bool   live  = a_c.m_tau > 0.0;
+
+#     pragma omp simd
+      for (size_t i = 0; i < a_n; ++i)
+      {
+        double x    = a_St / a_K[i];
+        double lx   = FastMath::Log(x);
+        double d1   = lx / s + mu;
+        double d2   = d1 - s;
+        double eu   = a_w * (x * dfD * FastMath::Phi(a_w * d1) -
+                             dfR * FastMath::Phi(a_w * d2));
+        double prem = A * FastMath::Exp(q * (lx - lnS));
+        double intr = a_w * (x - 1.0);
+        double px   = (a_w * (x - sStar) >= 0.0) ? intr : (eu + prem);
+        double pay  = (intr > 0.0) ? intr : 0.0;
+        a_px[i]     = a_K[i] * (live ? px : pay);
+      }
+    }
+  }
+
+  //=========================================================================//
+  // "AmerCritical":                                                         //
+  //=========================================================================//
+  AmerCrit AmerCritical
+  (
+    AmerApprox a_method,
+    PayoffType a_type,
+    double     a_T,
+    double     a_r,
+    double     a_D,
+    double     a_sigma,
+    double     a_t
+  )
+  {
+    //-----------------------------------------------------------------------//
+    // Check the args:                                                       //
+    //-----------------------------------------------------------------------//
+    double tau = a_T - a_t;
+
+    if (tau <  0.0)
+      throw std::invalid_argument("Negative Time to Expiration");
+
+    double w = 0.0;   // +1 for Call, -1 for Put
+    switch (a_type)
+    {
+      case PayoffType::Call: w =  1.0; break;
+      case PayoffType::Put:  w = -1.0; break;
+      default:
+        throw std::logic_error("Unsupported PayoffType");
+    }
+
+    if (a_sigma <= 0.0)
+      throw std::invalid_argument("Non-Positive Strike / UnderlyingPx / Vol");
+
+    if (a_method != AmerApprox::BAW &&
+        a_method != AmerApprox::BjerksundStensland)
+      throw std::logic_error("Unsupported AmerApprox");
+
+    //-----------------------------------------------------------------------//
+    // The European part:                                                    //
+    //-----------------------------------------------------------------------//
+    AmerCrit c;
+    c.m_method   = a_method;
+    c.m_type     = a_type;
+    c.m_tau      = tau;
+    c.m_r        = a_r;
+    c.m_D        = a_D;
+    c.m_sigma    = a_sigma;
+    c.m_s        = a_sigma * sqrt(tau);
+    c.m_mu       = (a_r - a_D) * tau / c.m_s + 0.5 * c.m_s;
+    c.m_dfD      = exp(- a_D * tau);
+    c.m_dfR      = exp(- a_r * tau);
+    // No early exercise yet: the exercise region is empty, no premium:
+    c.m_european = true;
+    c.m_sStar    = (w > 0.0) ? INFINITY : 0.0;
+
+    // Early exercise is never optimal for a Call with D <= 0, or for a Put
+    // with r <= 0:
+    if (tau == 0.0 || (w > 0.0 ? a_D : a_r) <= 0.0)
+      return c;
+
+    //-----------------------------------------------------------------------//
+    // The Critical Pxs:                                                     //
+    //-----------------------------------------------------------------------//
+    c.m_european = false;
+    if (a_method == AmerApprox::BAW)
+      SolveBAW(w, &c);
+    else
+    {
+      c.m_rr = (w > 0.0) ? a_r       : a_D;
+      c.m_bb = (w > 0.0) ? a_r - a_D : a_D - a_r;
+      SetupBS(&c);
+    }
+    return c;
+  }
+
+  //=========================================================================//
+  // "PxAmer":                                                               //
+  //=========================================================================//
+  double PxAmer(AmerCrit const& a_crit, double a_K, double a_St)
+  {
+    if (a_K <= 0.0 || a_St <= 0.0)
+      throw std::invalid_argument("Non-Positive Strike / UnderlyingPx / Vol");
+
+    double w = (a_crit.m_type == PayoffType::Call) ? 1.0 : -1.0;
+    double x = a_St / a_K;
+
+    // At expiration time, return the PayOff:
+    if (a_crit.m_tau == 0.0)
+      return a_K * std::max(w * (x - 1.0), 0.0);
+
+    if (a_crit.m_european)
+      return a_K * std::max(EuroN(a_crit, w, x), 0.0);
+
+    if (a_crit.m_method == AmerApprox::BAW)
+    {
+      if (w * (x - a_crit.m_sStar) >= 0.0)
+        return a_K * w * (x - 1.0);
+      return a_K *
+             (EuroN(a_crit, w, x) +
+              a_crit.m_A * exp(a_crit.m_q * (log(x) - a_crit.m_lnSStar)));
+    }
+    // Bjerksund-Stensland: a Put is the Call with the Strike and the Under-
+    // lying Px swapped:
+    return (w > 0.0)
+           ? a_K  * CallBS(a_crit, x)
+           : a_St * CallBS(a_crit, 1.0 / x);
+  }
+
+  double PxAmer
+  (
+    AmerApprox a_method,
+    PayoffType a_type,
+    double     a_K,
+    double     a_T,
+    double     a_r,
+    double     a_D,
+    double     a_sigma,
+    double     a_t,
+    double     a_St
+  )
+  {
+    return PxAmer
+           (AmerCritical(a_method, a_type, a_T, a_r, a_D, a_sigma, a_t),
+            a_K, a_St);
+  }
+
+  //=========================================================================//
+  // "PxAmerBatch":                                                          //
+  //=========================================================================//
+  void PxAmerBatch
+  (
+    AmerCrit const& a_crit,
+    size_t          a_n,
+    double const*   a_K,
+    double          a_St,
+    double*         a_px
+  )
+  {
+    if (a_St <= 0.0 ||
+        std::any_of(a_K, a_K + a_n, [](double a_k) { return a_k <= 0.0; }))
+      throw std::invalid_argument("Non-Positive Strike / UnderlyingPx / Vol");
+
+    if (a_crit.m_european || a_crit.m_method == AmerApprox::BAW)
+    {
+      double w = (a_crit.m_type == PayoffType::Call) ? 1.0 : -1.0;
+      PxAmerBatchKernel(a_crit, w, a_n, a_K, a_St, a_px);
+    }
+    else
+      for (size_t i = 0; i < a_n; ++i)
+        a_px[i] = PxAmer(a_crit, a_K[i], a_St);
+  }
+
+  //=========================================================================//
+  // "AmerCritCache" Non-Default Ctor:                                       //
+  //=========================================================================//
+  AmerCritCache::AmerCritCache(size_t a_capacity)
+  : m_capacity(a_capacity),
+    m_entries ()
+  {
+    if (a_capacity == 0)
+      throw std::invalid_argument("AmerCritCache: Zero Capacity");
+  }
+
+  //=========================================================================//
+  // "AmerCritCache::Get":                                                   //
+  //=========================================================================//
+  AmerCrit const& AmerCritCache::Get
+  (
+    AmerApprox a_method,
+    PayoffType a_type,
+    double     a_T,
+    double     a_r,
+    double     a_D,
+    double     a_sigma,
+    double     a_t
+  )
+  {
+    for (Entry& e: m_entries)
+    {
+      AmerCrit const& c = e.m_crit;
+      if (c.m_method == a_method && c.m_type == a_type && e.m_T == a_T &&
+          c.m_r      == a_r      && c.m_D    == a_D    &&
+          c.m_sigma  == a_sigma)
+      {
+        // A stale entry (of an earlier Pricing Time) is replaced in place:
+        if (e.m_t != a_t)
+        {
+          e.m_crit = AmerCritical(a_method, a_type, a_T, a_r, a_D, a_sigma,
+                                  a_t);
+          e.m_t    = a_t;
+        }
+        return e.m_crit;
+      }
+    }
+    AmerCrit crit =
+      AmerCritical(a_method, a_type, a_T, a_r, a_D, a_sigma, a_t);
+
+    if (m_entries.size() >= m_capacity)
+      m_entries.pop_front();
+    m_entries.push_back(Entry{a_T, a_t, crit});
+    return m_entries.back().m_crit;
+  }
+}
+// End namespace BSM
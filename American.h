@@ -0,0 +1,181 @@
+// vim:ts=2:et
+//===========================================================================//
+//                                "American.h":                              //
+//     Analytic American Approximations (Barone-Adesi-Whaley, Bjerksund-     //
+//                            Stensland 2002)                                //
+//===========================================================================//
+#pragma once
+#include "BSM.h"
+#include <cstddef>
+#include <deque>
+
+namespace BSM
+{
+  //-------------------------------------------------------------------------//
+  // Approximation Methods:                                                  //
+  //-------------------------------------------------------------------------//
+  // Against a 4000-step tree (S=100, K=80..120, vol 15-40%, r up to 8%, D up
+  // to 10%), the max abs errors are 0.16 (BAW) and 0.13 (Bjerksund-Stens-
+  // land) for expirations up to 1Y; for 3Y, BAW degrades to 0.85, Bjerksund-
+  // Stensland to 0.25. Use "PDEPricer" or "TreePricer" where that matters:
+  //
+  enum class AmerApprox: int
+  {
+    BAW                = 0,  // Barone-Adesi-Whaley (1987): quadratic approx
+                             //   of the early exercise premium
+    BjerksundStensland = 1   // Bjerksund-Stensland (2002): 2-step flat exer-
+                             //   cise boundary (a lower bound for the Px)
+  };
+
+  //-------------------------------------------------------------------------//
+  // "AmerCrit": The Per-Expiry Part of an Approximation:                    //
+  //-------------------------------------------------------------------------//
+  // The Critical (early exercise) Pxs are proportional to the Strike, so they
+  // are computed once for the Strike 1 (for BAW, by Newton iterations), and
+  // re-used for all Strikes with the same (Type, Expiration, r, D, sigma).
+  // Nor do they depend on the Underlying Px, so on each tick, the American
+  // Pxs cost about as much as the European ones (for BAW; Bjerksund-Stensland
+  // also requires some bivariate normal CDFs per option).
+  // For Bjerksund-Stensland, a Put is priced as the equivalent Call (with the
+  // Underlying and Strike, and "r" and "D", swapped), whose params are given
+  // by the "m_rr", "m_bb" flds:
+  //
+  struct AmerCrit
+  {
+    // The Key:
+    AmerApprox m_method  = AmerApprox::BAW;
+    PayoffType m_type    = PayoffType::UNDEFINED;
+    double     m_tau     = NAN;   // Time to Expiration
+    double     m_r       = NAN;
+    double     m_D       = NAN;
+    double     m_sigma   = NAN;
+    // No early exercise premium (eg Call with D <= 0, or at expiration):
+    bool       m_european = true;
+    // The European Px for K=1 and S=x: with d1 = log(x) / m_s + m_mu,
+    //   Px = w * (x * m_dfD * Phi(w * d1) - m_dfR * Phi(w * (d1 - m_s))):
+    double     m_s       = NAN;   // sigma * sqrt(tau)
+    double     m_mu      = NAN;   // (r - D) * tau / m_s + m_s / 2
+    double     m_dfD     = NAN;   // exp(-D * tau)
+    double     m_dfR     = NAN;   // exp(-r * tau)
+    // BAW: the Px (for K=1) is
+    //   x in the exercise region (w * (x - m_sStar) >= 0): w * (x - 1),
+    //   otherwise: European + m_A * exp(m_q * (log(x) - m_lnSStar)):
+    double     m_sStar   = NAN;   // Critical Px / K
+    double     m_lnSStar = 0.0;
+    double     m_q       = 0.0;   // q2 (Call) or q1 (Put)
+    double     m_A       = 0.0;   // A2 (Call) or A1 (Put), divided by K
+    // Bjerksund-Stensland (for the equivalent Call with Strike 1):
+    double     m_rr      = NAN;   // Interest Rate
+    double     m_bb      = NAN;   // Cost of Carry
+    double     m_beta    = NAN;
+    double     m_t1      = NAN;   // The 1st step: (sqrt(5) - 1) / 2 * tau
+    double     m_I1      = NAN;   // Flat exercise boundary over [0, t1]
+    double     m_I2      = NAN;   // ... and over [t1, tau]
+    double     m_alpha1  = NAN;
+    double     m_alpha2  = NAN;
+  };
+
+  //-------------------------------------------------------------------------//
+  // "AmerCritical": Computes the Per-Expiry Part:                           //
+  //-------------------------------------------------------------------------//
+  // Call and Put only (otherwise throws "std::logic_error"); throws "std::in-
+  // valid_argument" for a negative Time to Expiration or a non-positive Vol,
+  // and if the approximation has no solution (which may happen with negative
+  // rates):
+  //
+  AmerCrit AmerCritical
+  (
+    AmerApprox a_method,
+    PayoffType a_type,
+    double     a_T,       // Option Expiration Time, as Year Fraction
+    double     a_r,       // Risk-Free Interest Rate
+    double     a_D,       // Dividend Rate
+    double     a_sigma,   // Volatility
+    double     a_t        // Pricing Time (as Year Fraction)
+  );
+
+  //-------------------------------------------------------------------------//
+  // "PxAmer": American Option Px:                                           //
+  //-------------------------------------------------------------------------//
+  // Using the pre-computed "AmerCrit"; throws "std::invalid_argument" for a
+  // non-positive Strike or Underlying Px:
+  //
+  double PxAmer(AmerCrit const& a_crit, double a_K, double a_St);
+
+  // All-in-one version (args as in "BSM::Px"):
+  double PxAmer
+  (
+    AmerApprox a_method,
+    PayoffType a_type,
+    double     a_K,
+    double     a_T,
+    double     a_r,
+    double     a_D,
+    double     a_sigma,
+    double     a_t,
+    double     a_St
+  );
+
+  //-------------------------------------------------------------------------//
+  // "PxAmerBatch": Options on One Expiration, with Different Strikes:       //
+  //-------------------------------------------------------------------------//
+  // For BAW (and the cases without early exercise), the loop is vectorised
+  // (with the "FastMath" kernels, so the results agree with "PxAmer" within
+  // 1e-13 * max(K, St)); Bjerksund-Stensland is evaluated per option:
+  //
+  void PxAmerBatch
+  (
+    AmerCrit const& a_crit,
+    size_t          a_n,    // Number of Options
+    double const*   a_K,    // [a_n] Option Strikes
+    double          a_St,   // Underlying Px (shared)
+    double*         a_px    // [a_n] Option Pxs
+  );
+
+  //=========================================================================//
+  // "AmerCritCache" Class:                                                  //
+  //=========================================================================//
+  // Keeps the "AmerCrit"s of the expirations seen so far, so that re-quoting
+  // (eg when the Underlying Px changes) does not repeat the solves.  The key
+  // is (method, type, T, r, D, sigma), compared exactly; the Pricing Time "t"
+  // is not part of it: when it moves on, the entry is re-solved and replaced
+  // in place, so the cache does not grow with the number of pricing times.
+  // At most "Capacity()" entries are kept (the oldest one is evicted first),
+  // so the linear lookup stays short. The returned ref remains valid until
+  // its entry is evicted or "Clear" is called, and its contents change when
+  // the entry is replaced (by a "Get" with the same key and another "t").
+  // NOT thread-safe:
+  //
+  class AmerCritCache
+  {
+  private:
+    struct Entry
+    {
+      double   m_T;
+      double   m_t;
+      AmerCrit m_crit;
+    };
+    size_t            m_capacity;
+    std::deque<Entry> m_entries;
+
+  public:
+    // Throws "std::invalid_argument" if "a_capacity" is 0:
+    explicit AmerCritCache(size_t a_capacity = 256);
+
+    AmerCrit const& Get
+    (
+      AmerApprox a_method,
+      PayoffType a_type,
+      double     a_T,
+      double     a_r,
+      double     a_D,
+      double     a_sigma,
+      double     a_t
+    );
+
+    void   Clear()          { m_entries.clear();       }
+    size_t Size()     const { return m_entries.size(); }
+    size_t Capacity() const { return m_capacity;       }
+  };
+}
+// End namespace BSM
@@ -3,7 +3,7 @@
 //                                 "BSM.cpp":                                //
 //       Black-Scholes-Merton Option Pricing Formulas: Implementation        //
 //===========================================================================//
-#include "BSM.h"
+#include "BSM.hpp"
 #include <algorithm>
 #include <stdexcept>
 #include <cassert>
@@ -13,6 +13,7 @@ namespace BSM
   //-------------------------------------------------------------------------//
   // "Px":                                                                   //
   //-------------------------------------------------------------------------//
+  template<typename CDF>
   double Px
   (
     // Option Spec:
@@ -27,6 +28,90 @@ namespace BSM
     double a_t,     // Pricing Time (as Year Fraction)
     double a_St     // Underlying Px at Time "a_t"
   )
+  {
+    // Dispatch to the closed-form for this PayoffType (the args are checked
+    // there):
+    switch (a_type)
+    {
+      case PayoffType::Call:
+        return Px<PayoffType::Call,        CDF>
+               (a_K, a_T, a_r, a_D, a_sigma, a_t, a_St);
+
+      case PayoffType::Put:
+        return Px<PayoffType::Put,         CDF>
+               (a_K, a_T, a_r, a_D, a_sigma, a_t, a_St);
+
+      case PayoffType::DigitalCall:
+        return Px<PayoffType::DigitalCall, CDF>
+               (a_K, a_T, a_r, a_D, a_sigma, a_t, a_St);
+
+      case PayoffType::DigitalPut:
+        return Px<PayoffType::DigitalPut,  CDF>
+               (a_K, a_T, a_r, a_D, a_sigma, a_t, a_St);
+
+      default:
+        throw std::logic_error("Unsupported PayoffType");
+    }
+  }
+
+  //-------------------------------------------------------------------------//
+  // "PxNoThrow":                                                            //
+  //-------------------------------------------------------------------------//
+  template<typename CDF>
+  PxRes PxNoThrow
+  (
+    PayoffType a_type,
+    double     a_K,
+    double     a_T,
+    double     a_r,
+    double     a_D,
+    double     a_sigma,
+    double     a_t,
+    double     a_St
+  )
+  noexcept
+  {
+    switch (a_type)
+    {
+      case PayoffType::Call:
+        return PxNoThrow<PayoffType::Call,        CDF>
+               (a_K, a_T, a_r, a_D, a_sigma, a_t, a_St);
+
+      case PayoffType::Put:
+        return PxNoThrow<PayoffType::Put,         CDF>
+               (a_K, a_T, a_r, a_D, a_sigma, a_t, a_St);
+
+      case PayoffType::DigitalCall:
+        return PxNoThrow<PayoffType::DigitalCall, CDF>
+               (a_K, a_T, a_r, a_D, a_sigma, a_t, a_St);
+
+      case PayoffType::DigitalPut:
+        return PxNoThrow<PayoffType::DigitalPut,  CDF>
+               (a_K, a_T, a_r, a_D, a_sigma, a_t, a_St);
+
+      default:
+        return PxRes{NAN, PxErr::UnsupportedType};
+    }
+  }
+
+  //-------------------------------------------------------------------------//
+  // "PxGreeks":                                                             //
+  //-------------------------------------------------------------------------//
+  template<typename CDF>
+  Greeks PxGreeks
+  (
+    // Option Spec:
+    PayoffType a_type,
+    double     a_K, // Option Strike
+    double     a_T, // Opton Expiration Time, as Year Fraction
+    // Market Data:
+    double a_r,     // Risk-Free Interest Rate (for the Numeraire Ccy)
+    double a_D,     // Dividend Rate (Risk-Free Ineterst Rate for Foreign Ccy)
+    double a_sigma, // Implied Volatility
+    // "Quick" variables:
+    double a_t,     // Pricing Time (as Year Fraction)
+    double a_St     // Underlying Px at Time "a_t"
+  )
   {
     // Time to expiration:
     double tau = a_T - a_t;
@@ -38,49 +123,260 @@ namespace BSM
       throw std::invalid_argument
             ("Non-Positive Strike / UnderlyingPx / Vol");
 
-    // Generic Case:
-    double px = NAN;
-
+    // w = +1 for Call, -1 for Put; then
+    // Px = w * (St * exp(-D*tau) * Phi(w*d1) - K * exp(-r*tau) * Phi(w*d2)):
+    double w = 0.0;
     switch (a_type)
     {
-      // Call:
-      case PayoffType::Call:
+      case PayoffType::Call: w =  1.0; break;
+      case PayoffType::Put:  w = -1.0; break;
+      default:
+        throw std::logic_error("Unsupported PayoffType");
+    }
+
+    Greeks res;
+    if (tau == 0.0)
+    {
+      // At expiration time, the PayOff and its Delta:
+      double intr = w * (a_St - a_K);
+      res.m_px    = std::max(intr, 0.0);
+      res.m_delta = (intr > 0.0) ? w : 0.0;
+      res.m_gamma = 0.0;
+      res.m_vega  = 0.0;
+      res.m_theta = 0.0;
+      res.m_rho   = 0.0;
+      return res;
+    }
+
+    // The shared terms:
+    double sqrtTau = sqrt(tau);
+    double s       = a_sigma * sqrtTau;
+    double d1      = (log(a_St / a_K) + (a_r - a_D) * tau) / s + 0.5 * s;
+    double d2      = d1 - s;
+    double SD      = a_St * exp(-a_D * tau);  // Discounted Underlying Px
+    double KD      = a_K  * exp(-a_r * tau);  // Discounted Strike
+    double phi1    = CDF::Phi(w * d1);
+    double phi2    = CDF::Phi(w * d2);
+    double SDpdf   = SD * CDF::NormPDF(d1);   // NB: SD*pdf(d1) = KD*pdf(d2)
+
+    res.m_px    = w * (SD * phi1 - KD * phi2);
+    res.m_delta = w * (SD / a_St) * phi1;
+    res.m_gamma = SDpdf / (a_St * a_St * s);
+    res.m_vega  = SDpdf * sqrtTau;
+    res.m_theta = - 0.5 * SDpdf * a_sigma / sqrtTau
+                  + w * (a_D * SD * phi1 - a_r * KD * phi2);
+    res.m_rho   = w * tau * KD * phi2;
+    return res;
+  }
+
+  namespace
+  {
+    //-----------------------------------------------------------------------//
+    // "BachelierGreeks": Px and Greeks in the Normal Model:                 //
+    //-----------------------------------------------------------------------//
+    // No arg checks here ("a_tau" > 0). With v = sigma * sqrt(tau) and
+    // d = (F - K) / v,
+    //   Px = exp(-r*tau) * (w * (F - K) * Phi(w*d) + v * pdf(d))  (Call/Put),
+    //   Px = exp(-r*tau) * Phi(w*d)                          (the Digitals);
+    // the Greeks are for Call and Put only:
+    //
+    template<typename CDF>
+    Greeks BachelierGreeks
+    (
+      bool   a_digital,
+      double a_w,
+      double a_K,
+      double a_tau,
+      double a_r,
+      double a_sigma,
+      double a_F
+    )
+    {
+      double sqrtTau = sqrt(a_tau);
+      double v       = a_sigma * sqrtTau;
+      double d       = (a_F - a_K) / v;
+      double DF      = exp(-a_r * a_tau);
+      double phi     = CDF::Phi(a_w * d);
+      double DFpdf   = DF * CDF::NormPDF(d);
+
+      Greeks res;
+      if (a_digital)
+      {
+        res.m_px    = DF * phi;
+        return res;
+      }
+      // (Deep out-of-the-money, rounding may give a tiny negative number):
+      res.m_px    = std::max(DF * a_w * (a_F - a_K) * phi + DFpdf * v, 0.0);
+      res.m_delta = a_w * DF * phi;
+      res.m_gamma = DFpdf / v;
+      res.m_vega  = DFpdf * sqrtTau;
+      res.m_theta = a_r * res.m_px - 0.5 * DFpdf * a_sigma / sqrtTau;
+      res.m_rho   = - a_tau * res.m_px;
+      return res;
+    }
+
+    //-----------------------------------------------------------------------//
+    // "CheckBachelierArgs": Returns "tau", and sets "w" and "digital":      //
+    //-----------------------------------------------------------------------//
+    double CheckBachelierArgs
+    (
+      PayoffType a_type,
+      double     a_T,
+      double     a_sigma,
+      double     a_t,
+      double*    a_w,
+      bool*      a_digital
+    )
+    {
+      double tau = a_T - a_t;
+      if (tau < 0.0)
+        throw std::invalid_argument("Negative Time to Expiration");
+
+      // K and St may be of any sign in the Normal Model:
+      if (!(a_sigma > 0.0))
+        throw std::invalid_argument("Non-Positive Vol");
+
+      switch (a_type)
+      {
+        case PayoffType::Call:        *a_w =  1.0; *a_digital = false; break;
+        case PayoffType::Put:         *a_w = -1.0; *a_digital = false; break;
+        case PayoffType::DigitalCall: *a_w =  1.0; *a_digital = true;  break;
+        case PayoffType::DigitalPut:  *a_w = -1.0; *a_digital = true;  break;
+        default:
+          throw std::logic_error("Unsupported PayoffType");
+      }
+      return tau;
+    }
+  }
+
+  //-------------------------------------------------------------------------//
+  // "Px" with "PxModel":                                                    //
+  //-------------------------------------------------------------------------//
+  template<typename CDF>
+  double Px
+  (
+    PxModel    a_model,
+    PayoffType a_type,
+    double     a_K,
+    double     a_T,
+    double     a_r,
+    double     a_D,
+    double     a_sigma,
+    double     a_t,
+    double     a_St
+  )
+  {
+    switch (a_model)
+    {
+      case PxModel::BSM:
+        return Px<CDF>(a_type, a_K, a_T, a_r, a_D, a_sigma, a_t, a_St);
+
+      // Black-76 is BSM on the Fwd, with the Fwd "dividend" rate equal to "r":
+      case PxModel::Black76:
+        return Px<CDF>(a_type, a_K, a_T, a_r, a_r, a_sigma, a_t, a_St);
+
+      case PxModel::Bachelier:
       {
+        double w       = 0.0;
+        bool   digital = false;
+        double tau     =
+          CheckBachelierArgs(a_type, a_T, a_sigma, a_t, &w, &digital);
+
         if (tau == 0.0)
-          // At expiration time, return the PayOff:
-          return std::max(a_St - a_K, 0.0);
-
-        double x    = log (a_St / a_K);
-        double s    = a_sigma * sqrt(tau);
-        double d1   = (x + (a_r - a_D + 0.5 * a_sigma * a_sigma) * tau) / s;
-        double d2   = d1 - s;
-        double phi1 = Phi(d1);
-        double phi2 = Phi(d2);
-
-        px   = a_St * exp(-a_D * tau) * phi1 -
-               a_K  * exp(-a_r * tau) * phi2;
-        break;
+        {
+          double intr = w * (a_St - a_K);
+          return digital ? ((intr > 0.0) ? 1.0 : 0.0) : std::max(intr, 0.0);
+        }
+        return BachelierGreeks<CDF>
+               (digital, w, a_K, tau, a_r, a_sigma, a_St).m_px;
       }
+      default:
+        throw std::invalid_argument("Invalid PxModel");
+    }
+  }
 
-      case PayoffType::Put:
+  //-------------------------------------------------------------------------//
+  // "PxGreeks" with "PxModel":                                              //
+  //-------------------------------------------------------------------------//
+  template<typename CDF>
+  Greeks PxGreeks
+  (
+    PxModel    a_model,
+    PayoffType a_type,
+    double     a_K,
+    double     a_T,
+    double     a_r,
+    double     a_D,
+    double     a_sigma,
+    double     a_t,
+    double     a_St
+  )
+  {
+    switch (a_model)
+    {
+      case PxModel::BSM:
+        return PxGreeks<CDF>(a_type, a_K, a_T, a_r, a_D, a_sigma, a_t, a_St);
+
+      case PxModel::Black76:
       {
-        if (a_D == 0.0)
-          px = Px(PayoffType::Call, a_K, a_T, a_r, a_D, a_sigma, a_t, a_St)
-               - a_St + a_K * exp(-a_r * tau);
-        else
-          throw std::logic_error("Unsupported: Put with Dividends");
-        break;
+        // As BSM with D = r, but "r" moves the Fwd discounting only:
+        Greeks res =
+          PxGreeks<CDF>(a_type, a_K, a_T, a_r, a_r, a_sigma, a_t, a_St);
+        res.m_rho  = - (a_T - a_t) * res.m_px;
+        return res;
       }
 
+      case PxModel::Bachelier:
+      {
+        double w       = 0.0;
+        bool   digital = false;
+        double tau     =
+          CheckBachelierArgs(a_type, a_T, a_sigma, a_t, &w, &digital);
+        if (digital)
+          throw std::logic_error("Unsupported PayoffType");
+
+        if (tau == 0.0)
+        {
+          Greeks res;
+          double intr = w * (a_St - a_K);
+          res.m_px    = std::max(intr, 0.0);
+          res.m_delta = (intr > 0.0) ? w : 0.0;
+          res.m_gamma = 0.0;
+          res.m_vega  = 0.0;
+          res.m_theta = 0.0;
+          res.m_rho   = 0.0;
+          return res;
+        }
+        return BachelierGreeks<CDF>(false, w, a_K, tau, a_r, a_sigma, a_St);
+      }
       default:
-        throw std::logic_error("Unsupported PayoffType");
+        throw std::invalid_argument("Invalid PxModel");
     }
-    // Use assert to enforce (in the debug model only) logically-invariant
-    // conditions:
-    assert(px > 0.0);
-    return px;
   }
 
+  //-------------------------------------------------------------------------//
+  // Explicit Instantiations:                                                //
+  //-------------------------------------------------------------------------//
+# define BSM_INSTANTIATE(CDF)                                                  \
+  template double Px<CDF>                                                      \
+    (PayoffType, double, double, double, double, double, double, double);      \
+  template PxRes  PxNoThrow<CDF>                                               \
+    (PayoffType, double, double, double, double, double, double, double)       \
+    noexcept;                                                                  \
+  template Greeks PxGreeks<CDF>                                                \
+    (PayoffType, double, double, double, double, double, double, double);      \
+  template double Px<CDF>                                                      \
+    (PxModel, PayoffType, double, double, double, double, double, double,      \
+     double);                                                                  \
+  template Greeks PxGreeks<CDF>                                                \
+    (PxModel, PayoffType, double, double, double, double, double, double,      \
+     double);
+
+  BSM_INSTANTIATE(CDFErf)
+  BSM_INSTANTIATE(CDFCody)
+  BSM_INSTANTIATE(CDFFast)
+# undef BSM_INSTANTIATE
+
 // PUT-CALL PARITY:
 // Call: max(S_T - K, 0)
 // Put : max(K - S_T, 0)
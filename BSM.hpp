@@ -0,0 +1,148 @@
+// vim:ts=2:et
+//===========================================================================//
+//                                  "BSM.hpp":                               //
+//      Implementation of the "Px" Templates Specialised by PayoffType       //
+//===========================================================================//
+#pragma once
+
+#include "BSM.h"
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+#include <cassert>
+
+namespace BSM
+{
+  //=========================================================================//
+  // "PxCore<PayoffType>":                                                   //
+  //=========================================================================//
+  // The closed-forms,  WITHOUT any arg checks (so "a_tau" must be >= 0, and
+  // "a_K", "a_sigma", "a_St" > 0). Each PayoffType gets its own closed-form
+  // (selected at compile time), so there is no switch and no recursion; when
+  // called in a loop over a chain of a single PayoffType, the body is inlined
+  // as straight-line code.
+  // "Real" is "double", or "AAD::ADouble" for the Greeks by AAD (see "AAD.h":
+  // then "exp", "log", "sqrt" and "CDFPhi" are found by ADL):
+  //
+  template<PayoffType PT, typename CDF, typename Real = double>
+  inline Real PxCore
+  (
+    Real a_K,     // Option Strike
+    Real a_tau,   // Time to Expiration
+    Real a_r,     // Risk-Free Interest Rate (for the Numeraire Ccy)
+    Real a_D,     // Dividend Rate (Risk-Free Ineterst Rate for Foreign Ccy)
+    Real a_sigma, // Implied Volatility
+    Real a_St     // Underlying Px
+  )
+  noexcept(std::is_floating_point_v<Real>)
+  {
+    static_assert(PT == PayoffType::Call        || PT == PayoffType::Put ||
+                  PT == PayoffType::DigitalCall || PT == PayoffType::DigitalPut,
+                  "Px<PayoffType>: Unsupported PayoffType");
+
+    if (a_tau == 0.0)
+    {
+      // At expiration time, return the PayOff:
+      if constexpr (PT == PayoffType::Call)
+        return std::max(a_St - a_K, Real(0.0));
+      else
+      if constexpr (PT == PayoffType::Put)
+        return std::max(a_K - a_St, Real(0.0));
+      else
+      if constexpr (PT == PayoffType::DigitalCall)
+        return Real((a_St > a_K) ? 1.0 : 0.0);
+      else
+        return Real((a_St < a_K) ? 1.0 : 0.0);
+    }
+
+    Real x  = log(a_St / a_K);
+    Real s  = a_sigma * sqrt(a_tau);
+    Real d1 = (x + (a_r - a_D) * a_tau) / s + 0.5 * s;
+    Real d2 = d1 - s;
+    Real KD = exp(-a_r * a_tau); // Discount Factor (not yet multiplied by K)
+    Real px;
+
+    if constexpr (PT == PayoffType::Call)
+      px = a_St * exp(-a_D * a_tau) * CDFPhi<CDF>(d1) -
+           a_K  * KD * CDFPhi<CDF>(d2);
+    else
+    if constexpr (PT == PayoffType::Put)
+      px = a_K  * KD * CDFPhi<CDF>(-d2) -
+           a_St * exp(-a_D * a_tau) * CDFPhi<CDF>(-d1);
+    else
+    // The Digitals are Cash-or-Nothing, paying 1 unit of the Numeraire Ccy:
+    if constexpr (PT == PayoffType::DigitalCall)
+      px = KD * CDFPhi<CDF>(d2);
+    else
+      px = KD * CDFPhi<CDF>(-d2);
+
+    // Deep out-of-the-money, the difference of 2 tiny terms may come out as
+    // a tiny negative number due to rounding:
+    px = std::max(px, Real(0.0));
+
+    // Use assert to enforce (in the debug model only) logically-invariant
+    // conditions:
+    assert(px >= 0.0);
+    return px;
+  }
+
+  //=========================================================================//
+  // "Px<PayoffType>":                                                       //
+  //=========================================================================//
+  template<PayoffType PT, typename CDF>
+  inline double Px
+  (
+    // Option Spec:
+    double a_K,     // Option Strike
+    double a_T,     // Opton Expiration Time, as Year Fraction
+    // Market Data:
+    double a_r,     // Risk-Free Interest Rate (for the Numeraire Ccy)
+    double a_D,     // Dividend Rate (Risk-Free Ineterst Rate for Foreign Ccy)
+    double a_sigma, // Implied Volatility
+    // "Quick" variables:
+    double a_t,     // Pricing Time (as Year Fraction)
+    double a_St     // Underlying Px at Time "a_t"
+  )
+  {
+    // Time to expiration:
+    double tau = a_T - a_t;
+
+    if (tau <  0.0)
+      throw std::invalid_argument("Negative Time to Expiration");
+
+    if (a_K <= 0.0 || a_St <= 0.0 || a_sigma <= 0.0)
+      throw std::invalid_argument
+            ("Non-Positive Strike / UnderlyingPx / Vol");
+
+    return PxCore<PT, CDF>(a_K, tau, a_r, a_D, a_sigma, a_St);
+  }
+
+  //=========================================================================//
+  // "PxNoThrow<PayoffType>":                                                //
+  //=========================================================================//
+  template<PayoffType PT, typename CDF>
+  inline PxRes PxNoThrow
+  (
+    double a_K,
+    double a_T,
+    double a_r,
+    double a_D,
+    double a_sigma,
+    double a_t,
+    double a_St
+  )
+  noexcept
+  {
+    double tau = a_T - a_t;
+
+    // NB: The conditions are written so that NaNs are caught as well:
+    if (!(tau >= 0.0))
+      return PxRes{NAN, PxErr::NegativeTau};
+
+    if (!(a_K > 0.0 && a_St > 0.0 && a_sigma > 0.0))
+      return PxRes{NAN, PxErr::NonPositiveArgs};
+
+    return PxRes{PxCore<PT, CDF>(a_K, tau, a_r, a_D, a_sigma, a_St), PxErr::OK};
+  }
+}
+// End namespace BSM
@@ -0,0 +1,717 @@
+// vim:ts=2:et
+//===========================================================================//
+//                               "BSMBatch.cpp":                             //
+//        Black-Scholes-Merton Option Pricing: Vectorised Batch Kernels      //
+//===========================================================================//
+#include "BSM.h"
+#include "FastMath.hpp"
+#include <stdexcept>
+#include <cstdint>
+
+namespace BSM
+{
+  namespace
+  {
+    //-----------------------------------------------------------------------//
+    // "CheckBatchArgs":                                                     //
+    //-----------------------------------------------------------------------//
+    // Same checks and msgs as in the scalar "Px":
+    //
+    template<typename Real>
+    void CheckBatchArgs
+    (
+      size_t      a_n,
+      Real const* a_K,
+      Real const* a_T,
+      Real const* a_sigma,
+      Real        a_t,
+      Real const* a_St,
+      bool        a_normal = false  // Bachelier: K and F are not checked
+    )
+    {
+      for (size_t i = 0; i < a_n; ++i)
+      {
+        if (a_T[i] - a_t < 0.0)
+          throw std::invalid_argument("Negative Time to Expiration");
+
+        if (a_normal)
+        {
+          if (!(a_sigma[i] > 0.0))
+            throw std::invalid_argument("Non-Positive Vol");
+        }
+        else if (a_K[i] <= 0.0 || a_St[i] <= 0.0 || a_sigma[i] <= 0.0)
+          throw std::invalid_argument
+                ("Non-Positive Strike / UnderlyingPx / Vol");
+      }
+    }
+
+    //-----------------------------------------------------------------------//
+    // "PxElem": Px of a Single Option (to be inlined into the Kernels):     //
+    //-----------------------------------------------------------------------//
+    // No arg checks here. With w = +1 for Calls and -1 for Puts,
+    //   Px = w * (S * exp(-D*tau) * Phi(w*d1) - K * exp(-r*tau) * Phi(w*d2)),
+    // and for the (Cash-or-Nothing) Digitals, Px = exp(-r*tau) * Phi(w*d2).
+    // "Real" is "double" or "float" (then all arithmetic is in "float"):
+    //
+    template<PayoffType PT, typename CDF, typename Real = double>
+    FASTMATH_INLINE Real PxElem
+    (
+      Real a_K,
+      Real a_tau,
+      Real a_r,
+      Real a_D,
+      Real a_sigma,
+      Real a_St
+    )
+    {
+      constexpr Real w =
+        (PT == PayoffType::Call || PT == PayoffType::DigitalCall)
+        ? Real(1) : Real(-1);
+      constexpr Real Zero = Real(0);
+
+      Real s      = a_sigma * std::sqrt(a_tau);
+      Real x      = FastMath::Log(a_St / a_K);
+      Real d1     = (x + (a_r - a_D) * a_tau) / s + Real(0.5) * s;
+      Real d2     = d1 - s;
+      Real DF     = FastMath::Exp(-a_r * a_tau);
+      Real intr   = w * (a_St - a_K);
+      Real px     = NAN;
+      Real payOff = NAN;
+
+      if constexpr (PT == PayoffType::Call || PT == PayoffType::Put)
+      {
+        Real SD = a_St * FastMath::Exp(-a_D * a_tau);
+        px      = w * (SD * CDF::Phi(w * d1) - a_K * DF * CDF::Phi(w * d2));
+        payOff  = (intr > Zero) ? intr    : Zero;
+      }
+      else
+      {
+        px      = DF * CDF::Phi(w * d2);
+        payOff  = (intr > Zero) ? Real(1) : Zero;
+      }
+      // At expiration time, return the PayOff (the above is NaN then):
+      return (a_tau > Zero) ? px : payOff;
+    }
+
+    //-----------------------------------------------------------------------//
+    // "PxElemBachelier": As "PxElem", but in the Normal Model:              //
+    //-----------------------------------------------------------------------//
+    // With v = sigma * sqrt(tau) and d = (F - K) / v,
+    //   Px = exp(-r*tau) * (w * (F - K) * Phi(w*d) + v * pdf(d)),
+    // and for the Digitals, Px = exp(-r*tau) * Phi(w*d):
+    //
+    template<PayoffType PT, typename CDF>
+    FASTMATH_INLINE double PxElemBachelier
+    (
+      double a_K,
+      double a_tau,
+      double a_r,
+      double a_sigma,
+      double a_F
+    )
+    {
+      constexpr double w =
+        (PT == PayoffType::Call || PT == PayoffType::DigitalCall) ? 1.0 : -1.0;
+
+      double v      = a_sigma * std::sqrt(a_tau);
+      double d      = (a_F - a_K) / v;
+      double DF     = FastMath::Exp(-a_r * a_tau);
+      double intr   = w * (a_F - a_K);
+      double px     = NAN;
+      double payOff = NAN;
+
+      if constexpr (PT == PayoffType::Call || PT == PayoffType::Put)
+      {
+        px     = DF * (intr * CDF::Phi(w * d) + v * CDF::NormPDF(d));
+        payOff = (intr > 0.0) ? intr : 0.0;
+      }
+      else
+      {
+        px     = DF * CDF::Phi(w * d);
+        payOff = (intr > 0.0) ? 1.0  : 0.0;
+      }
+      return (a_tau > 0.0) ? px : payOff;
+    }
+
+    //-----------------------------------------------------------------------//
+    // "ModelPxElem": "PxElem" for any "PxModel":                            //
+    //-----------------------------------------------------------------------//
+    // (Bachelier is for "double" only):
+    //
+    template<PxModel M, PayoffType PT, typename CDF, typename Real = double>
+    FASTMATH_INLINE Real ModelPxElem
+    (
+      Real a_K,
+      Real a_tau,
+      Real a_r,
+      Real a_D,
+      Real a_sigma,
+      Real a_St
+    )
+    {
+      if constexpr (M == PxModel::Bachelier)
+        return PxElemBachelier<PT, CDF>(a_K, a_tau, a_r, a_sigma, a_St);
+      else
+        return PxElem<PT, CDF, Real>
+          (a_K, a_tau, a_r, (M == PxModel::Black76) ? a_r : a_D, a_sigma,
+           a_St);
+    }
+
+    //-----------------------------------------------------------------------//
+    // "PxBatchKernel":                                                      //
+    //-----------------------------------------------------------------------//
+    template<PayoffType PT, typename CDF, PxModel M = PxModel::BSM,
+             typename Real = double>
+    FASTMATH_SIMD_KERNEL
+    void PxBatchKernel
+    (
+      size_t                 a_n,
+      Real const* __restrict a_K,
+      Real const* __restrict a_T,
+      Real                   a_r,
+      Real                   a_D,
+      Real const* __restrict a_sigma,
+      Real                   a_t,
+      Real const* __restrict a_St,
+      Real*       __restrict a_px
+    )
+    {
+#     pragma omp simd
+      for (size_t i = 0; i < a_n; ++i)
+        a_px[i] = ModelPxElem<M, PT, CDF, Real>
+                  (a_K[i], a_T[i] - a_t, a_r, a_D, a_sigma[i], a_St[i]);
+    }
+
+    //-----------------------------------------------------------------------//
+    // "PxBatchNoThrowKernel":                                               //
+    //-----------------------------------------------------------------------//
+    // All Pxs are computed first (invalid args just produce garbage, as there
+    // are no FP traps), then the args are checked per element (branch-free),
+    // and the Pxs of invalid ones are replaced by NaNs.  Returns the number of
+    // invalid elements.
+    // NB: Doing the checks within the pricing loop prevents its vectorisation
+    // (the compiler then moves the pricing under a branch):
+    //
+    template<PayoffType PT, typename CDF>
+    FASTMATH_SIMD_KERNEL
+    size_t PxBatchNoThrowKernel
+    (
+      size_t                 a_n,
+      double const* __restrict a_K,
+      double const* __restrict a_T,
+      double                 a_r,
+      double                 a_D,
+      double const* __restrict a_sigma,
+      double                 a_t,
+      double const* __restrict a_St,
+      double*       __restrict a_px,
+      uint8_t*      __restrict a_status
+    )
+    {
+      PxBatchKernel<PT, CDF>(a_n, a_K, a_T, a_r, a_D, a_sigma, a_t, a_St, a_px);
+
+      size_t nErrs = 0;
+#     pragma omp simd reduction(+: nErrs)
+      for (size_t i = 0; i < a_n; ++i)
+      {
+        // NB: The conditions are written so that NaNs are caught as well; "&"
+        // rather than "&&" avoids branches:
+        uint8_t err =
+          !(a_T[i] - a_t >= 0.0)
+          ? uint8_t(PxErr::NegativeTau)
+          : !((a_K[i] > 0.0) & (a_St[i] > 0.0) & (a_sigma[i] > 0.0))
+            ? uint8_t(PxErr::NonPositiveArgs)
+            : uint8_t(PxErr::OK);
+        a_status[i] = err;
+        a_px    [i] = (err == 0) ? a_px[i] : NAN;
+        nErrs      += (err != 0);
+      }
+      return nErrs;
+    }
+
+    //-----------------------------------------------------------------------//
+    // "PxGreeksBatchKernel":                                                //
+    //-----------------------------------------------------------------------//
+    // For Calls and Puts only;  "a_w" is as in "PxElem", and the Greeks for-
+    // mulas are the same as in "PxGreeks". For Black76, D = r and Rho is -tau
+    // * Px. "Real" is as in "PxElem":
+    //
+    template<typename CDF, PxModel M = PxModel::BSM, typename Real = double>
+    FASTMATH_SIMD_KERNEL
+    void PxGreeksBatchKernel
+    (
+      Real                   a_w,
+      size_t                 a_n,
+      Real const* __restrict a_K,
+      Real const* __restrict a_T,
+      Real                   a_r,
+      Real                   a_D,
+      Real const* __restrict a_sigma,
+      Real                   a_t,
+      Real const* __restrict a_St,
+      Real*       __restrict a_px,
+      Real*       __restrict a_delta,
+      Real*       __restrict a_gamma,
+      Real*       __restrict a_vega,
+      Real*       __restrict a_theta,
+      Real*       __restrict a_rho
+    )
+    {
+      static_assert(M == PxModel::BSM || M == PxModel::Black76);
+      constexpr Real Zero = Real(0);
+      Real D  = (M == PxModel::Black76) ? a_r : a_D;
+      Real rD = a_r - D;
+
+#     pragma omp simd
+      for (size_t i = 0; i < a_n; ++i)
+      {
+        Real K       = a_K[i];
+        Real St      = a_St[i];
+        Real sigma   = a_sigma[i];
+        Real tau     = a_T[i] - a_t;
+
+        Real sqrtTau = std::sqrt(tau);
+        Real s       = sigma * sqrtTau;
+        Real d1      = (FastMath::Log(St / K) + rD * tau) / s + Real(0.5) * s;
+        Real d2      = d1 - s;
+        Real DFD     = FastMath::Exp(-D * tau);
+        Real SD      = St * DFD;
+        Real KD      = K  * FastMath::Exp(-a_r * tau);
+        Real phi1    = CDF::Phi(a_w * d1);
+        Real phi2    = CDF::Phi(a_w * d2);
+        Real SDpdf   = SD * CDF::NormPDF(d1);
+
+        Real px      = a_w * (SD * phi1 - KD * phi2);
+        Real delta   = a_w * DFD * phi1;
+        Real gamma   = SDpdf / (St * St * s);
+        Real vega    = SDpdf * sqrtTau;
+        Real theta   = - Real(0.5) * SDpdf * sigma / sqrtTau
+                       + a_w * (D * SD * phi1 - a_r * KD * phi2);
+        Real rho     = (M == PxModel::Black76)
+                       ? - tau * px
+                       : a_w * tau * KD * phi2;
+
+        // At expiration time, the PayOff and its Delta:
+        bool live    = (tau > Zero);
+        Real intr    = a_w * (St - K);
+        bool itm     = (intr > Zero);
+        a_px   [i]   = live ? px    : (itm ? intr : Zero);
+        a_delta[i]   = live ? delta : (itm ? a_w  : Zero);
+        a_gamma[i]   = live ? gamma : Zero;
+        a_vega [i]   = live ? vega  : Zero;
+        a_theta[i]   = live ? theta : Zero;
+        a_rho  [i]   = live ? rho   : Zero;
+      }
+    }
+
+    //-----------------------------------------------------------------------//
+    // "PxGreeksBachelierKernel":                                            //
+    //-----------------------------------------------------------------------//
+    // As "PxGreeksBatchKernel", in the Normal Model (on the Fwd "a_F"):
+    //
+    template<typename CDF>
+    FASTMATH_SIMD_KERNEL
+    void PxGreeksBachelierKernel
+    (
+      double                 a_w,
+      size_t                 a_n,
+      double const* __restrict a_K,
+      double const* __restrict a_T,
+      double                 a_r,
+      double const* __restrict a_sigma,
+      double                 a_t,
+      double const* __restrict a_F,
+      double*       __restrict a_px,
+      double*       __restrict a_delta,
+      double*       __restrict a_gamma,
+      double*       __restrict a_vega,
+      double*       __restrict a_theta,
+      double*       __restrict a_rho
+    )
+    {
+#     pragma omp simd
+      for (size_t i = 0; i < a_n; ++i)
+      {
+        double K       = a_K[i];
+        double F       = a_F[i];
+        double sigma   = a_sigma[i];
+        double tau     = a_T[i] - a_t;
+
+        double sqrtTau = std::sqrt(tau);
+        double v       = sigma * sqrtTau;
+        double d       = (F - K) / v;
+        double DF      = FastMath::Exp(-a_r * tau);
+        double intr    = a_w * (F - K);
+        double phi     = CDF::Phi(a_w * d);
+        double DFpdf   = DF * CDF::NormPDF(d);
+
+        double px      = DF * intr * phi + DFpdf * v;
+        double delta   = a_w * DF * phi;
+        double gamma   = DFpdf / v;
+        double vega    = DFpdf * sqrtTau;
+        double theta   = a_r * px - 0.5 * DFpdf * sigma / sqrtTau;
+        double rho     = - tau * px;
+
+        bool   live    = (tau > 0.0);
+        bool   itm     = (intr > 0.0);
+        a_px   [i]     = live ? px    : (itm ? intr : 0.0);
+        a_delta[i]     = live ? delta : (itm ? a_w  : 0.0);
+        a_gamma[i]     = live ? gamma : 0.0;
+        a_vega [i]     = live ? vega  : 0.0;
+        a_theta[i]     = live ? theta : 0.0;
+        a_rho  [i]     = live ? rho   : 0.0;
+      }
+    }
+  }
+
+  //-------------------------------------------------------------------------//
+  // "PxBatch":                                                              //
+  //-------------------------------------------------------------------------//
+  template<typename CDF>
+  void PxBatch
+  (
+    // Option Specs:
+    PayoffType    a_type,
+    size_t        a_n,
+    double const* a_K,
+    double const* a_T,
+    // Market Data:
+    double        a_r,
+    double        a_D,
+    double const* a_sigma,
+    // "Quick" variables:
+    double        a_t,
+    double const* a_St,
+    // Output:
+    double*       a_px
+  )
+  {
+    CheckBatchArgs(a_n, a_K, a_T, a_sigma, a_t, a_St);
+
+    switch (a_type)
+    {
+#     define BSM_PX_BATCH_CASE(PT)                                             \
+      case PT:                                                                 \
+        PxBatchKernel<PT, CDF>                                                 \
+          (a_n, a_K, a_T, a_r, a_D, a_sigma, a_t, a_St, a_px);                 \
+        break;
+
+      BSM_PX_BATCH_CASE(PayoffType::Call)
+      BSM_PX_BATCH_CASE(PayoffType::Put)
+      BSM_PX_BATCH_CASE(PayoffType::DigitalCall)
+      BSM_PX_BATCH_CASE(PayoffType::DigitalPut)
+#     undef BSM_PX_BATCH_CASE
+
+      default:
+        throw std::logic_error("Unsupported PayoffType");
+    }
+  }
+
+  //-------------------------------------------------------------------------//
+  // "PxBatchNoThrow":                                                       //
+  //-------------------------------------------------------------------------//
+  template<typename CDF>
+  size_t PxBatchNoThrow
+  (
+    // Option Specs:
+    PayoffType    a_type,
+    size_t        a_n,
+    double const* a_K,
+    double const* a_T,
+    // Market Data:
+    double        a_r,
+    double        a_D,
+    double const* a_sigma,
+    // "Quick" variables:
+    double        a_t,
+    double const* a_St,
+    // Outputs:
+    double*       a_px,
+    PxErr*        a_status
+  )
+  noexcept
+  {
+    uint8_t* status = reinterpret_cast<uint8_t*>(a_status);
+    switch (a_type)
+    {
+#     define BSM_PX_BATCH_CASE(PT)                                             \
+      case PT:                                                                 \
+        return PxBatchNoThrowKernel<PT, CDF>                                   \
+               (a_n, a_K, a_T, a_r, a_D, a_sigma, a_t, a_St, a_px, status);
+
+      BSM_PX_BATCH_CASE(PayoffType::Call)
+      BSM_PX_BATCH_CASE(PayoffType::Put)
+      BSM_PX_BATCH_CASE(PayoffType::DigitalCall)
+      BSM_PX_BATCH_CASE(PayoffType::DigitalPut)
+#     undef BSM_PX_BATCH_CASE
+
+      default:
+        for (size_t i = 0; i < a_n; ++i)
+        {
+          a_px    [i] = NAN;
+          a_status[i] = PxErr::UnsupportedType;
+        }
+        return a_n;
+    }
+  }
+
+  //-------------------------------------------------------------------------//
+  // "PxGreeksBatch":                                                        //
+  //-------------------------------------------------------------------------//
+  template<typename CDF>
+  void PxGreeksBatch
+  (
+    // Option Specs:
+    PayoffType        a_type,
+    size_t            a_n,
+    double const*     a_K,
+    double const*     a_T,
+    // Market Data:
+    double            a_r,
+    double            a_D,
+    double const*     a_sigma,
+    // "Quick" variables:
+    double            a_t,
+    double const*     a_St,
+    // Output:
+    GreeksArrs const& a_out
+  )
+  {
+    CheckBatchArgs(a_n, a_K, a_T, a_sigma, a_t, a_St);
+
+    double w = 0.0;
+    switch (a_type)
+    {
+      case PayoffType::Call: w =  1.0; break;
+      case PayoffType::Put:  w = -1.0; break;
+      default:
+        throw std::logic_error("Unsupported PayoffType");
+    }
+    PxGreeksBatchKernel<CDF>
+      (w, a_n, a_K, a_T, a_r, a_D, a_sigma, a_t, a_St,
+       a_out.m_px,   a_out.m_delta, a_out.m_gamma,
+       a_out.m_vega, a_out.m_theta, a_out.m_rho);
+  }
+
+  //-------------------------------------------------------------------------//
+  // "PxBatch" with "PxModel":                                               //
+  //-------------------------------------------------------------------------//
+  template<typename CDF>
+  void PxBatch
+  (
+    PxModel       a_model,
+    PayoffType    a_type,
+    size_t        a_n,
+    double const* a_K,
+    double const* a_T,
+    double        a_r,
+    double        a_D,
+    double const* a_sigma,
+    double        a_t,
+    double const* a_St,
+    double*       a_px
+  )
+  {
+    switch (a_model)
+    {
+      case PxModel::BSM:
+        PxBatch<CDF>
+          (a_type, a_n, a_K, a_T, a_r, a_D, a_sigma, a_t, a_St, a_px);
+        return;
+
+      // Black-76 is BSM on the Fwd, with the Fwd "dividend" rate equal to "r":
+      case PxModel::Black76:
+        PxBatch<CDF>
+          (a_type, a_n, a_K, a_T, a_r, a_r, a_sigma, a_t, a_St, a_px);
+        return;
+
+      case PxModel::Bachelier:
+        break;
+
+      default:
+        throw std::invalid_argument("Invalid PxModel");
+    }
+
+    CheckBatchArgs(a_n, a_K, a_T, a_sigma, a_t, a_St, true);
+
+    switch (a_type)
+    {
+#     define BSM_PX_BATCH_CASE(PT)                                             \
+      case PT:                                                                 \
+        PxBatchKernel<PT, CDF, PxModel::Bachelier>                             \
+          (a_n, a_K, a_T, a_r, a_D, a_sigma, a_t, a_St, a_px);                 \
+        break;
+
+      BSM_PX_BATCH_CASE(PayoffType::Call)
+      BSM_PX_BATCH_CASE(PayoffType::Put)
+      BSM_PX_BATCH_CASE(PayoffType::DigitalCall)
+      BSM_PX_BATCH_CASE(PayoffType::DigitalPut)
+#     undef BSM_PX_BATCH_CASE
+
+      default:
+        throw std::logic_error("Unsupported PayoffType");
+    }
+  }
+
+  //-------------------------------------------------------------------------//
+  // "PxGreeksBatch" with "PxModel":                                         //
+  //-------------------------------------------------------------------------//
+  template<typename CDF>
+  void PxGreeksBatch
+  (
+    PxModel           a_model,
+    PayoffType        a_type,
+    size_t            a_n,
+    double const*     a_K,
+    double const*     a_T,
+    double            a_r,
+    double            a_D,
+    double const*     a_sigma,
+    double            a_t,
+    double const*     a_St,
+    GreeksArrs const& a_out
+  )
+  {
+    if (a_model != PxModel::BSM && a_model != PxModel::Black76 &&
+        a_model != PxModel::Bachelier)
+      throw std::invalid_argument("Invalid PxModel");
+
+    bool normal = (a_model == PxModel::Bachelier);
+    CheckBatchArgs(a_n, a_K, a_T, a_sigma, a_t, a_St, normal);
+
+    double w = 0.0;
+    switch (a_type)
+    {
+      case PayoffType::Call: w =  1.0; break;
+      case PayoffType::Put:  w = -1.0; break;
+      default:
+        throw std::logic_error("Unsupported PayoffType");
+    }
+    switch (a_model)
+    {
+      case PxModel::BSM:
+        PxGreeksBatchKernel<CDF, PxModel::BSM>
+          (w, a_n, a_K, a_T, a_r, a_D, a_sigma, a_t, a_St,
+           a_out.m_px,   a_out.m_delta, a_out.m_gamma,
+           a_out.m_vega, a_out.m_theta, a_out.m_rho);
+        break;
+
+      case PxModel::Black76:
+        PxGreeksBatchKernel<CDF, PxModel::Black76>
+          (w, a_n, a_K, a_T, a_r, a_D, a_sigma, a_t, a_St,
+           a_out.m_px,   a_out.m_delta, a_out.m_gamma,
+           a_out.m_vega, a_out.m_theta, a_out.m_rho);
+        break;
+
+      default:
+        PxGreeksBachelierKernel<CDF>
+          (w, a_n, a_K, a_T, a_r, a_sigma, a_t, a_St,
+           a_out.m_px,   a_out.m_delta, a_out.m_gamma,
+           a_out.m_vega, a_out.m_theta, a_out.m_rho);
+    }
+  }
+
+  //-------------------------------------------------------------------------//
+  // "PxBatch" in Single Precision:                                          //
+  //-------------------------------------------------------------------------//
+  template<typename CDF>
+  void PxBatch
+  (
+    PayoffType   a_type,
+    size_t       a_n,
+    float const* a_K,
+    float const* a_T,
+    float        a_r,
+    float        a_D,
+    float const* a_sigma,
+    float        a_t,
+    float const* a_St,
+    float*       a_px
+  )
+  {
+    CheckBatchArgs(a_n, a_K, a_T, a_sigma, a_t, a_St);
+
+    switch (a_type)
+    {
+#     define BSM_PX_BATCH_CASE(PT)                                             \
+      case PT:                                                                 \
+        PxBatchKernel<PT, CDF, PxModel::BSM, float>                            \
+          (a_n, a_K, a_T, a_r, a_D, a_sigma, a_t, a_St, a_px);                 \
+        break;
+
+      BSM_PX_BATCH_CASE(PayoffType::Call)
+      BSM_PX_BATCH_CASE(PayoffType::Put)
+      BSM_PX_BATCH_CASE(PayoffType::DigitalCall)
+      BSM_PX_BATCH_CASE(PayoffType::DigitalPut)
+#     undef BSM_PX_BATCH_CASE
+
+      default:
+        throw std::logic_error("Unsupported PayoffType");
+    }
+  }
+
+  //-------------------------------------------------------------------------//
+  // "PxGreeksBatch" in Single Precision:                                    //
+  //-------------------------------------------------------------------------//
+  template<typename CDF>
+  void PxGreeksBatch
+  (
+    PayoffType         a_type,
+    size_t             a_n,
+    float const*       a_K,
+    float const*       a_T,
+    float              a_r,
+    float              a_D,
+    float const*       a_sigma,
+    float              a_t,
+    float const*       a_St,
+    GreeksArrsF const& a_out
+  )
+  {
+    CheckBatchArgs(a_n, a_K, a_T, a_sigma, a_t, a_St);
+
+    float w = 0.0f;
+    switch (a_type)
+    {
+      case PayoffType::Call: w =  1.0f; break;
+      case PayoffType::Put:  w = -1.0f; break;
+      default:
+        throw std::logic_error("Unsupported PayoffType");
+    }
+    PxGreeksBatchKernel<CDF, PxModel::BSM, float>
+      (w, a_n, a_K, a_T, a_r, a_D, a_sigma, a_t, a_St,
+       a_out.m_px,   a_out.m_delta, a_out.m_gamma,
+       a_out.m_vega, a_out.m_theta, a_out.m_rho);
+  }
+
+  //-------------------------------------------------------------------------//
+  // Explicit Instantiations:                                                //
+  //-------------------------------------------------------------------------//
+# define BSM_INSTANTIATE(CDF)                                                  \
+  template void PxBatch<CDF>                                                   \
+    (PayoffType, size_t, double const*, double const*, double, double,         \
+     double const*, double, double const*, double*);                           \
+  template size_t PxBatchNoThrow<CDF>                                          \
+    (PayoffType, size_t, double const*, double const*, double, double,         \
+     double const*, double, double const*, double*, PxErr*) noexcept;          \
+  template void PxGreeksBatch<CDF>                                             \
+    (PayoffType, size_t, double const*, double const*, double, double,         \
+     double const*, double, double const*, GreeksArrs const&);                 \
+  template void PxBatch<CDF>                                                   \
+    (PxModel, PayoffType, size_t, double const*, double const*, double,        \
+     double, double const*, double, double const*, double*);                   \
+  template void PxGreeksBatch<CDF>                                             \
+    (PxModel, PayoffType, size_t, double const*, double const*, double,        \
+     double, double const*, double, double const*, GreeksArrs const&);         \
+  template void PxBatch<CDF>                                                   \
+    (PayoffType, size_t, float const*, float const*, float, float,             \
+     float const*, float, float const*, float*);                               \
+  template void PxGreeksBatch<CDF>                                             \
+    (PayoffType, size_t, float const*, float const*, float, float,             \
+     float const*, float, float const*, GreeksArrsF const&);
+
+  BSM_INSTANTIATE(CDFErf)
+  BSM_INSTANTIATE(CDFCody)
+  BSM_INSTANTIATE(CDFFast)
+# undef BSM_INSTANTIATE
+}
@@ -0,0 +1,547 @@
+// vim:ts=2:et
+//===========================================================================//
+//                             "Calibration.cpp":                            //
+//        Levenberg-Marquardt Calibration of Model Params to Option Chains   //
+//===========================================================================//
+#include "Calibration.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+
+namespace BSM
+{
+  namespace
+  {
+    //-----------------------------------------------------------------------//
+    // "CholSolve": Solves M x = b for a (small) Symmetric Pos-Def M:        //
+    //-----------------------------------------------------------------------//
+    // "a_M" (row-major, [n x n]) is overwritten by the Cholesky factor.
+    // Returns "false" if "a_M" is not (numerically) positive-definite:
+    //
+    bool CholSolve
+    (
+      size_t        a_n,
+      double*       a_M,
+      double const* a_b,
+      double*       a_x
+    )
+    {
+      for (size_t j = 0; j < a_n; ++j)
+      {
+        double d = a_M[j * a_n + j];
+        for (size_t k = 0; k < j; ++k)
+          d -= a_M[j * a_n + k] * a_M[j * a_n + k];
+        if (!(d > 0.0))
+          return false;
+        d = std::sqrt(d);
+        a_M[j * a_n + j] = d;
+
+        for (size_t i = j + 1; i < a_n; ++i)
+        {
+          double s = a_M[i * a_n + j];
+          for (size_t k = 0; k < j; ++k)
+            s -= a_M[i * a_n + k] * a_M[j * a_n + k];
+          a_M[i * a_n + j] = s / d;
+        }
+      }
+      // Forward (L y = b) and backward (L^T x = y) substitutions:
+      for (size_t i = 0; i < a_n; ++i)
+      {
+        double s = a_b[i];
+        for (size_t k = 0; k < i; ++k)
+          s -= a_M[i * a_n + k] * a_x[k];
+        a_x[i] = s / a_M[i * a_n + i];
+      }
+      for (size_t i = a_n; i-- > 0; )
+      {
+        double s = a_x[i];
+        for (size_t k = i + 1; k < a_n; ++k)
+          s -= a_M[k * a_n + i] * a_x[k];
+        a_x[i] = s / a_M[i * a_n + i];
+      }
+      return true;
+    }
+
+    //-----------------------------------------------------------------------//
+    // "NormalEqs": A = J^T J, g = J^T r:                                    //
+    //-----------------------------------------------------------------------//
+    void NormalEqs
+    (
+      size_t        a_n,
+      size_t        a_m,
+      double const* a_J,
+      double const* a_r,
+      double*       a_A,
+      double*       a_g
+    )
+    {
+      std::fill_n(a_A, a_n * a_n, 0.0);
+      std::fill_n(a_g, a_n,       0.0);
+      for (size_t k = 0; k < a_m; ++k)
+      {
+        double const* row = a_J + k * a_n;
+        for (size_t i = 0; i < a_n; ++i)
+        {
+          a_g[i] += row[i] * a_r[k];
+          for (size_t j = 0; j <= i; ++j)
+            a_A[i * a_n + j] += row[i] * row[j];
+        }
+      }
+      for (size_t i = 0; i < a_n; ++i)
+        for (size_t j = 0; j < i; ++j)
+          a_A[j * a_n + i] = a_A[i * a_n + j];
+    }
+
+    double SumSq(size_t a_m, double const* a_r)
+    {
+      double s = 0.0;
+      for (size_t k = 0; k < a_m; ++k)
+        s += a_r[k] * a_r[k];
+      return s;
+    }
+  }
+
+  //=========================================================================//
+  // "LevenbergMarquardt":                                                   //
+  //=========================================================================//
+  LMRes LevenbergMarquardt
+  (
+    size_t             a_n,
+    size_t             a_m,
+    double*            a_x,
+    double const*      a_lo,
+    double const*      a_hi,
+    LMResidFunc const& a_resid,
+    LMJacFunc   const& a_jac,
+    LMParams    const& a_params
+  )
+  {
+    if (a_n == 0 || a_m < a_n)
+      throw std::invalid_argument("LevenbergMarquardt: Invalid Dimensions");
+
+    for (size_t i = 0; i < a_n; ++i)
+      if (!(a_lo[i] <= a_x[i] && a_x[i] <= a_hi[i]))
+        throw std::invalid_argument
+              ("LevenbergMarquardt: Initial Guess Outside the Bounds");
+
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point start = Clock::now();
+
+    std::vector<double> r   (a_m);
+    std::vector<double> rNew(a_m);
+    std::vector<double> J   (a_m * a_n);
+    std::vector<double> A   (a_n * a_n);
+    std::vector<double> M   (a_n * a_n);
+    std::vector<double> g   (a_n);
+    std::vector<double> mg  (a_n);
+    std::vector<double> h   (a_n);
+    std::vector<double> xNew(a_n);
+
+    LMRes res;
+    a_resid(a_x, r.data());
+    a_jac  (a_x, r.data(), J.data());
+    res.m_nEvals = 1;
+    res.m_nJacs  = 1;
+
+    // Here and below, the cost is f = 1/2 |r|^2:
+    double tolR   = a_params.m_tolRMSE;
+    double f      = 0.5 * SumSq(a_m, r.data());
+    double fStop  = 0.5 * double(a_m) * tolR * tolR;
+    NormalEqs(a_n, a_m, J.data(), r.data(), A.data(), g.data());
+
+    double maxDiag = 0.0;
+    for (size_t i = 0; i < a_n; ++i)
+      maxDiag = std::max(maxDiag, A[i * a_n + i]);
+    double mu = a_params.m_mu0 * maxDiag;
+    double nu = 2.0;
+
+    while (true)
+    {
+      //---------------------------------------------------------------------//
+      // Stopping criteria at the current point:                             //
+      //---------------------------------------------------------------------//
+      if (f <= fStop)
+      {
+        res.m_stop = LMStop::Residual;
+        break;
+      }
+      // The gradient components pushing "x" out of the box do not count:
+      double gMax = 0.0;
+      for (size_t i = 0; i < a_n; ++i)
+      {
+        bool blocked = (g[i] > 0.0 && a_x[i] <= a_lo[i]) ||
+                       (g[i] < 0.0 && a_x[i] >= a_hi[i]);
+        if (!blocked)
+          gMax = std::max(gMax, std::fabs(g[i]));
+      }
+      if (gMax <= a_params.m_tolG)
+      {
+        res.m_stop = LMStop::Gradient;
+        break;
+      }
+      if (res.m_nIter >= a_params.m_maxIter)
+      {
+        res.m_stop = LMStop::MaxIter;
+        break;
+      }
+      ++res.m_nIter;
+
+      //---------------------------------------------------------------------//
+      // The damped step, projected onto the box:                            //
+      //---------------------------------------------------------------------//
+      // (A + mu diag(A)) h = -g; the diag is floored so that the params the
+      // residuals do not depend on (locally) still get damped:
+      M = A;
+      for (size_t i = 0; i < a_n; ++i)
+      {
+        M[i * a_n + i] += mu * std::max(A[i * a_n + i], 1e-12 * maxDiag);
+        mg[i] = -g[i];
+      }
+      if (!CholSolve(a_n, M.data(), mg.data(), h.data()))
+      {
+        mu *= nu;
+        nu *= 2.0;
+        continue;
+      }
+      double hNorm = 0.0;
+      double xNorm = 0.0;
+      for (size_t i = 0; i < a_n; ++i)
+      {
+        xNew[i] = std::clamp(a_x[i] + h[i], a_lo[i], a_hi[i]);
+        h[i]    = xNew[i] - a_x[i];
+        hNorm  += h[i]    * h[i];
+        xNorm  += a_x[i]  * a_x[i];
+      }
+      hNorm = std::sqrt(hNorm);
+      xNorm = std::sqrt(xNorm);
+      if (hNorm <= a_params.m_tolX * (xNorm + a_params.m_tolX))
+      {
+        res.m_stop = LMStop::Step;
+        break;
+      }
+
+      //---------------------------------------------------------------------//
+      // Actual vs predicted (by the linear model of r) reduction:           //
+      //---------------------------------------------------------------------//
+      a_resid(xNew.data(), rNew.data());
+      ++res.m_nEvals;
+      double fNew = 0.5 * SumSq(a_m, rNew.data());
+
+      // f - 1/2 |r + J h|^2 = -g^T h - 1/2 h^T A h:
+      double pred = 0.0;
+      for (size_t i = 0; i < a_n; ++i)
+      {
+        double Ah = 0.0;
+        for (size_t j = 0; j < a_n; ++j)
+          Ah += A[i * a_n + j] * h[j];
+        pred -= h[i] * (g[i] + 0.5 * Ah);
+      }
+      double rho = (pred > 0.0) ? (f - fNew) / pred : -1.0;
+
+      if (rho > 0.0 && std::isfinite(fNew))
+      {
+        std::copy(xNew.begin(), xNew.end(), a_x);
+        r.swap(rNew);
+        bool flat = (f - fNew <= a_params.m_tolF * f);
+        f = fNew;
+        if (flat)
+        {
+          res.m_stop = LMStop::Cost;
+          break;
+        }
+        a_jac(a_x, r.data(), J.data());
+        ++res.m_nJacs;
+        NormalEqs(a_n, a_m, J.data(), r.data(), A.data(), g.data());
+
+        maxDiag = 0.0;
+        for (size_t i = 0; i < a_n; ++i)
+          maxDiag = std::max(maxDiag, A[i * a_n + i]);
+
+        double q = 2.0 * rho - 1.0;
+        mu *= std::max(1.0 / 3.0, 1.0 - q * q * q);
+        nu  = 2.0;
+      }
+      else
+      {
+        mu *= nu;
+        nu *= 2.0;
+      }
+    }
+    res.m_rmse = std::sqrt(2.0 * f / double(a_m));
+    res.m_time = std::chrono::duration<double>(Clock::now() - start).count();
+    return res;
+  }
+
+  namespace
+  {
+    HestonParams ToParams(double const* a_x)
+    {
+      HestonParams p;
+      p.m_v0    = a_x[0];
+      p.m_kappa = a_x[1];
+      p.m_theta = a_x[2];
+      p.m_xi    = a_x[3];
+      p.m_rho   = a_x[4];
+      return p;
+    }
+
+    void FromParams(HestonParams const& a_p, double* a_x)
+    {
+      a_x[0] = a_p.m_v0;
+      a_x[1] = a_p.m_kappa;
+      a_x[2] = a_p.m_theta;
+      a_x[3] = a_p.m_xi;
+      a_x[4] = a_p.m_rho;
+    }
+  }
+
+  //=========================================================================//
+  // "HestonCalibrator" Non-Default Ctor:                                    //
+  //=========================================================================//
+  HestonCalibrator::HestonCalibrator(ThreadPool* a_pool)
+  : m_pool  (a_pool),
+    m_lo    { 1e-4, 1e-3, 1e-4, 1e-3, -0.999 },
+    m_hi    { 4.0,  20.0, 4.0,  5.0,   0.999 },
+    m_params(),
+    m_warm  (false),
+    m_slices(),
+    m_resIdx()
+  {}
+
+  //=========================================================================//
+  // "HestonCalibrator::SetBounds":                                          //
+  //=========================================================================//
+  void HestonCalibrator::SetBounds
+    (HestonParams const& a_lo, HestonParams const& a_hi)
+  {
+    double lo[NParams];
+    double hi[NParams];
+    FromParams(a_lo, lo);
+    FromParams(a_hi, hi);
+
+    // The bounds must be within the domain of the Heston model:
+    if (!(lo[0] >= 0.0 && lo[1] > 0.0 && lo[2] >= 0.0 && lo[3] > 0.0 &&
+          lo[4] >= -1.0 && hi[4] <= 1.0))
+      throw std::invalid_argument("Invalid Heston Params");
+
+    for (int i = 0; i < NParams; ++i)
+      if (!(lo[i] <= hi[i]))
+        throw std::invalid_argument("HestonCalibrator: Invalid Bounds");
+
+    std::copy(lo, lo + NParams, m_lo);
+    std::copy(hi, hi + NParams, m_hi);
+  }
+
+  //=========================================================================//
+  // "HestonCalibrator::SetParams":                                          //
+  //=========================================================================//
+  void HestonCalibrator::SetParams(HestonParams const& a_params)
+  {
+    double x[NParams];
+    FromParams(a_params, x);
+    for (int i = 0; i < NParams; ++i)
+      if (!(m_lo[i] <= x[i] && x[i] <= m_hi[i]))
+        throw std::invalid_argument("HestonCalibrator: Params Out of Bounds");
+    m_params = a_params;
+    m_warm   = true;
+  }
+
+  //=========================================================================//
+  // "HestonCalibrator::Resids":                                             //
+  //=========================================================================//
+  void HestonCalibrator::Resids
+  (
+    Slice&        a_slice,
+    size_t        a_cos,
+    double const* a_x,
+    double        a_r,
+    double        a_D,
+    double        a_t,
+    double        a_St,
+    double*       a_res
+  )
+  {
+    size_t  nK = a_slice.m_K.size();
+    double* px = a_slice.m_px.data() + a_cos * nK;
+
+    a_slice.m_cos[a_cos].Px
+      (ToParams(a_x), PayoffType::Put, a_slice.m_T, a_r, a_D, a_t, a_St,
+       nK, a_slice.m_K.data(), px);
+
+    for (size_t i = 0; i < nK; ++i)
+      a_res[i] = (px[i] - a_slice.m_mktPx[i]) * a_slice.m_scale[i];
+  }
+
+  //=========================================================================//
+  // "HestonCalibrator::Calibrate":                                          //
+  //=========================================================================//
+  LMRes HestonCalibrator::Calibrate
+  (
+    size_t            a_n,
+    CalibQuote const* a_quotes,
+    double            a_r,
+    double            a_D,
+    double            a_t,
+    double            a_St,
+    LMParams const&   a_params,
+    double*           a_resids
+  )
+  {
+    //-----------------------------------------------------------------------//
+    // Check the args:                                                       //
+    //-----------------------------------------------------------------------//
+    if (a_n < size_t(NParams))
+      throw std::invalid_argument("HestonCalibrator: Too Few Quotes");
+
+    if (!(a_St > 0.0))
+      throw std::invalid_argument("Non-Positive Strike / UnderlyingPx / Vol");
+
+    for (size_t q = 0; q < a_n; ++q)
+    {
+      CalibQuote const& quote = a_quotes[q];
+      if (!(quote.m_K > 0.0 && quote.m_vol > 0.0))
+        throw std::invalid_argument
+              ("Non-Positive Strike / UnderlyingPx / Vol");
+      if (!(quote.m_T > a_t))
+        throw std::invalid_argument
+              ("HestonCalibrator: Non-Positive Time to Expiration");
+      if (!(quote.m_weight >= 0.0 && std::isfinite(quote.m_weight)))
+        throw std::invalid_argument("HestonCalibrator: Invalid Weight");
+    }
+
+    //-----------------------------------------------------------------------//
+    // Group the quotes by maturity:                                         //
+    //-----------------------------------------------------------------------//
+    std::vector<size_t> order(a_n);
+    std::iota(order.begin(), order.end(), size_t(0));
+    std::stable_sort
+      (order.begin(), order.end(),
+       [a_quotes](size_t a_i, size_t a_j)
+       { return a_quotes[a_i].m_T < a_quotes[a_j].m_T; });
+
+    m_slices.clear();
+    m_resIdx.resize(a_n);
+    double meanVar = 0.0;
+
+    for (size_t k = 0; k < a_n; ++k)
+    {
+      CalibQuote const& quote = a_quotes[order[k]];
+      if (m_slices.empty() || m_slices.back().m_T != quote.m_T)
+      {
+        m_slices.emplace_back();
+        Slice& slice = m_slices.back();
+        slice.m_T    = quote.m_T;
+        slice.m_off  = k;
+        slice.m_cos.resize(1 + NParams);
+      }
+      Slice& slice = m_slices.back();
+
+      // The market Px and Vega of the Put. The Vega is floored (at 1/40 of
+      // the ATM one, roughly), so that the deep out-of-the-money quotes do
+      // not amplify the Px errors:
+      Greeks mkt  =
+        PxGreeks(PayoffType::Put, quote.m_K, quote.m_T, a_r, a_D, quote.m_vol,
+                 a_t, a_St);
+      double vega =
+        std::max(mkt.m_vega, 0.01 * a_St * std::sqrt(quote.m_T - a_t));
+
+      slice.m_K    .push_back(quote.m_K);
+      slice.m_mktPx.push_back(mkt.m_px);
+      slice.m_scale.push_back(quote.m_weight / vega);
+      m_resIdx[order[k]] = k;
+      meanVar += quote.m_vol * quote.m_vol;
+    }
+    meanVar /= double(a_n);
+
+    for (Slice& slice: m_slices)
+      slice.m_px.resize((1 + NParams) * slice.m_K.size());
+
+    //-----------------------------------------------------------------------//
+    // Initial guess (inside the bounds):                                    //
+    //-----------------------------------------------------------------------//
+    double x[NParams];
+    if (m_warm)
+      FromParams(m_params, x);
+    else
+    {
+      x[0] = meanVar;
+      x[1] = 1.5;
+      x[2] = meanVar;
+      x[3] = 0.5;
+      x[4] = -0.5;
+    }
+    for (int i = 0; i < NParams; ++i)
+      x[i] = std::clamp(x[i], m_lo[i], m_hi[i]);
+
+    //-----------------------------------------------------------------------//
+    // The Residuals and Jacobian (in parallel):                             //
+    //-----------------------------------------------------------------------//
+    auto run =
+      [this](size_t a_nTasks, std::function<void(size_t)> const& a_task)
+      {
+        if (m_pool != nullptr)
+          m_pool->Run(a_nTasks, a_task);
+        else
+          for (size_t i = 0; i < a_nTasks; ++i)
+            a_task(i);
+      };
+
+    LMResidFunc resid =
+      [&](double const* a_x, double* a_res)
+      {
+        run(m_slices.size(),
+            [&](size_t a_s)
+            {
+              Slice& slice = m_slices[a_s];
+              Resids(slice, 0, a_x, a_r, a_D, a_t, a_St, a_res + slice.m_off);
+            });
+      };
+
+    // Forward differences; the steps are relative (with a floor), and taken
+    // backwards at the upper bounds:
+    LMJacFunc jac =
+      [&](double const* a_x, double const* a_res, double* a_J)
+      {
+        run(m_slices.size() * NParams,
+            [&](size_t a_i)
+            {
+              Slice& slice = m_slices[a_i / NParams];
+              int    c     = int(a_i % NParams);
+
+              double xb[NParams];
+              std::copy(a_x, a_x + NParams, xb);
+              double h = 1e-5 * std::max(std::fabs(a_x[c]), 0.1);
+              if (xb[c] + h > m_hi[c])
+                h = -h;
+              xb[c] += h;
+
+              size_t              nK = slice.m_K.size();
+              std::vector<double> res(nK);
+              Resids
+                (slice, size_t(1 + c), xb, a_r, a_D, a_t, a_St, res.data());
+
+              for (size_t k = 0; k < nK; ++k)
+                a_J[(slice.m_off + k) * NParams + size_t(c)] =
+                  (res[k] - a_res[slice.m_off + k]) / h;
+            });
+      };
+
+    LMRes res = LevenbergMarquardt
+      (NParams, a_n, x, m_lo, m_hi, resid, jac, a_params);
+
+    m_params = ToParams(x);
+    m_warm   = true;
+
+    if (a_resids != nullptr)
+    {
+      std::vector<double> r(a_n);
+      resid(x, r.data());
+      for (size_t q = 0; q < a_n; ++q)
+        a_resids[q] = r[m_resIdx[q]];
+    }
+    return res;
+  }
+}
+// End namespace BSM
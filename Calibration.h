@@ -0,0 +1,204 @@
+// vim:ts=2:et
+//===========================================================================//
+//                              "Calibration.h":                             //
+//        Levenberg-Marquardt Calibration of Model Params to Option Chains   //
+//===========================================================================//
+#pragma once
+#include "BSM.h"
+#include "Heston.h"
+#include "ThreadPool.h"
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+namespace BSM
+{
+  //=========================================================================//
+  // Generic Levenberg-Marquardt Solver:                                     //
+  //=========================================================================//
+  //-------------------------------------------------------------------------//
+  // "LMParams": Stopping Criteria and Initial Damping:                      //
+  //-------------------------------------------------------------------------//
+  struct LMParams
+  {
+    int    m_maxIter = 100;     // Max number of (accepted or rejected) steps
+    double m_tolG    = 1e-12;   // On max |J^T r|
+    double m_tolX    = 1e-8;    // On |step|, relative to |x|
+    double m_tolRMSE = 1e-10;   // On the RMS of the residuals
+    double m_tolF    = 1e-6;    // On the relative reduction of |r|^2 by a step
+    double m_mu0     = 1e-3;    // Initial damping, rel to max diag(J^T J)
+  };
+
+  enum class LMStop: int
+  {
+    MaxIter  = 0,
+    Gradient = 1,   // Stationary point (possibly on the bounds)
+    Step     = 2,   // The step became negligible
+    Residual = 3,   // The fit is exact (up to "m_tolRMSE")
+    Cost     = 4    // The last step hardly reduced the cost
+  };
+
+  struct LMRes
+  {
+    double m_rmse   = NAN;  // RMS of the residuals at the solution
+    int    m_nIter  = 0;    // Number of steps tried
+    int    m_nEvals = 0;    // Number of residual evaluations (excl Jacobians)
+    int    m_nJacs  = 0;    // Number of Jacobian evaluations
+    LMStop m_stop   = LMStop::MaxIter;
+    double m_time   = 0.0;  // Wall-clock time, sec
+  };
+
+  // "a_x" is the point (input),  "a_r" the residuals (output):
+  using LMResidFunc =
+    std::function<void(double const* a_x, double* a_r)>;
+
+  // "a_J" is the [m x n] Jacobian (row-major) at "a_x", where the residuals
+  // are "a_r" (given,  as they are useful for finite differences):
+  using LMJacFunc   =
+    std::function<void(double const* a_x, double const* a_r, double* a_J)>;
+
+  //-------------------------------------------------------------------------//
+  // "LevenbergMarquardt":                                                   //
+  //-------------------------------------------------------------------------//
+  // Minimises 1/2 |r(x)|^2 over the box [a_lo, a_hi] (the steps are projected
+  // onto the box), with Marquardt's diag(J^T J) scaling of the damping,  and
+  // the damping updated from the ratio of the actual and predicted reductions
+  // (Nielsen's rule). The Jacobian is only re-computed after accepted steps.
+  // On input, "a_x" is the initial guess (eg the previous calibration: warm
+  // start), on output the solution. Throws "std::invalid_argument" if the
+  // initial guess is outside the box or m < n,  and propagates the exceptions
+  // thrown by the callbacks:
+  //
+  LMRes LevenbergMarquardt
+  (
+    size_t             a_n,       // Number of params
+    size_t             a_m,       // Number of residuals (>= a_n)
+    double*            a_x,       // [a_n] In: initial guess; Out: solution
+    double const*      a_lo,      // [a_n] Lower bounds
+    double const*      a_hi,      // [a_n] Upper bounds
+    LMResidFunc const& a_resid,
+    LMJacFunc   const& a_jac,
+    LMParams    const& a_params = LMParams()
+  );
+
+  //=========================================================================//
+  // "CalibQuote": A Market Quote of a European Option:                      //
+  //=========================================================================//
+  // Quoted as the implied vol;  the residual is then the model Px error div-
+  // ided by the Vega of the quote, ie (to the 1st order) the implied vol err-
+  // or, multiplied by the weight:
+  //
+  struct CalibQuote
+  {
+    double m_K      = NAN;  // Strike
+    double m_T      = NAN;  // Expiration Time
+    double m_vol    = NAN;  // Market implied vol
+    double m_weight = 1.0;
+  };
+
+  //=========================================================================//
+  // "HestonCalibrator":                                                     //
+  //=========================================================================//
+  // Calibrates "HestonParams" to the quotes of one Underlying,  using "Heston-
+  // COS" for the Pxs and Levenberg-Marquardt with forward-difference Jacobi-
+  // ans (by the Put-Call parity, the residuals do not depend on the option
+  // type, so all quotes are priced as Puts).
+  // The quotes are grouped by maturity; each maturity has its own "HestonCOS"
+  // objs (one for the residuals and one per param for the Jacobian), so the
+  // cached COS ranges and payoff coeffs survive across the iterations.  All
+  // Strikes of a maturity are priced by one (vectorised) COS valuation; the
+  // parallel tasks are the maturities for the residuals, and the (maturity,
+  // param) pairs for the Jacobian.
+  // The params of the last calibration are kept, and used as the initial
+  // guess of the next one (warm start; the intraday re-calibrations then typ-
+  // ically take a few iterations). The obj is NOT thread-safe, but several
+  // objs (eg one per Underlying) may share a "ThreadPool":
+  //
+  class HestonCalibrator
+  {
+  public:
+    constexpr static int NParams = 5;   // v0, kappa, theta, xi, rho
+
+  private:
+    //-----------------------------------------------------------------------//
+    // Types and Data Flds:                                                  //
+    //-----------------------------------------------------------------------//
+    struct Slice
+    {
+      double                 m_T;
+      size_t                 m_off;     // Offset of the residuals
+      std::vector<double>    m_K;       // Strikes
+      std::vector<double>    m_mktPx;   // Market Put Pxs
+      std::vector<double>    m_scale;   // Weight / Vega
+      std::vector<double>    m_px;      // [1 + NParams][nK] Model Pxs
+      std::vector<HestonCOS> m_cos;     // [1 + NParams]
+    };
+
+    ThreadPool*         m_pool;     // May be NULL (then no parallelism)
+    double              m_lo[NParams];
+    double              m_hi[NParams];
+    HestonParams        m_params;   // Last calibrated (or set) params
+    bool                m_warm;     // Are "m_params" valid?
+    std::vector<Slice>  m_slices;
+    std::vector<size_t> m_resIdx;   // Quote idx -> residual idx
+
+    // Residuals of "a_slice" at "a_x", using its COS obj "a_cos":
+    void Resids
+    (
+      Slice&        a_slice,
+      size_t        a_cos,
+      double const* a_x,
+      double        a_r,
+      double        a_D,
+      double        a_t,
+      double        a_St,
+      double*       a_res     // [a_slice.m_K.size()]
+    );
+
+  public:
+    //-----------------------------------------------------------------------//
+    // Non-Default Ctor:                                                     //
+    //-----------------------------------------------------------------------//
+    // The default bounds are: v0, theta in [1e-4, 4], kappa in [1e-3, 20],
+    // xi in [1e-3, 5], rho in [-0.999, 0.999]:
+    //
+    explicit HestonCalibrator(ThreadPool* a_pool = nullptr);
+
+    void SetBounds(HestonParams const& a_lo, HestonParams const& a_hi);
+
+    //-----------------------------------------------------------------------//
+    // "Calibrate":                                                          //
+    //-----------------------------------------------------------------------//
+    // Without a warm start, the initial guess is v0 = theta = the mean squar-
+    // ed market vol, kappa = 1.5, xi = 0.5, rho = -0.5. The result is avail-
+    // able via "Params()". If "a_resids" is non-NULL, it receives the resid-
+    // uals (in the order of "a_quotes"). Throws "std::invalid_argument" for
+    // invalid quotes or market data, or fewer than 5 quotes:
+    //
+    LMRes Calibrate
+    (
+      size_t            a_n,              // Number of quotes
+      CalibQuote const* a_quotes,         // [a_n]
+      double            a_r,              // Risk-Free Interest Rate
+      double            a_D,              // Dividend Rate
+      double            a_t,              // Pricing Time
+      double            a_St,             // Underlying Px
+      LMParams const&   a_params = LMParams(),
+      double*           a_resids = nullptr  // [a_n] (optional)
+    );
+
+    //-----------------------------------------------------------------------//
+    // Warm-Start State:                                                     //
+    //-----------------------------------------------------------------------//
+    HestonParams const& Params() const { return m_params; }
+    bool                IsWarm() const { return m_warm;   }
+
+    // Eg to seed the calibration from a related Underlying (throws if the
+    // params are outside the bounds):
+    void SetParams(HestonParams const& a_params);
+
+    // Next "Calibrate" starts from the default guess:
+    void Reset() { m_warm = false; }
+  };
+}
+// End namespace BSM
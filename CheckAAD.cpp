@@ -0,0 +1,94 @@
+// vim:ts=2:et
+//===========================================================================//
+//                               "CheckAAD.cpp":                             //
+//          AAD Greeks (Closed Form and Monte Carlo) vs the BSM Greeks       //
+//===========================================================================//
+#include "AAD.hpp"
+#include "Checks.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <exception>
+
+using namespace BSM;
+
+namespace
+{
+  //-------------------------------------------------------------------------//
+  // "MaxRelErr": Of the Px, Delta, Vega, Theta and Rho (not Gamma):         //
+  //-------------------------------------------------------------------------//
+  double MaxRelErr(Greeks const& a_g, Greeks const& a_ref)
+  {
+    auto rel = [](double a_x, double a_y)
+      { return std::fabs(a_x - a_y) / std::max(std::fabs(a_y), 1.0); };
+    return std::max({rel(a_g.m_px,    a_ref.m_px),
+                     rel(a_g.m_delta, a_ref.m_delta),
+                     rel(a_g.m_vega,  a_ref.m_vega),
+                     rel(a_g.m_theta, a_ref.m_theta),
+                     rel(a_g.m_rho,   a_ref.m_rho)});
+  }
+}
+
+int main()
+{
+  try
+  {
+    Checks::Tally check;
+    double const  T = 1.0, r = 0.03, D = 0.01, t = 0.25, St = 100.0;
+
+    //-----------------------------------------------------------------------//
+    // Closed form via AAD: the same formulas, so agreement to round-off:    //
+    //-----------------------------------------------------------------------//
+    double errC = 0.0;
+    double errP = 0.0;
+    for (double K: {60.0, 90.0, 100.0, 110.0, 160.0})
+      for (double sigma: {0.05, 0.2, 0.8})
+      {
+        errC = std::max(errC,
+          MaxRelErr(PxGreeksAAD<PayoffType::Call>(K, T, r, D, sigma, t, St),
+                    PxGreeks(PayoffType::Call, K, T, r, D, sigma, t, St)));
+        errP = std::max(errP,
+          MaxRelErr(PxGreeksAAD<PayoffType::Put> (K, T, r, D, sigma, t, St),
+                    PxGreeks(PayoffType::Put,  K, T, r, D, sigma, t, St)));
+      }
+    check("PxGreeksAAD Call vs PxGreeks (max rel err)", errC, 1e-12);
+    check("PxGreeksAAD Put  vs PxGreeks (max rel err)", errP, 1e-12);
+
+    //-----------------------------------------------------------------------//
+    // Pathwise MC Greeks: within 4 StdErrs of the closed form:              //
+    //-----------------------------------------------------------------------//
+    // (The seed is fixed, so the results are deterministic):
+    double   K     = 105.0;
+    double   sigma = 0.25;
+    MCParams params;
+    params.m_nPaths     = 400'000;
+    params.m_antithetic = true;
+
+    auto payoff = [K](auto const* a_path, int a_nSteps)
+                  { return max(a_path[a_nSteps] - K, 0.0); };
+
+    MCGreeks mc  = PxGreeksMC(payoff, T, r, D, sigma, t, St, params);
+    Greeks   ref = PxGreeks(PayoffType::Call, K, T, r, D, sigma, t, St);
+
+    char const* names[] = { "Px", "Delta", "Vega", "Theta", "Rho" };
+    double      vals [] = { mc.m_greeks.m_px,    mc.m_greeks.m_delta,
+                            mc.m_greeks.m_vega,  mc.m_greeks.m_theta,
+                            mc.m_greeks.m_rho };
+    double      errs [] = { mc.m_stdErrs.m_px,   mc.m_stdErrs.m_delta,
+                            mc.m_stdErrs.m_vega, mc.m_stdErrs.m_theta,
+                            mc.m_stdErrs.m_rho };
+    double      refs [] = { ref.m_px,   ref.m_delta, ref.m_vega,
+                            ref.m_theta, ref.m_rho };
+    for (int i = 0; i < 5; ++i)
+    {
+      char what[64];
+      snprintf(what, sizeof(what), "PxGreeksMC %s (in StdErrs)", names[i]);
+      check(what, (vals[i] - refs[i]) / errs[i], 4.0);
+    }
+    return check.Result("CheckAAD");
+  }
+  catch (std::exception const& exn)
+  {
+    fprintf(stderr, "EXCEPTION: %s\n", exn.what());
+    return 1;
+  }
+}
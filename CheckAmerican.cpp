@@ -0,0 +1,123 @@
+// vim:ts=2:et
+//===========================================================================//
+//                              "CheckAmerican.cpp":                         //
+//   Analytic American Approximations vs Trees; Batches; "AmerCritCache"     //
+//===========================================================================//
+#include "American.h"
+#include "Trees.h"
+#include "Checks.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <exception>
+#include <stdexcept>
+
+using namespace BSM;
+
+int main()
+{
+  try
+  {
+    Checks::Tally check;
+
+    //-----------------------------------------------------------------------//
+    // BAW and Bjerksund-Stensland vs a Tree (the bounds of "American.h"):   //
+    //-----------------------------------------------------------------------//
+    // S = 100, K = 80..120, vol 15-40%, r up to 8%, D up to 10%. The reference
+    // is a 1001-step Leisen-Reimer tree (its error is ~1e-4, well below the
+    // bounds checked):
+    TreePricer tree(TreeType::LeisenReimer, 1000);
+    double errBAW[2] = {}, errBS[2] = {};    // [0]: T <= 1Y, [1]: 3Y
+    double aboveBS   = -INFINITY;            // BS - Tree: a lower bound
+    double belowEur  =  INFINITY;            // min(Approx - European)
+    for (PayoffType type: {PayoffType::Call, PayoffType::Put})
+      for (double K: {80.0, 90.0, 100.0, 110.0, 120.0})
+        for (double sigma: {0.15, 0.4})
+          for (double r: {0.02, 0.08})
+            for (double D: {0.0, 0.1})
+              for (double T: {0.25, 0.5, 1.0, 3.0})
+              {
+                double ref = tree.Px(type, ExerStyle::American, K, T, r, D,
+                                     sigma, 0.0, 100.0);
+                double baw = PxAmer(AmerApprox::BAW, type, K, T, r, D, sigma,
+                                    0.0, 100.0);
+                double bs  = PxAmer(AmerApprox::BjerksundStensland, type, K,
+                                    T, r, D, sigma, 0.0, 100.0);
+                double eur = Px(type, K, T, r, D, sigma, 0.0, 100.0);
+                int    i   = (T > 1.0);
+                errBAW[i]  = std::max(errBAW[i], std::fabs(baw - ref));
+                errBS [i]  = std::max(errBS [i], std::fabs(bs  - ref));
+                aboveBS    = std::max(aboveBS,  bs - ref);
+                belowEur   = std::min(belowEur, std::min(baw, bs) - eur);
+              }
+    check("BAW vs Tree, T <= 1Y (max abs err)",                errBAW[0],
+          0.16);
+    check("Bjerksund-Stensland vs Tree, T <= 1Y (max abs err)", errBS[0],
+          0.13);
+    check("BAW vs Tree, T = 3Y (max abs err)",                 errBAW[1],
+          0.85);
+    check("Bjerksund-Stensland vs Tree, T = 3Y (max abs err)",  errBS[1],
+          0.25);
+    // A lower bound, up to the tree error:
+    check("Bjerksund-Stensland above Tree (max)", std::max(aboveBS, 0.0),
+          1e-3);
+    // Up to the accuracy of the bivariate normal CDF quadrature (deep OTM,
+    // where the early exercise premium vanishes):
+    check("Approx below European (max)", std::max(-belowEur, 0.0), 1e-8);
+
+    //-----------------------------------------------------------------------//
+    // "PxAmerBatch" vs "PxAmer":                                            //
+    //-----------------------------------------------------------------------//
+    double const Ks[7] = { 60.0, 80.0, 95.0, 100.0, 105.0, 120.0, 150.0 };
+    double       pxs[7];
+    double       errBatch = 0.0;
+    for (AmerApprox method: {AmerApprox::BAW,
+                             AmerApprox::BjerksundStensland})
+      for (PayoffType type: {PayoffType::Call, PayoffType::Put})
+      {
+        AmerCrit crit = AmerCritical(method, type, 1.0, 0.05, 0.03, 0.3, 0.0);
+        PxAmerBatch(crit, 7, Ks, 100.0, pxs);
+        for (int k = 0; k < 7; ++k)
+          errBatch = std::max(errBatch, std::fabs(pxs[k] -
+                     PxAmer(crit, Ks[k], 100.0)) / std::max(Ks[k], 100.0));
+      }
+    check("PxAmerBatch vs PxAmer (rel to max(K, St))", errBatch, 1e-13);
+
+    //-----------------------------------------------------------------------//
+    // "AmerCritCache":                                                      //
+    //-----------------------------------------------------------------------//
+    AmerCritCache cache(4);
+    double        nBad = 0.0;
+    AmerCrit const& c0 =
+      cache.Get(AmerApprox::BAW, PayoffType::Put, 1.0, 0.05, 0.0, 0.2, 0.0);
+    // A hit returns the same entry:
+    nBad += (&cache.Get(AmerApprox::BAW, PayoffType::Put, 1.0, 0.05, 0.0, 0.2,
+                        0.0) != &c0);
+    // A later Pricing Time replaces the entry in place:
+    AmerCrit const& c1 =
+      cache.Get(AmerApprox::BAW, PayoffType::Put, 1.0, 0.05, 0.0, 0.2, 0.5);
+    nBad += (&c1 != &c0) + (cache.Size() != 1);
+    nBad += (c1.m_tau != 0.5);
+    // Capacity: the oldest entries are evicted:
+    for (int i = 1; i <= 6; ++i)
+      cache.Get(AmerApprox::BAW, PayoffType::Put, 1.0 + i, 0.05, 0.0, 0.2,
+                0.0);
+    nBad += (cache.Size() != cache.Capacity());
+    cache.Clear();
+    nBad += (cache.Size() != 0);
+    try
+    {
+      AmerCritCache zero(0);
+      nBad += 1.0;
+    }
+    catch (std::invalid_argument const&) {}
+    check("AmerCritCache: wrong results (count)", nBad, 0.0);
+
+    return check.Result("CheckAmerican");
+  }
+  catch (std::exception const& exn)
+  {
+    fprintf(stderr, "EXCEPTION: %s\n", exn.what());
+    return 1;
+  }
+}
@@ -0,0 +1,72 @@
+// vim:ts=2:et
+//===========================================================================//
+//                           "CheckCalibration.cpp":                         //
+//            Heston LM Calibration: Recovery of the Known Params            //
+//===========================================================================//
+#include "Calibration.h"
+#include "ImpliedVol.h"
+#include "Checks.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <exception>
+#include <stdexcept>
+#include <vector>
+
+using namespace BSM;
+
+int main()
+{
+  try
+  {
+    Checks::Tally check;
+
+    //-----------------------------------------------------------------------//
+    // Heston: quotes generated by "HestonCOS" from known params:            //
+    //-----------------------------------------------------------------------//
+    double const r = 0.03, D = 0.01, t = 0.0, St = 100.0;
+    HestonParams truth;
+    truth.m_v0    = 0.04;
+    truth.m_kappa = 2.0;
+    truth.m_theta = 0.06;
+    truth.m_xi    = 0.6;
+    truth.m_rho   = -0.7;
+
+    std::vector<CalibQuote> quotes;
+    HestonCOS               cos;
+    for (double T: {0.25, 0.5, 1.0, 2.0})
+      for (double K: {70.0, 80.0, 90.0, 100.0, 110.0, 120.0, 130.0})
+      {
+        double   px = NAN;
+        IVStatus st = IVStatus::OK;
+        cos.Px(truth, PayoffType::Put, T, r, D, t, St, 1, &K, &px);
+        double vol = ImplVol(PayoffType::Put, px, K, T, r, D, t, St, &st);
+        if (st != IVStatus::OK)
+          throw std::runtime_error("CheckCalibration: No Implied Vol");
+        quotes.push_back(CalibQuote{K, T, vol, 1.0});
+      }
+
+    HestonCalibrator calib;
+    LMRes res = calib.Calibrate(quotes.size(), quotes.data(), r, D, t, St);
+    HestonParams const& p = calib.Params();
+
+    double errP = std::max({std::fabs(p.m_v0    - truth.m_v0),
+                            std::fabs(p.m_kappa - truth.m_kappa) / 10.0,
+                            std::fabs(p.m_theta - truth.m_theta),
+                            std::fabs(p.m_xi    - truth.m_xi),
+                            std::fabs(p.m_rho   - truth.m_rho)});
+    check("Heston: RMSE of the vol residuals",         res.m_rmse, 1e-8);
+    check("Heston: params (kappa / 10) vs the truth",  errP,       1e-6);
+
+    // Warm start from the solution: converges immediately:
+    res = calib.Calibrate(quotes.size(), quotes.data(), r, D, t, St);
+    check("Heston: warm-start iterations",             res.m_nIter, 3);
+
+    return check.Result("CheckCalibration");
+  }
+  catch (std::exception const& exn)
+  {
+    fprintf(stderr, "EXCEPTION: %s\n", exn.what());
+    return 1;
+  }
+}
@@ -0,0 +1,140 @@
+// vim:ts=2:et
+//===========================================================================//
+//                              "CheckCurves.cpp":                           //
+//        Yield Curve Bootstrapping: Re-Pricing of the Input Instruments     //
+//===========================================================================//
+#include "Curves.h"
+#include "Checks.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <exception>
+#include <vector>
+
+using namespace BSM;
+
+namespace
+{
+  //-------------------------------------------------------------------------//
+  // "Quote": The Quote Implied by the Curve:                                //
+  //-------------------------------------------------------------------------//
+  // Independent of the bootstrapper: only "DF" is used. The Swaps here have
+  // regular schedules (a whole number of periods from "m_start"):
+  //
+  double Quote(CurveInstr const& a_in, YieldCurve const& a_curve)
+  {
+    double dfS   = a_curve.DF(a_in.m_start);
+    double dfE   = a_curve.DF(a_in.m_end);
+    double alpha = a_in.m_end - a_in.m_start;
+    switch (a_in.m_type)
+    {
+      case InstrType::Deposit:
+        return (dfS / dfE - 1.0) / alpha;
+
+      case InstrType::Future:
+        return 100.0 - 100.0 * ((dfS / dfE - 1.0) / alpha + a_in.m_convAdj);
+
+      default:
+      {
+        double dt  = 1.0 / double(a_in.m_freq);
+        int    n   = int(std::lround(alpha / dt));
+        double ann = 0.0;
+        for (int k = 1; k <= n; ++k)
+          ann += dt * a_curve.DF(a_in.m_start + double(k) * dt);
+        return (dfS - dfE) / ann;
+      }
+    }
+  }
+}
+
+int main()
+{
+  try
+  {
+    Checks::Tally check;
+    double const  t0 = 0.0;
+
+    //-----------------------------------------------------------------------//
+    // A typical (upward-sloping, with a hump) set of instruments:           //
+    //-----------------------------------------------------------------------//
+    std::vector<CurveInstr> instrs
+    {
+      { InstrType::Deposit, t0,   1.0 / 12.0, 0.0410, 1, 0.0    },
+      { InstrType::Deposit, t0,   0.25,       0.0425, 1, 0.0    },
+      { InstrType::Future,  0.25, 0.50,       95.60,  1, 0.0    },
+      { InstrType::Future,  0.50, 0.75,       95.45,  1, 0.0001 },
+      { InstrType::Future,  0.75, 1.00,       95.38,  1, 0.0002 },
+      { InstrType::Swap,    t0,   2.0,        0.0455, 2, 0.0    },
+      { InstrType::Swap,    t0,   3.0,        0.0449, 2, 0.0    },
+      { InstrType::Swap,    t0,   5.0,        0.0430, 1, 0.0    },
+      { InstrType::Swap,    t0,   10.0,       0.0415, 1, 0.0    },
+      { InstrType::Swap,    t0,   30.0,       0.0402, 1, 0.0    }
+    };
+
+    for (CurveInterp interp: {CurveInterp::LogLinear,
+                              CurveInterp::MonotoneConvex})
+    {
+      char const* name =
+        (interp == CurveInterp::LogLinear) ? "LogLinear" : "MonotoneConvex";
+
+      // The instruments are given in reverse order (any order is allowed):
+      std::vector<CurveInstr> rev(instrs.rbegin(), instrs.rend());
+      YieldCurve curve =
+        YieldCurve::Bootstrap(t0, rev.size(), rev.data(), interp);
+
+      // Rates re-priced to 1e-12 (0.0001 bp), Futures Pxs to 1e-10:
+      double errR = 0.0;
+      double errF = 0.0;
+      for (CurveInstr const& in: instrs)
+      {
+        double err = std::fabs(Quote(in, curve) - in.m_quote);
+        if (in.m_type == InstrType::Future)
+          errF = std::max(errF, err);
+        else
+          errR = std::max(errR, err);
+      }
+      char what[64];
+      snprintf(what, sizeof(what), "%s: Deposit / Swap rates", name);
+      check(what, errR, 1e-12);
+      snprintf(what, sizeof(what), "%s: Future Pxs", name);
+      check(what, errF, 1e-10);
+
+      // DF(t0) = 1, and the zero rates are consistent with the DFs:
+      snprintf(what, sizeof(what), "%s: DF(t0) = 1", name);
+      check(what, curve.DF(t0) - 1.0, 0.0);
+
+      double errZ = 0.0;
+      for (double T = 0.1; T < 40.0; T *= 1.5)
+        errZ = std::max(errZ, std::fabs(std::exp(-curve.ZeroRate(t0, T) * T) -
+                                        curve.DF(T)));
+      snprintf(what, sizeof(what), "%s: ZeroRate vs DF", name);
+      check(what, errZ, 1e-14);
+    }
+
+    //-----------------------------------------------------------------------//
+    // Flat quotes give a flat curve:                                        //
+    //-----------------------------------------------------------------------//
+    // Continuously-compounded r = 4%, so the simple rate over "a" is
+    // (exp(r a) - 1) / a, and the par rate of a Swap paid "f" times a year
+    // is f * (exp(r / f) - 1):
+    double const r = 0.04;
+    std::vector<CurveInstr> flat
+    {
+      { InstrType::Deposit, t0, 0.5,  (std::exp(r * 0.5) - 1.0) / 0.5, 1, 0 },
+      { InstrType::Swap,    t0, 2.0,  2.0 * (std::exp(r / 2.0) - 1.0), 2, 0 },
+      { InstrType::Swap,    t0, 10.0, std::exp(r) - 1.0,               1, 0 }
+    };
+    YieldCurve curve = YieldCurve::Bootstrap(t0, flat.size(), flat.data());
+    double     errFlat = 0.0;
+    for (double T = 0.1; T < 20.0; T *= 1.5)
+      errFlat = std::max(errFlat, std::fabs(curve.ZeroRate(t0, T) - r));
+    check("Flat quotes: zero rates", errFlat, 1e-12);
+
+    return check.Result("CheckCurves");
+  }
+  catch (std::exception const& exn)
+  {
+    fprintf(stderr, "EXCEPTION: %s\n", exn.what());
+    return 1;
+  }
+}
@@ -0,0 +1,167 @@
+// vim:ts=2:et
+//===========================================================================//
+//                             "CheckDividends.cpp":                         //
+//   Cash Dividends: Schedules, Escrowed Closed Forms, Tree Jump Accuracy    //
+//===========================================================================//
+#include "Dividends.h"
+#include "Trees.h"
+#include "Checks.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <exception>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using namespace BSM;
+
+int main()
+{
+  try
+  {
+    Checks::Tally check;
+    double const r = 0.05, t = 0.1;
+
+    //-----------------------------------------------------------------------//
+    // "DivSchedule": PV over (t, T], dPV/dr, and invalid dividends:         //
+    //-----------------------------------------------------------------------//
+    // Given unsorted; the one at "t" itself is not paid within (t, T]:
+    CashDiv const     divs[4] = {{0.85, 1.5}, {t, 3.0}, {0.35, 1.0},
+                                 {1.35, 2.0}};
+    DivSchedule const sched(4, divs);
+    double dPVdr = 0.0;
+    double pv    = sched.PV(t, 1.35, r, &dPVdr);
+    double ref   = 1.0 * std::exp(-r * 0.25) + 1.5 * std::exp(-r * 0.75) +
+                   2.0 * std::exp(-r * 1.25);
+    double refDr = -0.25 * 1.0 * std::exp(-r * 0.25)
+                   -0.75 * 1.5 * std::exp(-r * 0.75)
+                   -1.25 * 2.0 * std::exp(-r * 1.25);
+    check("DivSchedule PV over (t, T]",       pv    - ref,   1e-15);
+    check("DivSchedule dPV/dr",               dPVdr - refDr, 1e-15);
+    check("DivSchedule PV, none in (t, T]",   sched.PV(0.4, 0.8, r), 0.0);
+
+    double nNoThrow = 0.0;
+    for (CashDiv bad: {CashDiv{0.5, -1.0}, CashDiv{NAN, 1.0},
+                       CashDiv{INFINITY, 1.0}})
+      try
+      {
+        DivSchedule s(1, &bad);
+        ++nNoThrow;
+      }
+      catch (std::invalid_argument const&) {}
+    check("Invalid dividends not throwing (count)", nNoThrow, 0.0);
+
+    //-----------------------------------------------------------------------//
+    // Escrowed Closed Forms:                                                //
+    //-----------------------------------------------------------------------//
+    // The flat "Px" on St - PV, the batch vs the scalar ones (grouped by
+    // expiry, as recommended), and Theta and Rho vs central differences:
+    std::mt19937_64                        gen(20240620);
+    std::uniform_real_distribution<double> u(0.0, 1.0);
+    size_t const        n    = 600;
+    double const        D    = 0.01;
+    double const        Ts[] = {0.3, 0.9, 1.6};   // 0, 2, 3 divs paid
+    std::vector<double> K(n), T(n), sigma(n), St(n), pxs(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+      K    [i] = 100.0 * std::exp(0.4 * (2.0 * u(gen) - 1.0));
+      T    [i] = Ts[(3 * i) / n];
+      sigma[i] = 0.1 + 0.4 * u(gen);
+      St   [i] = 90.0 + 20.0 * u(gen);
+    }
+    double errEsc = 0.0, errBatch = 0.0, errTheta = 0.0, errRho = 0.0;
+    for (PayoffType type: {PayoffType::Call, PayoffType::Put})
+    {
+      PxBatch<CDFCody>(type, n, K.data(), T.data(), r, D, sigma.data(), t,
+                       St.data(), sched, pxs.data());
+      for (size_t i = 0; i < n; ++i)
+      {
+        double scale = std::max(K[i], St[i]);
+        double px    = Px<CDFCody>(type, K[i], T[i], r, D, sigma[i], t, St[i],
+                                   sched);
+        double flat  = Px<CDFCody>(type, K[i], T[i], r, D, sigma[i], t,
+                                   St[i] - sched.PV(t, T[i], r));
+        errEsc   = std::max(errEsc,   std::fabs(px     - flat) / scale);
+        errBatch = std::max(errBatch, std::fabs(pxs[i] - px)   / scale);
+
+        // One-sided (2nd order) in t, as the dividend at "t" itself would be
+        // paid within (t - h, T]:
+        double const h = 1e-5;
+        Greeks g = PxGreeks<CDFCody>(type, K[i], T[i], r, D, sigma[i], t,
+                                     St[i], sched);
+        double th = (4.0 * Px<CDFCody>(type, K[i], T[i], r, D, sigma[i],
+                                       t + h, St[i], sched) -
+                     Px<CDFCody>(type, K[i], T[i], r, D, sigma[i], t + 2.0 * h,
+                                 St[i], sched) - 3.0 * g.m_px) / (2.0 * h);
+        double rh = (Px<CDFCody>(type, K[i], T[i], r + h, D, sigma[i], t,
+                                 St[i], sched) -
+                     Px<CDFCody>(type, K[i], T[i], r - h, D, sigma[i], t,
+                                 St[i], sched)) / (2.0 * h);
+        errTheta = std::max(errTheta, std::fabs(g.m_theta - th) / scale);
+        errRho   = std::max(errRho,   std::fabs(g.m_rho   - rh) / scale);
+      }
+    }
+    check("Escrowed Px vs flat Px(St - PV) (rel)", errEsc,   1e-15);
+    check("Escrowed PxBatch vs Px (rel)",          errBatch, 1e-14);
+    check("Escrowed Theta vs FD (rel)",            errTheta, 1e-7);
+    check("Escrowed Rho vs FD (rel)",              errRho,   1e-7);
+
+    //-----------------------------------------------------------------------//
+    // Trees with Dividends: the Errors documented in "Trees.h":             //
+    //-----------------------------------------------------------------------//
+    // 1y ATM European Put, St = 100, vol = 25%, r = 5%, 2 dividends of 2. The
+    // reference is the Richardson extrapolation of Leisen-Reimer at 2000 and
+    // 4000 steps (it converges as 1/NSteps, within ~1e-5 of a 20000-step LR
+    // tree):
+    CashDiv const     two[2] = {{0.3137, 2.0}, {0.8123, 2.0}};
+    DivSchedule const sched2(2, two);
+    auto put = [&](TreeType a_type, int a_nSteps, ExerStyle a_exer)
+    {
+      TreePricer tree(a_type, a_nSteps);
+      return tree.Px(PayoffType::Put, a_exer, 100.0, 1.0, r, 0.0, 0.25, 0.0,
+                     100.0, nullptr, 0, &sched2);
+    };
+    ExerStyle const eur = ExerStyle::European;
+    double    const exact =
+      2.0 * put(TreeType::LeisenReimer, 4000, eur) -
+            put(TreeType::LeisenReimer, 2000, eur);
+
+    check("LR,  100 steps (abs err)",
+          put(TreeType::LeisenReimer, 100,  eur) - exact, 6e-4);
+    check("LR, 1000 steps (abs err)",
+          put(TreeType::LeisenReimer, 1000, eur) - exact, 2e-4);
+    check("CRR, 1000 steps (abs err)",
+          put(TreeType::CRR,          1000, eur) - exact, 2.5e-3);
+    check("Trinomial, 1000 steps (abs err)",
+          put(TreeType::Trinomial,    1000, eur) - exact, 1.5e-3);
+
+    // First order: the error halves as the steps double:
+    double worstRatio = 0.0;
+    for (TreeType type: {TreeType::CRR, TreeType::LeisenReimer,
+                         TreeType::Trinomial})
+    {
+      double ratio = (put(type, 2000, eur) - exact) /
+                     (put(type, 1000, eur) - exact);
+      worstRatio   = std::max(worstRatio, std::fabs(ratio - 0.5));
+    }
+    check("Err(2000) / Err(1000) - 1/2 (worst)", worstRatio, 0.1);
+
+    // American: less regular, but within 1e-3 at 1000 steps (vs a 4000-step
+    // Leisen-Reimer tree):
+    ExerStyle const amer = ExerStyle::American;
+    double    const refA = put(TreeType::LeisenReimer, 4000, amer);
+    double    errA = 0.0;
+    for (TreeType type: {TreeType::CRR, TreeType::LeisenReimer,
+                         TreeType::Trinomial})
+      errA = std::max(errA, std::fabs(put(type, 1000, amer) - refA));
+    check("American, 1000 steps (max abs err)", errA, 1e-3);
+
+    return check.Result("CheckDividends");
+  }
+  catch (std::exception const& exn)
+  {
+    fprintf(stderr, "EXCEPTION: %s\n", exn.what());
+    return 1;
+  }
+}
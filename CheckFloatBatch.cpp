@@ -0,0 +1,149 @@
+// vim:ts=2:et
+//===========================================================================//
+//                            "CheckFloatBatch.cpp":                         //
+//    Single-Precision Batch Pricers vs the "double" Path: Documented Bounds //
+//===========================================================================//
+#include "BSM.h"
+#include "Checks.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <exception>
+#include <random>
+#include <vector>
+
+using namespace BSM;
+
+namespace
+{
+  //-------------------------------------------------------------------------//
+  // "MaxErrs": Of the "float" Path with the CDF Policy "CDF":               //
+  //-------------------------------------------------------------------------//
+  // Against the "double" "CDFCody" path, with the errors scaled as in the
+  // "BSM.h" docs: [0] Px / max(K, St), [1] Delta, [2..5] Gamma, Vega, Theta
+  // and Rho relative to their scales:
+  //
+  template<typename CDF>
+  void MaxErrs
+  (
+    PayoffType                 a_type,
+    std::vector<double> const& a_K,
+    std::vector<double> const& a_T,
+    std::vector<double> const& a_sigma,
+    std::vector<double> const& a_St,
+    double                     a_r,
+    double                     a_D,
+    double*                    a_errs   // [6]
+  )
+  {
+    size_t n = a_K.size();
+    std::vector<float>  Kf(a_K.begin(), a_K.end());
+    std::vector<float>  Tf(a_T.begin(), a_T.end());
+    std::vector<float>  sf(a_sigma.begin(), a_sigma.end());
+    std::vector<float>  Sf(a_St.begin(), a_St.end());
+    std::vector<double> gd(6 * n);
+    std::vector<float>  gf(6 * n);
+    GreeksArrs  outD
+      { &gd[0], &gd[n], &gd[2 * n], &gd[3 * n], &gd[4 * n], &gd[5 * n] };
+    GreeksArrsF outF
+      { &gf[0], &gf[n], &gf[2 * n], &gf[3 * n], &gf[4 * n], &gf[5 * n] };
+
+    PxGreeksBatch<CDFCody>
+      (a_type, n, a_K.data(), a_T.data(), a_r, a_D, a_sigma.data(), 0.0,
+       a_St.data(), outD);
+    PxGreeksBatch<CDF>
+      (a_type, n, Kf.data(), Tf.data(), float(a_r), float(a_D), sf.data(),
+       0.0f, Sf.data(), outF);
+
+    // "PxBatch" must agree with the Pxs of "PxGreeksBatch":
+    std::vector<float> pxF(n);
+    PxBatch<CDF>
+      (a_type, n, Kf.data(), Tf.data(), float(a_r), float(a_D), sf.data(),
+       0.0f, Sf.data(), pxF.data());
+
+    std::fill(a_errs, a_errs + 6, 0.0);
+    for (size_t i = 0; i < n; ++i)
+    {
+      double S     = a_St[i];
+      double sqT   = std::sqrt(a_T[i]);
+      double scale[6] =
+      {
+        std::max(a_K[i], S),               // Px
+        1.0,                               // Delta
+        1.0 / (S * a_sigma[i] * sqT),      // Gamma
+        S * sqT,                           // Vega
+        S * a_sigma[i] / sqT,              // Theta
+        S * sqT                            // Rho
+      };
+      for (int g = 0; g < 6; ++g)
+      {
+        double err = std::fabs(double(gf[g * n + i]) - gd[g * n + i]) /
+                     scale[g];
+        a_errs[g]  = std::max(a_errs[g], err);
+      }
+      a_errs[0] = std::max(a_errs[0],
+                           std::fabs(double(pxF[i]) - gd[i]) / scale[0]);
+    }
+  }
+}
+
+int main()
+{
+  try
+  {
+    Checks::Tally check;
+
+    //-----------------------------------------------------------------------//
+    // Random options over the documented ranges:                            //
+    //-----------------------------------------------------------------------//
+    // K / St in [0.5, 2], vols in [0.05, 1], tau in [0.01, 5] (log-uniform;
+    // the seed is fixed, so the check is deterministic).  The inputs are
+    // rounded to "float", so that both paths price the same options:
+    size_t const        n     = 100'000;
+    double const        LogRK = std::log(4.0);     // Log-ranges
+    double const        LogRT = std::log(500.0);
+    double const        LogRS = std::log(20.0);
+    std::mt19937_64     gen(20240601);
+    std::uniform_real_distribution<double> u(0.0, 1.0);
+    std::vector<double> K(n), T(n), sigma(n), St(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+      St   [i] = 100.0;
+      K    [i] = float(100.0 * std::exp(std::log(0.5)  + u(gen) * LogRK));
+      T    [i] = float(        std::exp(std::log(0.01) + u(gen) * LogRT));
+      sigma[i] = float(        std::exp(std::log(0.05) + u(gen) * LogRS));
+    }
+    double const r = 0.03, D = 0.01;
+
+    // The bounds documented in "BSM.h":
+    char const* gNames[6] =
+      { "Px", "Delta", "Gamma", "Vega", "Theta", "Rho" };
+    double      tolC  [6] = { 4e-7, 5e-6, 3e-6, 3e-6, 2e-6, 2e-6 };
+    double      tolF  [6] = { 6e-7, 5e-6, 3e-6, 3e-6, 2e-6, 2e-6 };
+
+    for (PayoffType type: {PayoffType::Call, PayoffType::Put})
+    {
+      char const* tName = (type == PayoffType::Call) ? "Call" : "Put";
+      double errsC[6], errsF[6];
+      MaxErrs<CDFCody>(type, K, T, sigma, St, r, D, errsC);
+      MaxErrs<CDFFast>(type, K, T, sigma, St, r, D, errsF);
+
+      for (int g = 0; g < 6; ++g)
+      {
+        char what[64];
+        snprintf(what, sizeof(what), "float %s %s (CDFCody)", tName,
+                 gNames[g]);
+        check(what, errsC[g], tolC[g]);
+        snprintf(what, sizeof(what), "float %s %s (CDFFast)", tName,
+                 gNames[g]);
+        check(what, errsF[g], tolF[g]);
+      }
+    }
+    return check.Result("CheckFloatBatch");
+  }
+  catch (std::exception const& exn)
+  {
+    fprintf(stderr, "EXCEPTION: %s\n", exn.what());
+    return 1;
+  }
+}
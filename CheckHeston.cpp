@@ -0,0 +1,87 @@
+// vim:ts=2:et
+//===========================================================================//
+//                              "CheckHeston.cpp":                           //
+//         Heston COS and FFT Pricers vs the Published Reference Pxs         //
+//===========================================================================//
+#include "Heston.h"
+#include "Checks.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <exception>
+
+using namespace BSM;
+
+int main()
+{
+  try
+  {
+    Checks::Tally check;
+
+    //-----------------------------------------------------------------------//
+    // Fang and Oosterlee (2008), Section 5.4 (Feller condition violated):   //
+    //-----------------------------------------------------------------------//
+    // St = K = 100, r = D = 0; the reference Call Pxs are 5.785155450 for
+    // T = 1, and 22.318945791 for T = 10. The tolerances are the accuracies
+    // documented in "Heston.h":
+    HestonParams p;
+    p.m_v0    = 0.0175;
+    p.m_kappa = 1.5768;
+    p.m_theta = 0.0398;
+    p.m_xi    = 0.5751;
+    p.m_rho   = -0.5711;
+
+    double const St  = 100.0;
+    double const K   = 100.0;
+    double const T[] = { 1.0, 10.0 };
+    double const R[] = { 5.785155450, 22.318945791 };
+
+    HestonCOS cos;
+    HestonFFT fft;
+    for (int i = 0; i < 2; ++i)
+    {
+      char   what[64];
+      double px = NAN;
+      cos.Px(p, PayoffType::Call, T[i], 0.0, 0.0, 0.0, St, 1, &K, &px);
+      snprintf(what, sizeof(what), "HestonCOS Call, T=%g", T[i]);
+      check(what, px - R[i], 1e-9 * St);
+
+      fft.Px(p, PayoffType::Call, T[i], 0.0, 0.0, 0.0, St, 1, &K, &px);
+      snprintf(what, sizeof(what), "HestonFFT Call, T=%g", T[i]);
+      check(what, px - R[i], 1e-8 * St);
+    }
+
+    //-----------------------------------------------------------------------//
+    // COS vs FFT over a Strike range, with rates, and the Put-Call parity:  //
+    //-----------------------------------------------------------------------//
+    double Ks[9];
+    for (int i = 0; i < 9; ++i)
+      Ks[i] = 60.0 + 10.0 * i;
+
+    double errCF = 0.0;
+    double errPC = 0.0;
+    for (double Tm: {0.1, 0.5, 2.0})
+    {
+      double r = 0.03, D = 0.01;
+      double callC[9], putC[9], callF[9];
+      cos.Px(p, PayoffType::Call, Tm, r, D, 0.0, St, 9, Ks, callC);
+      cos.Px(p, PayoffType::Put,  Tm, r, D, 0.0, St, 9, Ks, putC);
+      fft.Px(p, PayoffType::Call, Tm, r, D, 0.0, St, 9, Ks, callF);
+      for (int i = 0; i < 9; ++i)
+      {
+        errCF = std::max(errCF, std::fabs(callC[i] - callF[i]));
+        double fwd = St * std::exp(-D * Tm) - Ks[i] * std::exp(-r * Tm);
+        errPC = std::max(errPC, std::fabs(callC[i] - putC[i] - fwd));
+      }
+    }
+    check("HestonCOS vs HestonFFT (K = 60..140)", errCF, 2e-5);
+    check("HestonCOS Put-Call parity",            errPC, 1e-10);
+
+    return check.Result("CheckHeston");
+  }
+  catch (std::exception const& exn)
+  {
+    fprintf(stderr, "EXCEPTION: %s\n", exn.what());
+    return 1;
+  }
+}
@@ -0,0 +1,150 @@
+// vim:ts=2:et
+//===========================================================================//
+//                             "CheckImpliedVol.cpp":                        //
+//        Implied Vols: Round-Trip Accuracy, Warm Starts, Status Codes       //
+//===========================================================================//
+#include "ImpliedVol.h"
+#include "Checks.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <exception>
+#include <random>
+#include <vector>
+
+using namespace BSM;
+
+int main()
+{
+  try
+  {
+    Checks::Tally check;
+
+    //-----------------------------------------------------------------------//
+    // Random out-of-the-money options, round trip through "Px":             //
+    //-----------------------------------------------------------------------//
+    // K / St in [0.5, 2], vols in [0.05, 1], tau in [0.01, 5] (log-uniform),
+    // Pxs above 1e-2 (the vol is then well-defined). Cold, warm (2% off) and
+    // far warm starts (1e-4 .. 1e3, ie up to 4 orders of magnitude off):
+    double const r = 0.03, D = 0.01, St = 100.0;
+    std::mt19937_64                        gen(20240603);
+    std::uniform_real_distribution<double> u(0.0, 1.0);
+
+    size_t const        n = 100'000;
+    std::vector<double> K, T, sigma, px;
+    while (K.size() < n)
+    {
+      double k = St * std::exp(std::log(0.5)  + u(gen) * std::log(4.0));
+      double t = std::exp(std::log(0.01) + u(gen) * std::log(500.0));
+      double s = std::exp(std::log(0.05) + u(gen) * std::log(20.0));
+      // OTM w.r.t. the Fwd: Calls above it, Puts below:
+      bool   call = (k > St * std::exp((r - D) * t));
+      double p    = Px(call ? PayoffType::Call : PayoffType::Put, k, t, r, D,
+                       s, 0.0, St);
+      if (!(p > 1e-2))
+        continue;
+      K.push_back(k);
+      T.push_back(t);
+      sigma.push_back(s);
+      px.push_back(p);
+    }
+
+    double errCold = 0.0, errWarm = 0.0, errFar = 0.0;
+    double nFailed = 0.0;
+    for (size_t i = 0; i < n; ++i)
+    {
+      PayoffType type =
+        (K[i] > St * std::exp((r - D) * T[i])) ? PayoffType::Call
+                                                : PayoffType::Put;
+      IVStatus st[3];
+      double   s0 = std::exp(std::log(1e-4) + u(gen) * std::log(1e7));
+      double   v0 = ImplVol(type, px[i], K[i], T[i], r, D, 0.0, St, &st[0]);
+      double   v1 = ImplVol(type, px[i], K[i], T[i], r, D, 0.0, St, &st[1],
+                            1.02 * sigma[i]);
+      double   v2 = ImplVol(type, px[i], K[i], T[i], r, D, 0.0, St, &st[2],
+                            s0);
+      for (IVStatus s: st)
+        nFailed += (s != IVStatus::OK);
+      errCold = std::max(errCold, std::fabs(v0 / sigma[i] - 1.0));
+      errWarm = std::max(errWarm, std::fabs(v1 / sigma[i] - 1.0));
+      errFar  = std::max(errFar,  std::fabs(v2 / sigma[i] - 1.0));
+    }
+    check("ImplVol failures (count)",               nFailed, 0.0);
+    check("ImplVol cold:            max rel err",   errCold, 1e-12);
+    check("ImplVol warm (2% off):   max rel err",   errWarm, 1e-12);
+    check("ImplVol warm (far off):  max rel err",   errFar,  1e-12);
+
+    //-----------------------------------------------------------------------//
+    // Implausible warm starts on plain inputs:                              //
+    //-----------------------------------------------------------------------//
+    // (S = 100, T = 1, r = 2%, vol = 20%: a sigma0 of 50 used to give
+    // "NoConvergence"):
+    double errPlain = 0.0;
+    double nPlain   = 0.0;
+    for (double k: {70.0, 100.0, 130.0})
+      for (double s0: {1e-8, 1e-3, 0.05, 2.0, 10.0, 50.0, 100.0, 1e4, 1e8})
+        for (PayoffType type: {PayoffType::Call, PayoffType::Put})
+        {
+          double   p  = Px(type, k, 1.0, 0.02, 0.0, 0.2, 0.0, 100.0);
+          IVStatus st = IVStatus::OK;
+          double   v  =
+            ImplVol(type, p, k, 1.0, 0.02, 0.0, 0.0, 100.0, &st, s0);
+          nPlain  += (st != IVStatus::OK);
+          errPlain = std::max(errPlain, std::fabs(v / 0.2 - 1.0));
+        }
+    check("ImplVol far warm starts: failures (count)", nPlain,   0.0);
+    check("ImplVol far warm starts: max rel err",      errPlain, 1e-12);
+
+    //-----------------------------------------------------------------------//
+    // "ImplVolBatch", warm-started from garbage previous vols:              //
+    //-----------------------------------------------------------------------//
+    size_t const          m = 1000;
+    std::vector<double>   Sts(m, St), vols(m);
+    std::vector<IVStatus> sts(m);
+    for (size_t i = 0; i < m; ++i)
+      vols[i] = (i % 3 == 0) ? 50.0 : (i % 3 == 1) ? 1e-6 : NAN;
+    // The first "m" OTM Calls of the above:
+    std::vector<double> Kc, Tc, pc, sc;
+    for (size_t i = 0; i < n && Kc.size() < m; ++i)
+      if (K[i] > St * std::exp((r - D) * T[i]))
+      {
+        Kc.push_back(K[i]);
+        Tc.push_back(T[i]);
+        pc.push_back(px[i]);
+        sc.push_back(sigma[i]);
+      }
+    ImplVolBatch(PayoffType::Call, m, pc.data(), Kc.data(), Tc.data(), r, D,
+                 0.0, Sts.data(), vols.data(), sts.data(), true);
+    double nBatch = 0.0, errBatch = 0.0;
+    for (size_t i = 0; i < m; ++i)
+    {
+      nBatch  += (sts[i] != IVStatus::OK);
+      errBatch = std::max(errBatch, std::fabs(vols[i] / sc[i] - 1.0));
+    }
+    check("ImplVolBatch garbage warm starts: failures", nBatch,   0.0);
+    check("ImplVolBatch garbage warm starts: rel err",  errBatch, 1e-12);
+
+    //-----------------------------------------------------------------------//
+    // Status codes:                                                         //
+    //-----------------------------------------------------------------------//
+    IVStatus st = IVStatus::OK;
+    double   c  = Px(PayoffType::Call, 90.0, 1.0, r, D, 0.2, 0.0, St);
+    double   nBad = 0.0;
+    ImplVol(PayoffType::Call, c, 90.0, 0.0, r, D, 0.0, St, &st);
+    nBad += (st != IVStatus::InvalidArgs);
+    ImplVol(PayoffType::Call, 1.0, 90.0, 1.0, r, D, 0.0, St, &st);
+    nBad += (st != IVStatus::BelowIntrinsic);
+    ImplVol(PayoffType::Call, St, 90.0, 1.0, r, D, 0.0, St, &st);
+    nBad += (st != IVStatus::AboveMax);
+    ImplVol(PayoffType::Arbitrary, c, 90.0, 1.0, r, D, 0.0, St, &st);
+    nBad += (st != IVStatus::UnsupportedType);
+    check("ImplVol status codes (wrong count)", nBad, 0.0);
+
+    return check.Result("CheckImpliedVol");
+  }
+  catch (std::exception const& exn)
+  {
+    fprintf(stderr, "EXCEPTION: %s\n", exn.what());
+    return 1;
+  }
+}
@@ -0,0 +1,145 @@
+// vim:ts=2:et
+//===========================================================================//
+//                              "CheckLocalVol.cpp":                         //
+//     Dupire Local Vol: Flat Surface, Repricing of Europeans, Determinism   //
+//===========================================================================//
+#include "LocalVol.hpp"
+#include "Checks.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+
+using namespace BSM;
+
+int main()
+{
+  try
+  {
+    Checks::Tally check;
+    double const r = 0.03, D = 0.01, t = 0.0, St = 100.0;
+    ThreadPool   pool(4);
+
+    //-----------------------------------------------------------------------//
+    // A flat surface gives a flat local vol:                                //
+    //-----------------------------------------------------------------------//
+    VolSurface flat(r, D, t, St);
+    for (double T: {0.5, 1.0, 2.0})
+      flat.SetSlice(T, SVIParams{0.04 * T, 0.0, 0.0, 0.0, 0.1});
+    LocalVolGrid flatGrid(flat, 2.0);
+    double errFlat = 0.0;
+    for (size_t i = 0; i < flatGrid.NT(); ++i)
+      for (size_t j = 0; j < flatGrid.NX(); ++j)
+        errFlat = std::max(errFlat, std::fabs(flatGrid.Row(i)[j] - 0.04));
+    check("Flat surface: local var - 0.04", errFlat, 1e-14);
+
+    //-----------------------------------------------------------------------//
+    // A skewed (arbitrage-free) surface: the grid, with and without a pool: //
+    //-----------------------------------------------------------------------//
+    double const    Ts [3] = { 0.25, 0.75, 1.5 };
+    SVIParams const svi[3] =
+    {
+      { 0.008, 0.08, -0.50, 0.00, 0.15 },
+      { 0.025, 0.10, -0.45, 0.01, 0.20 },
+      { 0.050, 0.12, -0.40, 0.02, 0.25 }
+    };
+    VolSurface surf(r, D, t, St);
+    for (int e = 0; e < 3; ++e)
+      surf.SetSlice(Ts[e], svi[e]);
+
+    LocalVolGrid grid(surf, Ts[2], &pool);
+    LocalVolGrid grid1(surf, Ts[2]);
+    check("Arbitrage fallbacks (count)", double(grid.NFallbacks()), 0.0);
+    size_t nDiff = 0;
+    for (size_t i = 0; i < grid.NT(); ++i)
+      nDiff += (std::memcmp(grid.Row(i), grid1.Row(i),
+                            grid.NX() * sizeof(double)) != 0);
+    check("Grid with a ThreadPool != without (rows)", double(nDiff), 0.0);
+
+    //-----------------------------------------------------------------------//
+    // Europeans under the local vol reproduce the surface's Pxs:            //
+    //-----------------------------------------------------------------------//
+    // Within 4 StdErrs plus the Euler bias (O(dt), within 1e-3 of the Px
+    // with 50 steps):
+    MCParams p;
+    p.m_nPaths     = 100'000;
+    p.m_nSteps     = 50;
+    p.m_antithetic = true;
+    p.m_seed       = 7;
+    p.m_nThreads   = 4;
+    double errEur = 0.0;
+    for (double T: {Ts[1], Ts[2]})
+      for (double K: {80.0, 100.0, 120.0})
+      {
+        PayoffType type = (K < St) ? PayoffType::Put : PayoffType::Call;
+        double     w    = (type == PayoffType::Call) ? 1.0 : -1.0;
+        auto payoff = [K, w](double const* a_path, int a_nSteps)
+          { return std::max(w * (a_path[a_nSteps] - K), 0.0); };
+
+        MCRes  mc  = PxMCLocalVol(payoff, grid, T, p);
+        double ref = Px(type, K, T, r, D, surf.Sigma(K, T), t, St);
+        errEur     = std::max(errEur, std::fabs(mc.m_px - ref) /
+                              (4.0 * mc.m_stdErr + 1e-3 * ref));
+      }
+    check("Europeans vs surface Pxs (in 4 StdErr + 1e-3 Px)", errEur, 1.0);
+
+    //-----------------------------------------------------------------------//
+    // Bit-identical for any "m_nThreads" (Philox and Sobol):                //
+    //-----------------------------------------------------------------------//
+    auto call = [](double const* a_path, int a_nSteps)
+      { return std::max(a_path[a_nSteps] - 100.0, 0.0); };
+    double nSame = 0.0;
+    for (bool sobol: {false, true})
+    {
+      p.m_sobol    = sobol;
+      p.m_nPaths   = 50'001;
+      p.m_nSteps   = 16;
+      p.m_nThreads = 1;
+      MCRes a      = PxMCLocalVol(call, grid, 1.0, p);
+      p.m_nThreads = 3;
+      MCRes b      = PxMCLocalVol(call, grid, 1.0, p);
+      nSame += (std::memcmp(&a.m_px,     &b.m_px,     sizeof(double)) != 0) +
+               (std::memcmp(&a.m_stdErr, &b.m_stdErr, sizeof(double)) != 0) +
+               (a.m_nPaths != 50'002);
+    }
+    check("1 vs 3 threads: differences (count)", nSame, 0.0);
+
+    //-----------------------------------------------------------------------//
+    // Unsupported Modes and Invalid Args:                                   //
+    //-----------------------------------------------------------------------//
+    double nNoThrow = 0.0;
+    MCParams cv;
+    cv.m_ctrlVar = true;
+    MCParams ad;
+    ad.m_tolCI   = 0.01;
+    for (MCParams const& q: {cv, ad})
+      try
+      {
+        PxMCLocalVol(call, grid, 1.0, q);
+        ++nNoThrow;
+      }
+      catch (std::invalid_argument const&) {}
+    try
+    {
+      PxMCLocalVol(call, grid, 2.0 * Ts[2], p);   // Beyond the grid
+      ++nNoThrow;
+    }
+    catch (std::invalid_argument const&) {}
+    try
+    {
+      LocalVolGrid(surf, t);
+      ++nNoThrow;
+    }
+    catch (std::invalid_argument const&) {}
+    check("Invalid modes / args not throwing (count)", nNoThrow, 0.0);
+
+    return check.Result("CheckLocalVol");
+  }
+  catch (std::exception const& exn)
+  {
+    fprintf(stderr, "EXCEPTION: %s\n", exn.what());
+    return 1;
+  }
+}
@@ -0,0 +1,202 @@
+// vim:ts=2:et
+//===========================================================================//
+//                               "CheckModels.cpp":                          //
+//    Black-76 and Bachelier: Closed Forms, Implied Vols, "OptionChain"      //
+//===========================================================================//
+#include "ImpliedVol.h"
+#include "OptionChain.h"
+#include "Checks.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using namespace BSM;
+
+namespace
+{
+  //-------------------------------------------------------------------------//
+  // "BachelierRef": Independent Closed Form of the Normal Model:            //
+  //-------------------------------------------------------------------------//
+  //   Call = df * ((F - K) Phi(d) + s phi(d)),  d = (F - K) / s,
+  // with s = sigma * sqrt(tau), and the Put by the Put-Call Parity:
+  //
+  double BachelierRef
+    (bool a_call, double a_K, double a_tau, double a_r, double a_sigma,
+     double a_F)
+  {
+    double s    = a_sigma * std::sqrt(a_tau);
+    double d    = (a_F - a_K) / s;
+    double df   = std::exp(-a_r * a_tau);
+    double call = df * ((a_F - a_K) * 0.5 * std::erfc(-d / M_SQRT2) +
+                        s * std::exp(-0.5 * d * d) / std::sqrt(2.0 * M_PI));
+    return a_call ? call : call - df * (a_F - a_K);
+  }
+}
+
+int main()
+{
+  try
+  {
+    Checks::Tally check;
+    double const r = 0.02, t = 0.1;
+
+    std::mt19937_64                        gen(20240618);
+    std::uniform_real_distribution<double> u(0.0, 1.0);
+
+    //-----------------------------------------------------------------------//
+    // Black-76 == BSM with St = F and D = r (and Rho = -tau * Px):          //
+    //-----------------------------------------------------------------------//
+    double errB76 = 0.0, errRho = 0.0, errIV76 = 0.0, nFail76 = 0.0;
+    for (int i = 0; i < 1000; ++i)
+    {
+      PayoffType type  = (i % 2) ? PayoffType::Call : PayoffType::Put;
+      double     F     = 100.0;
+      double     K     = F * std::exp(0.6 * (2.0 * u(gen) - 1.0));
+      double     T     = t + 0.05 + 3.0 * u(gen);
+      double     sigma = 0.05 + 0.6 * u(gen);
+      // "a_D" (0.07) is ignored by Black-76:
+      Greeks b76 = PxGreeks(PxModel::Black76, type, K, T, r, 0.07, sigma, t,
+                            F);
+      Greeks bsm = PxGreeks(type, K, T, r, r, sigma, t, F);
+      errB76 = std::max({errB76,
+                         std::fabs(b76.m_px    - bsm.m_px)    / K,
+                         std::fabs(b76.m_delta - bsm.m_delta),
+                         std::fabs(b76.m_vega  - bsm.m_vega)  / K});
+      errRho = std::max(errRho, std::fabs(b76.m_rho + (T - t) * b76.m_px) /
+                                K);
+      // Round trip through "ImplVol", cold and far-off warm starts, for the
+      // Pxs with a time value above 1e-2 (as in "CheckImpliedVol"):
+      double intr = std::exp(-r * (T - t)) *
+        std::max(((type == PayoffType::Call) ? 1.0 : -1.0) * (F - K), 0.0);
+      if (!(b76.m_px - intr > 1e-2))
+        continue;
+      for (double s0: {0.0, 1e-3, 10.0})
+      {
+        IVStatus st = IVStatus::OK;
+        double   v  = ImplVol(PxModel::Black76, type, b76.m_px, K, T, r, 0.0,
+                              t, F, &st, s0);
+        nFail76 += (st != IVStatus::OK);
+        errIV76  = std::max(errIV76, std::fabs(v / sigma - 1.0));
+      }
+    }
+    check("Black-76 vs BSM(D = r): Px, Delta, Vega", errB76, 1e-15);
+    check("Black-76 Rho + tau * Px (rel to K)",       errRho, 1e-15);
+    check("Black-76 ImplVol failures (count)",        nFail76, 0.0);
+    check("Black-76 ImplVol round trip (rel)",        errIV76, 1e-10);
+
+    //-----------------------------------------------------------------------//
+    // Bachelier: vs the Closed Form, with F and K of any sign:              //
+    //-----------------------------------------------------------------------//
+    size_t const        n = 2000;
+    std::vector<double> Fs(n), Ks(n), Tn(n), sN(n), pxs(n);
+    std::vector<bool>   calls(n);
+    double errBach = 0.0;
+    for (size_t i = 0; i < n; ++i)
+    {
+      // Rates-like: F, K in [-1%, 4%], Normal vols of 20..200 bp:
+      Fs[i]    = -0.01 + 0.05 * u(gen);
+      Ks[i]    = -0.01 + 0.05 * u(gen);
+      Tn[i]    = t + 0.05 + 5.0 * u(gen);
+      sN[i]    = 0.002 + 0.018 * u(gen);
+      calls[i] = (i % 2 == 0);
+      PayoffType type = calls[i] ? PayoffType::Call : PayoffType::Put;
+      pxs[i]   = Px(PxModel::Bachelier, type, Ks[i], Tn[i], r, 0.0, sN[i], t,
+                    Fs[i]);
+      double ref = BachelierRef(calls[i], Ks[i], Tn[i] - t, r, sN[i], Fs[i]);
+      double s   = sN[i] * std::sqrt(Tn[i] - t);
+      errBach    = std::max(errBach, std::fabs(pxs[i] - ref) / s);
+    }
+    check("Bachelier vs closed form (rel to sigma sqrt(tau))", errBach,
+          1e-14);
+
+    //-----------------------------------------------------------------------//
+    // Bachelier Implied Vols: cold, and far-off warm starts:                //
+    //-----------------------------------------------------------------------//
+    double errIV = 0.0, nFail = 0.0;
+    for (size_t i = 0; i < n; ++i)
+    {
+      PayoffType type = calls[i] ? PayoffType::Call : PayoffType::Put;
+      // Skip the Pxs with (almost) no time value, where the vol is ill-
+      // conditioned:
+      double s    = sN[i] * std::sqrt(Tn[i] - t);
+      double intr = std::exp(-r * (Tn[i] - t)) *
+                    std::max((calls[i] ? 1.0 : -1.0) * (Fs[i] - Ks[i]), 0.0);
+      if (!(pxs[i] - intr > 1e-3 * s))
+        continue;
+      for (double s0: {0.0, 1e-3 * sN[i], 1e3 * sN[i]})
+      {
+        IVStatus st = IVStatus::OK;
+        double   v  = ImplVol(PxModel::Bachelier, type, pxs[i], Ks[i], Tn[i],
+                              r, 0.0, t, Fs[i], &st, s0);
+        nFail += (st != IVStatus::OK);
+        errIV  = std::max(errIV, std::fabs(v / sN[i] - 1.0));
+      }
+    }
+    check("Bachelier ImplVol failures (count)", nFail, 0.0);
+    check("Bachelier ImplVol round trip (rel)", errIV, 1e-10);
+
+    //-----------------------------------------------------------------------//
+    // "OptionChain::SetModel" == a Fresh Chain of that Model:               //
+    //-----------------------------------------------------------------------//
+    size_t const            m = 257;
+    std::vector<PayoffType> types(m);
+    std::vector<double>     K(m), T(m), lnVol(m), nVol(m);
+    for (size_t i = 0; i < m; ++i)
+    {
+      types[i] = (i % 3 == 0) ? PayoffType::Call
+               : (i % 3 == 1) ? PayoffType::Put : PayoffType::DigitalCall;
+      K    [i] = 100.0 * std::exp(0.4 * (2.0 * u(gen) - 1.0));
+      T    [i] = t + ((i % 5) + 1) * 0.3;
+      lnVol[i] = 0.1 + 0.4 * u(gen);
+      nVol [i] = 100.0 * lnVol[i];
+    }
+    OptionChain chain(m, types.data(), K.data(), T.data(), r, 0.01,
+                      lnVol.data(), t);
+    double nDiff = 0.0, errChain = 0.0;
+    for (PxModel model: {PxModel::Bachelier, PxModel::Black76, PxModel::BSM})
+    {
+      double const* vols = (model == PxModel::Bachelier) ? nVol.data()
+                                                         : lnVol.data();
+      chain.SetModel(model, vols);
+      OptionChain fresh(m, types.data(), K.data(), T.data(), r, 0.01, vols,
+                        t, model);
+      double const* a = chain.Reprice(103.0);
+      double const* b = fresh.Reprice(103.0);
+      nDiff += (std::memcmp(a, b, m * sizeof(double)) != 0);
+      for (size_t i = 0; i < m; ++i)
+        errChain = std::max(errChain, std::fabs(a[i] - Px<CDFCody>
+                   (model, types[i], K[i], T[i], r, 0.01, vols[i], t, 103.0))
+                   / std::max(K[i], 103.0));
+    }
+    check("SetModel vs a fresh chain (differing models)", nDiff,    0.0);
+    check("Chain vs Px, all models (rel to max(K, F))",   errChain, 1e-13);
+
+    // Bachelier chains take non-positive Fwds; a non-positive vol throws:
+    chain.SetModel(PxModel::Bachelier, nVol.data());
+    double negF  = chain.Reprice(-5.0)[1];   // A Put (K > 0 > F)
+    check("Bachelier chain at F = -5: Put vs ref (rel to K)", std::fabs(negF -
+          BachelierRef(false, K[1], T[1] - t, r, nVol[1], -5.0)) / K[1],
+          1e-13);
+    double nNoThrow = 0.0;
+    nVol[7] = 0.0;
+    try
+    {
+      chain.SetModel(PxModel::Bachelier, nVol.data());
+      ++nNoThrow;
+    }
+    catch (std::invalid_argument const&) {}
+    check("Non-positive Normal vol not throwing (count)", nNoThrow, 0.0);
+
+    return check.Result("CheckModels");
+  }
+  catch (std::exception const& exn)
+  {
+    fprintf(stderr, "EXCEPTION: %s\n", exn.what());
+    return 1;
+  }
+}
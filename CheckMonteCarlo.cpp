@@ -0,0 +1,173 @@
+// vim:ts=2:et
+//===========================================================================//
+//                             "CheckMonteCarlo.cpp":                        //
+//    Monte Carlo: Closed-Form Refs, Thread Determinism, Variance Reduction  //
+//===========================================================================//
+#include "MonteCarlo.hpp"
+#include "Checks.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+
+using namespace BSM;
+
+namespace
+{
+  //-------------------------------------------------------------------------//
+  // "GeomAsianCall": Closed-Form Px of the Discrete Geometric Asian Call:   //
+  //-------------------------------------------------------------------------//
+  // Averaging over path[1 .. n] (the "n" step times): log G is Normal, with
+  // the mean "m" and the variance "v" below:
+  //
+  double GeomAsianCall
+    (double a_K, double a_T, double a_r, double a_D, double a_sigma,
+     double a_St, int a_n)
+  {
+    double n  = double(a_n);
+    double m  = std::log(a_St) + (a_r - a_D - 0.5 * a_sigma * a_sigma) * a_T *
+                (n + 1.0) / (2.0 * n);
+    double v  = a_sigma * a_sigma * a_T * (n + 1.0) * (2.0 * n + 1.0) /
+                (6.0 * n * n);
+    double sv = std::sqrt(v);
+    double d2 = (m - std::log(a_K)) / sv;
+    auto   Phi = [](double a_x) { return 0.5 * std::erfc(-a_x / M_SQRT2); };
+    return std::exp(-a_r * a_T) *
+           (std::exp(m + 0.5 * v) * Phi(d2 + sv) - a_K * Phi(d2));
+  }
+
+  // Bitwise equality of 2 doubles:
+  bool Same(double a_x, double a_y)
+    { return std::memcmp(&a_x, &a_y, sizeof(double)) == 0; }
+}
+
+int main()
+{
+  try
+  {
+    Checks::Tally check;
+    double const K = 105.0, T = 1.0, r = 0.03, D = 0.01, sigma = 0.25,
+                 St = 100.0;
+    double const bsm = Px(PayoffType::Call, K, T, r, D, sigma, 0.0, St);
+    auto call = [K](double const* a_path, int a_nSteps)
+      { return std::max(a_path[a_nSteps] - K, 0.0); };
+
+    //-----------------------------------------------------------------------//
+    // European Call vs BSM (in StdErrs), and Thread Determinism:            //
+    //-----------------------------------------------------------------------//
+    MCParams p;
+    p.m_nPaths   = 1'000'000;
+    p.m_seed     = 42;
+    p.m_nThreads = 1;
+    MCRes ref = PxMC(call, T, r, D, sigma, 0.0, St, p);
+    check("Call vs BSM (StdErrs)", (ref.m_px - bsm) / ref.m_stdErr, 4.0);
+
+    double nDiff = 0.0;
+    for (int nThreads: {2, 3, 8})
+    {
+      p.m_nThreads = nThreads;
+      MCRes res = PxMC(call, T, r, D, sigma, 0.0, St, p);
+      nDiff += !Same(res.m_px, ref.m_px) + !Same(res.m_stdErr, ref.m_stdErr);
+    }
+    check("Px, StdErr with 2, 3, 8 threads != 1 thread (count)", nDiff, 0.0);
+
+    //-----------------------------------------------------------------------//
+    // Multi-Step Paths: Discrete Geometric Asian (Philox, Sobol + Bridge):  //
+    //-----------------------------------------------------------------------//
+    int    const n   = 16;
+    double const ga  = GeomAsianCall(100.0, T, r, D, sigma, St, n);
+    auto geomAsian = [](double const* a_path, int a_nSteps)
+    {
+      double s = 0.0;
+      for (int k = 1; k <= a_nSteps; ++k)
+        s += std::log(a_path[k]);
+      return std::max(std::exp(s / a_nSteps) - 100.0, 0.0);
+    };
+    p.m_nThreads = 0;
+    p.m_nSteps   = n;
+    p.m_nPaths   = 500'000;
+    MCRes gaMC   = PxMC(geomAsian, T, r, D, sigma, 0.0, St, p);
+    check("Geom Asian (16 steps) vs closed form (StdErrs)",
+          (gaMC.m_px - ga) / gaMC.m_stdErr, 4.0);
+
+    // Scrambled Sobol: the StdErr over-states the error,  so a fixed tol:
+    p.m_sobol    = true;
+    p.m_nPaths   = (1 << 16) - 1;
+    MCRes gaQMC  = PxMC(geomAsian, T, r, D, sigma, 0.0, St, p);
+    check("Geom Asian, Sobol + Bridge, 2^16 pts (rel)", gaQMC.m_px / ga - 1.0,
+          2e-3);
+    p.m_sobol    = false;
+    p.m_nSteps   = 1;
+
+    //-----------------------------------------------------------------------//
+    // Antithetic Variates: Odd Path Counts are Rounded Up:                  //
+    //-----------------------------------------------------------------------//
+    p.m_antithetic = true;
+    p.m_nPaths     = 1'000'001;
+    MCRes anti = PxMC(call, T, r, D, sigma, 0.0, St, p);
+    check("Antithetic: m_nPaths - 1'000'002",
+          double(anti.m_nPaths - 1'000'002), 0.0);
+    check("Antithetic: Call vs BSM (StdErrs)", (anti.m_px - bsm) /
+          anti.m_stdErr, 4.0);
+    check("Antithetic: StdErr / plain StdErr", anti.m_stdErr / ref.m_stdErr,
+          0.9);
+    p.m_nPaths = 1;
+    check("Antithetic: 1 path gives 2", double(
+          PxMC(call, T, r, D, sigma, 0.0, St, p).m_nPaths - 2), 0.0);
+    p.m_antithetic = false;
+
+    //-----------------------------------------------------------------------//
+    // Control Variate: the ATM Call for the 105 Call:                       //
+    //-----------------------------------------------------------------------//
+    p.m_nPaths  = 1'000'000;
+    p.m_ctrlVar = true;
+    MCRes cv = PxMC(call, T, r, D, sigma, 0.0, St, p);
+    check("Control Variate: Call vs BSM (StdErrs)", (cv.m_px - bsm) /
+          cv.m_stdErr, 4.0);
+    check("Control Variate: StdErr / plain StdErr", cv.m_stdErr /
+          ref.m_stdErr, 0.2);
+    p.m_ctrlVar = false;
+
+    //-----------------------------------------------------------------------//
+    // Adaptive Mode: Stops at the Tolerance, well before "m_nPaths":        //
+    //-----------------------------------------------------------------------//
+    p.m_nPaths = 100'000'000;
+    p.m_tolCI  = 0.02;
+    MCRes ad = PxMC(call, T, r, D, sigma, 0.0, St, p);
+    check("Adaptive: stopped by Tolerance (wrong count)",
+          double(ad.m_stop != MCStop::Tolerance), 0.0);
+    check("Adaptive: CI half-width - tol", std::max(1.96 * ad.m_stdErr -
+          p.m_tolCI, 0.0), 0.0);
+    check("Adaptive: paths used / m_nPaths", double(ad.m_nPaths) /
+          double(p.m_nPaths), 0.1);
+    check("Adaptive: Call vs BSM (StdErrs)", (ad.m_px - bsm) / ad.m_stdErr,
+          4.0);
+    p.m_tolCI  = 0.0;
+
+    //-----------------------------------------------------------------------//
+    // Invalid Args:                                                         //
+    //-----------------------------------------------------------------------//
+    double nNoThrow = 0.0;
+    auto expectThrow = [&](auto a_f)
+    {
+      try        { a_f(); ++nNoThrow; }
+      catch (std::invalid_argument const&) {}
+    };
+    expectThrow([&] { PxMC(call, T, r, D, -0.2, 0.0, St, p); });
+    expectThrow([&] { PxMC(call, T, r, D, sigma, 0.0, 0.0, p); });
+    expectThrow([&] { PxMC(call, -1.0, r, D, sigma, 0.0, St, p); });
+    MCParams bad = p;
+    bad.m_nPaths = 0;
+    expectThrow([&] { PxMC(call, T, r, D, sigma, 0.0, St, bad); });
+    check("Invalid args not throwing (count)", nNoThrow, 0.0);
+
+    return check.Result("CheckMonteCarlo");
+  }
+  catch (std::exception const& exn)
+  {
+    fprintf(stderr, "EXCEPTION: %s\n", exn.what());
+    return 1;
+  }
+}
@@ -0,0 +1,125 @@
+// vim:ts=2:et
+//===========================================================================//
+//                            "CheckOptionChain.cpp":                        //
+//        "OptionChain::Reprice" vs "Px": Mixed Types, Expired, Dividends    //
+//===========================================================================//
+#include "OptionChain.h"
+#include "Dividends.h"
+#include "Checks.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <exception>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using namespace BSM;
+
+int main()
+{
+  try
+  {
+    Checks::Tally check;
+
+    //-----------------------------------------------------------------------//
+    // A random chain: 4 PayoffTypes, 8 expirations (one of them expired):   //
+    //-----------------------------------------------------------------------//
+    double const r = 0.04, D = 0.015, t = 0.25;
+    double const Ts[8] = { 0.25, 0.27, 0.35, 0.5, 0.75, 1.25, 2.25, 5.25 };
+    PayoffType const types[4] =
+      { PayoffType::Call, PayoffType::Put, PayoffType::DigitalCall,
+        PayoffType::DigitalPut };
+
+    std::mt19937_64                        gen(20240611);
+    std::uniform_real_distribution<double> u(0.0, 1.0);
+    size_t const            n = 1001;
+    std::vector<PayoffType> type(n);
+    std::vector<double>     K(n), T(n), sigma(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+      type [i] = types[int(u(gen) * 4.0) % 4];
+      K    [i] = 100.0 * std::exp(0.5 * (2.0 * u(gen) - 1.0));
+      T    [i] = Ts[int(u(gen) * 8.0) % 8];
+      sigma[i] = 0.05 + 0.75 * u(gen);
+    }
+
+    //-----------------------------------------------------------------------//
+    // "Reprice" vs "Px" (with the same CDF), at several Underlying Pxs:     //
+    //-----------------------------------------------------------------------//
+    // Within 1e-13 * max(K, St), as documented in "OptionChain.h":
+    OptionChain chain(n, type.data(), K.data(), T.data(), r, D, sigma.data(),
+                      t);
+    double err = 0.0;
+    for (double St: {60.0, 95.0, 100.0, 104.5, 170.0})
+    {
+      double const* px = chain.Reprice(St);
+      for (size_t i = 0; i < n; ++i)
+      {
+        double ref = Px<CDFCody>(type[i], K[i], T[i], r, D, sigma[i], t, St);
+        err = std::max(err, std::fabs(px[i] - ref) / std::max(K[i], St));
+      }
+    }
+    check("Reprice vs Px<CDFCody> (rel to max(K, St))", err, 1e-13);
+
+    // The other CDF Policies agree with their own "Px" as well:
+    double errErf = 0.0;
+    double const* pe = chain.Reprice<CDFErf>(104.5);
+    for (size_t i = 0; i < n; ++i)
+      errErf = std::max(errErf, std::fabs(pe[i] - Px<CDFErf>
+               (type[i], K[i], T[i], r, D, sigma[i], t, 104.5)) /
+               std::max(K[i], 104.5));
+    check("Reprice<CDFErf> vs Px<CDFErf> (rel to max(K, St))", errErf,
+          1e-13);
+
+    //-----------------------------------------------------------------------//
+    // Cash Dividends: vs the Escrowed "Px" of "Dividends.h":                //
+    //-----------------------------------------------------------------------//
+    CashDiv const divs[3] = { {0.4, 1.0}, {0.9, 1.2}, {1.9, 1.5} };
+    DivSchedule   sched(3, divs);
+    OptionChain   divChain(n, type.data(), K.data(), T.data(), r, D,
+                           sigma.data(), t, PxModel::BSM, &sched);
+    double errDiv = 0.0;
+    for (double St: {60.0, 100.0, 170.0})
+    {
+      double const* px = divChain.Reprice(St);
+      for (size_t i = 0; i < n; ++i)
+      {
+        double ref = Px<CDFCody>(type[i], K[i], T[i], r, D, sigma[i], t, St,
+                                 sched);
+        errDiv = std::max(errDiv, std::fabs(px[i] - ref) /
+                          std::max(K[i], St));
+      }
+    }
+    check("Reprice with divs vs escrowed Px (rel to max(K, St))", errDiv,
+          1e-13);
+
+    //-----------------------------------------------------------------------//
+    // Invalid Underlying Pxs:                                               //
+    //-----------------------------------------------------------------------//
+    // (As in "Px", a NaN St gives NaN Pxs rather than an exception):
+    double nNoThrow = 0.0;
+    for (double St: {0.0, -1.0})
+      try
+      {
+        chain.Reprice(St);
+        ++nNoThrow;
+      }
+      catch (std::invalid_argument const&) {}
+    // The escrowed Px St - PV is non-positive:
+    try
+    {
+      divChain.Reprice(3.0);
+      ++nNoThrow;
+    }
+    catch (std::invalid_argument const&) {}
+    check("Invalid St not throwing (count)", nNoThrow, 0.0);
+
+    return check.Result("CheckOptionChain");
+  }
+  catch (std::exception const& exn)
+  {
+    fprintf(stderr, "EXCEPTION: %s\n", exn.what());
+    return 1;
+  }
+}
@@ -0,0 +1,118 @@
+// vim:ts=2:et
+//===========================================================================//
+//                                "CheckPDE.cpp":                            //
+//      Crank-Nicolson PDE: European vs BSM, American Benchmarks, Batches    //
+//===========================================================================//
+#include "PDE.h"
+#include "Checks.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <exception>
+#include <vector>
+
+using namespace BSM;
+
+int main()
+{
+  try
+  {
+    Checks::Tally check;
+    PDEPricer     pde;    // The default 400 x 200 grid
+
+    //-----------------------------------------------------------------------//
+    // Europeans vs BSM, by the total vol (the bounds of "PDE.h"):           //
+    //-----------------------------------------------------------------------//
+    // [0]: sigma * sqrt(tau) in [0.25, 0.75]; [1]: up to 1.25; [2]: up to 2:
+    double errEur[3] = {};
+    for (PayoffType type: {PayoffType::Call, PayoffType::Put})
+      for (double K: {50.0, 70.0, 90.0, 100.0, 110.0, 140.0, 200.0})
+        for (double T: {0.02, 0.1, 0.5, 1.0, 3.0, 5.0})
+          for (double sigma: {0.05, 0.1, 0.25, 0.5, 0.8})
+            for (double D: {0.0, 0.08})
+            {
+              double px  = pde.Px(type, false, K, T, 0.05, D, sigma, 0.0,
+                                  100.0);
+              double bs  = Px(type, K, T, 0.05, D, sigma, 0.0, 100.0);
+              double err = std::fabs(px - bs) / K;
+              double sd  = sigma * std::sqrt(T);
+              int    b   = (sd >= 0.25 && sd <= 0.75) ? 0
+                         : (sd <= 1.25)                ? 1 : 2;
+              errEur[b]  = std::max(errEur[b], err);
+            }
+    check("European vs BSM, vol*sqrt(T) 0.25..0.75 (rel to K)", errEur[0],
+          1e-5);
+    check("European vs BSM, vol*sqrt(T) <= 1.25   (rel to K)", errEur[1],
+          2e-5);
+    check("European vs BSM, vol*sqrt(T) <= 2      (rel to K)", errEur[2],
+          5e-5);
+
+    //-----------------------------------------------------------------------//
+    // American Benchmarks:                                                  //
+    //-----------------------------------------------------------------------//
+    // The Put with S = K = 100, r = 5%, vol = 20%, T = 1: 6.0903 (the conver-
+    // ged binomial value); the default grid gives 6.0898:
+    double amPut = pde.Px(PayoffType::Put, true, 100.0, 1.0, 0.05, 0.0, 0.2,
+                          0.0, 100.0);
+    check("American Put (S=K=100, r=5%, vol=20%, T=1) - 6.0903",
+          amPut - 6.0903, 6e-4);
+    PDEPricer fine(1600, 800);
+    double amFine = fine.Px(PayoffType::Put, true, 100.0, 1.0, 0.05, 0.0,
+                            0.2, 0.0, 100.0);
+    check("American Put, 1600 x 800 grid - 6.0903", amFine - 6.0903, 1e-4);
+
+    // With no dividends, the American Call is never exercised early:
+    double amCall = pde.Px(PayoffType::Call, true, 100.0, 1.0, 0.05, 0.0,
+                           0.2, 0.0, 100.0);
+    double euCall = Px(PayoffType::Call, 100.0, 1.0, 0.05, 0.0, 0.2, 0.0,
+                       100.0);
+    check("American Call (D=0) vs BSM (rel to K)", (amCall - euCall) / 100.0,
+          1e-5);
+
+    // The Early-Exercise Premium is non-negative, and deep ITM the American
+    // Put is worth its intrinsic value:
+    double minPremium = 0.0;
+    for (double K: {80.0, 100.0, 120.0})
+    {
+      double am = pde.Px(PayoffType::Put, true, K, 1.0, 0.05, 0.0, 0.3, 0.0,
+                         100.0);
+      double eu = Px(PayoffType::Put, K, 1.0, 0.05, 0.0, 0.3, 0.0, 100.0);
+      minPremium = std::min(minPremium, am - eu);
+    }
+    check("American Put: min early-exercise premium < 0", minPremium, 0.0);
+    double deep = pde.Px(PayoffType::Put, true, 200.0, 1.0, 0.05, 0.0, 0.2,
+                         0.0, 100.0);
+    check("American Put deep ITM (K=200) - intrinsic", deep - 100.0, 1e-6);
+
+    //-----------------------------------------------------------------------//
+    // "PxBatch" vs Single Solves:                                           //
+    //-----------------------------------------------------------------------//
+    size_t const        n = 64;
+    std::vector<double> Ks(n), sigmas(n), pxs(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+      Ks    [i] = 70.0 + double(i);
+      sigmas[i] = 0.15 + 0.005 * double(i);
+    }
+    double errBatch = 0.0;
+    for (bool american: {false, true})
+    {
+      pde.PxBatch(PayoffType::Put, american, n, Ks.data(), 1.0, 0.05, 0.02,
+                  sigmas.data(), 0.0, 100.0, pxs.data());
+      for (size_t i = 0; i < n; ++i)
+      {
+        double one = pde.Px(PayoffType::Put, american, Ks[i], 1.0, 0.05,
+                            0.02, sigmas[i], 0.0, 100.0);
+        errBatch   = std::max(errBatch, std::fabs(pxs[i] - one) / Ks[i]);
+      }
+    }
+    check("PxBatch vs single Px (rel to K)", errBatch, 1e-5);
+
+    return check.Result("CheckPDE");
+  }
+  catch (std::exception const& exn)
+  {
+    fprintf(stderr, "EXCEPTION: %s\n", exn.what());
+    return 1;
+  }
+}
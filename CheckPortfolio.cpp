@@ -0,0 +1,174 @@
+// vim:ts=2:et
+//===========================================================================//
+//                             "CheckPortfolio.cpp":                         //
+//   Portfolio Totals: Thread-Count Determinism, Accuracy, Mixed Precision   //
+//===========================================================================//
+#include "Portfolio.h"
+#include "Checks.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <random>
+#include <vector>
+
+using namespace BSM;
+
+namespace
+{
+  //-------------------------------------------------------------------------//
+  // "Flds": The 6 Flds of "Greeks", in the "Portfolio" order:               //
+  //-------------------------------------------------------------------------//
+  void Flds(Greeks const& a_g, double* a_v)
+  {
+    a_v[0] = a_g.m_px;
+    a_v[1] = a_g.m_delta;
+    a_v[2] = a_g.m_gamma;
+    a_v[3] = a_g.m_vega;
+    a_v[4] = a_g.m_theta;
+    a_v[5] = a_g.m_rho;
+  }
+
+  //-------------------------------------------------------------------------//
+  // "Results": All Totals of a Run, as a flat vector (for exact compares):  //
+  //-------------------------------------------------------------------------//
+  std::vector<double> Results(Portfolio const& a_pf, int a_nUnds)
+  {
+    std::vector<double> res;
+    double              v[6];
+    auto add = [&](Greeks const& a_g)
+      { Flds(a_g, v); res.insert(res.end(), v, v + 6); };
+
+    add(a_pf.Total());
+    for (int u = 0; u < a_nUnds; ++u)
+      add(a_pf.UnderlyingTotal(u));
+    for (size_t b = 0; b < a_pf.NBuckets(); ++b)
+      add(a_pf.BucketTotal(b));
+    return res;
+  }
+}
+
+int main()
+{
+  try
+  {
+    Checks::Tally check;
+
+    //-----------------------------------------------------------------------//
+    // A random book: several Chunks per Bucket, and a partial last Chunk:   //
+    //-----------------------------------------------------------------------//
+    int    const nUnds = 7;
+    size_t const n     = 30'011;
+    double const r     = 0.03, t = 0.1;
+    double const Ts[]  = { 0.25, 0.5, 1.0, 2.0 };
+    double       St[nUnds], D[nUnds];
+
+    std::mt19937_64                        gen(20240607);
+    std::uniform_real_distribution<double> u(0.0, 1.0);
+    for (int i = 0; i < nUnds; ++i)
+    {
+      St[i] = 50.0 + 100.0 * u(gen);
+      D [i] = 0.04 * u(gen);
+    }
+    std::vector<Position> pos(n);
+    for (Position& p: pos)
+    {
+      p.m_und   = int(u(gen) * nUnds) % nUnds;
+      p.m_type  = (u(gen) < 0.5) ? PayoffType::Call : PayoffType::Put;
+      p.m_K     = St[p.m_und] * (0.6 + 0.8 * u(gen));
+      p.m_T     = Ts[int(u(gen) * 4.0) % 4];
+      p.m_sigma = 0.1 + 0.5 * u(gen);
+      p.m_qty   = std::round(200.0 * u(gen)) - 100.0;
+    }
+
+    //-----------------------------------------------------------------------//
+    // Bit-identical Totals for any number of threads:                       //
+    //-----------------------------------------------------------------------//
+    std::vector<double> ref;
+    for (int nThreads: {1, 2, 3, 8})
+    {
+      Portfolio pf(n, pos.data(), nUnds, nThreads);
+      pf.Run(r, t, St, D);
+      std::vector<double> res = Results(pf, nUnds);
+      if (ref.empty())
+      {
+        ref = res;
+        continue;
+      }
+      size_t nDiff = 0;
+      for (size_t i = 0; i < res.size(); ++i)
+        nDiff += (std::memcmp(&res[i], &ref[i], sizeof(double)) != 0);
+      char what[64];
+      snprintf(what, sizeof(what),
+               "Totals with %d threads != 1 thread (count)", nThreads);
+      check(what, double(nDiff), 0.0);
+    }
+
+    //-----------------------------------------------------------------------//
+    // The Total vs a scalar "PxGreeks" loop:                                //
+    //-----------------------------------------------------------------------//
+    // Relative to the sum of |Qty * Greek|, ie to the condition number of
+    // the sum (the Portfolio sums are pairwise, the loop's sequential):
+    Portfolio pf(n, pos.data(), nUnds, 2);
+    pf.Run(r, t, St, D);
+    double tot[6];
+    Flds(pf.Total(), tot);
+
+    double sum[6] = {}, absSum[6] = {};
+    double notional = 0.0;    // sum(|Qty| * max(K, St))
+    for (Position const& p: pos)
+    {
+      double v[6];
+      Flds(PxGreeks(p.m_type, p.m_K, p.m_T, r, D[p.m_und], p.m_sigma, t,
+                    St[p.m_und]), v);
+      for (int k = 0; k < 6; ++k)
+      {
+        sum   [k] += p.m_qty * v[k];
+        absSum[k] += std::fabs(p.m_qty * v[k]);
+      }
+      notional += std::fabs(p.m_qty) * std::max(p.m_K, St[p.m_und]);
+    }
+    char const* names[6] =
+      { "Px", "Delta", "Gamma", "Vega", "Theta", "Rho" };
+    for (int k = 0; k < 6; ++k)
+    {
+      char what[64];
+      snprintf(what, sizeof(what), "Total %s vs PxGreeks loop (rel)",
+               names[k]);
+      check(what, (tot[k] - sum[k]) / absSum[k], 2e-14);
+    }
+
+    //-----------------------------------------------------------------------//
+    // Mixed Precision: within the bound documented in "Portfolio.h":        //
+    //-----------------------------------------------------------------------//
+    pf.Run(r, t, St, D, PFPrecision::Mixed);
+    double mixed[6];
+    Flds(pf.Total(), mixed);
+    check("Mixed Total Px vs Double (rel to sum |Qty| max(K,St))",
+          (mixed[0] - tot[0]) / notional, 3e-7);
+
+    // The worst case of the bound is a single position:
+    double errOne = 0.0;
+    for (size_t i = 0; i < 2000; ++i)
+    {
+      Position const& p = pos[i];
+      if (p.m_qty == 0.0)
+        continue;
+      Portfolio one(1, &p, nUnds, 1);
+      one.Run(r, t, St, D);
+      double px = one.Total().m_px;
+      one.Run(r, t, St, D, PFPrecision::Mixed);
+      errOne = std::max(errOne, std::fabs(one.Total().m_px - px) /
+                        (std::fabs(p.m_qty) * std::max(p.m_K, St[p.m_und])));
+    }
+    check("Mixed single-position Px (rel to |Qty| max(K,St))", errOne, 3e-7);
+
+    return check.Result("CheckPortfolio");
+  }
+  catch (std::exception const& exn)
+  {
+    fprintf(stderr, "EXCEPTION: %s\n", exn.what());
+    return 1;
+  }
+}
@@ -0,0 +1,131 @@
+// vim:ts=2:et
+//===========================================================================//
+//                               "CheckSABR.cpp":                            //
+//      SABR Vols (Hagan / Obloj): Jacobian, ATM Series and Calibration      //
+//===========================================================================//
+#include "SABR.h"
+#include "Checks.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <exception>
+#include <stdexcept>
+
+using namespace BSM;
+
+int main()
+{
+  try
+  {
+    Checks::Tally check;
+    double const  F   = 0.03;
+    double const  tau = 1.5;
+    SABRParams    sTruth { 0.012, 0.5, -0.35, 0.45 };
+
+    for (SABRFormula formula: {SABRFormula::Hagan, SABRFormula::Obloj})
+    {
+      char const* name = (formula == SABRFormula::Hagan) ? "Hagan" : "Obloj";
+      char what[64];
+
+      //---------------------------------------------------------------------//
+      // The analytic Jacobian vs central differences:                       //
+      //---------------------------------------------------------------------//
+      double K[11], vol[11], dA[11], dR[11], dN[11];
+      for (int i = 0; i < 11; ++i)
+        K[i] = F * (0.5 + 0.1 * i);
+      SABRVols(sTruth, formula, F, tau, 11, K, vol, dA, dR, dN);
+
+      double errJ = 0.0;
+      for (int i = 0; i < 11; ++i)
+      {
+        double const h = 1e-6;
+        SABRParams up = sTruth, dn = sTruth;
+        up.m_alpha += h * sTruth.m_alpha;
+        dn.m_alpha -= h * sTruth.m_alpha;
+        double fdA = (SABRVol(up, formula, F, tau, K[i]) -
+                      SABRVol(dn, formula, F, tau, K[i])) /
+                     (2.0 * h * sTruth.m_alpha);
+        up = sTruth; dn = sTruth;
+        up.m_rho += h;
+        dn.m_rho -= h;
+        double fdR = (SABRVol(up, formula, F, tau, K[i]) -
+                      SABRVol(dn, formula, F, tau, K[i])) / (2.0 * h);
+        up = sTruth; dn = sTruth;
+        up.m_nu += h;
+        dn.m_nu -= h;
+        double fdN = (SABRVol(up, formula, F, tau, K[i]) -
+                      SABRVol(dn, formula, F, tau, K[i])) / (2.0 * h);
+        errJ = std::max({errJ, std::fabs(dA[i] - fdA) * sTruth.m_alpha,
+                         std::fabs(dR[i] - fdR), std::fabs(dN[i] - fdN)});
+      }
+      snprintf(what, sizeof(what), "SABR %s: Jacobian vs finite diffs", name);
+      check(what, errJ, 1e-8);
+
+      //---------------------------------------------------------------------//
+      // The ATM series: continuous across K = F:                            //
+      //---------------------------------------------------------------------//
+      double errA = 0.0;
+      double atm  = SABRVol(sTruth, formula, F, tau, F);
+      for (double e: {1e-9, 1e-7, 1e-5})
+        errA = std::max({errA,
+                         std::fabs(SABRVol(sTruth, formula, F, tau,
+                                           F * (1.0 + e)) - atm) / e,
+                         std::fabs(SABRVol(sTruth, formula, F, tau,
+                                           F * (1.0 - e)) - atm) / e});
+      snprintf(what, sizeof(what), "SABR %s: ATM vol slope (near K = F)",
+               name);
+      check(what, errA, 1.0);
+
+      //---------------------------------------------------------------------//
+      // Calibration: vols generated from known params:                      //
+      //---------------------------------------------------------------------//
+      SABRParams sp;
+      sp.m_beta  = sTruth.m_beta;
+      LMRes sRes = SABRCalibrate(formula, F, tau, 11, K, vol, nullptr, &sp);
+
+      double errS = std::max({std::fabs(sp.m_alpha - sTruth.m_alpha) / F,
+                              std::fabs(sp.m_rho   - sTruth.m_rho),
+                              std::fabs(sp.m_nu    - sTruth.m_nu)});
+      snprintf(what, sizeof(what), "SABR %s: RMSE of the vol residuals", name);
+      check(what, sRes.m_rmse, 1e-10);
+      snprintf(what, sizeof(what), "SABR %s: params vs the truth", name);
+      check(what, errS, 1e-6);
+    }
+
+    //-----------------------------------------------------------------------//
+    // Invalid F or Strikes are rejected before any work:                    //
+    //-----------------------------------------------------------------------//
+    double K[3]   = { 0.02, 0.03, 0.04 };
+    double vol[3] = { 0.08, 0.07, 0.075 };
+    int    nBad   = 0;
+    for (double badF: {0.0, -0.01, double(NAN), double(INFINITY)})
+    {
+      SABRParams sp;
+      sp.m_beta = 0.5;
+      try
+      {
+        SABRCalibrate(SABRFormula::Hagan, badF, tau, 3, K, vol, nullptr,
+                      &sp);
+      }
+      catch (std::invalid_argument const&) { ++nBad; }
+    }
+    K[1] = -0.03;
+    {
+      SABRParams sp;
+      sp.m_beta = 0.5;
+      try
+      {
+        SABRCalibrate(SABRFormula::Hagan, F, tau, 3, K, vol, nullptr, &sp);
+      }
+      catch (std::invalid_argument const&) { ++nBad; }
+    }
+    check("SABRCalibrate: invalid F / K not rejected", 5 - nBad, 0.0);
+
+    return check.Result("CheckSABR");
+  }
+  catch (std::exception const& exn)
+  {
+    fprintf(stderr, "EXCEPTION: %s\n", exn.what());
+    return 1;
+  }
+}
@@ -0,0 +1,111 @@
+// vim:ts=2:et
+//===========================================================================//
+//                             "CheckScenarios.cpp":                         //
+//      "ScenarioGrid" vs "Px" in Every Scenario; "BookPx" vs the Sum        //
+//===========================================================================//
+#include "Scenarios.h"
+#include "Checks.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <exception>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using namespace BSM;
+
+int main()
+{
+  try
+  {
+    Checks::Tally check;
+
+    //-----------------------------------------------------------------------//
+    // 400 Random Options: 4 PayoffTypes, some Expired, 3 Underlyings:       //
+    //-----------------------------------------------------------------------//
+    double const r = 0.03, D = 0.01, t = 0.5;
+    PayoffType const types[4] =
+      { PayoffType::Call, PayoffType::Put, PayoffType::DigitalCall,
+        PayoffType::DigitalPut };
+    double const Ts[5] = { 0.5, 0.6, 0.75, 1.5, 3.5 };
+
+    std::mt19937_64                        gen(20240614);
+    std::uniform_real_distribution<double> u(0.0, 1.0);
+    size_t const            n = 400;
+    std::vector<PayoffType> type(n);
+    std::vector<double>     K(n), T(n), sigma(n), St(n), qty(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+      type [i] = types[int(u(gen) * 4.0) % 4];
+      St   [i] = (i % 3 == 0) ? 50.0 : (i % 3 == 1) ? 100.0 : 250.0;
+      K    [i] = St[i] * std::exp(0.4 * (2.0 * u(gen) - 1.0));
+      T    [i] = Ts[(i / 7) % 5];   // Runs of equal expirations
+      sigma[i] = 0.08 + 0.6 * u(gen);
+      qty  [i] = std::round(20.0 * u(gen)) - 10.0;
+    }
+
+    //-----------------------------------------------------------------------//
+    // "Px" in Each Scenario (of the Default 21 x 21 Grid):                  //
+    //-----------------------------------------------------------------------//
+    // (Some of the shocked vols are floored at "ScenVolFloor"):
+    ScenarioGrid        grid;
+    size_t const        m = grid.Size();
+    std::vector<double> px(n * m);
+    grid.Px(n, type.data(), K.data(), T.data(), r, D, sigma.data(), t,
+            St.data(), px.data());
+
+    double err = 0.0;
+    std::vector<double> book(m, 0.0);   // The qty-weighted sum of "px"
+    for (size_t i = 0; i < n; ++i)
+      for (size_t j = 0; j < grid.NVol(); ++j)
+        for (size_t k = 0; k < grid.NSpot(); ++k)
+        {
+          // The default grid: by 2% in spot and by 1 point in vol:
+          double S   = St[i] * (1.0 + (double(k) - 10.0) * 0.02);
+          double vol = std::max(sigma[i] + (double(j) - 10.0) * 0.01,
+                                ScenVolFloor);
+          double ref = Px<CDFCody>(type[i], K[i], T[i], r, D, vol, t, S);
+          double val = px[i * m + j * grid.NSpot() + k];
+          err        = std::max(err, std::fabs(val - ref) /
+                                std::max(K[i], S));
+          book[j * grid.NSpot() + k] += qty[i] * val;
+        }
+    check("ScenarioGrid::Px vs Px (rel to max(K, S))", err, 1e-13);
+
+    //-----------------------------------------------------------------------//
+    // "BookPx" vs the Qty-Weighted Sum of the Matrices:                     //
+    //-----------------------------------------------------------------------//
+    std::vector<double> bookPx(m);
+    grid.BookPx(n, type.data(), K.data(), T.data(), r, D, sigma.data(), t,
+                St.data(), qty.data(), bookPx.data());
+    double errBook = 0.0, scale = 0.0;
+    for (size_t s = 0; s < m; ++s)
+    {
+      errBook = std::max(errBook, std::fabs(bookPx[s] - book[s]));
+      scale   = std::max(scale,   std::fabs(book[s]));
+    }
+    check("BookPx vs sum of Qty * Px (rel to max |sum|)", errBook / scale,
+          1e-13);
+
+    //-----------------------------------------------------------------------//
+    // Invalid Spot Shocks:                                                  //
+    //-----------------------------------------------------------------------//
+    double nNoThrow = 0.0;
+    try
+    {
+      double const spot[2] = { -1.0, 0.0 }, vol[1] = { 0.0 };
+      ScenarioGrid bad(2, spot, 1, vol);
+      ++nNoThrow;
+    }
+    catch (std::invalid_argument const&) {}
+    check("SpotShock <= -1 not throwing (count)", nNoThrow, 0.0);
+
+    return check.Result("CheckScenarios");
+  }
+  catch (std::exception const& exn)
+  {
+    fprintf(stderr, "EXCEPTION: %s\n", exn.what());
+    return 1;
+  }
+}
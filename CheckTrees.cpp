@@ -0,0 +1,102 @@
+// vim:ts=2:et
+//===========================================================================//
+//                               "CheckTrees.cpp":                           //
+//     Binomial and Trinomial Trees: Europeans vs BSM, American Benchmark    //
+//===========================================================================//
+#include "Trees.h"
+#include "Checks.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <exception>
+#include <vector>
+
+using namespace BSM;
+
+int main()
+{
+  try
+  {
+    Checks::Tally check;
+    char const*   names[3] = { "CRR", "Leisen-Reimer", "Trinomial" };
+    TreeType      types[3] =
+      { TreeType::CRR, TreeType::LeisenReimer, TreeType::Trinomial };
+
+    for (int i = 0; i < 3; ++i)
+    {
+      TreePricer tree(types[i], 1000);
+      char       what[80];
+
+      //---------------------------------------------------------------------//
+      // Europeans vs BSM (1000 steps):                                      //
+      //---------------------------------------------------------------------//
+      double errEur = 0.0;
+      for (PayoffType type: {PayoffType::Call, PayoffType::Put})
+        for (double K: {80.0, 100.0, 120.0})
+          for (double T: {0.25, 1.0})
+          {
+            double px = tree.Px(type, ExerStyle::European, K, T, 0.05, 0.02,
+                                0.25, 0.0, 100.0);
+            double bs = Px(type, K, T, 0.05, 0.02, 0.25, 0.0, 100.0);
+            errEur    = std::max(errEur, std::fabs(px - bs) / K);
+          }
+      snprintf(what, sizeof(what), "%s: European vs BSM (rel to K)",
+               names[i]);
+      check(what, errEur, (i == 1) ? 1e-6 : 1e-4);
+
+      //---------------------------------------------------------------------//
+      // The American Put with S = K = 100, r = 5%, vol = 20%, T = 1:        //
+      //---------------------------------------------------------------------//
+      // The 1000-step values are 6.0896 (CRR), 6.0901 (LR) and 6.0896 (Tri-
+      // nomial), vs the converged 6.0903:
+      double const am[3] = { 6.0896, 6.0901, 6.0896 };
+      double amPut = tree.Px(PayoffType::Put, ExerStyle::American, 100.0,
+                             1.0, 0.05, 0.0, 0.2, 0.0, 100.0);
+      snprintf(what, sizeof(what), "%s: American Put - %.4f", names[i],
+               am[i]);
+      check(what, amPut - am[i], 5e-5);
+
+      // Bermudan on every step == American; with no dates == European (NB:
+      // Leisen-Reimer uses 1001 steps):
+      std::vector<double> dates((i == 1) ? 1001 : 1000);
+      for (size_t k = 0; k < dates.size(); ++k)
+        dates[k] = double(k + 1) / double(dates.size());
+      double berm = tree.Px(PayoffType::Put, ExerStyle::Bermudan, 100.0, 1.0,
+                            0.05, 0.0, 0.2, 0.0, 100.0, dates.data(),
+                            dates.size());
+      double eur  = tree.Px(PayoffType::Put, ExerStyle::European, 100.0, 1.0,
+                            0.05, 0.0, 0.2, 0.0, 100.0);
+      double none = tree.Px(PayoffType::Put, ExerStyle::Bermudan, 100.0, 1.0,
+                            0.05, 0.0, 0.2, 0.0, 100.0);
+      snprintf(what, sizeof(what), "%s: Bermudan (all steps) - American",
+               names[i]);
+      check(what, berm - amPut, 1e-12);
+      snprintf(what, sizeof(what), "%s: Bermudan (no dates) - European",
+               names[i]);
+      check(what, none - eur, 1e-12);
+
+      //---------------------------------------------------------------------//
+      // "PxBatch" vs "Px", and an empty batch:                              //
+      //---------------------------------------------------------------------//
+      double const Ks[5] = { 80.0, 90.0, 100.0, 110.0, 120.0 };
+      double       pxs[5];
+      tree.PxBatch(PayoffType::Put, ExerStyle::American, 5, Ks, 1.0, 0.05,
+                   0.0, 0.2, 0.0, 100.0, pxs);
+      double errBatch = 0.0;
+      for (int k = 0; k < 5; ++k)
+        errBatch = std::max(errBatch, std::fabs(pxs[k] - tree.Px
+                   (PayoffType::Put, ExerStyle::American, Ks[k], 1.0, 0.05,
+                    0.0, 0.2, 0.0, 100.0)));
+      snprintf(what, sizeof(what), "%s: PxBatch vs Px", names[i]);
+      check(what, errBatch, 1e-12);
+      tree.PxBatch(PayoffType::Put, ExerStyle::American, 0, nullptr, 1.0,
+                   0.05, 0.0, 0.2, 0.0, 100.0, nullptr);
+    }
+    return check.Result("CheckTrees");
+  }
+  catch (std::exception const& exn)
+  {
+    fprintf(stderr, "EXCEPTION: %s\n", exn.what());
+    return 1;
+  }
+}
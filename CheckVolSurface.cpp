@@ -0,0 +1,203 @@
+// vim:ts=2:et
+//===========================================================================//
+//                             "CheckVolSurface.cpp":                        //
+//      SVI / SSVI Surface: Interpolation, Batch Lookups, Calibration        //
+//===========================================================================//
+#include "VolSurface.h"
+#include "Checks.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <exception>
+#include <stdexcept>
+#include <vector>
+
+using namespace BSM;
+
+int main()
+{
+  try
+  {
+    Checks::Tally check;
+    double const r = 0.03, D = 0.01, t = 0.2, St = 100.0;
+
+    //-----------------------------------------------------------------------//
+    // A surface of 3 known slices:                                          //
+    //-----------------------------------------------------------------------//
+    double const    Ts [3] = { 0.45, 1.2, 2.2 };
+    SVIParams const svi[3] =
+    {
+      { 0.010, 0.10, -0.40, 0.00, 0.20 },
+      { 0.035, 0.12, -0.35, 0.02, 0.25 },
+      { 0.070, 0.13, -0.30, 0.05, 0.30 }
+    };
+    VolSurface surf(r, D, t, St);
+    for (int e = 2; e >= 0; --e)          // In any order
+      surf.SetSlice(Ts[e], svi[e]);
+
+    // The reference: total var linear in "tau" between the slices (at the
+    // same k = log(K / F(tau))), and flat vols beyond them:
+    auto refSigma = [&](double a_K, double a_T)
+    {
+      double tau = a_T - t;
+      double k   = std::log(a_K / St) - (r - D) * tau;
+      auto   vol = [&](int a_e)
+        { return std::sqrt(SVITotalVar(svi[a_e], k) / (Ts[a_e] - t)); };
+      if (a_T <= Ts[0])
+        return vol(0);
+      if (a_T >= Ts[2])
+        return vol(2);
+      int    e  = (a_T < Ts[1]) ? 0 : 1;
+      double x  = (tau - (Ts[e] - t)) / (Ts[e + 1] - Ts[e]);
+      double w  = (1.0 - x) * SVITotalVar(svi[e], k) +
+                  x * SVITotalVar(svi[e + 1], k);
+      return std::sqrt(w / tau);
+    };
+
+    std::vector<double> Ks, TsAll;
+    for (double T: {0.25, 0.45, 0.8, 1.2, 1.7, 2.2, 4.0})
+      for (double K = 50.0; K <= 200.0; K += 5.0)
+      {
+        Ks   .push_back(K);
+        TsAll.push_back(T);
+      }
+    size_t const n = Ks.size();
+
+    double errSigma = 0.0, errView = 0.0;
+    for (size_t i = 0; i < n; ++i)
+    {
+      double s  = surf.Sigma(Ks[i], TsAll[i]);
+      errSigma  = std::max(errSigma, std::fabs(s / refSigma(Ks[i], TsAll[i])
+                                               - 1.0));
+      errView   = std::max(errView, std::fabs(surf.At(TsAll[i]).Sigma(Ks[i])
+                                              - s));
+    }
+    check("Sigma vs linear-in-tau total var (rel)", errSigma, 1e-14);
+    check("ExpiryView::Sigma vs Sigma (abs)",       errView,  0.0);
+
+    //-----------------------------------------------------------------------//
+    // Batch Lookups: "ChainSigmas" and "Sigmas" (unsorted), and "PxBatch":  //
+    //-----------------------------------------------------------------------//
+    std::vector<double> chain(n), pairs(n), px(n);
+    double errChain = 0.0;
+    for (size_t i0 = 0; i0 < n; )
+    {
+      size_t i1 = i0;
+      while (i1 < n && TsAll[i1] == TsAll[i0])
+        ++i1;
+      surf.ChainSigmas(TsAll[i0], i1 - i0, Ks.data() + i0, chain.data() + i0);
+      i0 = i1;
+    }
+    // "Sigmas" on the pairs in reverse order:
+    std::vector<double> Kr(Ks.rbegin(), Ks.rend()),
+                        Tr(TsAll.rbegin(), TsAll.rend());
+    surf.Sigmas(n, Kr.data(), Tr.data(), pairs.data());
+    double errPairs = 0.0;
+    for (size_t i = 0; i < n; ++i)
+    {
+      double s = surf.Sigma(Ks[i], TsAll[i]);
+      errChain = std::max(errChain, std::fabs(chain[i] / s - 1.0));
+      errPairs = std::max(errPairs, std::fabs(pairs[n - 1 - i] / s - 1.0));
+    }
+    check("ChainSigmas vs Sigma (rel)", errChain, 1e-13);
+    check("Sigmas (unsorted) vs Sigma (rel)", errPairs, 1e-13);
+
+    surf.PxBatch(PayoffType::Put, n, Ks.data(), TsAll.data(), px.data());
+    double errPx = 0.0;
+    for (size_t i = 0; i < n; ++i)
+      errPx = std::max(errPx, std::fabs(px[i] - Px<CDFCody>
+              (PayoffType::Put, Ks[i], TsAll[i], r, D,
+               surf.Sigma(Ks[i], TsAll[i]), t, St)) / std::max(Ks[i], St));
+    check("PxBatch vs Px at the surface vols (rel to max(K, St))", errPx,
+          1e-13);
+
+    //-----------------------------------------------------------------------//
+    // "CalibrateSlice": Recovery of a Known Slice (cold and warm starts):   //
+    //-----------------------------------------------------------------------//
+    std::vector<double> Kq, vq;
+    for (double K = 60.0; K <= 160.0; K += 5.0)
+    {
+      Kq.push_back(K);
+      vq.push_back(surf.Sigma(K, Ts[1]));
+    }
+    VolSurface fit(r, D, t, St);
+    LMRes cold = fit.CalibrateSlice(Ts[1], Kq.size(), Kq.data(), vq.data());
+    double errFit = 0.0;
+    for (double K = 60.0; K <= 160.0; K += 2.5)
+      errFit = std::max(errFit, std::fabs(fit.Sigma(K, Ts[1]) -
+                                          surf.Sigma(K, Ts[1])));
+    check("CalibrateSlice cold: RMSE (vol)",            cold.m_rmse, 1e-8);
+    check("CalibrateSlice cold: max vol err (K 60..160)", errFit,    1e-7);
+    LMRes warm = fit.CalibrateSlice(Ts[1], Kq.size(), Kq.data(), vq.data());
+    check("CalibrateSlice warm: RMSE (vol)",            warm.m_rmse, 1e-8);
+    check("CalibrateSlice warm: iterations <= cold",
+          double(std::max(warm.m_nIter - cold.m_nIter, 0)), 0.0);
+
+    //-----------------------------------------------------------------------//
+    // "CalibrateSSVI": Recovery of Known (rho, eta, gamma):                 //
+    //-----------------------------------------------------------------------//
+    // (within the calibration bounds: eta <= 1, gamma <= 1/2):
+    SSVIParams const ssvi = { -0.45, 0.8, 0.35 };
+    std::vector<CalibQuote> quotes;
+    for (double T: {0.45, 0.7, 1.2, 2.2})
+    {
+      double tau   = T - t;
+      double theta = 0.04 * tau + 0.002 * tau * tau;   // ATM total var
+      double phi   = ssvi.m_eta / (std::pow(theta, ssvi.m_gamma) *
+                                   std::pow(1.0 + theta, 1.0 - ssvi.m_gamma));
+      for (double K = 70.0; K <= 140.0; K += 5.0)
+      {
+        double k  = std::log(K / St) - (r - D) * tau;
+        double pk = phi * k;
+        double w  = 0.5 * theta * (1.0 + ssvi.m_rho * pk + std::sqrt(
+                    (pk + ssvi.m_rho) * (pk + ssvi.m_rho) + 1.0 -
+                    ssvi.m_rho * ssvi.m_rho));
+        quotes.push_back(CalibQuote{K, T, std::sqrt(w / tau), 1.0});
+      }
+    }
+    VolSurface ss(r, D, t, St);
+    SSVIParams res;
+    LMRes      lm = ss.CalibrateSSVI(quotes.size(), quotes.data(), &res);
+    double errQ = 0.0;
+    for (CalibQuote const& q: quotes)
+      errQ = std::max(errQ, std::fabs(ss.Sigma(q.m_K, q.m_T) - q.m_vol));
+    // Not exact: theta(T) is interpolated between the Strikes nearest to F:
+    check("CalibrateSSVI: RMSE (vol)",                lm.m_rmse, 1e-4);
+    check("CalibrateSSVI: max vol err at the quotes", errQ,      2e-4);
+    check("CalibrateSSVI: rho",   res.m_rho   - ssvi.m_rho,   1e-2);
+    check("CalibrateSSVI: eta",   res.m_eta   - ssvi.m_eta,   1e-2);
+    check("CalibrateSSVI: gamma", res.m_gamma - ssvi.m_gamma, 1e-2);
+
+    //-----------------------------------------------------------------------//
+    // Exceptions:                                                           //
+    //-----------------------------------------------------------------------//
+    double nBad = 0.0;
+    try
+    {
+      VolSurface(r, D, t, St).Sigma(100.0, 1.0);
+      ++nBad;
+    }
+    catch (std::logic_error const&) {}
+    for (double K: {0.0, -1.0})
+      try
+      {
+        surf.Sigma(K, 1.0);
+        ++nBad;
+      }
+      catch (std::invalid_argument const&) {}
+    try
+    {
+      surf.At(t - 0.1);
+      ++nBad;
+    }
+    catch (std::invalid_argument const&) {}
+    check("Invalid lookups not throwing (count)", nBad, 0.0);
+
+    return check.Result("CheckVolSurface");
+  }
+  catch (std::exception const& exn)
+  {
+    fprintf(stderr, "EXCEPTION: %s\n", exn.what());
+    return 1;
+  }
+}
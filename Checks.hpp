@@ -0,0 +1,49 @@
+// vim:ts=2:et
+//===========================================================================//
+//                                "Checks.hpp":                              //
+//           Minimal Pass / Fail Reporting for the "Check*" Drivers          //
+//===========================================================================//
+// Each "Check*" executable compares the library against an independent ref-
+// erence (closed forms, published benchmarks, re-pricing or known params),
+// prints one line per check, and returns non-0 if any check failed, so that
+// "make check" fails too:
+//
+#pragma once
+#include <cmath>
+#include <cstdio>
+
+namespace Checks
+{
+  //=========================================================================//
+  // "Tally": Counts the Checks and the Failures:                            //
+  //=========================================================================//
+  class Tally
+  {
+  private:
+    int m_nChecks;
+    int m_nFailed;
+
+  public:
+    Tally(): m_nChecks(0), m_nFailed(0) {}
+
+    // "a_err" is the error measured,  "a_tol" its bound (NaN errors fail):
+    bool operator()(char const* a_what, double a_err, double a_tol)
+    {
+      bool ok = (std::fabs(a_err) <= a_tol);
+      ++m_nChecks;
+      if (!ok)
+        ++m_nFailed;
+      printf("%-4s %-52s err=%9.2e tol=%9.2e\n",
+             ok ? "OK" : "FAIL", a_what, a_err, a_tol);
+      return ok;
+    }
+
+    // Prints the summary; the exit code of "main":
+    int Result(char const* a_name) const
+    {
+      printf("%s: %d checks, %d failed\n", a_name, m_nChecks, m_nFailed);
+      return (m_nFailed == 0) ? 0 : 1;
+    }
+  };
+}
+// End namespace Checks
@@ -0,0 +1,556 @@
+// vim:ts=2:et
+//===========================================================================//
+//                                "Curves.cpp":                              //
+//       Yield and Dividend Curves, and the Per-Expiry Cache of the Rates    //
+//===========================================================================//
+#include "Curves.h"
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+namespace BSM
+{
+  namespace
+  {
+    //-----------------------------------------------------------------------//
+    // Monotone-Convex Interpolation (Hagan-West):                           //
+    //-----------------------------------------------------------------------//
+    // On a pillar interval,  the instantaneous fwd is f = f^d + g(x),  where
+    // f^d is the discrete fwd over the interval, x in [0, 1] the position in
+    // it, and "g" is a piecewise-quadratic with g(0) = g0, g(1) = g1 and a 0
+    // integral over [0, 1];  its form depends on the sector of (g0, g1) (so
+    // that "f" stays between the neighbouring fwds). "MCInt" returns
+    // G(x) = int_0^x g, and "MCVal" returns g(x):
+    //
+    double MCInt(double a_g0, double a_g1, double a_x)
+    {
+      double g0 = a_g0;
+      double g1 = a_g1;
+      double x  = a_x;
+
+      // Sector (i) (incl. the degenerate cases g0 = 0 or g1 = 0):
+      if (g0 == 0.0 || g1 == 0.0 ||
+          (g0 < 0.0 && -0.5 * g0 <= g1 && g1 <= -2.0 * g0) ||
+          (g0 > 0.0 && -0.5 * g0 >= g1 && g1 >= -2.0 * g0))
+        return g0 * (x - 2.0 * x * x + x * x * x) + g1 * (x * x * x - x * x);
+
+      // Sector (ii):
+      if ((g0 < 0.0 && g1 > -2.0 * g0) || (g0 > 0.0 && g1 < -2.0 * g0))
+      {
+        double eta = (g1 + 2.0 * g0) / (g1 - g0);
+        double y   = x - eta;
+        return (x <= eta)
+               ? g0 * x
+               : g0 * x + (g1 - g0) * y * y * y / (3.0 * (1.0 - eta) *
+                                                          (1.0 - eta));
+      }
+      // Sector (iii):
+      if ((g0 > 0.0 && g1 < 0.0 && g1 > -0.5 * g0) ||
+          (g0 < 0.0 && g1 > 0.0 && g1 < -0.5 * g0))
+      {
+        double eta = 3.0 * g1 / (g1 - g0);
+        double y   = (eta - x) / eta;
+        return (x < eta)
+               ? g1 * x + (g0 - g1) * eta / 3.0 * (1.0 - y * y * y)
+               : g1 * x + (g0 - g1) * eta / 3.0;
+      }
+      // Sector (iv): g0, g1 of the same sign:
+      double eta = g1 / (g0 + g1);
+      double A   = - g0 * g1 / (g0 + g1);
+      if (x < eta)
+      {
+        double y = (eta - x) / eta;
+        return A * x + (g0 - A) * eta / 3.0 * (1.0 - y * y * y);
+      }
+      double y = x - eta;
+      return A * x + (g0 - A) * eta / 3.0 +
+             (g1 - A) * y * y * y / (3.0 * (1.0 - eta) * (1.0 - eta));
+    }
+
+    double MCVal(double a_g0, double a_g1, double a_x)
+    {
+      double g0 = a_g0;
+      double g1 = a_g1;
+      double x  = a_x;
+
+      if (g0 == 0.0 || g1 == 0.0 ||
+          (g0 < 0.0 && -0.5 * g0 <= g1 && g1 <= -2.0 * g0) ||
+          (g0 > 0.0 && -0.5 * g0 >= g1 && g1 >= -2.0 * g0))
+        return g0 * (1.0 - 4.0 * x + 3.0 * x * x) +
+               g1 * (3.0 * x * x - 2.0 * x);
+
+      if ((g0 < 0.0 && g1 > -2.0 * g0) || (g0 > 0.0 && g1 < -2.0 * g0))
+      {
+        double eta = (g1 + 2.0 * g0) / (g1 - g0);
+        double y   = (x - eta) / (1.0 - eta);
+        return (x <= eta) ? g0 : g0 + (g1 - g0) * y * y;
+      }
+      if ((g0 > 0.0 && g1 < 0.0 && g1 > -0.5 * g0) ||
+          (g0 < 0.0 && g1 > 0.0 && g1 < -0.5 * g0))
+      {
+        double eta = 3.0 * g1 / (g1 - g0);
+        double y   = (eta - x) / eta;
+        return (x < eta) ? g1 + (g0 - g1) * y * y : g1;
+      }
+      double eta = g1 / (g0 + g1);
+      double A   = - g0 * g1 / (g0 + g1);
+      if (x < eta)
+      {
+        double y = (eta - x) / eta;
+        return A + (g0 - A) * y * y;
+      }
+      double y = (x - eta) / (1.0 - eta);
+      return A + (g1 - A) * y * y;
+    }
+
+    //-----------------------------------------------------------------------//
+    // "CashFlows": An Instrument as  -DF(start) + sum_k c_k DF(T_k) = 0:    //
+    //-----------------------------------------------------------------------//
+    struct CashFlows
+    {
+      double              m_start;
+      std::vector<double> m_T;
+      std::vector<double> m_c;
+    };
+
+    CashFlows MkCashFlows(CurveInstr const& a_instr, double a_t0)
+    {
+      CurveInstr const& in = a_instr;
+      if (!(in.m_start >= a_t0 && in.m_end > in.m_start &&
+            std::isfinite(in.m_end) && std::isfinite(in.m_quote)))
+        throw std::invalid_argument("YieldCurve::Bootstrap: Invalid Instr");
+
+      CashFlows cf;
+      cf.m_start = in.m_start;
+      double    alpha = in.m_end - in.m_start;
+
+      switch (in.m_type)
+      {
+        case InstrType::Deposit:
+          cf.m_T.push_back(in.m_end);
+          cf.m_c.push_back(1.0 + in.m_quote * alpha);
+          break;
+
+        case InstrType::Future:
+        {
+          double f = (100.0 - in.m_quote) / 100.0 - in.m_convAdj;
+          cf.m_T.push_back(in.m_end);
+          cf.m_c.push_back(1.0 + f * alpha);
+          break;
+        }
+        case InstrType::Swap:
+        {
+          if (in.m_freq <= 0)
+            throw std::invalid_argument
+                  ("YieldCurve::Bootstrap: Invalid Swap Freq");
+          // The fixed leg dates, backwards from the end (a period shorter
+          // than 1% of the regular one is merged into the 1st period):
+          double              dt = 1.0 / double(in.m_freq);
+          std::vector<double> dates;
+          for (int k = 0; ; ++k)
+          {
+            double T = in.m_end - double(k) * dt;
+            if (T <= in.m_start + 0.01 * dt)
+              break;
+            dates.push_back(T);
+          }
+          std::reverse(dates.begin(), dates.end());
+          double prev = in.m_start;
+          for (double T: dates)
+          {
+            cf.m_T.push_back(T);
+            cf.m_c.push_back(in.m_quote * (T - prev));
+            prev = T;
+          }
+          cf.m_c.back() += 1.0;
+          break;
+        }
+        default:
+          throw std::invalid_argument("YieldCurve::Bootstrap: Invalid Instr");
+      }
+      return cf;
+    }
+
+    double PV(CashFlows const& a_cf, YieldCurve const& a_curve)
+    {
+      double pv = - a_curve.DF(a_cf.m_start);
+      for (size_t k = 0; k < a_cf.m_T.size(); ++k)
+        pv += a_cf.m_c[k] * a_curve.DF(a_cf.m_T[k]);
+      return pv;
+    }
+  }
+
+  //=========================================================================//
+  // "YieldCurve" Ctors:                                                     //
+  //=========================================================================//
+  YieldCurve::YieldCurve(double a_t0, double a_r)
+  : m_t0    (a_t0),
+    m_interp(CurveInterp::LogLinear),
+    m_T     {a_t0, a_t0 + 1.0},
+    m_lnDF  {0.0, -a_r},
+    m_fd    (),
+    m_f     ()
+  {
+    if (!std::isfinite(a_r))
+      throw std::invalid_argument("YieldCurve: Invalid Rate");
+    Prepare();
+  }
+
+  YieldCurve::YieldCurve
+  (
+    double        a_t0,
+    size_t        a_n,
+    double const* a_T,
+    double const* a_DF,
+    CurveInterp   a_interp
+  )
+  : m_t0    (a_t0),
+    m_interp(a_interp),
+    m_T     (a_n + 1),
+    m_lnDF  (a_n + 1),
+    m_fd    (),
+    m_f     ()
+  {
+    if (a_n == 0)
+      throw std::invalid_argument("YieldCurve: No Pillars");
+    if (a_interp != CurveInterp::LogLinear &&
+        a_interp != CurveInterp::MonotoneConvex)
+      throw std::invalid_argument("YieldCurve: Invalid CurveInterp");
+
+    m_T   [0] = a_t0;
+    m_lnDF[0] = 0.0;
+    for (size_t i = 0; i < a_n; ++i)
+    {
+      if (!(a_T[i] > m_T[i]))
+        throw std::invalid_argument("YieldCurve: Non-Increasing Pillars");
+      if (!(a_DF[i] > 0.0 && std::isfinite(a_DF[i])))
+        throw std::invalid_argument("YieldCurve: Non-Positive DF");
+      m_T   [i + 1] = a_T[i];
+      m_lnDF[i + 1] = log(a_DF[i]);
+    }
+    Prepare();
+  }
+
+  //=========================================================================//
+  // "YieldCurve::Prepare": The Discrete and Instantaneous Fwds:             //
+  //=========================================================================//
+  void YieldCurve::Prepare()
+  {
+    size_t n = m_T.size() - 1;
+    m_fd.assign(n + 1, 0.0);
+    for (size_t i = 1; i <= n; ++i)
+      m_fd[i] = - (m_lnDF[i] - m_lnDF[i - 1]) / (m_T[i] - m_T[i - 1]);
+    m_fd[0] = m_fd[1];
+
+    if (m_interp != CurveInterp::MonotoneConvex)
+      return;
+
+    // The fwds at the interior pillars are the time-weighted averages of the
+    // adjacent discrete ones; at the ends, they are extrapolated so that the
+    // 1st and last intervals have g1 = -g0 / 2:
+    m_f.assign(n + 1, m_fd[1]);
+    if (n == 1)
+      return;
+    for (size_t i = 1; i < n; ++i)
+    {
+      double h0 = m_T[i]     - m_T[i - 1];
+      double h1 = m_T[i + 1] - m_T[i];
+      m_f[i]    = (h0 * m_fd[i + 1] + h1 * m_fd[i]) / (h0 + h1);
+    }
+    m_f[0] = m_fd[1] - 0.5 * (m_f[1]     - m_fd[1]);
+    m_f[n] = m_fd[n] - 0.5 * (m_f[n - 1] - m_fd[n]);
+  }
+
+  //=========================================================================//
+  // "YieldCurve" Lookups:                                                   //
+  //=========================================================================//
+  double YieldCurve::LnDF(double a_T) const
+  {
+    if (!(a_T >= m_t0))
+      throw std::invalid_argument("YieldCurve: Time Before the Curve Time");
+
+    bool   mc = (m_interp == CurveInterp::MonotoneConvex);
+    size_t n  = m_T.size() - 1;
+    if (a_T >= m_T[n])
+      // Flat extrapolation of the instantaneous fwd:
+      return m_lnDF[n] - (a_T - m_T[n]) * (mc ? m_f[n] : m_fd[n]);
+
+    size_t i = size_t(std::upper_bound(m_T.begin(), m_T.end(), a_T) -
+                      m_T.begin());
+    double h = m_T[i] - m_T[i - 1];
+    double x = (a_T - m_T[i - 1]) / h;
+    double I = m_fd[i] * x;
+    if (mc)
+      I += MCInt(m_f[i - 1] - m_fd[i], m_f[i] - m_fd[i], x);
+    return m_lnDF[i - 1] - h * I;
+  }
+
+  double YieldCurve::FwdRate(double a_T) const
+  {
+    if (!(a_T >= m_t0))
+      throw std::invalid_argument("YieldCurve: Time Before the Curve Time");
+
+    bool   mc = (m_interp == CurveInterp::MonotoneConvex);
+    size_t n  = m_T.size() - 1;
+    if (a_T >= m_T[n])
+      return mc ? m_f[n] : m_fd[n];
+
+    size_t i = size_t(std::upper_bound(m_T.begin(), m_T.end(), a_T) -
+                      m_T.begin());
+    if (!mc)
+      return m_fd[i];
+    double x = (a_T - m_T[i - 1]) / (m_T[i] - m_T[i - 1]);
+    return m_fd[i] + MCVal(m_f[i - 1] - m_fd[i], m_f[i] - m_fd[i], x);
+  }
+
+  double YieldCurve::ZeroRate(double a_t, double a_T) const
+  {
+    double tau = a_T - a_t;
+    if (tau < 0.0)
+      throw std::invalid_argument("Negative Time to Expiration");
+    return (tau > 0.0)
+           ? - (LnDF(a_T) - LnDF(a_t)) / tau
+           : FwdRate(a_t);
+  }
+
+  //=========================================================================//
+  // "YieldCurve::Bootstrap":                                                //
+  //=========================================================================//
+  YieldCurve YieldCurve::Bootstrap
+  (
+    double            a_t0,
+    size_t            a_n,
+    CurveInstr const* a_instrs,
+    CurveInterp       a_interp
+  )
+  {
+    if (a_n == 0)
+      throw std::invalid_argument("YieldCurve::Bootstrap: No Instrs");
+
+    // Sort the instruments by maturity:
+    std::vector<size_t> order(a_n);
+    std::iota(order.begin(), order.end(), size_t(0));
+    std::sort(order.begin(), order.end(),
+              [a_instrs](size_t a_i, size_t a_j)
+              { return a_instrs[a_i].m_end < a_instrs[a_j].m_end; });
+
+    std::vector<CashFlows> cfs;
+    std::vector<double>    T  (a_n);
+    std::vector<double>    DF (a_n, 1.0);
+    for (size_t i = 0; i < a_n; ++i)
+    {
+      cfs.push_back(MkCashFlows(a_instrs[order[i]], a_t0));
+      T[i] = a_instrs[order[i]].m_end;
+      if (i > 0 && !(T[i] > T[i - 1]))
+        throw std::invalid_argument
+              ("YieldCurve::Bootstrap: Non-Distinct Maturities");
+    }
+
+    //-----------------------------------------------------------------------//
+    // Solve for the pillars one by one, in log(DF) (by Newton's method):    //
+    //-----------------------------------------------------------------------//
+    // In the 1st pass, the curve only has the pillars solved so far; in the
+    // next ones (MonotoneConvex only), all of them:
+    //
+    constexpr int    MaxPasses = 50;
+    constexpr int    MaxIters  = 50;
+    constexpr double Tol       = 1e-14;
+    constexpr double dX        = 1e-7;
+
+    for (int pass = 0; pass < MaxPasses; ++pass)
+    {
+      double maxDX = 0.0;
+      for (size_t i = 0; i < a_n; ++i)
+      {
+        size_t nP = (pass == 0) ? i + 1 : a_n;
+        double x  = log(DF[i]);
+        double x0 = x;
+
+        auto pv =
+          [&](double a_x)
+          {
+            DF[i] = exp(a_x);
+            return PV(cfs[i], YieldCurve(a_t0, nP, T.data(), DF.data(),
+                                         a_interp));
+          };
+        for (int it = 0; it < MaxIters; ++it)
+        {
+          double f  = pv(x);
+          if (fabs(f) <= Tol)
+            break;
+          double f1 = (pv(x + dX) - f) / dX;
+          if (!(f1 != 0.0 && std::isfinite(f1)))
+            throw std::runtime_error("YieldCurve::Bootstrap: Failed");
+          x -= f / f1;
+        }
+        DF[i] = exp(x);
+        maxDX = std::max(maxDX, fabs(x - x0));
+      }
+      if (a_interp == CurveInterp::LogLinear || (pass > 0 && maxDX <= Tol))
+        break;
+    }
+    return YieldCurve(a_t0, a_n, T.data(), DF.data(), a_interp);
+  }
+
+  //=========================================================================//
+  // "YieldCurve::FromFwds":                                                 //
+  //=========================================================================//
+  YieldCurve YieldCurve::FromFwds
+  (
+    YieldCurve const& a_rates,
+    double            a_St,
+    size_t            a_n,
+    double const*     a_T,
+    double const*     a_F,
+    CurveInterp       a_interp
+  )
+  {
+    if (!(a_St > 0.0))
+      throw std::invalid_argument("Non-Positive Strike / UnderlyingPx / Vol");
+
+    std::vector<double> DF(a_n);
+    for (size_t i = 0; i < a_n; ++i)
+    {
+      if (!(a_F[i] > 0.0))
+        throw std::invalid_argument("YieldCurve::FromFwds: Non-Positive Fwd");
+      DF[i] = a_F[i] * a_rates.DF(a_T[i]) / a_St;
+    }
+    return YieldCurve(a_rates.Time(), a_n, a_T, DF.data(), a_interp);
+  }
+
+  //=========================================================================//
+  // "CurveCache":                                                           //
+  //=========================================================================//
+  CurveCache::CurveCache
+  (
+    YieldCurve const& a_rates,
+    DivCurve const&   a_divs,
+    double            a_t
+  )
+  : m_rates(&a_rates),
+    m_divs (&a_divs),
+    m_t    (a_t),
+    m_memo (),
+    m_lastT(NAN),
+    m_last (nullptr)
+  {
+    if (!(a_t >= a_rates.Time() && a_t >= a_divs.Time()))
+      throw std::invalid_argument("CurveCache: Time Before the Curve Time");
+  }
+
+  ExpiryRates const& CurveCache::At(double a_T)
+  {
+    if (a_T == m_lastT)
+      return *m_last;
+
+    auto it = m_memo.find(a_T);
+    if (it == m_memo.end())
+    {
+      ExpiryRates er;
+      er.m_tau = a_T - m_t;
+      er.m_r   = m_rates->ZeroRate(m_t, a_T);  // (Also checks "a_T")
+      er.m_D   = m_divs ->ZeroRate(m_t, a_T);
+      er.m_dfR = exp(-er.m_r * er.m_tau);
+      er.m_dfD = exp(-er.m_D * er.m_tau);
+      er.m_fwd = er.m_dfD / er.m_dfR;
+      it = m_memo.emplace(a_T, er).first;
+    }
+    m_lastT = a_T;
+    m_last  = &(it->second);
+    return *m_last;
+  }
+
+  //=========================================================================//
+  // Pricers Taking a "CurveCache":                                          //
+  //=========================================================================//
+  template<typename CDF>
+  double Px
+  (
+    PayoffType  a_type,
+    double      a_K,
+    double      a_T,
+    CurveCache& a_curves,
+    double      a_sigma,
+    double      a_St
+  )
+  {
+    ExpiryRates const& er = a_curves.At(a_T);
+    return Px<CDF>
+           (a_type, a_K, a_T, er.m_r, er.m_D, a_sigma, a_curves.Time(), a_St);
+  }
+
+  template<typename CDF>
+  void PxBatch
+  (
+    PayoffType    a_type,
+    size_t        a_n,
+    double const* a_K,
+    double const* a_T,
+    CurveCache&   a_curves,
+    double const* a_sigma,
+    double const* a_St,
+    double*       a_px
+  )
+  {
+    double t = a_curves.Time();
+    for (size_t i0 = 0, i1 = 0; i0 < a_n; i0 = i1)
+    {
+      // The run of equal expirations:
+      for (i1 = i0 + 1; i1 < a_n && a_T[i1] == a_T[i0]; ++i1) ;
+
+      ExpiryRates const& er = a_curves.At(a_T[i0]);
+      PxBatch<CDF>
+        (a_type, i1 - i0, a_K + i0, a_T + i0, er.m_r, er.m_D, a_sigma + i0,
+         t, a_St + i0, a_px + i0);
+    }
+  }
+
+  template<typename CDF>
+  void PxGreeksBatch
+  (
+    PayoffType        a_type,
+    size_t            a_n,
+    double const*     a_K,
+    double const*     a_T,
+    CurveCache&       a_curves,
+    double const*     a_sigma,
+    double const*     a_St,
+    GreeksArrs const& a_out
+  )
+  {
+    double t = a_curves.Time();
+    for (size_t i0 = 0, i1 = 0; i0 < a_n; i0 = i1)
+    {
+      for (i1 = i0 + 1; i1 < a_n && a_T[i1] == a_T[i0]; ++i1) ;
+
+      ExpiryRates const& er = a_curves.At(a_T[i0]);
+      GreeksArrs out
+      {
+        a_out.m_px   + i0, a_out.m_delta + i0, a_out.m_gamma + i0,
+        a_out.m_vega + i0, a_out.m_theta + i0, a_out.m_rho   + i0
+      };
+      PxGreeksBatch<CDF>
+        (a_type, i1 - i0, a_K + i0, a_T + i0, er.m_r, er.m_D, a_sigma + i0,
+         t, a_St + i0, out);
+    }
+  }
+
+  //-------------------------------------------------------------------------//
+  // Explicit Instantiations:                                                //
+  //-------------------------------------------------------------------------//
+# define CURVES_INSTANTIATE(CDF)                                               \
+  template double Px<CDF>                                                      \
+    (PayoffType, double, double, CurveCache&, double, double);                 \
+  template void PxBatch<CDF>                                                   \
+    (PayoffType, size_t, double const*, double const*, CurveCache&,            \
+     double const*, double const*, double*);                                   \
+  template void PxGreeksBatch<CDF>                                             \
+    (PayoffType, size_t, double const*, double const*, CurveCache&,            \
+     double const*, double const*, GreeksArrs const&);
+
+  CURVES_INSTANTIATE(CDFErf)
+  CURVES_INSTANTIATE(CDFCody)
+  CURVES_INSTANTIATE(CDFFast)
+# undef CURVES_INSTANTIATE
+}
+// End namespace BSM
@@ -0,0 +1,246 @@
+// vim:ts=2:et
+//===========================================================================//
+//                                 "Curves.h":                               //
+//       Yield and Dividend Curves, and the Per-Expiry Cache of the Rates    //
+//===========================================================================//
+#pragma once
+#include "BSM.h"
+#include <cstddef>
+#include <map>
+#include <vector>
+
+namespace BSM
+{
+  //-------------------------------------------------------------------------//
+  // "CurveInterp": Interpolation of the Discount Factors:                   //
+  //-------------------------------------------------------------------------//
+  enum class CurveInterp: int
+  {
+    LogLinear      = 0, // Linear in log(DF): piecewise-flat instantaneous fwds
+    MonotoneConvex = 1  // Hagan-West (2006): continuous fwds,  with no spuri-
+                        // ous oscillations; (no positivity collar,  so that
+                        // negative rates are allowed)
+  };
+
+  //-------------------------------------------------------------------------//
+  // "CurveInstr": Bootstrapping Instruments:                                //
+  //-------------------------------------------------------------------------//
+  // All times are Year Fractions (as "a_T" in "Px"),  and the accrual periods
+  // are their differences (ie the Act/Act day count; other day counts should
+  // be applied to the quotes by the caller):
+  //   Deposit: "m_quote" is the simple rate from "m_start" to "m_end";
+  //   Future : "m_quote" is the Px,  100 - 100 * (the simple fwd rate from
+  //            "m_start" to "m_end" + "m_convAdj");
+  //   Swap   : "m_quote" is the par rate of the fixed leg paid "m_freq" times
+  //            a year (backwards from "m_end", with a short 1st period if
+  //            needed) against the floating leg (single-curve, so it is worth
+  //            DF(m_start) - DF(m_end)):
+  //
+  enum class InstrType: int
+  {
+    Deposit = 0,
+    Future  = 1,
+    Swap    = 2
+  };
+
+  struct CurveInstr
+  {
+    InstrType m_type    = InstrType::Deposit;
+    double    m_start   = NAN;   // Start Time (>= the curve time)
+    double    m_end     = NAN;   // Maturity Time
+    double    m_quote   = NAN;
+    int       m_freq    = 1;     // Swaps only
+    double    m_convAdj = 0.0;   // Futures only: the convexity adjustment
+  };
+
+  //=========================================================================//
+  // "YieldCurve" Class:                                                     //
+  //=========================================================================//
+  // Discount Factors DF(T) = exp(-int_{t0}^T y(s) ds) on the pillars T_i > t0
+  // (DF(t0) = 1), interpolated as per "CurveInterp";  beyond the last pillar,
+  // the instantaneous fwd is extrapolated flat. The same class represents the
+  // dividend (or foreign-rate) curves, for which "DF" is the dividend "dis-
+  // count" exp(-int D); see "DivCurve" below. Immutable once constructed:
+  //
+  class YieldCurve
+  {
+  private:
+    //-----------------------------------------------------------------------//
+    // Data Flds:                                                            //
+    //-----------------------------------------------------------------------//
+    double              m_t0;
+    CurveInterp         m_interp;
+    std::vector<double> m_T;      // [n+1] Pillars, m_T[0] = t0
+    std::vector<double> m_lnDF;   // [n+1] log(DF), m_lnDF[0] = 0
+    std::vector<double> m_fd;     // [n+1] Discrete fwds over (T_{i-1}, T_i]
+    std::vector<double> m_f;      // [n+1] Instantaneous fwds at the pillars
+                                  //       (MonotoneConvex only)
+    void Prepare();
+
+  public:
+    //-----------------------------------------------------------------------//
+    // Ctors:                                                                //
+    //-----------------------------------------------------------------------//
+    // Flat (continuously-compounded) rate "a_r":
+    YieldCurve(double a_t0, double a_r);
+
+    // From the DFs on the pillars (increasing, > a_t0). Throws "std::invalid_
+    // argument" if the pillars are not increasing, or a DF is non-positive:
+    //
+    YieldCurve
+    (
+      double        a_t0,
+      size_t        a_n,
+      double const* a_T,      // [a_n]
+      double const* a_DF,     // [a_n]
+      CurveInterp   a_interp = CurveInterp::MonotoneConvex
+    );
+
+    //-----------------------------------------------------------------------//
+    // "Bootstrap": From Deposits, Futures and Swaps:                        //
+    //-----------------------------------------------------------------------//
+    // Each instrument adds a pillar at its "m_end" (the "m_end"s must be dis-
+    // tinct), solved for so that the instrument is re-priced exactly; with
+    // "MonotoneConvex",  the interpolation is non-local,  so the pillars are
+    // re-solved until all instruments are re-priced to 1e-14:
+    //
+    static YieldCurve Bootstrap
+    (
+      double            a_t0,
+      size_t            a_n,
+      CurveInstr const* a_instrs,  // [a_n], in any order
+      CurveInterp       a_interp = CurveInterp::MonotoneConvex
+    );
+
+    //-----------------------------------------------------------------------//
+    // "FromFwds": Dividend (or Foreign-Rate) Curve Implied by Fwd Pxs:      //
+    //-----------------------------------------------------------------------//
+    // DF_D(T) = F(T) * DF_r(T) / St, for the Fwds "a_F" (eg from the Futures
+    // or the Put-Call Parity) at the times "a_T":
+    //
+    static YieldCurve FromFwds
+    (
+      YieldCurve const& a_rates,
+      double            a_St,     // Spot Px at the curve time
+      size_t            a_n,
+      double const*     a_T,      // [a_n]
+      double const*     a_F,      // [a_n]
+      CurveInterp       a_interp = CurveInterp::MonotoneConvex
+    );
+
+    //-----------------------------------------------------------------------//
+    // Lookups:                                                              //
+    //-----------------------------------------------------------------------//
+    // "a_T" must be >= the curve time (otherwise "std::invalid_argument"):
+    double LnDF(double a_T) const;
+    double DF  (double a_T) const { return exp(LnDF(a_T)); }
+
+    // The continuously-compounded zero rate from "a_t" to "a_T" (the instant-
+    // aneous fwd at "a_t" if they coincide):
+    double ZeroRate(double a_t, double a_T) const;
+
+    // The instantaneous fwd rate at "a_T":
+    double FwdRate(double a_T) const;
+
+    //-----------------------------------------------------------------------//
+    // Accessors:                                                            //
+    //-----------------------------------------------------------------------//
+    double      Time()            const { return m_t0;           }
+    CurveInterp Interp()          const { return m_interp;       }
+    size_t      NPillars()        const { return m_T.size() - 1; }
+    double      Pillar(size_t a_i) const { return m_T[a_i + 1];   }
+  };
+
+  // Dividend curves are "YieldCurve"s (of the dividend yield):
+  using DivCurve = YieldCurve;
+
+  //=========================================================================//
+  // "CurveCache": The Rates per Expiry, for the Pricers:                    //
+  //=========================================================================//
+  // For a Pricing Time "t", the flat rates equivalent (for European options)
+  // to the curves over [t, T] are the zero rates r(t, T) and D(t, T).  They,
+  // the DFs and the Fwd factor are computed on the 1st lookup of each "T" and
+  // memoised, so a chain pays for the curve interpolation and the "exp"s once
+  // per expiry rather than once per option. Consecutive lookups of the same
+  // "T" (eg a chain sorted by expiry) do not even search the memo.
+  // The curves must outlive the cache. NOT thread-safe (the lookups modify
+  // the memo); use one cache per thread:
+  //
+  struct ExpiryRates
+  {
+    double m_tau;   // T - t
+    double m_r;     // Zero rate  r(t, T)
+    double m_D;     // Zero yield D(t, T)
+    double m_dfR;   // exp(-r * tau)
+    double m_dfD;   // exp(-D * tau)
+    double m_fwd;   // m_dfD / m_dfR: F(T) = St * m_fwd
+  };
+
+  class CurveCache
+  {
+  private:
+    YieldCurve const*             m_rates;
+    YieldCurve const*             m_divs;
+    double                        m_t;
+    std::map<double, ExpiryRates> m_memo;
+    double                        m_lastT;
+    ExpiryRates const*            m_last;
+
+  public:
+    // Throws "std::invalid_argument" if "a_t" precedes either curve time:
+    CurveCache(YieldCurve const& a_rates, DivCurve const& a_divs, double a_t);
+
+    // Throws "std::invalid_argument" if "a_T" < "Time()":
+    ExpiryRates const& At(double a_T);
+
+    double Fwd(double a_T, double a_St) { return a_St * At(a_T).m_fwd; }
+    double Time() const                 { return m_t; }
+  };
+
+  //=========================================================================//
+  // Pricers Taking a "CurveCache" Instead of "r", "D" and "t":              //
+  //=========================================================================//
+  // Same PayoffTypes, results and exceptions as the flat-rate versions in
+  // "BSM.h" (with the rates of "CurveCache::At(T)"). The batch ones call the
+  // flat-rate kernels once per run of equal "a_T" (so chains should be
+  // grouped by expiry); Rho is the sensitivity to a parallel shift of the
+  // rate curve. Instantiated (in "Curves.cpp") for the 3 CDF Policies:
+  //
+  template<typename CDF = CDFErf>
+  double Px
+  (
+    PayoffType  a_type,
+    double      a_K,
+    double      a_T,
+    CurveCache& a_curves,
+    double      a_sigma,
+    double      a_St
+  );
+
+  template<typename CDF = CDFCody>
+  void PxBatch
+  (
+    PayoffType    a_type,
+    size_t        a_n,
+    double const* a_K,      // [a_n]
+    double const* a_T,      // [a_n]
+    CurveCache&   a_curves,
+    double const* a_sigma,  // [a_n]
+    double const* a_St,     // [a_n]
+    double*       a_px      // [a_n] Output
+  );
+
+  template<typename CDF = CDFCody>
+  void PxGreeksBatch
+  (
+    PayoffType        a_type,
+    size_t            a_n,
+    double const*     a_K,
+    double const*     a_T,
+    CurveCache&       a_curves,
+    double const*     a_sigma,
+    double const*     a_St,
+    GreeksArrs const& a_out
+  );
+}
+// End namespace BSM
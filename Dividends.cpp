@@ -0,0 +1,235 @@
+// vim:ts=2:et
+//===========================================================================//
+//                              "Dividends.cpp":                             //
+//         Cash-Dividend Schedules and Escrowed Pricers: Implementation      //
+//===========================================================================//
+#include "Dividends.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace BSM
+{
+  //=========================================================================//
+  // "DivSchedule":                                                          //
+  //=========================================================================//
+  //-------------------------------------------------------------------------//
+  // Non-Default Ctor:                                                       //
+  //-------------------------------------------------------------------------//
+  DivSchedule::DivSchedule(size_t a_n, CashDiv const* a_divs)
+  : m_t     (),
+    m_amount()
+  {
+    std::vector<CashDiv> divs(a_divs, a_divs + a_n);
+    for (CashDiv const& div: divs)
+      if (!std::isfinite(div.m_t) || !(div.m_amount >= 0.0))
+        throw std::invalid_argument("DivSchedule: Invalid Dividend");
+
+    std::stable_sort(divs.begin(), divs.end(),
+                     [](CashDiv const& a_l, CashDiv const& a_r)
+                     { return a_l.m_t < a_r.m_t; });
+    m_t     .reserve(a_n);
+    m_amount.reserve(a_n);
+    for (CashDiv const& div: divs)
+    {
+      m_t     .push_back(div.m_t);
+      m_amount.push_back(div.m_amount);
+    }
+  }
+
+  //-------------------------------------------------------------------------//
+  // "PV":                                                                   //
+  //-------------------------------------------------------------------------//
+  double DivSchedule::PV
+  (
+    double  a_t,
+    double  a_T,
+    double  a_r,
+    double* a_dPVdr
+  )
+  const
+  {
+    // The 1st dividend with the ex-time > a_t:
+    size_t i  = size_t(std::upper_bound(m_t.begin(), m_t.end(), a_t) -
+                       m_t.begin());
+    double pv = 0.0;
+    double dr = 0.0;
+    for (; i < m_t.size() && m_t[i] <= a_T; ++i)
+    {
+      double dt = m_t[i] - a_t;
+      double v  = m_amount[i] * exp(-a_r * dt);
+      pv       += v;
+      dr       -= dt * v;
+    }
+    if (a_dPVdr != nullptr)
+      *a_dPVdr = dr;
+    return pv;
+  }
+
+  //=========================================================================//
+  // Escrowed-Dividend Closed Forms:                                         //
+  //=========================================================================//
+  namespace
+  {
+    // The max number of escrowed Pxs held on the stack by the batch pricers
+    // (longer runs are processed in chunks):
+    constexpr size_t ChunkSz = 256;
+  }
+
+  //-------------------------------------------------------------------------//
+  // "Px":                                                                   //
+  //-------------------------------------------------------------------------//
+  template<typename CDF>
+  double Px
+  (
+    PayoffType         a_type,
+    double             a_K,
+    double             a_T,
+    double             a_r,
+    double             a_D,
+    double             a_sigma,
+    double             a_t,
+    double             a_St,
+    DivSchedule const& a_divs
+  )
+  {
+    double pv = a_divs.PV(a_t, a_T, a_r);
+    return Px<CDF>(a_type, a_K, a_T, a_r, a_D, a_sigma, a_t, a_St - pv);
+  }
+
+  //-------------------------------------------------------------------------//
+  // "PxGreeks":                                                             //
+  //-------------------------------------------------------------------------//
+  // With S* = St - PV(t, r): dS*/dt = -r * PV, and dS*/dr = -dPV/dr:
+  //
+  template<typename CDF>
+  Greeks PxGreeks
+  (
+    PayoffType         a_type,
+    double             a_K,
+    double             a_T,
+    double             a_r,
+    double             a_D,
+    double             a_sigma,
+    double             a_t,
+    double             a_St,
+    DivSchedule const& a_divs
+  )
+  {
+    double dPVdr = 0.0;
+    double pv    = a_divs.PV(a_t, a_T, a_r, &dPVdr);
+    Greeks res   =
+      PxGreeks<CDF>(a_type, a_K, a_T, a_r, a_D, a_sigma, a_t, a_St - pv);
+    res.m_theta -= res.m_delta * a_r * pv;
+    res.m_rho   -= res.m_delta * dPVdr;
+    return res;
+  }
+
+  //-------------------------------------------------------------------------//
+  // "PxBatch":                                                              //
+  //-------------------------------------------------------------------------//
+  template<typename CDF>
+  void PxBatch
+  (
+    PayoffType         a_type,
+    size_t             a_n,
+    double const*      a_K,
+    double const*      a_T,
+    double             a_r,
+    double             a_D,
+    double const*      a_sigma,
+    double             a_t,
+    double const*      a_St,
+    DivSchedule const& a_divs,
+    double*            a_px
+  )
+  {
+    double escS[ChunkSz];
+    for (size_t i0 = 0, i1 = 0; i0 < a_n; i0 = i1)
+    {
+      // The run of equal expirations (at most "ChunkSz" long):
+      size_t iMax = std::min(a_n, i0 + ChunkSz);
+      for (i1 = i0 + 1; i1 < iMax && a_T[i1] == a_T[i0]; ++i1) ;
+
+      double pv = a_divs.PV(a_t, a_T[i0], a_r);
+      for (size_t i = i0; i < i1; ++i)
+        escS[i - i0] = a_St[i] - pv;
+
+      PxBatch<CDF>
+        (a_type, i1 - i0, a_K + i0, a_T + i0, a_r, a_D, a_sigma + i0, a_t,
+         escS, a_px + i0);
+    }
+  }
+
+  //-------------------------------------------------------------------------//
+  // "PxGreeksBatch":                                                        //
+  //-------------------------------------------------------------------------//
+  template<typename CDF>
+  void PxGreeksBatch
+  (
+    PayoffType         a_type,
+    size_t             a_n,
+    double const*      a_K,
+    double const*      a_T,
+    double             a_r,
+    double             a_D,
+    double const*      a_sigma,
+    double             a_t,
+    double const*      a_St,
+    DivSchedule const& a_divs,
+    GreeksArrs const&  a_out
+  )
+  {
+    double escS[ChunkSz];
+    for (size_t i0 = 0, i1 = 0; i0 < a_n; i0 = i1)
+    {
+      size_t iMax = std::min(a_n, i0 + ChunkSz);
+      for (i1 = i0 + 1; i1 < iMax && a_T[i1] == a_T[i0]; ++i1) ;
+
+      double dPVdr = 0.0;
+      double pv    = a_divs.PV(a_t, a_T[i0], a_r, &dPVdr);
+      for (size_t i = i0; i < i1; ++i)
+        escS[i - i0] = a_St[i] - pv;
+
+      GreeksArrs out
+      {
+        a_out.m_px   + i0, a_out.m_delta + i0, a_out.m_gamma + i0,
+        a_out.m_vega + i0, a_out.m_theta + i0, a_out.m_rho   + i0
+      };
+      PxGreeksBatch<CDF>
+        (a_type, i1 - i0, a_K + i0, a_T + i0, a_r, a_D, a_sigma + i0, a_t,
+         escS, out);
+
+      if (pv != 0.0)
+        for (size_t i = i0; i < i1; ++i)
+        {
+          a_out.m_theta[i] -= a_out.m_delta[i] * a_r * pv;
+          a_out.m_rho  [i] -= a_out.m_delta[i] * dPVdr;
+        }
+    }
+  }
+
+  //-------------------------------------------------------------------------//
+  // Explicit Instantiations:                                                //
+  //-------------------------------------------------------------------------//
+# define DIVS_INSTANTIATE(CDF)                                                 \
+  template double Px<CDF>                                                      \
+    (PayoffType, double, double, double, double, double, double, double,       \
+     DivSchedule const&);                                                      \
+  template Greeks PxGreeks<CDF>                                                \
+    (PayoffType, double, double, double, double, double, double, double,       \
+     DivSchedule const&);                                                      \
+  template void PxBatch<CDF>                                                   \
+    (PayoffType, size_t, double const*, double const*, double, double,         \
+     double const*, double, double const*, DivSchedule const&, double*);       \
+  template void PxGreeksBatch<CDF>                                             \
+    (PayoffType, size_t, double const*, double const*, double, double,         \
+     double const*, double, double const*, DivSchedule const&,                 \
+     GreeksArrs const&);
+
+  DIVS_INSTANTIATE(CDFErf)
+  DIVS_INSTANTIATE(CDFCody)
+  DIVS_INSTANTIATE(CDFFast)
+# undef DIVS_INSTANTIATE
+}
+// End namespace BSM
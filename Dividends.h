@@ -0,0 +1,147 @@
+// vim:ts=2:et
+//===========================================================================//
+//                               "Dividends.h":                              //
+//        Discrete Cash-Dividend Schedules and the Escrowed-Div Pricers      //
+//===========================================================================//
+#pragma once
+#include "BSM.h"
+#include <cstddef>
+#include <vector>
+
+namespace BSM
+{
+  //-------------------------------------------------------------------------//
+  // "CashDiv": A Single Cash Dividend:                                      //
+  //-------------------------------------------------------------------------//
+  struct CashDiv
+  {
+    double m_t      = NAN;   // Ex-Dividend Time (as Year Fraction)
+    double m_amount = 0.0;   // Cash Amount (per unit of the Underlying)
+  };
+
+  //=========================================================================//
+  // "DivSchedule" Class:                                                    //
+  //=========================================================================//
+  // The cash dividends of one Underlying, sorted by the ex-dividend time.  A
+  // dividend is "paid" within (t, T] if its ex-time is in that interval: on
+  // the ex-time itself, the Underlying Px is already ex-dividend. Immutable
+  // once constructed:
+  //
+  class DivSchedule
+  {
+  private:
+    std::vector<double> m_t;      // Ex-times, increasing
+    std::vector<double> m_amount;
+
+  public:
+    //-----------------------------------------------------------------------//
+    // Ctors:                                                                //
+    //-----------------------------------------------------------------------//
+    // No dividends:
+    DivSchedule() = default;
+
+    // From the dividends in any order. Throws "std::invalid_argument" if an
+    // ex-time is not finite or an amount is negative:
+    //
+    DivSchedule(size_t a_n, CashDiv const* a_divs);
+
+    //-----------------------------------------------------------------------//
+    // "PV": Discounted Dividends Paid within (a_t, a_T]:                    //
+    //-----------------------------------------------------------------------//
+    // PV = sum_i d_i * exp(-r * (t_i - t)); if "a_dPVdr" is non-NULL, it is
+    // set to dPV/dr (for Rho):
+    //
+    double PV
+    (
+      double  a_t,
+      double  a_T,
+      double  a_r,
+      double* a_dPVdr = nullptr
+    )
+    const;
+
+    //-----------------------------------------------------------------------//
+    // Accessors:                                                            //
+    //-----------------------------------------------------------------------//
+    size_t Size()               const { return m_t.size();    }
+    bool   Empty()              const { return m_t.empty();   }
+    double Time  (size_t a_i)   const { return m_t[a_i];      }
+    double Amount(size_t a_i)   const { return m_amount[a_i]; }
+  };
+
+  //=========================================================================//
+  // Escrowed-Dividend Closed Forms:                                         //
+  //=========================================================================//
+  // The dividends paid before expiration are "escrowed": the BSM formulas are
+  // applied to St - PV(divs in (t, T]) (with the continuous "a_D" still app-
+  // lied on top of them), so the vol is that of the Underlying net of the
+  // escrow. Same PayoffTypes and exceptions as the flat versions in "BSM.h";
+  // in particular, "std::invalid_argument" if the escrowed Px is non-posit-
+  // ive. Delta, Gamma and Vega are unchanged; Theta and Rho include the time
+  // and rate sensitivities of the PV.
+  // The batch ones compute the PV once per run of equal "a_T" (so chains
+  // should be grouped by expiry),  and then call the flat-rate kernels, so
+  // their per-option cost is that of "PxBatch" plus a subtraction.
+  // Instantiated (in "Dividends.cpp") for the 3 CDF Policies:
+  //
+  template<typename CDF = CDFErf>
+  double Px
+  (
+    PayoffType         a_type,
+    double             a_K,
+    double             a_T,
+    double             a_r,
+    double             a_D,
+    double             a_sigma,
+    double             a_t,
+    double             a_St,   // Cum-Dividend Underlying Px
+    DivSchedule const& a_divs
+  );
+
+  template<typename CDF = CDFErf>
+  Greeks PxGreeks
+  (
+    PayoffType         a_type,
+    double             a_K,
+    double             a_T,
+    double             a_r,
+    double             a_D,
+    double             a_sigma,
+    double             a_t,
+    double             a_St,
+    DivSchedule const& a_divs
+  );
+
+  template<typename CDF = CDFCody>
+  void PxBatch
+  (
+    PayoffType         a_type,
+    size_t             a_n,
+    double const*      a_K,      // [a_n]
+    double const*      a_T,      // [a_n]
+    double             a_r,
+    double             a_D,
+    double const*      a_sigma,  // [a_n]
+    double             a_t,
+    double const*      a_St,     // [a_n]
+    DivSchedule const& a_divs,
+    double*            a_px      // [a_n] Output
+  );
+
+  template<typename CDF = CDFCody>
+  void PxGreeksBatch
+  (
+    PayoffType         a_type,
+    size_t             a_n,
+    double const*      a_K,
+    double const*      a_T,
+    double             a_r,
+    double             a_D,
+    double const*      a_sigma,
+    double             a_t,
+    double const*      a_St,
+    DivSchedule const& a_divs,
+    GreeksArrs const&  a_out
+  );
+}
+// End namespace BSM
@@ -0,0 +1,558 @@
+// vim:ts=2:et
+//===========================================================================//
+//                                "Heston.cpp":                              //
+//       Heston Model: Characteristic Function, FFT and COS: Implementation  //
+//===========================================================================//
+#include "Heston.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace BSM
+{
+  using Complex = std::complex<double>;
+
+  namespace
+  {
+    //-----------------------------------------------------------------------//
+    // "CheckArgs": Common to "HestonFFT::Px" and "HestonCOS::Px":           //
+    //-----------------------------------------------------------------------//
+    void CheckArgs
+    (
+      HestonParams const& a_params,
+      PayoffType          a_type,
+      double              a_tau,
+      double              a_St,
+      size_t              a_n,
+      double const*       a_K
+    )
+    {
+      CheckHestonParams(a_params);
+
+      if (a_tau < 0.0)
+        throw std::invalid_argument("Negative Time to Expiration");
+
+      if (!(a_St > 0.0))
+        throw std::invalid_argument
+              ("Non-Positive Strike / UnderlyingPx / Vol");
+
+      for (size_t i = 0; i < a_n; ++i)
+        if (!(a_K[i] > 0.0))
+          throw std::invalid_argument
+                ("Non-Positive Strike / UnderlyingPx / Vol");
+
+      if (a_type != PayoffType::Call && a_type != PayoffType::Put)
+        throw std::logic_error("Unsupported PayoffType");
+    }
+
+    //-----------------------------------------------------------------------//
+    // "PayOffs": At expiration time:                                        //
+    //-----------------------------------------------------------------------//
+    void PayOffs
+    (
+      PayoffType    a_type,
+      double        a_St,
+      size_t        a_n,
+      double const* a_K,
+      double*       a_px
+    )
+    {
+      double w = (a_type == PayoffType::Call) ? 1.0 : -1.0;
+      for (size_t i = 0; i < a_n; ++i)
+        a_px[i] = std::max(w * (a_St - a_K[i]), 0.0);
+    }
+
+    //-----------------------------------------------------------------------//
+    // "FindSlice": The Cached Slice of an Expiration:                       //
+    //-----------------------------------------------------------------------//
+    // The Slices are keyed on (T, r, D); if there is none for "a_T", a new
+    // (blank) one is appended, evicting the oldest one if there are already
+    // "MaxSlices" of them. The Slice is re-used in place when the Pricing
+    // Time moves on, so "a_ok" is set iff it was computed for "a_tau" (and
+    // otherwise must be re-computed by the caller):
+    //
+    constexpr size_t MaxSlices = 64;
+
+    template<typename Slice>
+    Slice& FindSlice
+    (
+      std::vector<Slice>& a_slices,
+      double              a_T,
+      double              a_tau,
+      double              a_r,
+      double              a_D,
+      bool*               a_ok
+    )
+    {
+      for (Slice& s: a_slices)
+        if (s.m_T == a_T && s.m_r == a_r && s.m_D == a_D)
+        {
+          *a_ok = (s.m_tau == a_tau);
+          s.m_tau = a_tau;
+          return s;
+        }
+      if (a_slices.size() >= MaxSlices)
+        a_slices.erase(a_slices.begin());
+
+      a_slices.emplace_back();
+      Slice& s = a_slices.back();
+      s.m_T    = a_T;
+      s.m_tau  = a_tau;
+      s.m_r    = a_r;
+      s.m_D    = a_D;
+      *a_ok    = false;
+      return s;
+    }
+  }
+
+  namespace
+  {
+    //-----------------------------------------------------------------------//
+    // "HornerKernel": s_i = Sum_k c_k z_i^k for all "i" (complex):          //
+    //-----------------------------------------------------------------------//
+    // Each Horner step depends on the previous one, so the loop over the
+    // Strikes is the inner (vectorised) one, giving independent chains:
+    //
+    FASTMATH_SIMD_KERNEL
+    void HornerKernel
+    (
+      size_t                   a_n,     // Number of Strikes
+      size_t                   a_m,     // Number of terms
+      double const* __restrict a_cRe,
+      double const* __restrict a_cIm,
+      double const* __restrict a_zRe,
+      double const* __restrict a_zIm,
+      double*       __restrict a_sRe,
+      double*       __restrict a_sIm
+    )
+    {
+#     pragma omp simd
+      for (size_t i = 0; i < a_n; ++i)
+      {
+        a_sRe[i] = a_cRe[a_m - 1];
+        a_sIm[i] = a_cIm[a_m - 1];
+      }
+      for (size_t k = a_m - 1; k-- > 0; )
+      {
+        double cRe = a_cRe[k];
+        double cIm = a_cIm[k];
+#       pragma omp simd
+        for (size_t i = 0; i < a_n; ++i)
+        {
+          double re = a_sRe[i] * a_zRe[i] - a_sIm[i] * a_zIm[i] + cRe;
+          a_sIm[i]  = a_sRe[i] * a_zIm[i] + a_sIm[i] * a_zRe[i] + cIm;
+          a_sRe[i]  = re;
+        }
+      }
+    }
+  }
+
+  //=========================================================================//
+  // "CheckHestonParams":                                                    //
+  //=========================================================================//
+  void CheckHestonParams(HestonParams const& a_params)
+  {
+    if (!(a_params.m_v0    >= 0.0  && a_params.m_theta >= 0.0 &&
+          a_params.m_kappa >  0.0  && a_params.m_xi    >  0.0 &&
+          a_params.m_rho   >= -1.0 && a_params.m_rho   <= 1.0))
+      throw std::invalid_argument("Invalid Heston Params");
+  }
+
+  //=========================================================================//
+  // "HestonCF":                                                             //
+  //=========================================================================//
+  Complex HestonCF
+  (
+    HestonParams const& a_params,
+    double              a_tau,
+    Complex             a_u
+  )
+  {
+    double  kappa = a_params.m_kappa;
+    double  xi    = a_params.m_xi;
+    double  xi2   = xi * xi;
+    Complex iu    = Complex(0.0, 1.0) * a_u;
+
+    Complex beta  = kappa - a_params.m_rho * xi * iu;
+    Complex d     = std::sqrt(beta * beta + xi2 * (iu + a_u * a_u));
+    Complex bmd   = beta - d;
+    Complex g     = bmd / (beta + d);
+    Complex e     = std::exp(- d * a_tau);
+    Complex ge1   = 1.0 - g * e;
+
+    Complex C     = kappa * a_params.m_theta / xi2 *
+                    (bmd * a_tau - 2.0 * std::log(ge1 / (1.0 - g)));
+    Complex Dv    = bmd / xi2 * (1.0 - e) / ge1;
+    return std::exp(C + Dv * a_params.m_v0);
+  }
+
+  //=========================================================================//
+  // "HestonFFT" Non-Default Ctor:                                           //
+  //=========================================================================//
+  HestonFFT::HestonFFT(int a_log2N, double a_eta, double a_alpha)
+  : m_N     (size_t(1) << std::clamp(a_log2N, 1, 24)),
+    m_eta   (a_eta),
+    m_alpha (a_alpha),
+    m_lambda(2.0 * M_PI / (double(m_N) * a_eta)),
+    m_twiddle(m_N / 2),
+    m_bitRev(m_N),
+    m_damp  (m_N),
+    m_buff  (m_N),
+    m_grid  (m_N)
+  {
+    if (a_log2N < 1 || a_log2N > 24 || !(a_eta > 0.0) || !(a_alpha > 0.0))
+      throw std::invalid_argument("HestonFFT: Invalid Params");
+
+    for (size_t j = 0; j < m_N / 2; ++j)
+      m_twiddle[j] = std::polar(1.0, -2.0 * M_PI * double(j) / double(m_N));
+
+    for (size_t j = 0, r = 0; j < m_N; ++j)
+    {
+      m_bitRev[j] = r;
+      // Increment "r" in the bit-reversed order:
+      size_t bit = m_N >> 1;
+      for (; bit > 0 && (r & bit) != 0; bit >>= 1)
+        r ^= bit;
+      r |= bit;
+    }
+
+    for (size_t j = 0; j < m_N; ++j)
+      m_damp[j] = exp(- m_alpha * LogStrike(j)) / M_PI;
+  }
+
+  //=========================================================================//
+  // "HestonFFT::FFT": In-Place Radix-2 Forward FFT of "m_buff":             //
+  //=========================================================================//
+  void HestonFFT::FFT()
+  {
+    for (size_t j = 0; j < m_N; ++j)
+      if (j < m_bitRev[j])
+        std::swap(m_buff[j], m_buff[m_bitRev[j]]);
+
+    for (size_t len = 2; len <= m_N; len <<= 1)
+    {
+      size_t half = len / 2;
+      size_t step = m_N / len;
+      for (size_t s = 0; s < m_N; s += len)
+        for (size_t j = 0; j < half; ++j)
+        {
+          Complex& a = m_buff[s + j];
+          Complex& b = m_buff[s + j + half];
+          Complex  t = m_twiddle[j * step] * b;
+          b          = a - t;
+          a         += t;
+        }
+    }
+  }
+
+  //=========================================================================//
+  // "HestonFFT::GetSlice":                                                  //
+  //=========================================================================//
+  HestonFFT::Slice const& HestonFFT::GetSlice
+  (
+    double a_T,
+    double a_tau,
+    double a_r,
+    double a_D
+  )
+  {
+    bool   ok = false;
+    Slice& s  = FindSlice(m_slices, a_T, a_tau, a_r, a_D, &ok);
+    if (ok)
+      return s;
+
+    // The weights of the Call transform at the nodes u_m = v_m - (alpha+1) i
+    // (everything but the Heston part of the CF):
+    //   Simpson_m * eta * exp(-r tau) * exp(i u_m mu) * exp(i v_m b) /
+    //   (alpha^2 + alpha - v_m^2 + i (2 alpha + 1) v_m),
+    // where mu = (r - D) tau and b = N lambda / 2 (the grid half-width):
+    //
+    s.m_w.resize(m_N);
+    double mu = (a_r - a_D) * a_tau;
+    double df = exp(- a_r * a_tau);
+    double b  = 0.5 * double(m_N) * m_lambda;
+    double a1 = m_alpha + 1.0;
+
+    for (size_t m = 0; m < m_N; ++m)
+    {
+      double  v    = double(m) * m_eta;
+      double  simp = (m == 0) ? 1.0 / 3.0 : ((m % 2 == 1) ? 4.0 / 3.0
+                                                         : 2.0 / 3.0);
+      Complex u    (v, - a1);
+      Complex drift = std::exp(Complex(0.0, 1.0) * u * mu);
+      Complex den   (m_alpha * m_alpha + m_alpha - v * v,
+                     (2.0 * m_alpha + 1.0) * v);
+      s.m_w[m] = simp * m_eta * df * drift * std::polar(1.0, v * b) / den;
+    }
+    return s;
+  }
+
+  //=========================================================================//
+  // "HestonFFT::GridPx":                                                    //
+  //=========================================================================//
+  void HestonFFT::GridPx
+  (
+    HestonParams const& a_params,
+    double              a_T,
+    double              a_r,
+    double              a_D,
+    double              a_t,
+    double              a_St,
+    double*             a_px
+  )
+  {
+    CheckHestonParams(a_params);
+    double tau = a_T - a_t;
+
+    if (tau <= 0.0)
+    {
+      if (tau < 0.0)
+        throw std::invalid_argument("Negative Time to Expiration");
+      for (size_t j = 0; j < m_N; ++j)
+        a_px[j] = a_St * std::max(1.0 - exp(LogStrike(j)), 0.0);
+      return;
+    }
+    if (!(a_St > 0.0))
+      throw std::invalid_argument("Non-Positive Strike / UnderlyingPx / Vol");
+
+    Slice const& s  = GetSlice(a_T, tau, a_r, a_D);
+    double       a1 = m_alpha + 1.0;
+
+    for (size_t m = 0; m < m_N; ++m)
+      m_buff[m] = s.m_w[m] *
+                  HestonCF(a_params, tau,
+                           Complex(double(m) * m_eta, - a1));
+    FFT();
+
+    for (size_t j = 0; j < m_N; ++j)
+      a_px[j] = a_St * std::max(m_damp[j] * m_buff[j].real(), 0.0);
+  }
+
+  //=========================================================================//
+  // "HestonFFT::Px":                                                        //
+  //=========================================================================//
+  void HestonFFT::Px
+  (
+    HestonParams const& a_params,
+    PayoffType          a_type,
+    double              a_T,
+    double              a_r,
+    double              a_D,
+    double              a_t,
+    double              a_St,
+    size_t              a_n,
+    double const*       a_K,
+    double*             a_px
+  )
+  {
+    double tau = a_T - a_t;
+    CheckArgs(a_params, a_type, tau, a_St, a_n, a_K);
+
+    if (tau == 0.0)
+    {
+      PayOffs(a_type, a_St, a_n, a_K, a_px);
+      return;
+    }
+
+    // All Strikes must be within the (interpolatable) grid:
+    for (size_t i = 0; i < a_n; ++i)
+    {
+      double p = log(a_K[i] / a_St) / m_lambda + 0.5 * double(m_N);
+      if (!(p >= 1.0 && p < double(m_N) - 2.0))
+        throw std::invalid_argument("HestonFFT: Strike off the Grid");
+    }
+
+    GridPx(a_params, a_T, a_r, a_D, a_t, a_St, m_grid.data());
+
+    double dfR = exp(- a_r * tau);
+    double dfD = exp(- a_D * tau);
+
+    for (size_t i = 0; i < a_n; ++i)
+    {
+      // Cubic Lagrange interpolation on the nodes j0-1 .. j0+2:
+      double p  = log(a_K[i] / a_St) / m_lambda + 0.5 * double(m_N);
+      size_t j0 = size_t(p);
+      double f  = p - double(j0);
+      double call =
+        - f * (f - 1.0) * (f - 2.0) / 6.0         * m_grid[j0 - 1] +
+          (f + 1.0) * (f - 1.0) * (f - 2.0) / 2.0 * m_grid[j0]     -
+          (f + 1.0) * f * (f - 2.0) / 2.0         * m_grid[j0 + 1] +
+          (f + 1.0) * f * (f - 1.0) / 6.0         * m_grid[j0 + 2];
+
+      a_px[i] = (a_type == PayoffType::Call)
+                ? std::max(call, 0.0)
+                : std::max(call - a_St * dfD + a_K[i] * dfR, 0.0);
+    }
+  }
+
+  //=========================================================================//
+  // "HestonCOS" Non-Default Ctor:                                           //
+  //=========================================================================//
+  HestonCOS::HestonCOS(int a_N, double a_L)
+  : m_N(size_t(std::max(a_N, 2))),
+    m_L(a_L)
+  {
+    if (a_N < 2 || !(a_L > 0.0))
+      throw std::invalid_argument("HestonCOS: Invalid Params");
+  }
+
+  //=========================================================================//
+  // "HestonCOS::GetSlice":                                                  //
+  //=========================================================================//
+  HestonCOS::Slice const& HestonCOS::GetSlice
+  (
+    HestonParams const& a_params,
+    double              a_T,
+    double              a_tau,
+    double              a_r,
+    double              a_D,
+    double              a_xMin,
+    double              a_xMax
+  )
+  {
+    //-----------------------------------------------------------------------//
+    // The range required by the current params:                             //
+    //-----------------------------------------------------------------------//
+    // The cumulants of log(S_T / S_t) (Fang and Oosterlee 2008, Table 11):
+    double k   = a_params.m_kappa;
+    double th  = a_params.m_theta;
+    double v0  = a_params.m_v0;
+    double xi  = a_params.m_xi;
+    double rho = a_params.m_rho;
+    double tau = a_tau;
+    double e1  = exp(- k * tau);
+    double c1  = (a_r - a_D) * tau + (1.0 - e1) * (th - v0) / (2.0 * k) -
+                 0.5 * th * tau;
+    double c2  =
+      (xi * tau * k * e1 * (v0 - th) * (8.0 * k * rho - 4.0 * xi) +
+       k * rho * xi * (1.0 - e1) * (16.0 * th - 8.0 * v0) +
+       2.0 * th * k * tau * (- 4.0 * k * rho * xi + xi * xi + 4.0 * k * k) +
+       xi * xi * ((th - 2.0 * v0) * e1 * e1 + th * (6.0 * e1 - 7.0) +
+                  2.0 * v0) +
+       8.0 * k * k * (v0 - th) * (1.0 - e1)) / (8.0 * k * k * k);
+
+    // (Guard against round-off for tiny variances):
+    double wBar = th * tau + (v0 - th) * (1.0 - e1) / k;
+    double sd   = sqrt(std::max({c2, wBar, 1e-8}));
+
+    // The range of log(S_T / K) = x + log(S_T / S_t) for all Strikes:
+    double lo   = a_xMin + c1 - m_L * sd;
+    double hi   = a_xMax + c1 + m_L * sd;
+
+    //-----------------------------------------------------------------------//
+    // Re-use the cached range if possible:                                  //
+    //-----------------------------------------------------------------------//
+    bool   ok = false;
+    Slice* s  = &FindSlice(m_slices, a_T, a_tau, a_r, a_D, &ok);
+    if (ok && s->m_a <= lo && s->m_b >= hi &&
+        s->m_b - s->m_a <= 1.5 * (hi - lo))
+      return *s;
+    double a = lo - 0.05 * (hi - lo);
+    double b = hi + 0.05 * (hi - lo);
+    s->m_a   = a;
+    s->m_b   = b;
+
+    // The number of terms: at least "m_N", and 8 per "sd" of the range:
+    size_t n = std::max(m_N, size_t(ceil(8.0 * (b - a) / sd)));
+    s->m_V.resize(n);
+
+    //-----------------------------------------------------------------------//
+    // The Put payoff coeffs: V_k = 2/(b-a) (Psi_k(a, d) - Chi_k(a, d)),     //
+    //-----------------------------------------------------------------------//
+    // where d = min(0, b), and (with u = u_k):
+    //   Chi_k = [cos(u(d-a)) e^d - e^a + u sin(u(d-a)) e^d] / (1 + u^2),
+    //   Psi_k = sin(u(d-a)) / u  (d - a for k = 0):
+    //
+    double d = std::min(0.0, b);
+    for (size_t j = 0; j < n; ++j)
+    {
+      double u   = double(j) * M_PI / (b - a);
+      double cs  = cos(u * (d - a));
+      double sn  = sin(u * (d - a));
+      double ed  = exp(d);
+      double chi = (cs * ed - exp(a) + u * sn * ed) / (1.0 + u * u);
+      double psi = (j == 0) ? (d - a) : sn / u;
+      s->m_V[j]  = 2.0 / (b - a) * (psi - chi);
+    }
+    return *s;
+  }
+
+  //=========================================================================//
+  // "HestonCOS::Px":                                                        //
+  //=========================================================================//
+  void HestonCOS::Px
+  (
+    HestonParams const& a_params,
+    PayoffType          a_type,
+    double              a_T,
+    double              a_r,
+    double              a_D,
+    double              a_t,
+    double              a_St,
+    size_t              a_n,
+    double const*       a_K,
+    double*             a_px
+  )
+  {
+    double tau = a_T - a_t;
+    CheckArgs(a_params, a_type, tau, a_St, a_n, a_K);
+
+    if (tau == 0.0 || a_n == 0)
+    {
+      PayOffs(a_type, a_St, a_n, a_K, a_px);
+      return;
+    }
+    double xMin = INFINITY;
+    double xMax = - INFINITY;
+    for (size_t i = 0; i < a_n; ++i)
+    {
+      double x = log(a_St / a_K[i]);
+      xMin     = std::min(xMin, x);
+      xMax     = std::max(xMax, x);
+    }
+    Slice const& s   = GetSlice(a_params, a_T, tau, a_r, a_D, xMin, xMax);
+    size_t       n   = s.m_V.size();
+    double       a   = s.m_a;
+    double       b   = s.m_b;
+    double       mu  = (a_r - a_D) * tau;
+    double       dfR = exp(- a_r * tau);
+    double       dfD = exp(- a_D * tau);
+
+    // The coeffs c_k = CF(u_k) * V_k (with the drift; the 1st one halved),
+    // as separate Re and Im parts:
+    m_cRe.resize(n);
+    m_cIm.resize(n);
+    for (size_t j = 0; j < n; ++j)
+    {
+      double  u = double(j) * M_PI / (b - a);
+      Complex c = HestonCF(a_params, tau, u) * std::polar(1.0, u * mu) *
+                  s.m_V[j];
+      m_cRe[j]  = c.real();
+      m_cIm[j]  = c.imag();
+    }
+    m_cRe[0] *= 0.5;
+    m_cIm[0] *= 0.5;
+
+    // For each Strike, z = exp(i Pi (x - a) / (b - a)):
+    m_zRe.resize(a_n);
+    m_zIm.resize(a_n);
+    m_sRe.resize(a_n);
+    m_sIm.resize(a_n);
+    for (size_t i = 0; i < a_n; ++i)
+    {
+      double ph = M_PI * (log(a_St / a_K[i]) - a) / (b - a);
+      m_zRe[i]  = cos(ph);
+      m_zIm[i]  = sin(ph);
+    }
+    HornerKernel(a_n, n, m_cRe.data(), m_cIm.data(), m_zRe.data(),
+                 m_zIm.data(), m_sRe.data(), m_sIm.data());
+
+    for (size_t i = 0; i < a_n; ++i)
+    {
+      double put = a_K[i] * dfR * m_sRe[i];
+      a_px[i]    = (a_type == PayoffType::Put)
+                   ? std::max(put, 0.0)
+                   : std::max(put + a_St * dfD - a_K[i] * dfR, 0.0);
+    }
+  }
+}
+// End namespace BSM
@@ -0,0 +1,235 @@
+// vim:ts=2:et
+//===========================================================================//
+//                                 "Heston.h":                               //
+//    Heston Stochastic Vol Model: Characteristic Function, FFT and COS      //
+//===========================================================================//
+#pragma once
+#include "BSM.h"
+#include <complex>
+#include <cstddef>
+#include <vector>
+
+namespace BSM
+{
+  //-------------------------------------------------------------------------//
+  // "HestonParams":                                                         //
+  //-------------------------------------------------------------------------//
+  //   dS/S = (r - D) dt + sqrt(v) dW1,
+  //   dv   = kappa (theta - v) dt + xi sqrt(v) dW2,   dW1 dW2 = rho dt:
+  //
+  struct HestonParams
+  {
+    double m_v0    = NAN;   // Initial Variance
+    double m_kappa = NAN;   // Mean-Reversion Rate of the Variance
+    double m_theta = NAN;   // Long-Run Variance
+    double m_xi    = NAN;   // Vol of Variance
+    double m_rho   = NAN;   // Correlation of the Underlying and the Variance
+  };
+
+  // Throws "std::invalid_argument" unless v0, theta >= 0, kappa, xi > 0 and
+  // |rho| <= 1:
+  void CheckHestonParams(HestonParams const& a_params);
+
+  //-------------------------------------------------------------------------//
+  // "HestonCF": The Characteristic Function:                                //
+  //-------------------------------------------------------------------------//
+  // E[exp(i u X)], where X = log(S_T / S_t) - (r - D) * tau, ie WITHOUT the
+  // drift (which the pricers below fold into their cached weights). "a_u"
+  // may be complex (as in Carr-Madan). Uses the "little trap" formulation
+  // (Albrecher et al), which is continuous in "a_u" for any "a_tau":
+  //
+  std::complex<double> HestonCF
+  (
+    HestonParams const&  a_params,
+    double               a_tau,
+    std::complex<double> a_u
+  );
+
+  //=========================================================================//
+  // "HestonFFT": Carr-Madan FFT Pricer:                                     //
+  //=========================================================================//
+  // One FFT of size N gives the Call Pxs on the whole log-strike grid
+  //   k_j = log(K_j / St) = (j - N/2) * lambda,  lambda = 2 Pi / (N * eta),
+  // from the damped (exp(alpha k)) Call transform,  integrated with Simpson's
+  // rule over the nodes v_m = m * eta.
+  // Per expiration (ie per (T, r, D)), the Heston-independent factors of the
+  // integrand (the Simpson weights, the discount factor, the drift, the damp-
+  // ing denominators and the grid phase) are cached; a re-valuation with new
+  // Heston params (as in calibration) then costs N "HestonCF" evaluations
+  // and the FFT. A cached expiration is re-computed in place when the Pric-
+  // ing Time moves on, and at most 64 expirations are kept (the oldest one
+  // is evicted first), so the cache stays bounded in long-running processes.
+  // With the defaults, the Pxs are typically within 1e-8 * St of the exact
+  // ones (up to 2e-7 * St for maturities of a few weeks, where the cubic in-
+  // terpolation is less accurate);  "HestonCOS" is both faster and more ac-
+  // curate for a given set of Strikes, the FFT being preferable when Pxs on
+  // the whole grid are needed. NOT thread-safe (the cache is in the obj):
+  //
+  class HestonFFT
+  {
+  private:
+    //-----------------------------------------------------------------------//
+    // Types and Data Flds:                                                  //
+    //-----------------------------------------------------------------------//
+    struct Slice
+    {
+      double                            m_T   = NAN;
+      double                            m_tau = NAN;
+      double                            m_r   = NAN;
+      double                            m_D   = NAN;
+      std::vector<std::complex<double>> m_w;     // [N] integrand weights
+    };
+
+    size_t                            m_N;
+    double                            m_eta;
+    double                            m_alpha;
+    double                            m_lambda;
+    std::vector<std::complex<double>> m_twiddle;  // [N/2] exp(-2 Pi i j/N)
+    std::vector<size_t>               m_bitRev;   // [N]
+    std::vector<double>               m_damp;     // [N] exp(-alpha k_j) / Pi
+    std::vector<Slice>                m_slices;
+    std::vector<std::complex<double>> m_buff;     // [N]
+    std::vector<double>               m_grid;     // [N] Call Pxs / St
+
+    Slice const& GetSlice(double a_T, double a_tau, double a_r, double a_D);
+    void         FFT();
+
+  public:
+    //-----------------------------------------------------------------------//
+    // Non-Default Ctor:                                                     //
+    //-----------------------------------------------------------------------//
+    // By default, N = 4096 and eta = 0.25, so lambda = 0.0061 (the grid spans
+    // +-12.6 in log-strike); alpha = 1.5:
+    //
+    HestonFFT(int a_log2N = 12, double a_eta = 0.25, double a_alpha = 1.5);
+
+    size_t N()                     const { return m_N; }
+    double LogStrike(size_t a_j)   const
+      { return (double(a_j) - 0.5 * double(m_N)) * m_lambda; }
+
+    //-----------------------------------------------------------------------//
+    // "GridPx": Call Pxs on the Whole Grid:                                 //
+    //-----------------------------------------------------------------------//
+    // "a_px[j]" is the Px of the Call with the Strike St * exp(LogStrike(j))
+    // (only the central part of the grid is accurate; far out-of-the-money,
+    // the Pxs are dominated by the FFT round-off):
+    //
+    void GridPx
+    (
+      HestonParams const& a_params,
+      double              a_T,    // Option Expiration Time
+      double              a_r,    // Risk-Free Interest Rate
+      double              a_D,    // Dividend Rate
+      double              a_t,    // Pricing Time
+      double              a_St,   // Underlying Px
+      double*             a_px    // [N] Call Pxs
+    );
+
+    //-----------------------------------------------------------------------//
+    // "Px": Pxs of Calls or Puts with Arbitrary Strikes:                    //
+    //-----------------------------------------------------------------------//
+    // One "GridPx", then cubic interpolation in log-strike (and the Put-Call
+    // parity for Puts). Throws "std::invalid_argument" for invalid args
+    // (including Strikes off the grid), "std::logic_error" for PayoffTypes
+    // other than Call and Put:
+    //
+    void Px
+    (
+      HestonParams const& a_params,
+      PayoffType          a_type,
+      double              a_T,
+      double              a_r,
+      double              a_D,
+      double              a_t,
+      double              a_St,
+      size_t              a_n,    // Number of Strikes
+      double const*       a_K,    // [a_n] Strikes
+      double*             a_px    // [a_n] Option Pxs
+    );
+
+    void ClearCache() { m_slices.clear(); }
+  };
+
+  //=========================================================================//
+  // "HestonCOS": Fourier-Cosine (Fang-Oosterlee) Pricer:                    //
+  //=========================================================================//
+  // The density of log(S_T / S_t) is expanded into cosines on [a, b], which
+  // covers c1 -+ L * sqrt(c2) (c1, c2 being its cumulants) shifted by the
+  // log-moneyness of all Strikes; the Put Pxs are then
+  //   K * exp(-r tau) * Re Sum'_k CF(u_k) * exp(i u_k (x - a)) * V_k,
+  // with u_k = k Pi / (b - a) and x = log(St / K), and the Calls are obtained
+  // by the Put-Call parity (as recommended by Fang and Oosterlee).  The CF is
+  // evaluated once per valuation (for all Strikes),  and the sum is computed
+  // by Horner's rule in exp(i Pi (x - a) / (b - a)), ie without any trigono-
+  // metric functions in the loop over the terms  (vectorised over Strikes).
+  // The number of terms is at least N, and 8 per sqrt(c2) of [a, b] (so it
+  // grows for wide Strike ranges at short maturities).  NB: Heston log-returns
+  // have fat tails, so L must be larger than the 10-12 common for Levy models:
+  // with L = 20, the Pxs are typically within 1e-9 * St of the exact ones.
+  // Per expiration, [a, b] and the payoff coeffs V_k are cached (bounded as
+  // in "HestonFFT"); [a, b] is only re-computed (with a 10% margin) when the
+  // Pricing Time moves on, or if the current Heston params or Strikes need
+  // a wider range, or a much (1.5x) narrower one, so during a calibration it
+  // mostly stays fixed. NOT thread-safe (the cache is in the obj):
+  //
+  class HestonCOS
+  {
+  private:
+    struct Slice
+    {
+      double              m_T   = NAN;
+      double              m_tau = NAN;
+      double              m_r   = NAN;
+      double              m_D   = NAN;
+      double              m_a   = NAN;
+      double              m_b   = NAN;
+      std::vector<double> m_V;      // Put payoff coeffs (>= N of them)
+    };
+
+    size_t              m_N;
+    double              m_L;
+    std::vector<Slice>  m_slices;
+    std::vector<double> m_cRe;    // CF(u_k) * V_k
+    std::vector<double> m_cIm;
+    std::vector<double> m_zRe;    // Per-Strike exp(i Pi (x - a) / (b - a))
+    std::vector<double> m_zIm;
+    std::vector<double> m_sRe;    // Per-Strike sums
+    std::vector<double> m_sIm;
+
+    Slice const& GetSlice
+    (
+      HestonParams const& a_params,
+      double              a_T,
+      double              a_tau,
+      double              a_r,
+      double              a_D,
+      double              a_xMin,   // Min and Max of log(St / K)
+      double              a_xMax
+    );
+
+  public:
+    HestonCOS(int a_N = 256, double a_L = 20.0);
+
+    size_t N() const { return m_N; }
+
+    // Same args and exceptions as "HestonFFT::Px" (except that there is no
+    // grid, so any positive Strikes are OK):
+    //
+    void Px
+    (
+      HestonParams const& a_params,
+      PayoffType          a_type,
+      double              a_T,
+      double              a_r,
+      double              a_D,
+      double              a_t,
+      double              a_St,
+      size_t              a_n,
+      double const*       a_K,
+      double*             a_px
+    );
+
+    void ClearCache() { m_slices.clear(); }
+  };
+}
+// End namespace BSM
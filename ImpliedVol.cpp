@@ -0,0 +1,488 @@
+// vim:ts=2:et
+//===========================================================================//
+//                              "ImpliedVol.cpp":                            //
+//                Implied Volatility Solver: Implementation                  //
+//===========================================================================//
+#include "ImpliedVol.h"
+#include <algorithm>
+#include <cmath>
+
+namespace BSM
+{
+  namespace
+  {
+    //-----------------------------------------------------------------------//
+    // Normalised Option Px:                                                 //
+    //-----------------------------------------------------------------------//
+    // In terms of x = log(F/K) and the total vol v = sigma * sqrt(tau), the
+    // undiscounted Px of an option on the Fwd "F", divided by "K", is
+    //   b(v) = q * (exp(x) * Phi(q*d1) - Phi(q*d2)),  d{1,2} = x/v +- v/2,
+    // where q = +1 for a Call and -1 for a Put.  We always use q = -sign(x),
+    // ie the out-of-the-money option, to avoid cancellation of the intrinsic
+    // value. NB: "erfc" is used for "Phi" as it is accurate in the left tail:
+    //
+    inline double PhiC(double a_x)
+      { return 0.5 * erfc(-a_x * M_SQRT1_2); }
+
+    inline double NormB(double a_x, double a_q, double a_v)
+    {
+      double d1 = a_x / a_v + 0.5 * a_v;
+      double d2 = d1 - a_v;
+      return a_q * (exp(a_x) * PhiC(a_q * d1) - PhiC(a_q * d2));
+    }
+
+    constexpr int    MaxIters = 64;
+    // The iterations converge cubically, so after a step of relative size
+    // "CubicTol", the remaining error is below (CubicTol^3 = 1e-15):
+    constexpr double CubicTol = 1e-5;
+    // The max ratio of a warm start to the built-in initial guess,  either
+    // way (the latter is within 2 orders of magnitude of the root):
+    constexpr double MaxWarmRatio = 100.0;
+
+    //-----------------------------------------------------------------------//
+    // "SolveNormVol":                                                       //
+    //-----------------------------------------------------------------------//
+    // Solves b(v) = a_b for v, where 0 < a_b < upper bound. Returns NaN if
+    // not converged:
+    //
+    double SolveNormVol(double a_x, double a_q, double a_b, double a_v0)
+    {
+      // The inflection point of b(v): b'' = 0 where d1 * d2 = 0; b is convex
+      // on the left of it, and concave on the right:
+      double vc    = sqrt(2.0 * fabs(a_x));
+      double bc    = (vc > 0.0) ? NormB(a_x, a_q, vc) : 0.0;
+      bool   useLn = (a_b < bc);
+      double lnB   = log(a_b);
+
+      // The built-in initial guess:
+      double v = NAN;
+      if (useLn)
+        // Asymptotically, ln b ~ A - x^2 / (2 v^2) for v -> 0; "A" is set so
+        // that this passes through the inflection point (vc, bc):
+        v = std::min
+            (fabs(a_x) / sqrt(2.0 * (log(bc) + 0.25 * fabs(a_x) - lnB)), vc);
+      else
+      {
+        // Corrado-Miller guess (in terms of the normalised Call Px "c"):
+        double f    = exp(a_x);
+        double c    = (a_q > 0.0) ? a_b : a_b + (f - 1.0);
+        double h    = c - 0.5 * (f - 1.0);
+        double disc = std::max(h * h - (f - 1.0) * (f - 1.0) / M_PI, 0.0);
+        v = sqrt(2.0 * M_PI) / (f + 1.0) * (h + sqrt(disc));
+        v = std::max(v, vc);
+      }
+      if (!(v > 0.0))
+        v = 1.0;
+
+      // A warm start is only trusted within "MaxWarmRatio" of the built-in
+      // guess (a stale or garbage vol would otherwise start the iterations
+      // where b(v) is flat, at 0 or at its upper bound):
+      if (a_v0 > 0.0)
+        v = std::clamp(a_v0, v / MaxWarmRatio, v * MaxWarmRatio);
+
+      // Bracketing interval for the root (hi = +oo initially):
+      double lo    = 0.0;
+      double hi    = INFINITY;
+      double prevF = INFINITY;  // |f| at the previous iteration
+
+      for (int i = 0; i < MaxIters; ++i)
+      {
+        double d1  = a_x / v + 0.5 * v;
+        double d2  = d1 - v;
+        double b   = a_q * (exp(a_x) * PhiC(a_q * d1) - PhiC(a_q * d2));
+
+        // Update the bracket: b(v) is increasing:
+        if (b > a_b)
+          hi = v;
+        else
+          lo = v;
+
+        // b' = Vega (normalised), and the ratios b''/b', b'''/b':
+        double b1  = M_2_SQRTPI * M_SQRT1_2 * 0.5 * exp(-0.5 * d2 * d2);
+        double dd  = d1 * d2;
+        double h2  = dd / v;
+        double h3  = (dd * dd - dd - d1 * d1 - d2 * d2) / (v * v);
+
+        // The objective "f", its derivative "f1" and the ratios f''/f1,
+        // f'''/f1:
+        double f   = NAN;
+        double f1  = b1;
+        if (useLn)
+        {
+          if (!(b > 0.0))
+          {
+            // b underflowed: we are far left of the root, bisect:
+            v = std::isfinite(hi) ? 0.5 * (lo + hi) : 2.0 * v;
+            continue;
+          }
+          double r = b1 / b;    // (ln b)'
+          h3  = h3 - 3.0 * h2 * r + 2.0 * r * r;
+          h2  = h2 - r;
+          f   = log(b) - lnB;
+          f1  = r;
+        }
+        else
+          f   = b - a_b;
+        double nu  = - f / f1;
+
+        // 3rd-order Householder step:
+        double den  = 1.0 + h2 * nu + h3 * nu * nu / 6.0;
+        if (!std::isfinite(den))
+        {
+          // b' (nearly) underflowed: b(v) is flat here, far from the root,
+          // and the step would be meaningless (0 or NaN); bisect instead:
+          v = std::isfinite(hi) ? 0.5 * (lo + hi) : 2.0 * std::max(v, lo);
+          continue;
+        }
+        double step = (fabs(den) > 0.1)
+                      ? nu * (1.0 + 0.5 * h2 * nu) / den
+                      : nu;
+        double vn   = v + step;
+
+        if (fabs(step) <= CubicTol * v)
+          return vn;
+
+        // Safe-guard: if the step leaves the bracket, or the last one did not
+        // halve |f| (the iterations crawl along a flat part of b(v), eg from
+        // a far-off initial guess), bisect the bracket instead (or double "v"
+        // while there is no upper bound yet):
+        if (!(vn > lo && vn < hi) || fabs(f) > 0.5 * prevF)
+          vn = std::isfinite(hi) ? 0.5 * (lo + hi) : 2.0 * std::max(v, lo);
+        prevF = fabs(f);
+        v     = vn;
+      }
+      return NAN;
+    }
+
+    //-----------------------------------------------------------------------//
+    // Normal (Bachelier) Time Value:                                        //
+    //-----------------------------------------------------------------------//
+    // For the out-of-the-money option at the distance a = |F - K| >= 0 from
+    // the Fwd, and the total Normal vol v = sigma * sqrt(tau), the undiscoun-
+    // ted Px is
+    //   g(v) = v * pdf(u) - a * Phi(-u) = v * pdf(u) * (1 - u * M(u)),
+    // where u = a / v and M(u) = Phi(-u) / pdf(u) is the Mills ratio; also,
+    // g'(v) = pdf(u). For large "u", 1 - u * M(u) suffers from cancellation,
+    // so its asymptotic series is used instead. Returns g, and g' via "a_g1":
+    //
+    inline double NormalTV(double a_a, double a_v, double* a_g1)
+    {
+      double u   = a_a / a_v;
+      double pdf = M_2_SQRTPI * M_SQRT1_2 * 0.5 * exp(-0.5 * u * u);
+      *a_g1      = pdf;
+      if (u < 20.0)
+        return a_v * pdf - a_a * PhiC(-u);
+
+      double y = 1.0 / (u * u);
+      double c =
+        y * (1.0 + y * (-3.0 + y * (15.0 + y * (-105.0 + y * (945.0 +
+        y * (-10395.0 + y * 135135.0))))));
+      return a_v * pdf * c;
+    }
+
+    //-----------------------------------------------------------------------//
+    // "SolveNormalVol":                                                     //
+    //-----------------------------------------------------------------------//
+    // Solves g(v) = a_b for v, where a_b > 0; returns NaN if not converged.
+    // As v / sqrt(2 pi) - a <= g(v) <= v / sqrt(2 pi), the root is bracketed
+    // by [sqrt(2 pi) * b, sqrt(2 pi) * (b + a)]:
+    //
+    double SolveNormalVol(double a_a, double a_b, double a_v0)
+    {
+      constexpr double Sqrt2Pi = 2.0 / (M_2_SQRTPI * M_SQRT1_2);
+      double lo  = Sqrt2Pi * a_b;
+      double hi  = Sqrt2Pi * (a_b + a_a);
+      if (a_a == 0.0)
+        return lo;      // ATM, exact
+      double lnB = log(a_b);
+
+      // Initial guess, if not given:
+      double v = a_v0;
+      if (!(v > lo && v < hi))
+      {
+        if (a_b < 0.0833 * a_a)
+        {
+          // Far out-of-the-money (g(a) = 0.0833 * a), g ~ v^3 pdf(a/v) / a^2:
+          // solve for "v" by fixed-point iterations:
+          v = a_a;
+          for (int i = 0; i < 3; ++i)
+          {
+            double e =
+              3.0 * log(v / a_a) + log(a_a / Sqrt2Pi) - lnB;
+            v = (e > 0.0) ? a_a / sqrt(2.0 * e) : v;
+          }
+        }
+        else
+          // g ~ v / sqrt(2 pi) - a / 2 for large "v":
+          v = Sqrt2Pi * (a_b + 0.5 * a_a);
+        v = std::clamp(v, lo, hi);
+      }
+
+      for (int i = 0; i < MaxIters; ++i)
+      {
+        double g1 = NAN;
+        double g  = NormalTV(a_a, v, &g1);
+
+        // Update the bracket: g(v) is increasing:
+        if (g > a_b)
+          hi = v;
+        else
+          lo = v;
+
+        if (!(g > 0.0))
+        {
+          // g underflowed: we are far left of the root, bisect:
+          v = 0.5 * (lo + hi);
+          continue;
+        }
+
+        // The objective ln(g) - ln(b) and its derivatives (g'' = g' u^2 / v):
+        double u    = a_a / v;
+        double r    = g1 / g;                     // (ln g)'
+        double h2   = g1 * u * u / (v * g) - r * r; // (ln g)''
+        double f    = log(g) - lnB;
+
+        // Halley step:
+        double nu   = - f / r;
+        double den  = 1.0 + 0.5 * nu * h2 / r;
+        double step = (fabs(den) > 0.1) ? nu / den : nu;
+        double vn   = v + step;
+
+        if (fabs(step) <= CubicTol * v)
+          return vn;
+
+        // Safe-guard: if the step leaves the bracket, bisect it instead:
+        if (!(vn > lo && vn < hi))
+          vn = 0.5 * (lo + hi);
+        v = vn;
+      }
+      return NAN;
+    }
+  }
+
+  //-------------------------------------------------------------------------//
+  // "ImplVol":                                                              //
+  //-------------------------------------------------------------------------//
+  double ImplVol
+  (
+    // Option Spec:
+    PayoffType a_type,
+    double     a_px,
+    double     a_K,
+    double     a_T,
+    // Market Data:
+    double     a_r,
+    double     a_D,
+    // "Quick" variables:
+    double     a_t,
+    double     a_St,
+    // Output and Initial Guess:
+    IVStatus*  a_status,
+    double     a_sigma0
+  )
+  noexcept
+  {
+    IVStatus dummy;
+    IVStatus& status = (a_status != nullptr) ? *a_status : dummy;
+
+    double tau = a_T - a_t;
+    if (!(tau > 0.0 && a_K > 0.0 && a_St > 0.0 && a_px >= 0.0))
+    {
+      status = IVStatus::InvalidArgs;
+      return NAN;
+    }
+    double theta = 0.0;   // +1 for Call, -1 for Put
+    switch (a_type)
+    {
+      case PayoffType::Call: theta =  1.0; break;
+      case PayoffType::Put:  theta = -1.0; break;
+      default:
+        status = IVStatus::UnsupportedType;
+        return NAN;
+    }
+
+    // Normalise: undiscounted Px on the Fwd, in units of "K":
+    double sqrtTau = sqrt(tau);
+    double x       = log(a_St / a_K) + (a_r - a_D) * tau;  // log(F/K)
+    double f       = exp(x);
+    double c       = a_px * exp(a_r * tau) / a_K;
+
+    // Switch to the out-of-the-money option using the Put-Call Parity:
+    //   Call - Put = f - 1:
+    double q = (x > 0.0) ? -1.0 : 1.0;
+    double b = (q == theta) ? c : c - theta * (f - 1.0);
+
+    if (!(b > 0.0))
+    {
+      status = IVStatus::BelowIntrinsic;
+      return NAN;
+    }
+    if (b >= ((q > 0.0) ? f : 1.0))
+    {
+      status = IVStatus::AboveMax;
+      return NAN;
+    }
+
+    double v = SolveNormVol(x, q, b, a_sigma0 * sqrtTau);
+    if (!std::isfinite(v))
+    {
+      status = IVStatus::NoConvergence;
+      return NAN;
+    }
+    status = IVStatus::OK;
+    return v / sqrtTau;
+  }
+
+  //-------------------------------------------------------------------------//
+  // "ImplVolBatch":                                                         //
+  //-------------------------------------------------------------------------//
+  void ImplVolBatch
+  (
+    // Option Specs:
+    PayoffType    a_type,
+    size_t        a_n,
+    double const* a_px,
+    double const* a_K,
+    double const* a_T,
+    // Market Data:
+    double        a_r,
+    double        a_D,
+    // "Quick" variables:
+    double        a_t,
+    double const* a_St,
+    // Outputs:
+    double*       a_sigma,
+    IVStatus*     a_status,
+    bool          a_warmStart
+  )
+  noexcept
+  {
+    for (size_t i = 0; i < a_n; ++i)
+    {
+      double sigma0 = a_warmStart ? a_sigma[i] : 0.0;
+      a_sigma[i]    =
+        ImplVol(a_type, a_px[i], a_K[i], a_T[i], a_r, a_D, a_t, a_St[i],
+                a_status + i, sigma0);
+    }
+  }
+
+  //-------------------------------------------------------------------------//
+  // "ImplVol" with "PxModel":                                               //
+  //-------------------------------------------------------------------------//
+  double ImplVol
+  (
+    PxModel    a_model,
+    PayoffType a_type,
+    double     a_px,
+    double     a_K,
+    double     a_T,
+    double     a_r,
+    double     a_D,
+    double     a_t,
+    double     a_St,
+    IVStatus*  a_status,
+    double     a_sigma0
+  )
+  noexcept
+  {
+    IVStatus dummy;
+    IVStatus& status = (a_status != nullptr) ? *a_status : dummy;
+
+    switch (a_model)
+    {
+      case PxModel::BSM:
+        return ImplVol
+               (a_type, a_px, a_K, a_T, a_r, a_D, a_t, a_St, a_status,
+                a_sigma0);
+
+      // Black-76 is BSM on the Fwd, with the Fwd "dividend" rate equal to "r":
+      case PxModel::Black76:
+        return ImplVol
+               (a_type, a_px, a_K, a_T, a_r, a_r, a_t, a_St, a_status,
+                a_sigma0);
+
+      case PxModel::Bachelier:
+        break;
+
+      default:
+        status = IVStatus::InvalidArgs;
+        return NAN;
+    }
+
+    double tau = a_T - a_t;
+    if (!(tau > 0.0 && std::isfinite(a_K) && std::isfinite(a_St) &&
+          a_px >= 0.0))
+    {
+      status = IVStatus::InvalidArgs;
+      return NAN;
+    }
+    double theta = 0.0;   // +1 for Call, -1 for Put
+    switch (a_type)
+    {
+      case PayoffType::Call: theta =  1.0; break;
+      case PayoffType::Put:  theta = -1.0; break;
+      default:
+        status = IVStatus::UnsupportedType;
+        return NAN;
+    }
+
+    // Undiscounted Px, and the out-of-the-money one by the Put-Call Parity:
+    //   Call - Put = F - K:
+    double sqrtTau = sqrt(tau);
+    double x       = a_St - a_K;
+    double c       = a_px * exp(a_r * tau);
+    double q       = (x > 0.0) ? -1.0 : 1.0;
+    double b       = (q == theta) ? c : c - theta * x;
+
+    if (!(b > 0.0))
+    {
+      status = IVStatus::BelowIntrinsic;
+      return NAN;
+    }
+    if (!std::isfinite(b))
+    {
+      status = IVStatus::InvalidArgs;
+      return NAN;
+    }
+
+    double v = SolveNormalVol(fabs(x), b, a_sigma0 * sqrtTau);
+    if (!std::isfinite(v))
+    {
+      status = IVStatus::NoConvergence;
+      return NAN;
+    }
+    status = IVStatus::OK;
+    return v / sqrtTau;
+  }
+
+  //-------------------------------------------------------------------------//
+  // "ImplVolBatch" with "PxModel":                                          //
+  //-------------------------------------------------------------------------//
+  void ImplVolBatch
+  (
+    PxModel       a_model,
+    PayoffType    a_type,
+    size_t        a_n,
+    double const* a_px,
+    double const* a_K,
+    double const* a_T,
+    double        a_r,
+    double        a_D,
+    double        a_t,
+    double const* a_St,
+    double*       a_sigma,
+    IVStatus*     a_status,
+    bool          a_warmStart
+  )
+  noexcept
+  {
+    for (size_t i = 0; i < a_n; ++i)
+    {
+      double sigma0 = a_warmStart ? a_sigma[i] : 0.0;
+      a_sigma[i]    =
+        ImplVol(a_model, a_type, a_px[i], a_K[i], a_T[i], a_r, a_D, a_t,
+                a_St[i], a_status + i, sigma0);
+    }
+  }
+}
+// End namespace BSM
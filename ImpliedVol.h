@@ -0,0 +1,137 @@
+// vim:ts=2:et
+//===========================================================================//
+//                               "ImpliedVol.h":                             //
+//            Implied Volatility from BSM Option Pxs (Call / Put)            //
+//===========================================================================//
+#pragma once
+#include "BSM.h"
+#include <cstddef>
+
+namespace BSM
+{
+  //-------------------------------------------------------------------------//
+  // Implied Vol Solver Status Codes:                                        //
+  //-------------------------------------------------------------------------//
+  // NB: The solver does NOT throw exceptions; in all cases other than "OK",
+  // the returned vol is NaN:
+  //
+  enum class IVStatus: int
+  {
+    OK              = 0,
+    InvalidArgs     = 1, // Non-positive K / St / tau, or negative / NaN Px
+    UnsupportedType = 2, // Only Call and Put are supported
+    BelowIntrinsic  = 3, // Px <= intrinsic value: no solution (vol = 0)
+    AboveMax        = 4, // Px >= upper no-arbitrage bound (vol = +oo)
+    NoConvergence   = 5  // Iterations limit exceeded
+  };
+
+  //-------------------------------------------------------------------------//
+  // "ImplVol": Implied Vol for a Single Option:                             //
+  //-------------------------------------------------------------------------//
+  // The Px is normalised to the undiscounted out-of-the-money option on the
+  // Fwd, and the vol is then found by 3rd-order Householder iterations with
+  // a bracketing safe-guard (as in P.Jaeckel's "Let's Be Rational",  below
+  // the inflection point the log of the Px is used as the objective). With
+  // the built-in initial guess,  it normally converges in 2-3 iterations to
+  // (almost) full "double" precision.
+  // If "a_sigma0" is positive,  it is used as the initial guess instead
+  // (warm start, eg from the previous tick's vol); then 1-2 iterations are
+  // typically sufficient. A warm start more than 100x off the built-in guess
+  // (either way) is clamped into that range,  and a far-off one converges by
+  // bisection (in at most ~15 iterations), so a stale vol cannot fail:
+  //
+  double ImplVol
+  (
+    // Option Spec:
+    PayoffType a_type,
+    double     a_px,    // Option Px (eg a market quote)
+    double     a_K,     // Option Strike
+    double     a_T,     // Opton Expiration Time, as Year Fraction
+    // Market Data:
+    double     a_r,     // Risk-Free Interest Rate (for the Numeraire Ccy)
+    double     a_D,     // Dividend Rate (Risk-Free Rate for Foreign Ccy)
+    // "Quick" variables:
+    double     a_t,     // Pricing Time (as Year Fraction)
+    double     a_St,    // Underlying Px at Time "a_t"
+    // Output (may be NULL) and Initial Guess (optional):
+    IVStatus*  a_status = nullptr,
+    double     a_sigma0 = 0.0
+  )
+  noexcept;
+
+  //-------------------------------------------------------------------------//
+  // "ImplVolBatch": Implied Vols for a Whole Chain:                         //
+  //-------------------------------------------------------------------------//
+  // Inputs are Structure-of-Arrays, as in "PxBatch". If "a_warmStart" is set,
+  // "a_sigma" must on input contain the initial guesses (eg the vols from the
+  // previous tick); non-positive or NaN ones are replaced by the built-in
+  // guess. Each element gets its own status:
+  //
+  void ImplVolBatch
+  (
+    // Option Specs:
+    PayoffType    a_type,
+    size_t        a_n,          // Number of Options
+    double const* a_px,         // [a_n] Option Pxs
+    double const* a_K,          // [a_n] Option Strikes
+    double const* a_T,          // [a_n] Option Expiration Times
+    // Market Data:
+    double        a_r,          // Risk-Free Interest Rate (shared)
+    double        a_D,          // Dividend Rate           (shared)
+    // "Quick" variables:
+    double        a_t,          // Pricing Time            (shared)
+    double const* a_St,         // [a_n] Underlying Pxs
+    // Outputs (and initial guesses in the Warm Start mode):
+    double*       a_sigma,      // [a_n]
+    IVStatus*     a_status,     // [a_n]
+    bool          a_warmStart = false
+  )
+  noexcept;
+
+  //-------------------------------------------------------------------------//
+  // "PxModel" Overloads (Black-76 and Bachelier):                           //
+  //-------------------------------------------------------------------------//
+  // Same args as above, with "a_St" the Fwd Px for "Black76" and "Bachelier"
+  // ("a_D" is then ignored; see "PxModel" in "BSM.h"). Black-76 uses the same
+  // solver (as BSM with D = r). For Bachelier, the result is the Normal vol;
+  // F and K may be of any sign, and there is no upper Px bound ("AboveMax"
+  // is never returned). Its solver uses Halley iterations on the log of the
+  // out-of-the-money time value (which is concave in the vol), starting from
+  // an asymptotic guess, with the same bracketing safe-guard as above; it
+  // normally converges in 2-4 iterations to (almost) full precision:
+  //
+  double ImplVol
+  (
+    PxModel    a_model,
+    PayoffType a_type,
+    double     a_px,
+    double     a_K,
+    double     a_T,
+    double     a_r,
+    double     a_D,
+    double     a_t,
+    double     a_St,    // Underlying Px (BSM) or Fwd Px
+    IVStatus*  a_status = nullptr,
+    double     a_sigma0 = 0.0
+  )
+  noexcept;
+
+  void ImplVolBatch
+  (
+    PxModel       a_model,
+    PayoffType    a_type,
+    size_t        a_n,
+    double const* a_px,         // [a_n]
+    double const* a_K,          // [a_n]
+    double const* a_T,          // [a_n]
+    double        a_r,
+    double        a_D,
+    double        a_t,
+    double const* a_St,         // [a_n] Underlying Pxs (BSM) or Fwd Pxs
+    double*       a_sigma,      // [a_n]
+    IVStatus*     a_status,     // [a_n]
+    bool          a_warmStart = false
+  )
+  noexcept;
+}
+// End namespace BSM
@@ -0,0 +1,263 @@
+// vim:ts=2:et
+//===========================================================================//
+//                               "LocalVol.cpp":                             //
+//        Dupire Local Volatility Grid and Local-Vol Monte Carlo Pricing     //
+//===========================================================================//
+#include "LocalVol.h"
+#include "FastMath.hpp"
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+namespace BSM
+{
+  namespace
+  {
+    //-----------------------------------------------------------------------//
+    // "StepKernel": One Euler Step for a Batch of Paths:                    //
+    //-----------------------------------------------------------------------//
+    FASTMATH_SIMD_KERNEL
+    void StepKernel
+    (
+      size_t                   a_nP,
+      double const* __restrict a_row,   // [a_nX] Local variance at the step
+      size_t                   a_nX,
+      double                   a_xMin,
+      double                   a_rDX,
+      double                   a_dt,
+      double                   a_sign,
+      double const* __restrict a_z,     // [a_nP]
+      double const* __restrict a_x,     // [a_nP] In
+      double*       __restrict a_xNext  // [a_nP] Out
+    )
+    {
+      double fMax = double(a_nX - 1);
+      double jMax = double(a_nX - 2);
+#     pragma omp simd
+      for (size_t p = 0; p < a_nP; ++p)
+      {
+        double f  = std::clamp((a_x[p] - a_xMin) * a_rDX, 0.0, fMax);
+        double jf = std::min(std::floor(f), jMax);
+        long   j  = long(jf);
+        double u  = f - jf;
+        double v  = a_row[j] + u * (a_row[j + 1] - a_row[j]);
+        a_xNext[p] =
+          a_x[p] - 0.5 * v * a_dt + std::sqrt(v * a_dt) * a_sign * a_z[p];
+      }
+    }
+
+    //-----------------------------------------------------------------------//
+    // "PathsKernel": S_k = F_k * exp(x_k), Transposed to Path-Major:        //
+    //-----------------------------------------------------------------------//
+    FASTMATH_SIMD_KERNEL
+    void PathsKernel
+    (
+      size_t                   a_nP,
+      size_t                   a_nK,      // Number of points per path
+      double const* __restrict a_fwd,     // [a_nK]
+      double const* __restrict a_x,       // [a_nK][a_nP]
+      double*       __restrict a_paths    // [a_nP][a_nK]
+    )
+    {
+      for (size_t p = 0; p < a_nP; ++p)
+      {
+#       pragma omp simd
+        for (size_t k = 0; k < a_nK; ++k)
+          a_paths[p * a_nK + k] = a_fwd[k] * FastMath::Exp(a_x[k * a_nP + p]);
+      }
+    }
+  }
+
+  //=========================================================================//
+  // "LocalVolGrid" Non-Default Ctor:                                        //
+  //=========================================================================//
+  LocalVolGrid::LocalVolGrid
+  (
+    VolSurface const& a_surf,
+    double            a_T,
+    ThreadPool*       a_pool,
+    size_t            a_nT,
+    size_t            a_nX,
+    double            a_nSD
+  )
+  : m_r         (a_surf.Rate()),
+    m_D         (a_surf.DivRate()),
+    m_t         (a_surf.Time()),
+    m_St        (a_surf.Spot()),
+    m_nT        (a_nT),
+    m_nX        (a_nX),
+    m_dTau      (0.0),
+    m_xMin      (0.0),
+    m_dX        (0.0),
+    m_var       (),
+    m_nFallbacks(0)
+  {
+    double tauMax = a_T - m_t;
+    if (!(tauMax > 0.0))
+      throw std::invalid_argument
+            ("LocalVolGrid: Non-Positive Time to Expiration");
+    if (a_nT < 2 || a_nX < 2)
+      throw std::invalid_argument("LocalVolGrid: Too Few Nodes");
+
+    // The "x" range from the ATM implied vol at "a_T":
+    VolSurface::ExpiryView atT  = a_surf.At(a_T);
+    double                 sig  = atT.Sigma(std::exp(atT.m_logF));
+    double                 half =
+      std::max(a_nSD * sig * std::sqrt(tauMax), 0.05);
+
+    m_dTau = tauMax / double(a_nT - 1);
+    m_xMin = -half;
+    m_dX   = 2.0 * half / double(a_nX - 1);
+    m_var.resize(a_nT * a_nX);
+
+    //-----------------------------------------------------------------------//
+    // Dupire, row by row:                                                   //
+    //-----------------------------------------------------------------------//
+    std::vector<size_t> fallbacks(a_nT, 0);
+
+    auto buildRow =
+      [&](size_t a_i)
+      {
+        double tau = (a_i == 0) ? 1e-4 * m_dTau : double(a_i) * m_dTau;
+        VolSurface::ExpiryView view = a_surf.At(m_t + tau);
+        double*                row  = m_var.data() + a_i * m_nX;
+
+        for (size_t j = 0; j < m_nX; ++j)
+        {
+          double x = X(j);
+          double w, wx, wxx, wT;
+          view.TotalVarDerivs(x, &w, &wx, &wxx, &wT);
+
+          double den =
+            1.0 - x * wx / w +
+            0.25 * (-0.25 - 1.0 / w + x * x / (w * w)) * wx * wx +
+            0.5  * wxx;
+
+          if (w > 0.0 && wT > 0.0 && den > 0.0 && std::isfinite(den))
+            row[j] = wT / den;
+          else
+          {
+            row[j] = std::max(w / tau, 0.0);
+            ++fallbacks[a_i];
+          }
+        }
+      };
+
+    if (a_pool != nullptr)
+      a_pool->Run(a_nT, buildRow);
+    else
+      for (size_t i = 0; i < a_nT; ++i)
+        buildRow(i);
+
+    m_nFallbacks =
+      std::accumulate(fallbacks.begin(), fallbacks.end(), size_t(0));
+  }
+
+  //=========================================================================//
+  // "LocalVolGrid" Lookups:                                                 //
+  //=========================================================================//
+  double LocalVolGrid::LocalVar(double a_tau, double a_x) const
+  {
+    double fi = std::clamp(a_tau / m_dTau,          0.0, double(m_nT - 1));
+    double fj = std::clamp((a_x - m_xMin) / m_dX,   0.0, double(m_nX - 1));
+    size_t i  = std::min(size_t(fi), m_nT - 2);
+    size_t j  = std::min(size_t(fj), m_nX - 2);
+    double u  = fi - double(i);
+    double v  = fj - double(j);
+
+    double const* r0 = Row(i);
+    double const* r1 = r0 + m_nX;
+    return (1.0 - u) * ((1.0 - v) * r0[j] + v * r0[j + 1]) +
+                  u  * ((1.0 - v) * r1[j] + v * r1[j + 1]);
+  }
+
+  double LocalVolGrid::Sigma(double a_T, double a_S) const
+  {
+    double tau = a_T - m_t;
+    if (tau < 0.0)
+      throw std::invalid_argument("Negative Time to Expiration");
+    if (!(a_S > 0.0))
+      throw std::invalid_argument("Non-Positive UnderlyingPx / Vol");
+
+    double x = std::log(a_S / m_St) - (m_r - m_D) * tau;
+    return std::sqrt(LocalVar(tau, x));
+  }
+
+  //=========================================================================//
+  // "LocalVolPaths" Non-Default Ctor:                                       //
+  //=========================================================================//
+  LocalVolPaths::LocalVolPaths
+  (
+    LocalVolGrid const& a_grid,
+    double              a_T,
+    int                 a_nSteps
+  )
+  : m_nSteps(a_nSteps),
+    m_nX    (a_grid.NX()),
+    m_xMin  (a_grid.X(0)),
+    m_rDX   (1.0 / (a_grid.X(1) - a_grid.X(0))),
+    m_dt    (0.0),
+    m_St    (a_grid.Spot()),
+    m_rows  (),
+    m_fwd   ()
+  {
+    double tau    = a_T - a_grid.Time();
+    double tauMax = a_grid.Tau(a_grid.NT() - 1);
+    if (!(tau > 0.0))
+      throw std::invalid_argument
+            ("LocalVolPaths: Non-Positive Time to Expiration");
+    if (tau > tauMax * (1.0 + 1e-12))
+      throw std::invalid_argument("LocalVolPaths: Beyond the Grid");
+    if (a_nSteps <= 0)
+      throw std::invalid_argument("LocalVolPaths: Non-Positive NSteps");
+
+    size_t m = size_t(a_nSteps);
+    m_dt     = tau / double(a_nSteps);
+    m_rows.resize(m * m_nX);
+    m_fwd .resize(m + 1);
+
+    double dTau = a_grid.Tau(1);
+    double mu   = a_grid.Rate() - a_grid.DivRate();
+    for (size_t k = 0; k <= m; ++k)
+      m_fwd[k] = m_St * std::exp(mu * double(k) * m_dt);
+
+    // The rows at the step times, linearly interpolated in "tau":
+    for (size_t k = 0; k < m; ++k)
+    {
+      double fi = std::min(double(k) * m_dt / dTau, double(a_grid.NT() - 1));
+      size_t i  = std::min(size_t(fi), a_grid.NT() - 2);
+      double u  = fi - double(i);
+
+      double const* r0  = a_grid.Row(i);
+      double const* r1  = a_grid.Row(i + 1);
+      double*       row = m_rows.data() + k * m_nX;
+      for (size_t j = 0; j < m_nX; ++j)
+        row[j] = (1.0 - u) * r0[j] + u * r1[j];
+    }
+  }
+
+  //=========================================================================//
+  // "LocalVolPaths::Build":                                                 //
+  //=========================================================================//
+  void LocalVolPaths::Build
+  (
+    size_t        a_nP,
+    double        a_sign,
+    double const* a_z,
+    double*       a_x,
+    double*       a_paths
+  )
+  const
+  {
+    size_t m = size_t(m_nSteps);
+    std::fill_n(a_x, a_nP, 0.0);
+
+    for (size_t k = 0; k < m; ++k)
+      StepKernel
+        (a_nP, m_rows.data() + k * m_nX, m_nX, m_xMin, m_rDX, m_dt, a_sign,
+         a_z + k * a_nP, a_x + k * a_nP, a_x + (k + 1) * a_nP);
+
+    PathsKernel(a_nP, m + 1, m_fwd.data(), a_x, a_paths);
+  }
+}
+// End namespace BSM
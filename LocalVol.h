@@ -0,0 +1,159 @@
+// vim:ts=2:et
+//===========================================================================//
+//                                "LocalVol.h":                              //
+//        Dupire Local Volatility Grid and Local-Vol Monte Carlo Pricing     //
+//===========================================================================//
+#pragma once
+#include "BSM.h"
+#include "MonteCarlo.h"
+#include "ThreadPool.h"
+#include "VolSurface.h"
+#include <cstddef>
+#include <vector>
+
+namespace BSM
+{
+  //=========================================================================//
+  // "LocalVolGrid" Class:                                                   //
+  //=========================================================================//
+  // The local variance sigma_loc^2(tau, x) on a uniform grid in tau = T - t
+  // (from 0 to tau_max) and in the log-fwd-moneyness x = log(S / F(tau)),
+  // obtained from a "VolSurface" by Dupire's formula in total variance:
+  //   sigma_loc^2 = w_T / (1 - x w_x / w + (-1/4 - 1/w + x^2 / w^2) w_x^2 / 4
+  //                        + w_xx / 2),
+  // with the analytic SVI derivatives in "x" (w_T is exact too,  as the total
+  // variance is piecewise-linear in tau). Nodes where the surface has arbit-
+  // rage (a non-positive numerator or denominator) get the implied variance
+  // instead,  and are counted in "NFallbacks()". The 1st row is the tau -> 0
+  // limit (evaluated at a tiny "tau").
+  // The grid is stored row-major, [NT][NX] (a row per time), so the lookups
+  // by the MC paths at the same time touch one or two contiguous rows; the
+  // lookup is bilinear, with flat extrapolation beyond the grid. The rows
+  // are the parallel tasks of the construction (if a "ThreadPool" is given).
+  // The market data (r, D, t, St) are those of the surface. The obj is im-
+  // mutable after construction, so it may be shared by many threads:
+  //
+  class LocalVolGrid
+  {
+  private:
+    //-----------------------------------------------------------------------//
+    // Data Flds:                                                            //
+    //-----------------------------------------------------------------------//
+    double              m_r;
+    double              m_D;
+    double              m_t;
+    double              m_St;
+    size_t              m_nT;
+    size_t              m_nX;
+    double              m_dTau;
+    double              m_xMin;
+    double              m_dX;
+    std::vector<double> m_var;        // [m_nT][m_nX] Local variance
+    size_t              m_nFallbacks;
+
+  public:
+    //-----------------------------------------------------------------------//
+    // Non-Default Ctor:                                                     //
+    //-----------------------------------------------------------------------//
+    // The "x" range is -+ a_nSD * (ATM implied vol at a_T) * sqrt(tau_max).
+    // Throws "std::invalid_argument" if "a_T" is not after the surface time,
+    // or NT, NX < 2:
+    //
+    LocalVolGrid
+    (
+      VolSurface const& a_surf,
+      double            a_T,              // Max Expiration Time
+      ThreadPool*       a_pool = nullptr, // NULL: single-threaded
+      size_t            a_nT   = 101,
+      size_t            a_nX   = 201,
+      double            a_nSD  = 5.0
+    );
+
+    //-----------------------------------------------------------------------//
+    // Lookups:                                                              //
+    //-----------------------------------------------------------------------//
+    double LocalVar(double a_tau, double a_x) const;
+
+    // sigma_loc at time "a_T" and Underlying Px "a_S":
+    double Sigma(double a_T, double a_S) const;
+
+    //-----------------------------------------------------------------------//
+    // Accessors:                                                            //
+    //-----------------------------------------------------------------------//
+    size_t        NT()            const { return m_nT;                    }
+    size_t        NX()            const { return m_nX;                    }
+    double        Tau(size_t a_i) const { return double(a_i) * m_dTau;    }
+    double        X  (size_t a_j) const { return m_xMin + double(a_j) * m_dX; }
+    double const* Row(size_t a_i) const { return m_var.data() + a_i * m_nX; }
+    size_t        NFallbacks()    const { return m_nFallbacks;            }
+
+    double        Rate()          const { return m_r;                     }
+    double        DivRate()       const { return m_D;                     }
+    double        Time()          const { return m_t;                     }
+    double        Spot()          const { return m_St;                    }
+  };
+
+  //=========================================================================//
+  // "LocalVolPaths": Euler Scheme on a Fixed Time Grid:                     //
+  //=========================================================================//
+  // For "a_nSteps" equal steps from the grid time to "a_T", the rows of the
+  // local variance at the step times (interpolated between the grid rows)
+  // and the fwds are pre-computed, so a step costs 1 linear interpolation in
+  // "x". The log-fwd-moneyness is driftless apart from the Ito term:
+  //   x_{k+1} = x_k - v_k dt / 2 + sqrt(v_k dt) z_k,  S_k = F(tau_k) e^{x_k},
+  // where v_k = sigma_loc^2(tau_k, x_k).  "Build" advances a batch of paths
+  // together (the loop over the paths is vectorised). Immutable once built:
+  //
+  class LocalVolPaths
+  {
+  private:
+    int                 m_nSteps;
+    size_t              m_nX;
+    double              m_xMin;
+    double              m_rDX;      // 1 / dX
+    double              m_dt;
+    double              m_St;
+    std::vector<double> m_rows;     // [m_nSteps][m_nX]
+    std::vector<double> m_fwd;      // [m_nSteps + 1]
+
+  public:
+    LocalVolPaths(LocalVolGrid const& a_grid, double a_T, int a_nSteps);
+
+    int NSteps() const { return m_nSteps; }
+
+    // "a_z" are the Normals, step-major: a_z[k * a_nP + p]; "a_x" is a work
+    // buffer of [(a_nSteps + 1) * a_nP]. "a_paths" receives the paths, one
+    // after another: a_paths[p * (a_nSteps + 1) + k] (so a_paths[0] == St):
+    //
+    void Build
+    (
+      size_t        a_nP,
+      double        a_sign,   // +1, or -1 for the antithetic paths
+      double const* a_z,
+      double*       a_x,
+      double*       a_paths
+    )
+    const;
+  };
+
+  //=========================================================================//
+  // "PxMCLocalVol": Monte Carlo Px of an Arbitrary Payoff under Local Vol:  //
+  //=========================================================================//
+  // As "PxMC",  but the paths follow the local-vol dynamics of "a_grid" (by
+  // "LocalVolPaths" with "m_nSteps" steps; the Euler bias is O(dt), so more
+  // steps are needed than for exotics under GBM). "a_payoff" gets the same
+  // args as in "PxMC". The Philox or Sobol (with the Brownian Bridge) Nor-
+  // mals and the Antithetic Variates are supported,  and the result is bit-
+  // identical for any "m_nThreads"; the Control Variate and the Adaptive mode
+  // are not (they throw "std::invalid_argument"). Defined in "LocalVol.hpp":
+  //
+  template<typename Payoff>
+  MCRes PxMCLocalVol
+  (
+    Payoff const&       a_payoff,
+    LocalVolGrid const& a_grid,
+    double              a_T,        // Expiration Time (<= that of the grid)
+    MCParams const&     a_params = MCParams()
+  );
+}
+// End namespace BSM
@@ -0,0 +1,128 @@
+// vim:ts=2:et
+//===========================================================================//
+//                               "LocalVol.hpp":                             //
+//           Implementation of the Templated Local-Vol Monte Carlo Pricer    //
+//===========================================================================//
+#pragma once
+
+#include "LocalVol.h"
+#include "MonteCarlo.hpp"
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <vector>
+
+namespace BSM
+{
+  //-------------------------------------------------------------------------//
+  // Number of Samples Simulated Together (within a Block):                  //
+  //-------------------------------------------------------------------------//
+  constexpr long LVBatchSize = 64;
+
+  //=========================================================================//
+  // "PxMCLocalVol":                                                         //
+  //=========================================================================//
+  template<typename Payoff>
+  MCRes PxMCLocalVol
+  (
+    Payoff const&       a_payoff,
+    LocalVolGrid const& a_grid,
+    double              a_T,
+    MCParams const&     a_params
+  )
+  {
+    //-----------------------------------------------------------------------//
+    // Check the args:                                                       //
+    //-----------------------------------------------------------------------//
+    if (a_params.m_nPaths <= 0 || a_params.m_nSteps <= 0)
+      throw std::invalid_argument("PxMC: Non-Positive NPaths / NSteps");
+
+    if (a_params.m_ctrlVar || a_params.m_tolCI > 0.0 ||
+        a_params.m_maxTime > 0.0)
+      throw std::invalid_argument("PxMCLocalVol: Unsupported MCParams");
+
+    // (Also checks "a_T" against the grid):
+    LocalVolPaths paths(a_grid, a_T, a_params.m_nSteps);
+
+    //-----------------------------------------------------------------------//
+    // Set-up (as in "PxMC"):                                                //
+    //-----------------------------------------------------------------------//
+    int    nSteps   = a_params.m_nSteps;
+    double df       = exp(-a_grid.Rate() * (a_T - a_grid.Time()));
+    bool   anti     = a_params.m_antithetic;
+
+    MCNormals normals(a_params);
+    long      nSamples = normals.NSamples();
+
+    size_t nBlocks = size_t((nSamples + MCBlockSize - 1) / MCBlockSize);
+    std::vector<MCStats> blockStats(nBlocks);
+
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point start = Clock::now();
+
+    //-----------------------------------------------------------------------//
+    // Block Simulation:                                                     //
+    //-----------------------------------------------------------------------//
+    // Within a block, the samples are simulated in batches of "LVBatchSize"
+    // (the Normals being transposed to step-major for "LocalVolPaths"), and
+    // added to the stats in the sample order:
+    //
+    auto simBlock =
+      [&](size_t a_b)
+      {
+        size_t m = size_t(nSteps);
+        size_t B = size_t(LVBatchSize);
+        std::vector<double> z    (m);
+        std::vector<double> zT   (m * B);
+        std::vector<double> x    ((m + 1) * B);
+        std::vector<double> pBuff((m + 1) * B);
+        std::vector<double> ys   (B);
+        MCStats& stats = blockStats[a_b];
+
+        long from = long(a_b) * MCBlockSize;
+        long to   = std::min(from + MCBlockSize, nSamples);
+        MCNormals::Cursor cursor(normals, from);
+
+        for (long s0 = from; s0 < to; s0 += LVBatchSize)
+        {
+          size_t nP = size_t(std::min(LVBatchSize, to - s0));
+
+          for (size_t p = 0; p < nP; ++p)
+          {
+            cursor.Get(s0 + long(p), z.data());
+            for (size_t k = 0; k < m; ++k)
+              zT[k * nP + p] = z[k];
+          }
+
+          std::fill_n(ys.begin(), nP, 0.0);
+          for (int a = 0; a < (anti ? 2 : 1); ++a)
+          {
+            paths.Build
+              (nP, (a == 0) ? 1.0 : -1.0, zT.data(), x.data(), pBuff.data());
+            for (size_t p = 0; p < nP; ++p)
+              ys[p] += a_payoff(pBuff.data() + p * (m + 1), nSteps);
+          }
+          for (size_t p = 0; p < nP; ++p)
+            stats.Add(anti ? 0.5 * ys[p] : ys[p], 0.0);
+        }
+      };
+
+    RunParallel(nBlocks, a_params.m_nThreads, simBlock);
+
+    //-----------------------------------------------------------------------//
+    // Merge the blocks (in the block order):                                //
+    //-----------------------------------------------------------------------//
+    MCStats total;
+    for (size_t b = 0; b < nBlocks; ++b)
+      total.Merge(blockStats[b]);
+
+    MCRes res;
+    MCEstimate(total, false, 0.0, df, &res);
+
+    long nDone   = long(total.m_n);
+    res.m_nPaths = anti ? 2 * nDone : nDone;
+    res.m_time   = std::chrono::duration<double>(Clock::now() - start).count();
+    return res;
+  }
+}
+// End namespace BSM
@@ -0,0 +1,123 @@
+// vim:ts=2:et
+//===========================================================================//
+//                              "MonteCarlo.cpp":                            //
+//          Non-Template Parts of the Monte Carlo Engine: Implementation     //
+//===========================================================================//
+#include "MonteCarlo.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace BSM
+{
+  //-------------------------------------------------------------------------//
+  // "MCStats::Merge":                                                       //
+  //-------------------------------------------------------------------------//
+  void MCStats::Merge(MCStats const& a_right)
+  {
+    if (a_right.m_n == 0.0)
+      return;
+    if (m_n == 0.0)
+    {
+      *this = a_right;
+      return;
+    }
+    double n  = m_n + a_right.m_n;
+    double dY = a_right.m_mY - m_mY;
+    double dC = a_right.m_mC - m_mC;
+    double w  = m_n * a_right.m_n / n;
+
+    m_mY  += dY * a_right.m_n / n;
+    m_mC  += dC * a_right.m_n / n;
+    m_sYY += a_right.m_sYY + dY * dY * w;
+    m_sCC += a_right.m_sCC + dC * dC * w;
+    m_sYC += a_right.m_sYC + dY * dC * w;
+    m_n    = n;
+  }
+
+  //-------------------------------------------------------------------------//
+  // "MCEstimate":                                                           //
+  //-------------------------------------------------------------------------//
+  void MCEstimate
+  (
+    MCStats const& a_stats,
+    bool           a_ctrlVar,
+    double         a_cvMean,
+    double         a_df,
+    MCRes*         a_res
+  )
+  {
+    double mean = a_stats.m_mY;
+    double sYY  = a_stats.m_sYY;
+
+    if (a_ctrlVar && a_stats.m_sCC > 0.0)
+    {
+      // Optimal coefficient; the residual variance is Var(Y) * (1 - Corr^2):
+      double beta     = a_stats.m_sYC / a_stats.m_sCC;
+      mean           -= beta * (a_stats.m_mC - a_cvMean);
+      sYY            -= beta * a_stats.m_sYC;
+      a_res->m_cvBeta = beta;
+    }
+    double n        = a_stats.m_n;
+    a_res->m_px     = a_df * mean;
+    a_res->m_stdErr =
+      (n > 1.0) ? a_df * sqrt(std::max(sYY, 0.0) / (n * (n - 1.0))) : NAN;
+  }
+
+  //-------------------------------------------------------------------------//
+  // "RunParallel":                                                          //
+  //-------------------------------------------------------------------------//
+  void RunParallel
+  (
+    size_t                             a_nTasks,
+    int                                a_nThreads,
+    std::function<void(size_t)> const& a_task
+  )
+  {
+    size_t nThreads =
+      (a_nThreads > 0)
+      ? size_t(a_nThreads)
+      : std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    nThreads = std::min(nThreads, a_nTasks);
+
+    // The next task to be taken (by any thread):
+    std::atomic<size_t> next  {0};
+    std::exception_ptr  error;
+    std::mutex          errorMtx;
+
+    auto worker =
+      [&]()
+      {
+        try
+        {
+          for (size_t i = next++; i < a_nTasks; i = next++)
+            a_task(i);
+        }
+        catch (...)
+        {
+          // Memoise the 1st exception, and make other threads stop:
+          std::lock_guard<std::mutex> lock(errorMtx);
+          if (!error)
+            error = std::current_exception();
+          next = a_nTasks;
+        }
+      };
+
+    // The calling thread is one of the workers:
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < nThreads; ++i)
+      threads.emplace_back(worker);
+    worker();
+
+    for (std::thread& th: threads)
+      th.join();
+
+    if (error)
+      std::rethrow_exception(error);
+  }
+}
+// End namespace BSM
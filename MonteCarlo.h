@@ -0,0 +1,186 @@
+// vim:ts=2:et
+//===========================================================================//
+//                               "MonteCarlo.h":                             //
+//        Multi-Threaded Monte Carlo Pricing of Arbitrary BSM Payoffs        //
+//===========================================================================//
+#pragma once
+#include "BSM.h"
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace BSM
+{
+  //-------------------------------------------------------------------------//
+  // "MCParams": Monte Carlo Configuration:                                  //
+  //-------------------------------------------------------------------------//
+  // In the Adaptive mode ("m_tolCI" and/or "m_maxTime" are positive), the
+  // simulation proceeds in rounds of blocks of paths; after each round, the
+  // running estimate is updated, and the simulation stops as soon as the
+  // Confidence Interval half-width  (m_confZ * StdErr)  is within "m_tolCI",
+  // or the wall-clock time exceeds "m_maxTime" (checked before each block),
+  // or "m_nPaths" paths are done.
+  // With "m_antithetic", the paths are simulated in pairs, so an odd "m_n-
+  // Paths" is rounded UP to the next even number (eg 1 gives 1 pair of 2
+  // paths); "MCRes::m_nPaths" is the number actually simulated. The same
+  // holds for "PxGreeksMC" and "PxMCLocalVol":
+  //
+  struct MCParams
+  {
+    long       m_nPaths     = 1'000'000;  // Total (max) number of paths
+                                          //   (rounded up to even if anti)
+    int        m_nSteps     = 1;          // Time steps per path
+    uint64_t   m_seed       = 0;          // The Philox Key
+    int        m_nThreads   = 0;          // 0: all hardware threads
+    // Adaptive Stopping:
+    double     m_tolCI      = 0.0;        // Target CI half-width, in Px units
+    double     m_confZ      = 1.96;       // CI Normal quantile (1.96: 95%)
+    double     m_maxTime    = 0.0;        // Wall-clock budget, sec
+    // Quasi-Monte Carlo (see "QMC.h"):
+    bool       m_sobol      = false;      // Sobol sequence rather than Philox
+    bool       m_scramble   = true;       // Owen scrambling (seed: "m_seed")
+    bool       m_bridge     = true;       // Brownian Bridge path construction
+    // Variance Reduction:
+    bool       m_antithetic = false;      // Use paths in pairs (Z, -Z)
+    bool       m_ctrlVar    = false;      // Use a BSM closed-form Control Var
+    PayoffType m_cvType     = PayoffType::Call;  // Call or Put
+    double     m_cvK        = NAN;        // Strike of the Control Variate;
+                                          //   NaN: the ATM Fwd
+  };
+
+  //-------------------------------------------------------------------------//
+  // "MCRes": Monte Carlo Result:                                            //
+  //-------------------------------------------------------------------------//
+  // Why the simulation has stopped:
+  enum class MCStop: int
+  {
+    NPaths    = 0,  // All "m_nPaths" paths done
+    Tolerance = 1,  // The CI half-width has reached "m_tolCI"
+    Time      = 2   // The wall-clock budget has been exhausted
+  };
+
+  struct MCRes
+  {
+    double m_px     = NAN;  // Estimated Option Px
+    double m_stdErr = NAN;  // Standard Error of "m_px"
+    long   m_nPaths = 0;    // Number of paths actually simulated
+    double m_cvBeta = NAN;  // Control Variate coefficient (if used)
+    double m_time   = 0.0;  // Wall-clock time spent, sec
+    MCStop m_stop   = MCStop::NPaths;
+  };
+
+  //-------------------------------------------------------------------------//
+  // "MCStats": Running Moments of the Payoff and the Control Variate:       //
+  //-------------------------------------------------------------------------//
+  // "Add" is Welford's update; "Merge" is the pairwise (Chan et al) combina-
+  // tion, so partial results from different threads can be combined without
+  // the cancellation of the naive sum-of-squares formulas:
+  //
+  struct alignas(64) MCStats    // Aligned to avoid False Sharing
+  {
+    double m_n   = 0.0;   // Number of samples
+    double m_mY  = 0.0;   // Mean of the Payoff
+    double m_mC  = 0.0;   // Mean of the Control Variate
+    double m_sYY = 0.0;   // Sums of the products of deviations from the means
+    double m_sCC = 0.0;
+    double m_sYC = 0.0;
+
+    void Add(double a_y, double a_c)
+    {
+      m_n       += 1.0;
+      double dY  = a_y - m_mY;
+      double dC  = a_c - m_mC;
+      m_mY      += dY / m_n;
+      m_mC      += dC / m_n;
+      m_sYY     += dY * (a_y - m_mY);
+      m_sCC     += dC * (a_c - m_mC);
+      m_sYC     += dY * (a_c - m_mC);
+    }
+
+    void Merge(MCStats const& a_right);
+  };
+
+  //-------------------------------------------------------------------------//
+  // "MCEstimate":                                                           //
+  //-------------------------------------------------------------------------//
+  // Fills in "m_px", "m_stdErr" and "m_cvBeta" of "a_res" from the merged
+  // (undiscounted) sample moments; "a_cvMean" is the exact mean of the Con-
+  // trol Variate (used only if "a_ctrlVar" is set), "a_df" is the Discount
+  // Factor to "a_T":
+  //
+  void MCEstimate
+  (
+    MCStats const& a_stats,
+    bool           a_ctrlVar,
+    double         a_cvMean,
+    double         a_df,
+    MCRes*         a_res
+  );
+
+  //-------------------------------------------------------------------------//
+  // "PxMC": Monte Carlo Px of an Arbitrary Payoff:                          //
+  //-------------------------------------------------------------------------//
+  // For "PayoffType::Arbitrary": the Underlying follows the BSM (Geometric
+  // Brownian Motion) dynamics,  and "a_payoff" is a user-supplied functor
+  // invoked on each path, as
+  //   double a_payoff(double const* a_path, int a_nSteps),
+  // where "a_path[0 .. a_nSteps]" are the Underlying Pxs at the times
+  // a_t + k * (a_T - a_t) / a_nSteps (so a_path[0] == a_St);  it returns the
+  // (undiscounted) amount paid at "a_T". It is invoked concurrently from
+  // multiple threads, so it must be thread-safe.
+  // The paths are split into fixed-size blocks which are distributed among
+  // the threads dynamically,  and the block results are combined in the block
+  // order, so  (together with the counter-based RNG)  the result is bit-
+  // identical for any "m_nThreads".
+  // If "m_ctrlVar" is set,  the European Call or Put with the Strike "m_cvK"
+  // (on the same paths) is used as a Control Variate,  with the optimal co-
+  // efficient estimated from the same paths.
+  // If "m_sobol" is set, the normals come from a Sobol sequence of dimension
+  // "m_nSteps" instead (sample No "i" being the Sobol point No "i"),  with the
+  // Brownian Bridge (by default) assigning the first (best-distributed) dims
+  // to the coarse structure of the path;  at most 2^32 - 1 samples are then
+  // allowed. NB: "m_stdErr" is still computed as if the samples were indep-
+  // endent, which over-states the actual error;  the spread of the results
+  // over several "m_seed"s (ie different scramblings) is a proper error
+  // estimate.
+  // In the Adaptive mode (see "MCParams"), the stopping decisions are made on
+  // the merged results of whole rounds,  so they do not depend on the number
+  // of threads either (unless the time budget is hit).
+  // Exceptions: "std::invalid_argument" for invalid args; any exception from
+  // "a_payoff" is propagated to the caller.
+  // Being a template, it is defined in "MonteCarlo.hpp":
+  //
+  template<typename Payoff>
+  MCRes PxMC
+  (
+    Payoff const&   a_payoff,
+    // Option Spec (other than the Payoff):
+    double          a_T,      // Opton Expiration Time, as Year Fraction
+    // Market Data:
+    double          a_r,      // Risk-Free Interest Rate
+    double          a_D,      // Dividend Rate
+    double          a_sigma,  // Volatility
+    // "Quick" variables:
+    double          a_t,      // Pricing Time (as Year Fraction)
+    double          a_St,     // Underlying Px at Time "a_t"
+    // Monte Carlo Params:
+    MCParams const& a_params = MCParams()
+  );
+
+  //-------------------------------------------------------------------------//
+  // "RunParallel":                                                          //
+  //-------------------------------------------------------------------------//
+  // Invokes "a_task(i)" for all i in [0 .. a_nTasks-1], distributing them dy-
+  // namically among "a_nThreads" threads (0: all hardware threads; the call-
+  // ing thread is one of them). Returns when all tasks are done; the first
+  // exception thrown by any task is re-thrown:
+  //
+  void RunParallel
+  (
+    size_t                             a_nTasks,
+    int                                a_nThreads,
+    std::function<void(size_t)> const& a_task
+  );
+}
+// End namespace BSM
@@ -0,0 +1,344 @@
+// vim:ts=2:et
+//===========================================================================//
+//                              "MonteCarlo.hpp":                            //
+//              Implementation of the Templated Monte Carlo Pricer           //
+//===========================================================================//
+#pragma once
+
+#include "MonteCarlo.h"
+#include "Philox.hpp"
+#include "QMC.h"
+#include "FastMath.hpp"
+#include <algorithm>
+#include <chrono>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+namespace BSM
+{
+  //-------------------------------------------------------------------------//
+  // Number of Samples per Block:                                            //
+  //-------------------------------------------------------------------------//
+  // The unit of work distribution among the threads. It must NOT depend on
+  // the number of threads, otherwise the results would:
+  //
+  constexpr long MCBlockSize = 1024;
+
+  // The min number of blocks per round in the Adaptive mode:
+  constexpr size_t MCMinRound = 16;
+
+  //-------------------------------------------------------------------------//
+  // "MCBuildPath": GBM Path from Normal Variates:                           //
+  //-------------------------------------------------------------------------//
+  // a_path[k] = a_St * exp(sum_{j<k} (a_drift + a_volDt * a_sign * a_z[j])),
+  // for k = 0 .. a_nSteps. "a_x" is a work buffer of size (a_nSteps + 1).
+  // The increments and the "Exp"s are vectorised; only the prefix sum is a
+  // sequential loop:
+  //
+  inline void MCBuildPath
+  (
+    double        a_St,
+    double        a_drift,
+    double        a_volDt,
+    double        a_sign,   // +1, or -1 for the antithetic path
+    int           a_nSteps,
+    double const* a_z,
+    double*       a_x,
+    double*       a_path
+  )
+  {
+    a_x[0] = 0.0;
+#   pragma omp simd
+    for (int k = 0; k < a_nSteps; ++k)
+      a_x[k+1] = a_drift + a_volDt * a_sign * a_z[k];
+
+    for (int k = 1; k <= a_nSteps; ++k)
+      a_x[k] += a_x[k-1];
+
+#   pragma omp simd
+    for (int k = 0; k <= a_nSteps; ++k)
+      a_path[k] = a_St * FastMath::Exp(a_x[k]);
+  }
+
+  //=========================================================================//
+  // "MCNormals": The Normal Variates of the Monte Carlo Samples:            //
+  //=========================================================================//
+  // Shared by "PxMC", "PxGreeksMC" and "PxMCLocalVol". Sample No "s" gets
+  // "m_nSteps" N(0,1) variates which depend on "s" only (not on the thread or
+  // the block): from Philox keyed by ("m_seed", s), or from the Sobol point
+  // No "s" (through the Brownian Bridge if enabled). With Antithetic Vari-
+  // ates, a sample is a pair of paths, so there are (m_nPaths+1)/2 samples.
+  // The obj is immutable after construction, so it is shared by the threads;
+  // each block reads its samples (in order) through its own "Cursor":
+  //
+  class MCNormals
+  {
+  private:
+    //-----------------------------------------------------------------------//
+    // Data Flds:                                                            //
+    //-----------------------------------------------------------------------//
+    int                                m_nSteps;
+    uint64_t                           m_seed;
+    long                               m_nSamples;
+    std::optional<RNG::Sobol>          m_sobol;
+    std::optional<RNG::BrownianBridge> m_bridge;
+
+  public:
+    //-----------------------------------------------------------------------//
+    // Non-Default Ctor:                                                     //
+    //-----------------------------------------------------------------------//
+    // "a_params" must have positive "m_nPaths" and "m_nSteps".  With Sobol,
+    // the generator is advanced past each sample, so the last usable point is
+    // No 2^Bits - 2 (advancing past 2^Bits - 1 needs the direction numbers of
+    // bit "Bits", which do not exist): more samples throw "std::invalid_arg-
+    // ument":
+    //
+    explicit MCNormals(MCParams const& a_params)
+    : m_nSteps  (a_params.m_nSteps),
+      m_seed    (a_params.m_seed),
+      m_nSamples(a_params.m_antithetic ? (a_params.m_nPaths + 1) / 2
+                                       : a_params.m_nPaths)
+    {
+      if (a_params.m_sobol)
+      {
+        if (m_nSamples >= (long(1) << RNG::Sobol::Bits))
+          throw std::invalid_argument("PxMC: Too Many Paths for Sobol");
+        m_sobol.emplace(m_nSteps, a_params.m_seed, a_params.m_scramble);
+        if (a_params.m_bridge && m_nSteps > 1)
+          m_bridge.emplace(m_nSteps);
+      }
+    }
+
+    long NSamples() const { return m_nSamples; }
+
+    //=======================================================================//
+    // "Cursor": Generates Consecutive Samples (one per Block):              //
+    //=======================================================================//
+    class Cursor
+    {
+    private:
+      MCNormals const&      m_normals;
+      std::vector<uint32_t> m_q;    // The current Sobol point
+      std::vector<double>   m_zq;   // The Bridge input
+      std::vector<double>   m_w;    // The Bridge work buffer
+
+    public:
+      // Positioned at sample No "a_from":
+      Cursor(MCNormals const& a_normals, long a_from)
+      : m_normals(a_normals),
+        m_q      (a_normals.m_sobol  ? size_t(a_normals.m_nSteps)     : 0),
+        m_zq     (a_normals.m_bridge ? size_t(a_normals.m_nSteps)     : 0),
+        m_w      (a_normals.m_bridge ? size_t(a_normals.m_nSteps) + 1 : 0)
+      {
+        if (m_normals.m_sobol)
+          m_normals.m_sobol->Seek(uint64_t(a_from), m_q.data());
+      }
+
+      // The Normals of sample No "a_s" into "a_z" [NSteps]; the samples must
+      // be consecutive, starting from "a_from":
+      void Get(long a_s, double* a_z)
+      {
+        MCNormals const& n = m_normals;
+        if (n.m_sobol)
+        {
+          if (n.m_bridge)
+          {
+            n.m_sobol ->Normals(m_q.data(),  m_zq.data());
+            n.m_bridge->Build  (m_zq.data(), m_w.data(), a_z);
+          }
+          else
+            n.m_sobol ->Normals(m_q.data(),  a_z);
+          n.m_sobol->Next(uint64_t(a_s), m_q.data());
+        }
+        else
+          RNG::PhiloxNormals(n.m_seed, uint64_t(a_s), n.m_nSteps, a_z);
+      }
+    };
+  };
+
+  //=========================================================================//
+  // "PxMC":                                                                 //
+  //=========================================================================//
+  template<typename Payoff>
+  MCRes PxMC
+  (
+    Payoff const&   a_payoff,
+    double          a_T,
+    double          a_r,
+    double          a_D,
+    double          a_sigma,
+    double          a_t,
+    double          a_St,
+    MCParams const& a_params
+  )
+  {
+    //-----------------------------------------------------------------------//
+    // Check the args:                                                       //
+    //-----------------------------------------------------------------------//
+    double tau = a_T - a_t;
+
+    if (tau <  0.0)
+      throw std::invalid_argument("Negative Time to Expiration");
+
+    if (a_St <= 0.0 || a_sigma <= 0.0)
+      throw std::invalid_argument("Non-Positive UnderlyingPx / Vol");
+
+    if (a_params.m_nPaths <= 0 || a_params.m_nSteps <= 0)
+      throw std::invalid_argument("PxMC: Non-Positive NPaths / NSteps");
+
+    bool   cv  = a_params.m_ctrlVar;
+    double cvW = 0.0;   // +1 for Call, -1 for Put
+    if (cv)
+      switch (a_params.m_cvType)
+      {
+        case PayoffType::Call: cvW =  1.0; break;
+        case PayoffType::Put:  cvW = -1.0; break;
+        default:
+          throw std::invalid_argument
+                ("PxMC: Control Variate must be a Call or a Put");
+      }
+
+    //-----------------------------------------------------------------------//
+    // Set-up:                                                               //
+    //-----------------------------------------------------------------------//
+    int    nSteps = a_params.m_nSteps;
+    double dt     = tau / nSteps;
+    double drift  = (a_r - a_D - 0.5 * a_sigma * a_sigma) * dt;
+    double volDt  = a_sigma * sqrt(dt);
+    bool   anti   = a_params.m_antithetic;
+    double df     = exp(-a_r * tau);
+
+    // The Control Variate: its Strike, and its exact (undiscounted) mean:
+    double cvK    =
+      std::isnan(a_params.m_cvK) ? a_St * exp((a_r - a_D) * tau)
+                                 : a_params.m_cvK;
+    double cvMean =
+      cv ? Px(a_params.m_cvType, cvK, a_T, a_r, a_D, a_sigma, a_t, a_St) / df
+         : 0.0;
+
+    // The Normals (and the Sobol / Brownian Bridge set-up, shared by the
+    // threads). With Antithetic Variates, a sample is the average over a pair
+    // of paths (so an odd "m_nPaths" is rounded up, as documented in "MC-
+    // Params"):
+    MCNormals normals(a_params);
+    long      nSamples = normals.NSamples();
+
+    size_t nBlocks  = size_t((nSamples + MCBlockSize - 1) / MCBlockSize);
+    std::vector<MCStats> blockStats(nBlocks);
+
+    //-----------------------------------------------------------------------//
+    // Block Simulation:                                                     //
+    //-----------------------------------------------------------------------//
+    using Clock  = std::chrono::steady_clock;
+    bool useTime = (a_params.m_maxTime > 0.0);
+    bool useTol  = (a_params.m_tolCI   > 0.0);
+    Clock::time_point start    = Clock::now();
+    Clock::time_point deadline =
+      start + std::chrono::duration_cast<Clock::duration>
+              (std::chrono::duration<double>(a_params.m_maxTime));
+
+    auto simBlock =
+      [&](size_t a_b)
+      {
+        // In the Adaptive mode, do not start new blocks after the deadline
+        // (the skipped ones remain empty, and are ignored when merged):
+        if (useTime && Clock::now() >= deadline)
+          return;
+
+        size_t m = size_t(nSteps);
+        std::vector<double> z   (m);
+        std::vector<double> x   (m + 1);
+        std::vector<double> path(m + 1);
+        MCStats& stats = blockStats[a_b];
+
+        long from = long(a_b) * MCBlockSize;
+        long to   = std::min(from + MCBlockSize, nSamples);
+        MCNormals::Cursor cursor(normals, from);
+
+        for (long s = from; s < to; ++s)
+        {
+          // The Normals depend on the sample number only:
+          cursor.Get(s, z.data());
+
+          double y = 0.0;
+          double c = 0.0;
+          for (int a = 0; a < (anti ? 2 : 1); ++a)
+          {
+            MCBuildPath(a_St, drift, volDt, (a == 0) ? 1.0 : -1.0, nSteps,
+                        z.data(), x.data(), path.data());
+            y += a_payoff(path.data(), nSteps);
+            if (cv)
+              c += std::max(cvW * (path[m] - cvK), 0.0);
+          }
+          if (anti)
+          {
+            y *= 0.5;
+            c *= 0.5;
+          }
+          stats.Add(y, c);
+        }
+      };
+
+    //-----------------------------------------------------------------------//
+    // Run the Blocks in Rounds (in parallel within each round):             //
+    //-----------------------------------------------------------------------//
+    // In the non-Adaptive mode, there is just 1 round of all blocks. Other-
+    // wise, the round size is predicted from the current StdErr (but at most
+    // doubling the number of blocks done). The block results are merged in
+    // the block order:
+    //
+    MCStats total;
+    MCRes   res;
+    size_t  done = 0;    // Blocks done
+    res.m_stop   = MCStop::NPaths;
+
+    while (done < nBlocks)
+    {
+      size_t round = nBlocks - done;
+      if (useTol || useTime)
+      {
+        size_t maxRound = std::max(done, MCMinRound);
+        if (useTol && res.m_stdErr > 0.0)
+        {
+          // StdErr ~ 1/sqrt(n), so the total number of samples needed is:
+          double ratio  = a_params.m_confZ * res.m_stdErr / a_params.m_tolCI;
+          double needed = total.m_n * ratio * ratio;
+          double more   = ceil((needed - total.m_n) / double(MCBlockSize));
+          // "more" may be huge or +oo (a large first StdErr vs a small tol),
+          // so clamp it before the conversion to "size_t":
+          more          = std::clamp(more, 0.0, double(maxRound));
+          maxRound      = std::max(size_t(more), MCMinRound);
+        }
+        round = std::min(round, maxRound);
+      }
+      RunParallel
+        (round, a_params.m_nThreads,
+         [&](size_t a_i) { simBlock(done + a_i); });
+
+      for (size_t b = done; b < done + round; ++b)
+        total.Merge(blockStats[b]);
+      done += round;
+
+      MCEstimate(total, cv, cvMean, df, &res);
+
+      // Check the stopping criteria:
+      if (useTol && a_params.m_confZ * res.m_stdErr <= a_params.m_tolCI)
+      {
+        res.m_stop = MCStop::Tolerance;
+        break;
+      }
+      if (useTime && Clock::now() >= deadline)
+      {
+        res.m_stop = MCStop::Time;
+        break;
+      }
+    }
+
+    long nDone   = long(total.m_n);
+    res.m_nPaths = anti ? 2 * nDone : nDone;
+    res.m_time   = std::chrono::duration<double>(Clock::now() - start).count();
+    return res;
+  }
+}
+// End namespace BSM
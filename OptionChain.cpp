@@ -0,0 +1,349 @@
+// vim:ts=2:et
+//===========================================================================//
+//                             "OptionChain.cpp":                            //
+//       Option Chain with Pre-Computed Invariants: Implementation           //
+//===========================================================================//
+#include "OptionChain.h"
+#include "FastMath.hpp"
+#include <map>
+#include <stdexcept>
+
+namespace BSM
+{
+  namespace
+  {
+    //-----------------------------------------------------------------------//
+    // "RepriceKernel":                                                      //
+    //-----------------------------------------------------------------------//
+    // "a_n" is a multiple of 8, and all arrays are 64-byte aligned. "a_x" is
+    // log(St) (log(F) for Black76), or F itself for the Normal model, which
+    // also adds the m_e * pdf(d1) term. With "Escrow", the per-option "a_escS"
+    // and "a_escX" are used instead of "a_St" and "a_x":
+    //
+    template<typename CDF, bool Normal, bool Escrow>
+    FASTMATH_SIMD_KERNEL
+    void RepriceKernel
+    (
+      size_t                   a_n,
+      double                   a_St,
+      double                   a_x,
+      double const* __restrict a_invS,
+      double const* __restrict a_c,
+      double const* __restrict a_s,
+      double const* __restrict a_w,
+      double const* __restrict a_a,
+      double const* __restrict a_b,
+      double const* __restrict a_e,
+      double const* __restrict a_K,
+      double const* __restrict a_dig,
+      double const* __restrict a_live,
+      double const* __restrict a_escS,
+      double const* __restrict a_escX,
+      double*       __restrict a_px
+    )
+    {
+#     pragma omp simd aligned(a_invS, a_c, a_s, a_w, a_a, a_b, a_e, a_K, \
+                              a_dig, a_live, a_escS, a_escX, a_px: 64)
+      for (size_t i = 0; i < a_n; ++i)
+      {
+        double S    = Escrow ? a_escS[i] : a_St;
+        double x    = Escrow ? a_escX[i] : a_x;
+        double w    = a_w[i];
+        double d1   = x * a_invS[i] + a_c[i];
+        double d2   = d1 - a_s[i];
+        double px   = S * a_a[i] * CDF::Phi(w * d1) +
+                      a_b[i] * CDF::Phi(w * d2);
+        if constexpr (Normal)
+          px       += a_e[i] * CDF::NormPDF(d1);
+        // Deep out-of-the-money, rounding may give a tiny negative number:
+        px          = (px > 0.0) ? px : 0.0;
+
+        // At expiration time, the PayOff (the above is garbage then):
+        double intr = w * (S - a_K[i]);
+        double pay  = (intr > 0.0) ? (intr + a_dig[i] * (1.0 - intr)) : 0.0;
+        a_px[i]     = (a_live[i] != 0.0) ? px : pay;
+      }
+    }
+  }
+
+  //=========================================================================//
+  // "OptionChain" Non-Default Ctor:                                         //
+  //=========================================================================//
+  OptionChain::OptionChain
+  (
+    size_t            a_n,
+    PayoffType const* a_types,
+    double const*     a_K,
+    double const*     a_T,
+    double            a_r,
+    double            a_D,
+    double const*     a_sigma,
+    double             a_t,
+    PxModel            a_model,
+    DivSchedule const* a_divs
+  )
+  : m_n     (a_n),
+    m_stride((a_n + 7) / 8 * 8),
+    m_model (a_model),
+    m_r     (a_r),
+    m_D     (a_D),
+    m_buff  (static_cast<double*>
+            (::operator new[](14 * m_stride * sizeof(double),
+                              std::align_val_t(64)))),
+    m_invS  (m_buff.get()),
+    m_c     (m_invS + m_stride),
+    m_s     (m_c    + m_stride),
+    m_w     (m_s    + m_stride),
+    m_a     (m_w    + m_stride),
+    m_b     (m_a    + m_stride),
+    m_e     (m_b    + m_stride),
+    m_tau   (m_e    + m_stride),
+    m_K     (m_tau  + m_stride),
+    m_dig   (m_K    + m_stride),
+    m_live  (m_dig  + m_stride),
+    m_px    (m_live + m_stride),
+    m_escS  (m_px   + m_stride),
+    m_escX  (m_escS + m_stride),
+    m_expIdx (),
+    m_expTau (),
+    m_expSqrt(),
+    m_expDfR (),
+    m_expDfD (),
+    m_expPV  (),
+    m_expS   (),
+    m_expX   ()
+  {
+    //-----------------------------------------------------------------------//
+    // Check the args (as in "PxBatch"; the vols in "SetModel"):             //
+    //-----------------------------------------------------------------------//
+    for (size_t i = 0; i < a_n; ++i)
+    {
+      if (a_T[i] - a_t < 0.0)
+        throw std::invalid_argument("Negative Time to Expiration");
+
+      if (a_types[i] != PayoffType::Call        &&
+          a_types[i] != PayoffType::Put         &&
+          a_types[i] != PayoffType::DigitalCall &&
+          a_types[i] != PayoffType::DigitalPut)
+        throw std::logic_error("Unsupported PayoffType");
+    }
+
+    //-----------------------------------------------------------------------//
+    // The model-independent per-option data:                                //
+    //-----------------------------------------------------------------------//
+    for (size_t i = 0; i < m_stride; ++i)
+    {
+      if (i >= a_n)
+      {
+        // Padding: a benign live Call with K = 1 and tau = 1:
+        m_w   [i] = 1.0;
+        m_tau [i] = 1.0;
+        m_K   [i] = 1.0;
+        m_dig [i] = 0.0;
+        m_live[i] = 1.0;
+        m_px  [i] = 0.0;
+        m_escS[i] = 1.0;
+        m_escX[i] = 0.0;
+        continue;
+      }
+      PayoffType type = a_types[i];
+      double     tau  = a_T[i] - a_t;
+      bool       dig  = (type == PayoffType::DigitalCall ||
+                         type == PayoffType::DigitalPut);
+      m_w   [i] = (type == PayoffType::Call ||
+                   type == PayoffType::DigitalCall) ? 1.0 : -1.0;
+      m_tau [i] = tau;
+      m_K   [i] = a_K[i];
+      m_dig [i] = dig  ? 1.0 : 0.0;
+      m_live[i] = (tau > 0.0) ? 1.0 : 0.0;
+      m_px  [i] = NAN;
+      m_escS[i] = NAN;
+      m_escX[i] = NAN;
+    }
+
+    //-----------------------------------------------------------------------//
+    // The distinct expirations:                                             //
+    //-----------------------------------------------------------------------//
+    std::map<double, uint32_t> exps;
+    m_expIdx.resize(a_n);
+    for (size_t i = 0; i < a_n; ++i)
+    {
+      auto it = exps.find(a_T[i]);
+      if (it == exps.end())
+      {
+        it = exps.emplace(a_T[i], uint32_t(m_expTau.size())).first;
+        m_expTau.push_back(a_T[i] - a_t);
+      }
+      m_expIdx[i] = it->second;
+    }
+    size_t nExp = m_expTau.size();
+    m_expSqrt.resize(nExp);
+    m_expDfR .resize(nExp);
+    m_expDfD .resize(nExp);
+
+    //-----------------------------------------------------------------------//
+    // The PVs of the dividends, per expiration:                             //
+    //-----------------------------------------------------------------------//
+    // (If no dividend is paid before any expiration, the chain is priced as
+    // one without dividends):
+    if (a_divs != nullptr && !a_divs->Empty())
+    {
+      bool any = false;
+      m_expPV.resize(nExp);
+      for (auto const& [T, e]: exps)
+      {
+        m_expPV[e] = a_divs->PV(a_t, T, a_r);
+        any       |= (m_expPV[e] != 0.0);
+      }
+      if (any)
+      {
+        m_expS.resize(nExp);
+        m_expX.resize(nExp);
+      }
+      else
+        m_expPV.clear();
+    }
+
+    SetModel(a_model, a_sigma);
+  }
+
+  //=========================================================================//
+  // "OptionChain::SetModel":                                                //
+  //=========================================================================//
+  void OptionChain::SetModel(PxModel a_model, double const* a_sigma)
+  {
+    if (a_model != PxModel::BSM && a_model != PxModel::Black76 &&
+        a_model != PxModel::Bachelier)
+      throw std::invalid_argument("Invalid PxModel");
+
+    // In the Normal Model, K may be of any sign:
+    bool normal = (a_model == PxModel::Bachelier);
+    for (size_t i = 0; i < m_n; ++i)
+      if (a_sigma[i] <= 0.0 || (!normal && m_K[i] <= 0.0))
+        throw std::invalid_argument
+              (normal ? "Non-Positive Vol"
+                      : "Non-Positive Strike / UnderlyingPx / Vol");
+
+    // For Black76, the Fwd grows at the rate r - D = 0:
+    double D = (a_model == PxModel::Black76) ? m_r : m_D;
+
+    //-----------------------------------------------------------------------//
+    // Per-Expiration Invariants:                                            //
+    //-----------------------------------------------------------------------//
+    for (size_t e = 0; e < m_expTau.size(); ++e)
+    {
+      double tau   = m_expTau[e];
+      m_expSqrt[e] = sqrt(tau);
+      m_expDfR [e] = exp(-m_r * tau);
+      m_expDfD [e] = exp(-D   * tau);
+    }
+
+    //-----------------------------------------------------------------------//
+    // Per-Option Coeffs:                                                    //
+    //-----------------------------------------------------------------------//
+    for (size_t i = 0; i < m_stride; ++i)
+    {
+      if (i >= m_n)
+      {
+        // Padding (see the Ctor):
+        m_invS[i] = 1.0;
+        m_c   [i] = 0.0;
+        m_s   [i] = normal ? 0.0 : 1.0;
+        m_a   [i] = 1.0;
+        m_b   [i] = -1.0;
+        m_e   [i] = 0.0;
+        continue;
+      }
+      uint32_t      e    = m_expIdx[i];
+      double        tau  = m_tau[i];
+      double        dfR  = m_expDfR[e];
+      double        dfD  = m_expDfD[e];
+      bool          dig  = (m_dig[i] != 0.0);
+      double        w    = m_w[i];
+      double        K    = m_K[i];
+      double        s    = a_sigma[i] * m_expSqrt[e];
+
+      m_invS[i] = 1.0 / s;
+      if (normal)
+      {
+        // d1 = d2 = (F - K) / s:
+        m_s [i] = 0.0;
+        m_c [i] = - K / s;
+        m_a [i] = dig ? 0.0       : w * dfR;
+        m_e [i] = dig ? 0.0       : dfR * s;
+      }
+      else
+      {
+        m_s [i] = s;
+        m_c [i] = (- log(K) + (m_r - D) * tau) / s + 0.5 * s;
+        m_a [i] = dig ? 0.0       : w * dfD;
+        m_e [i] = 0.0;
+      }
+      m_b   [i] = dig ? dfR       : - w * K * dfR;
+    }
+    m_model = a_model;
+  }
+
+  //=========================================================================//
+  // "OptionChain::Reprice":                                                 //
+  //=========================================================================//
+  template<typename CDF>
+  double const* OptionChain::Reprice(double a_St)
+  {
+    if (m_model == PxModel::Bachelier)
+    {
+      if (!std::isfinite(a_St))
+        throw std::invalid_argument
+              ("Non-Positive Strike / UnderlyingPx / Vol");
+
+      RepriceKernel<CDF, true, false>
+        (m_stride, a_St, a_St, m_invS, m_c, m_s, m_w, m_a, m_b, m_e, m_K,
+         m_dig, m_live, m_escS, m_escX, m_px);
+      return m_px;
+    }
+
+    if (a_St <= 0.0)
+      throw std::invalid_argument("Non-Positive Strike / UnderlyingPx / Vol");
+
+    if (m_model == PxModel::BSM && !m_expPV.empty())
+    {
+      // The escrowed Pxs and their logs, per expiration, then per option:
+      size_t nExp = m_expPV.size();
+      for (size_t e = 0; e < nExp; ++e)
+      {
+        double S = a_St - m_expPV[e];
+        if (S <= 0.0)
+          throw std::invalid_argument
+                ("Non-Positive Strike / UnderlyingPx / Vol");
+        m_expS[e] = S;
+        m_expX[e] = log(S);
+      }
+      for (size_t i = 0; i < m_n; ++i)
+      {
+        uint32_t e = m_expIdx[i];
+        m_escS[i]  = m_expS[e];
+        m_escX[i]  = m_expX[e];
+      }
+      RepriceKernel<CDF, false, true>
+        (m_stride, a_St, 0.0, m_invS, m_c, m_s, m_w, m_a, m_b, m_e, m_K,
+         m_dig, m_live, m_escS, m_escX, m_px);
+      return m_px;
+    }
+
+    // The only transcendental function evaluated per tick:
+    double lnS = log(a_St);
+
+    RepriceKernel<CDF, false, false>
+      (m_stride, a_St, lnS, m_invS, m_c, m_s, m_w, m_a, m_b, m_e, m_K, m_dig,
+       m_live, m_escS, m_escX, m_px);
+    return m_px;
+  }
+
+  //-------------------------------------------------------------------------//
+  // Explicit Instantiations:                                                //
+  //-------------------------------------------------------------------------//
+  template double const* OptionChain::Reprice<CDFErf> (double);
+  template double const* OptionChain::Reprice<CDFCody>(double);
+  template double const* OptionChain::Reprice<CDFFast>(double);
+}
+// End namespace BSM
@@ -0,0 +1,144 @@
+// vim:ts=2:et
+//===========================================================================//
+//                              "OptionChain.h":                             //
+//       Option Chain with Pre-Computed Invariants for Fast Repricing        //
+//===========================================================================//
+#pragma once
+#include "BSM.h"
+#include "Dividends.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace BSM
+{
+  //=========================================================================//
+  // "OptionChain" Class:                                                    //
+  //=========================================================================//
+  // On an Underlying tick, only "St" changes, but "Px" recomputes sqrt(tau),
+  // the discount factors and log(K) for each option. Here they are computed
+  // once (per expiration, then folded into per-option coeffs), so that
+  //   d1 = log(St) * m_invS[i] + m_c[i],  d2 = d1 - m_s[i],
+  //   Px = St * m_a[i] * Phi(w * d1) + m_b[i] * Phi(w * d2),
+  // and "Reprice" is a single loop (2 "Phi"s per option, no "log" or "exp")
+  // over Structure-of-Arrays data, aligned at cache lines, and padded to a
+  // multiple of 8 (so there are no remainder iterations).
+  // The same layout serves all "PxModel"s: for Black76, "Reprice" takes the
+  // Fwd Px (and D = r); for Bachelier, d1 = d2 = F * m_invS[i] + m_c[i], and
+  // the term m_e[i] * pdf(d1) is added (so the Fwd is not logged).
+  // With cash dividends (BSM only), "St" is replaced by the escrowed Px St -
+  // PV_e, where the PVs are computed once per expiration "e" at construction;
+  // so "Reprice" evaluates 1 "log" per expiration (not per option), and then
+  // gathers the escrowed Pxs and their logs into per-option arrays, at a cost
+  // of a few loads and stores per option.
+  // Call, Put, DigitalCall and DigitalPut may be mixed in one chain.  The
+  // rates and the Pricing Time are fixed at construction; the model and the
+  // vols may be changed in place by "SetModel"; otherwise, construct a new
+  // chain. NOT thread-safe (the Pxs are stored in the object):
+  //
+  class OptionChain
+  {
+  private:
+    //-----------------------------------------------------------------------//
+    // Cache-Aligned Storage:                                                //
+    //-----------------------------------------------------------------------//
+    struct AlignedDeleter
+    {
+      void operator()(double* a_ptr) const
+        { ::operator delete[](a_ptr, std::align_val_t(64)); }
+    };
+
+    //-----------------------------------------------------------------------//
+    // Data Flds:                                                            //
+    //-----------------------------------------------------------------------//
+    size_t  m_n;        // Number of Options
+    size_t  m_stride;   // m_n rounded up to a multiple of 8
+    PxModel m_model;
+    double  m_r;
+    double  m_D;
+    std::unique_ptr<double[], AlignedDeleter> m_buff;
+    // Ptrs into "m_buff", each to "m_stride" values:
+    double* m_invS;     // 1 / (sigma * sqrt(tau))
+    double* m_c;        // (-log(K) + (r-D)*tau) / s + s/2
+    double* m_s;        // sigma * sqrt(tau) (0 for Bachelier)
+    double* m_w;        // +1 (Calls) or -1 (Puts)
+    double* m_a;        // w * exp(-D*tau) (0 for Digitals)
+    double* m_b;        // -w * K * exp(-r*tau) (Digitals: exp(-r*tau))
+    double* m_e;        // Bachelier: exp(-r*tau) * sigma * sqrt(tau), else 0
+    double* m_tau;      // Time to expiration
+    double* m_K;        // For the expired options:
+    double* m_dig;      //   1 for Digitals, 0 otherwise
+    double* m_live;     //   1 if tau > 0, 0 otherwise
+    double* m_px;       // The results of the last "Reprice"
+    double* m_escS;     // Dividends only: St - PV, and its log, per option
+    double* m_escX;     //   (re-computed by "Reprice")
+    // The distinct expirations, by index:
+    std::vector<uint32_t> m_expIdx;   // [m_n]: The index of the option's one
+    std::vector<double>   m_expTau;   // Time to expiration
+    std::vector<double>   m_expSqrt;  // Re-computed by "SetModel":
+    std::vector<double>   m_expDfR;   //   sqrt(tau), exp(-r*tau),
+    std::vector<double>   m_expDfD;   //   exp(-D*tau)
+    // Dividends only (otherwise empty), per expiration:
+    std::vector<double>   m_expPV;    // PV of the divs before expiration
+    std::vector<double>   m_expS;     // Work buffers for "Reprice":
+    std::vector<double>   m_expX;     //   St - PV and its log
+
+  public:
+    //-----------------------------------------------------------------------//
+    // Non-Default Ctor:                                                     //
+    //-----------------------------------------------------------------------//
+    // Inputs as in "PxBatch" (and so are the exceptions), but with per-option
+    // PayoffTypes; "a_sigma" are Normal vols for Bachelier:
+    //
+    OptionChain
+    (
+      // Option Specs:
+      size_t            a_n,      // Number of Options
+      PayoffType const* a_types,  // [a_n] Call, Put, DigitalCall, DigitalPut
+      double const*     a_K,      // [a_n] Option Strikes
+      double const*     a_T,      // [a_n] Option Expiration Times
+      // Market Data:
+      double            a_r,      // Risk-Free Interest Rate
+      double            a_D,      // Dividend Rate
+      double const*     a_sigma,  // [a_n] Implied Vols
+      // Pricing Time:
+      double            a_t,
+      PxModel           a_model = PxModel::BSM,
+      // Cash dividends of the Underlying (if any; used for BSM only):
+      DivSchedule const* a_divs = nullptr
+    );
+
+    //-----------------------------------------------------------------------//
+    // "SetModel": Switches the Model and / or the Vols, in place:           //
+    //-----------------------------------------------------------------------//
+    // "a_sigma" ([Size()]) are in the units of "a_model". Only the per-expir-
+    // ation invariants and the per-option coeffs are re-computed (into the
+    // existing arrays, so there is no allocation):
+    //
+    void SetModel(PxModel a_model, double const* a_sigma);
+
+    //-----------------------------------------------------------------------//
+    // "Reprice": All Pxs for a New Underlying Px:                           //
+    //-----------------------------------------------------------------------//
+    // Returns the ptr to the "Size()" Pxs (valid until the next "Reprice").
+    // "a_St" is the Fwd Px for Black76 and Bachelier. Throws "std::invalid_
+    // argument" if "a_St" (or an escrowed Px) is non-positive (non-finite
+    // for Bachelier).
+    // With "CDFCody", the results agree with "Px" within 1e-13 * max(K, St).
+    // Instantiated (in "OptionChain.cpp") for the 3 CDF Policies:
+    //
+    template<typename CDF = CDFCody>
+    double const* Reprice(double a_St);
+
+    //-----------------------------------------------------------------------//
+    // Accessors:                                                            //
+    //-----------------------------------------------------------------------//
+    size_t        Size()           const { return m_n;     }
+    PxModel       Model()          const { return m_model; }
+    double const* Pxs()            const { return m_px;    }
+    double        Px(size_t a_i)   const { return m_px[a_i]; }
+  };
+}
+// End namespace BSM
@@ -20,7 +20,7 @@ int main(int argc, char* argv[])
       cerr << "REQUIRED PARAMS: PayoffType K T r D sigma t St" << endl;
       return 1;     // Return an error code by convention
     }
-    int    poType = atoi(argv[1]);  // 1=Call, 2=Put
+    int    poType = atoi(argv[1]);  // 1=Call, 2=Put, 3=DigCall, 4=DigPut
     double K      = atof(argv[2]);
     double T      = atof(argv[3]);
     double r      = atof(argv[4]);
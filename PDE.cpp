@@ -0,0 +1,559 @@
+// vim:ts=2:et
+//===========================================================================//
+//                                  "PDE.cpp":                               //
+//           Crank-Nicolson Finite-Difference Pricer: Implementation         //
+//===========================================================================//
+#include "PDE.h"
+#include "FastMath.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace BSM
+{
+  namespace
+  {
+    //-----------------------------------------------------------------------//
+    // Grid Params:                                                          //
+    //-----------------------------------------------------------------------//
+    // S_max is this many StdDevs above max(K, St, Fwd) (in log terms), but at
+    // least "MinSMaxRatio" times above:
+    constexpr double NStdDevs     = 5.0;
+    constexpr double MinSMaxRatio = 1.25;
+    // The "sinh" grid concentration parameter, relative to the StdDev of the
+    // Underlying Px (smaller means more concentrated around the Strike):
+    constexpr double ConcRatio    = 0.5;
+
+    //-----------------------------------------------------------------------//
+    // "Factorise":                                                          //
+    //-----------------------------------------------------------------------//
+    // Pre-computes the elimination of the matrix (I - a_thDt * L) (rows 0 ..
+    // a_N-1; row a_N is the Dirichlet one), in the Brennan-Schwartz order:
+    // from the top (S_max) down for a Put,  from the bottom (S=0) up for a
+    // Call. All arrays are [a_N+1][a_nK]:
+    //
+    FASTMATH_SIMD_KERNEL
+    void Factorise
+    (
+      int                      a_N,
+      size_t                   a_nK,
+      bool                     a_put,
+      double                   a_thDt,
+      double const* __restrict a_l,
+      double const* __restrict a_d,
+      double const* __restrict a_u,
+      double*       __restrict a_elim,
+      double*       __restrict a_invD
+    )
+    {
+      size_t nK = a_nK;
+      if (a_put)
+      {
+        size_t r0 = size_t(a_N - 1) * nK;
+#       pragma omp simd
+        for (size_t k = 0; k < nK; ++k)
+        {
+          a_elim[r0 + k] = 0.0;
+          a_invD[r0 + k] = 1.0 / (1.0 - a_thDt * a_d[r0 + k]);
+        }
+        for (int i = a_N - 2; i >= 0; --i)
+        {
+          size_t r  = size_t(i) * nK;   // This row
+          size_t rp = r + nK;           // The row above (already eliminated)
+#         pragma omp simd
+          for (size_t k = 0; k < nK; ++k)
+          {
+            double m   = - a_thDt * a_u[r + k] * a_invD[rp + k];
+            double piv =
+              (1.0 - a_thDt * a_d[r + k]) + m * a_thDt * a_l[rp + k];
+            a_elim[r + k] = m;
+            a_invD[r + k] = 1.0 / piv;
+          }
+        }
+      }
+      else
+      {
+#       pragma omp simd
+        for (size_t k = 0; k < nK; ++k)
+        {
+          a_elim[k] = 0.0;
+          a_invD[k] = 1.0 / (1.0 - a_thDt * a_d[k]);
+        }
+        for (int i = 1; i < a_N; ++i)
+        {
+          size_t r  = size_t(i) * nK;   // This row
+          size_t rm = r - nK;           // The row below (already eliminated)
+#         pragma omp simd
+          for (size_t k = 0; k < nK; ++k)
+          {
+            double m   = - a_thDt * a_l[r + k] * a_invD[rm + k];
+            double piv =
+              (1.0 - a_thDt * a_d[r + k]) + m * a_thDt * a_u[rm + k];
+            a_elim[r + k] = m;
+            a_invD[r + k] = 1.0 / piv;
+          }
+        }
+      }
+    }
+
+    //-----------------------------------------------------------------------//
+    // "TimeStep":                                                           //
+    //-----------------------------------------------------------------------//
+    // One step of the theta-scheme
+    //   (I - a_thDt * L) V_new = (I + a_exDt * L) V_old,
+    // with V_new[a_N] = a_top (Dirichlet), and (if "a_american") the projec-
+    // tion onto the payoff applied in the back-substitution:
+    //
+    FASTMATH_SIMD_KERNEL
+    void TimeStep
+    (
+      int                      a_N,
+      size_t                   a_nK,
+      bool                     a_put,
+      bool                     a_american,
+      double                   a_exDt,
+      double                   a_thDt,
+      double const* __restrict a_l,
+      double const* __restrict a_d,
+      double const* __restrict a_u,
+      double const* __restrict a_elim,
+      double const* __restrict a_invD,
+      double const* __restrict a_payoff,
+      double const* __restrict a_top,
+      double*       __restrict a_V,
+      double*       __restrict a_rhs
+    )
+    {
+      size_t nK = a_nK;
+
+      //---------------------------------------------------------------------//
+      // The explicit part (using the old V, incl the old V[a_N]):           //
+      //---------------------------------------------------------------------//
+      // Row 0 (S=0): l = u = 0:
+#     pragma omp simd
+      for (size_t k = 0; k < nK; ++k)
+        a_rhs[k] = a_V[k] * (1.0 + a_exDt * a_d[k]);
+
+      for (int i = 1; i < a_N; ++i)
+      {
+        size_t r = size_t(i) * nK;
+#       pragma omp simd
+        for (size_t k = 0; k < nK; ++k)
+          a_rhs[r + k] =
+            a_V[r + k] +
+            a_exDt * (a_l[r + k] * a_V[r - nK + k] + a_d[r + k] * a_V[r + k] +
+                      a_u[r + k] * a_V[r + nK + k]);
+      }
+
+      // The new Dirichlet values, moved to the RHS:
+      size_t rN  = size_t(a_N) * nK;
+      size_t rN1 = rN - nK;
+#     pragma omp simd
+      for (size_t k = 0; k < nK; ++k)
+      {
+        a_V  [rN  + k]  = a_top[k];
+        a_rhs[rN1 + k] += a_thDt * a_u[rN1 + k] * a_top[k];
+      }
+
+      //---------------------------------------------------------------------//
+      // Elimination and Back-Substitution with Projection:                  //
+      //---------------------------------------------------------------------//
+      if (a_put)
+      {
+        for (int i = a_N - 2; i >= 0; --i)
+        {
+          size_t r = size_t(i) * nK;
+#         pragma omp simd
+          for (size_t k = 0; k < nK; ++k)
+            a_rhs[r + k] -= a_elim[r + k] * a_rhs[r + nK + k];
+        }
+#       pragma omp simd
+        for (size_t k = 0; k < nK; ++k)
+        {
+          double v = a_rhs[k] * a_invD[k];
+          double p = a_payoff[k];
+          a_V[k]   = (a_american & (v < p)) ? p : v;
+        }
+        for (int i = 1; i < a_N; ++i)
+        {
+          size_t r = size_t(i) * nK;
+#         pragma omp simd
+          for (size_t k = 0; k < nK; ++k)
+          {
+            double v   =
+              (a_rhs[r + k] + a_thDt * a_l[r + k] * a_V[r - nK + k]) *
+              a_invD[r + k];
+            double p   = a_payoff[r + k];
+            a_V[r + k] = (a_american & (v < p)) ? p : v;
+          }
+        }
+      }
+      else
+      {
+        for (int i = 1; i < a_N; ++i)
+        {
+          size_t r = size_t(i) * nK;
+#         pragma omp simd
+          for (size_t k = 0; k < nK; ++k)
+            a_rhs[r + k] -= a_elim[r + k] * a_rhs[r - nK + k];
+        }
+        for (int i = a_N - 1; i >= 0; --i)
+        {
+          size_t r = size_t(i) * nK;
+#         pragma omp simd
+          for (size_t k = 0; k < nK; ++k)
+          {
+            double v   =
+              (a_rhs[r + k] + a_thDt * a_u[r + k] * a_V[r + nK + k]) *
+              a_invD[r + k];
+            double p   = a_payoff[r + k];
+            a_V[r + k] = (a_american & (v < p)) ? p : v;
+          }
+        }
+      }
+    }
+
+    //-----------------------------------------------------------------------//
+    // "Lagrange4": Cubic Interpolation Weights on the S Grid:               //
+    //-----------------------------------------------------------------------//
+    // Returns "j" such that V(a_x) ~= sum_{p=0..3} a_wts[p] * V[j+p]:
+    //
+    int Lagrange4(std::vector<double> const& a_S, double a_x, double* a_wts)
+    {
+      int N = int(a_S.size()) - 1;
+      int j = int(std::upper_bound(a_S.begin(), a_S.end(), a_x) -
+                  a_S.begin());
+      j     = std::min(std::max(j - 2, 0), N - 3);   // Nodes j .. j+3
+
+      for (int p = 0; p < 4; ++p)
+      {
+        double Sp = a_S[size_t(j+p)];
+        a_wts[p]  = 1.0;
+        for (int q = 0; q < 4; ++q)
+          if (q != p)
+          {
+            double Sq = a_S[size_t(j+q)];
+            a_wts[p] *= (a_x - Sq) / (Sp - Sq);
+          }
+      }
+      return j;
+    }
+
+    //-----------------------------------------------------------------------//
+    // "DivJump": V(S_i) = V(S_i - a_d), for All Options:                    //
+    //-----------------------------------------------------------------------//
+    // The result is put into "a_tmp" and then copied back into "a_V" (both
+    // [N+1][a_nK]); below S=0, the Underlying is worthless, so V(0) is used.
+    // For American options, the values are then floored by the payoff:
+    //
+    FASTMATH_SIMD_KERNEL
+    void DivJump
+    (
+      std::vector<double> const& a_S,
+      size_t                     a_nK,
+      double                     a_d,
+      bool                       a_american,
+      double const* __restrict   a_payoff,
+      double*       __restrict   a_V,
+      double*       __restrict   a_tmp
+    )
+    {
+      size_t nK     = a_nK;
+      size_t nNodes = a_S.size();
+      for (size_t i = 0; i < nNodes; ++i)
+      {
+        size_t r = i * nK;
+        double x = a_S[i] - a_d;
+        if (x <= 0.0)
+        {
+#         pragma omp simd
+          for (size_t k = 0; k < nK; ++k)
+            a_tmp[r + k] = a_V[k];
+          continue;
+        }
+        double wts[4];
+        size_t j  = size_t(Lagrange4(a_S, x, wts));
+        double const* V = a_V + j * nK;
+#       pragma omp simd
+        for (size_t k = 0; k < nK; ++k)
+          a_tmp[r + k] = wts[0] * V[k]          + wts[1] * V[nK + k] +
+                         wts[2] * V[2 * nK + k] + wts[3] * V[3 * nK + k];
+      }
+
+      size_t sz = nNodes * nK;
+#     pragma omp simd
+      for (size_t r = 0; r < sz; ++r)
+      {
+        double v = a_tmp[r];
+        double p = a_payoff[r];
+        a_V[r]   = (a_american & (v < p)) ? p : v;
+      }
+    }
+  }
+
+  //=========================================================================//
+  // "PDEPricer" Non-Default Ctor:                                           //
+  //=========================================================================//
+  PDEPricer::PDEPricer(int a_nS, int a_nT, int a_nRannacher)
+  : m_nS        (a_nS),
+    m_nT        (a_nT),
+    m_nRannacher(a_nRannacher)
+  {
+    if (a_nS < 4 || a_nT < 1 || a_nRannacher < 0)
+      throw std::invalid_argument("PDEPricer: Invalid Grid Size");
+  }
+
+  //=========================================================================//
+  // "PDEPricer::Px":                                                        //
+  //=========================================================================//
+  double PDEPricer::Px
+  (
+    PayoffType a_type,
+    bool       a_american,
+    double     a_K,
+    double     a_T,
+    double     a_r,
+    double     a_D,
+    double     a_sigma,
+    double             a_t,
+    double             a_St,
+    DivSchedule const* a_divs
+  )
+  {
+    double px = NAN;
+    PxBatch(a_type, a_american, 1, &a_K, a_T, a_r, a_D, &a_sigma, a_t, a_St,
+            &px, a_divs);
+    return px;
+  }
+
+  //=========================================================================//
+  // "PDEPricer::PxBatch":                                                   //
+  //=========================================================================//
+  void PDEPricer::PxBatch
+  (
+    PayoffType    a_type,
+    bool          a_american,
+    size_t        a_n,
+    double const* a_K,
+    double        a_T,
+    double        a_r,
+    double        a_D,
+    double const* a_sigma,
+    double        a_t,
+    double             a_St,
+    double*            a_px,
+    DivSchedule const* a_divs
+  )
+  {
+    //-----------------------------------------------------------------------//
+    // Check the args:                                                       //
+    //-----------------------------------------------------------------------//
+    double tau = a_T - a_t;
+
+    if (tau <  0.0)
+      throw std::invalid_argument("Negative Time to Expiration");
+
+    double w = 0.0;   // +1 for Call, -1 for Put
+    switch (a_type)
+    {
+      case PayoffType::Call: w =  1.0; break;
+      case PayoffType::Put:  w = -1.0; break;
+      default:
+        throw std::logic_error("Unsupported PayoffType");
+    }
+    bool put = (w < 0.0);
+
+    if (a_St <= 0.0)
+      throw std::invalid_argument("Non-Positive Strike / UnderlyingPx / Vol");
+
+    double minK = INFINITY, maxK = 0.0, maxSigma = 0.0;
+    for (size_t k = 0; k < a_n; ++k)
+    {
+      if (a_K[k] <= 0.0 || a_sigma[k] <= 0.0)
+        throw std::invalid_argument
+              ("Non-Positive Strike / UnderlyingPx / Vol");
+      minK     = std::min(minK, a_K[k]);
+      maxK     = std::max(maxK, a_K[k]);
+      maxSigma = std::max(maxSigma, a_sigma[k]);
+    }
+    if (a_n == 0)
+      return;
+
+    // At expiration time, return the PayOff:
+    if (tau == 0.0)
+    {
+      for (size_t k = 0; k < a_n; ++k)
+        a_px[k] = std::max(w * (a_St - a_K[k]), 0.0);
+      return;
+    }
+
+    //-----------------------------------------------------------------------//
+    // The Grid:                                                             //
+    //-----------------------------------------------------------------------//
+    // S_j = C + alpha * sinh(c1 + (c2 - c1) * j/N),  j = 0..N, with S_0 = 0
+    // and S_N = S_max; the density is highest around "C" (the geometric mean
+    // of the Strikes, moved half-way along the drift:  backwards in time, the
+    // kink of the payoff at K moves to K * exp(-(r - D) * tau)). S_max is
+    // above the Fwd as well, as with a low vol and a large drift,  most of
+    // the distribution may be above max(K, St):
+    //
+    int    N      = m_nS;
+    size_t nK     = a_n;
+    size_t nNodes = size_t(N) + 1;
+    double sd     = maxSigma * sqrt(tau);
+    double drift  = (a_r - a_D) * tau;
+    double sMax   =
+      std::max(maxK, a_St * std::max(exp(drift), 1.0)) *
+      std::max(exp(NStdDevs * sd), MinSMaxRatio);
+    double C      = sqrt(minK * maxK) * exp(-0.5 * drift);
+    double alpha  = ConcRatio * sd * C;
+    double c1     = asinh(-C / alpha);
+    double c2     = asinh((sMax - C) / alpha);
+
+    m_S.resize(nNodes);
+    for (int j = 0; j <= N; ++j)
+      m_S[size_t(j)] = C + alpha * sinh(c1 + (c2 - c1) * double(j) / N);
+    m_S[0]          = 0.0;
+    m_S[size_t(N)]  = sMax;
+
+    //-----------------------------------------------------------------------//
+    // The Operator Coeffs and the Payoff:                                   //
+    //-----------------------------------------------------------------------//
+    size_t sz = nNodes * nK;
+    for (std::vector<double>* v:
+         { &m_l, &m_d, &m_u, &m_elim, &m_invD, &m_payoff, &m_V, &m_rhs })
+      v->resize(sz);
+    m_top.resize(nK);
+
+    for (int i = 0; i <= N; ++i)
+    {
+      double S  = m_S[size_t(i)];
+      size_t r  = size_t(i) * nK;
+      bool   in = (0 < i && i < N);    // Interior node
+      double hm = in ? S - m_S[size_t(i-1)] : 1.0;
+      double hp = in ? m_S[size_t(i+1)] - S : 1.0;
+      double b  = (a_r - a_D) * S;
+
+      for (size_t k = 0; k < nK; ++k)
+      {
+        m_payoff[r + k] = std::max(w * (S - a_K[k]), 0.0);
+        if (!in)
+        {
+          // S=0: dV/dtau = -r*V; S_max: Dirichlet (coeffs not used):
+          m_l[r + k] = 0.0;
+          m_d[r + k] = (i == 0) ? -a_r : 0.0;
+          m_u[r + k] = 0.0;
+          continue;
+        }
+        double a  = 0.5 * a_sigma[k] * a_sigma[k] * S * S;
+        // Central differences for dV/dS, unless this makes "l" or "u" neg-
+        // ative (possible for low vols on the coarse part of the grid); then
+        // one-sided (upwind) differences are used:
+        double lc = (2.0 * a - b * hp) / (hm * (hm + hp));
+        double uc = (2.0 * a + b * hm) / (hp * (hm + hp));
+        double a2 = 2.0 * a / (hm * hp * (hm + hp));
+        if (lc >= 0.0 && uc >= 0.0)
+        {
+          m_l[r + k] = lc;
+          m_u[r + k] = uc;
+          m_d[r + k] = (-2.0 * a + b * (hp - hm)) / (hm * hp) - a_r;
+        }
+        else
+        if (b > 0.0)
+        {
+          m_l[r + k] = a2 * hp;
+          m_u[r + k] = a2 * hm + b / hp;
+          m_d[r + k] = -2.0 * a / (hm * hp) - b / hp - a_r;
+        }
+        else
+        {
+          m_l[r + k] = a2 * hp - b / hm;
+          m_u[r + k] = a2 * hm;
+          m_d[r + k] = -2.0 * a / (hm * hp) + b / hm - a_r;
+        }
+      }
+    }
+
+    //-----------------------------------------------------------------------//
+    // Time Stepping (in tau = time to expiration):                          //
+    //-----------------------------------------------------------------------//
+    double dt   = tau / m_nT;
+    int    nRan = std::min(m_nRannacher, m_nT);
+
+    Factorise(N, nK, put, 0.5 * dt, m_l.data(), m_d.data(), m_u.data(),
+              m_elim.data(), m_invD.data());
+
+    std::copy(m_payoff.begin(), m_payoff.end(), m_V.begin());
+
+    // The dividends, on the nearest tau steps (0 = at expiration):
+    bool hasDivs = false;
+    if (a_divs != nullptr)
+    {
+      m_div.assign(size_t(m_nT + 1), 0.0);
+      for (size_t e = 0; e < a_divs->Size(); ++e)
+      {
+        double te = a_divs->Time(e);
+        if (te <= a_t || te > a_T || a_divs->Amount(e) == 0.0)
+          continue;
+        m_div[size_t(lround((a_T - te) / dt))] += a_divs->Amount(e);
+        hasDivs = true;
+      }
+    }
+    // The PV of the dividends already passed (in tau) is divAcc * dfR:
+    double divAcc = 0.0;
+    auto   jump   =
+      [&](int a_m)
+      {
+        double d = m_div[size_t(a_m)];
+        if (d == 0.0)
+          return;
+        DivJump(m_S, nK, d, a_american, m_payoff.data(), m_V.data(),
+                m_rhs.data());
+        divAcc += d * exp(a_r * a_m * dt);
+      };
+    if (hasDivs)
+      jump(0);
+
+    double tauCurr = 0.0;
+    for (int n = 0; n < m_nT; ++n)
+    {
+      bool rannacher = (n < nRan);
+      for (int h = 0; h < (rannacher ? 2 : 1); ++h)
+      {
+        tauCurr += rannacher ? 0.5 * dt : dt;
+
+        // The Dirichlet values at S_max:
+        double dfD = exp(-a_D * tauCurr);
+        double dfR = exp(-a_r * tauCurr);
+        double pvD = divAcc * dfR;
+        for (size_t k = 0; k < nK; ++k)
+        {
+          double euro = put ? 0.0 : sMax * dfD - pvD - a_K[k] * dfR;
+          double intr = w * (sMax - a_K[k]);
+          m_top[k]    = a_american ? std::max(euro, intr) : euro;
+        }
+        // Fully-implicit half-step, or Crank-Nicolson step:
+        TimeStep(N, nK, put, a_american, rannacher ? 0.0 : 0.5 * dt, 0.5 * dt,
+                 m_l.data(), m_d.data(), m_u.data(), m_elim.data(),
+                 m_invD.data(), m_payoff.data(), m_top.data(), m_V.data(),
+                 m_rhs.data());
+      }
+      if (hasDivs)
+        jump(n + 1);
+    }
+
+    //-----------------------------------------------------------------------//
+    // Cubic Interpolation at "a_St":                                        //
+    //-----------------------------------------------------------------------//
+    double wts[4];
+    int    j = Lagrange4(m_S, a_St, wts);
+    for (size_t k = 0; k < nK; ++k)
+    {
+      double v = 0.0;
+      for (int p = 0; p < 4; ++p)
+        v += wts[p] * m_V[size_t(j+p) * nK + k];
+      a_px[k] = v;
+    }
+  }
+}
+// End namespace BSM
@@ -0,0 +1,136 @@
+// vim:ts=2:et
+//===========================================================================//
+//                                   "PDE.h":                                //
+//      Crank-Nicolson Finite-Difference Pricer for American / European      //
+//===========================================================================//
+#pragma once
+#include "BSM.h"
+#include "Dividends.h"
+#include <cstddef>
+#include <vector>
+
+namespace BSM
+{
+  //=========================================================================//
+  // "PDEPricer" Class:                                                      //
+  //=========================================================================//
+  // Solves the BSM PDE in the Underlying Px "S" (backwards in time):
+  // (*) Grid: non-uniform (Tavella-Randall "sinh" type), from S=0 (where the
+  //     PDE degenerates into dV/dt = r*V, so no boundary condition is needed)
+  //     to S_max, concentrated around the Strike(s);  Dirichlet condition at
+  //     S_max (the asymptotic European value, or the intrinsic value if it is
+  //     larger for an American option);
+  // (*) Time stepping: Crank-Nicolson, with Rannacher start-up: the first
+  //     "a_nRannacher" steps are each replaced by 2 fully-implicit half-steps,
+  //     which damps the oscillations caused by the non-smooth payoff;
+  // (*) Early exercise: the Brennan-Schwartz algorithm -- the tridiagonal sys-
+  //     tem is eliminated starting from the continuation end (S_max for a Put,
+  //     S=0 for a Call), and the projection onto the payoff is applied during
+  //     back-substitution. This is exact for the single exercise boundary of
+  //     vanilla Calls and Puts, and (unlike PSOR) has no iterations;
+  // (*) Batches: many options with the same expiration share one S grid. The
+  //     state is stored as [Node][Option], and all per-node operations  (the
+  //     RHS, the elimination and the back-substitution)  are loops over the
+  //     options, vectorised by the compiler.  Each option may have its own
+  //     vol, so the operator coeffs are per-option as well;
+  // (*) The grid memory is owned by the object and re-used across solves (it
+  //     only grows if a larger batch comes). So the object is NOT thread-safe;
+  //     use one per thread.
+  // (*) Cash dividends (if a "DivSchedule" is given): exact jump conditions
+  //     V(S, t_d-) = V(S - d, t_d+), applied (by cubic interpolation on the
+  //     S grid, for all options at once) at the time step nearest to each
+  //     ex-time, followed by the projection onto the payoff for American op-
+  //     tions; the S_max condition includes the PV of the dividends left;
+  // The result is interpolated (cubic) at "a_St".
+  // With the default grid (400 x 200), the European errors are below 1e-5 *
+  // K for total vols sigma * sqrt(tau) of 0.25 .. 0.75, 2e-5 * K for up to
+  // 1.25 (and for lower ones with a large drift),  and 5e-5 * K for up to 2.
+  // The American Put with S = K = 100, r = 5%, vol = 20%, T = 1 is 6.0898
+  // (vs 6.0903, the error being mostly in time; 1600 x 800 gives 6.0903).
+  // A batch of 64 Strikes is about 8x faster than 64 single solves:
+  //
+  class PDEPricer
+  {
+  private:
+    //-----------------------------------------------------------------------//
+    // Data Flds:                                                            //
+    //-----------------------------------------------------------------------//
+    int                 m_nS;         // Number of S intervals (nodes: m_nS+1)
+    int                 m_nT;         // Number of time steps
+    int                 m_nRannacher; // Number of Rannacher start-up steps
+    // The S Grid:
+    std::vector<double> m_S;          // [m_nS+1]
+    // The Operator Coeffs (L*V)_i = l_i V_{i-1} + d_i V_i + u_i V_{i+1}, and
+    // the rest of the state, all [m_nS+1][NOptions]:
+    std::vector<double> m_l;
+    std::vector<double> m_d;
+    std::vector<double> m_u;
+    // NB: The matrix (I - dt/2 * L) is the same for the CN steps and the
+    // implicit half-steps, so it is factorised once:
+    std::vector<double> m_elim;       // Elimination multipliers
+    std::vector<double> m_invD;       // Inverse pivots
+    std::vector<double> m_payoff;
+    std::vector<double> m_V;          // The solution
+    std::vector<double> m_rhs;        // Work buffer
+    std::vector<double> m_top;        // [NOptions]: Values at S_max
+    std::vector<double> m_div;        // [m_nT+1]: Cash div at this tau step
+
+  public:
+    //-----------------------------------------------------------------------//
+    // Non-Default Ctor:                                                     //
+    //-----------------------------------------------------------------------//
+    PDEPricer(int a_nS = 400, int a_nT = 200, int a_nRannacher = 2);
+
+    //-----------------------------------------------------------------------//
+    // "Px": Single Option:                                                  //
+    //-----------------------------------------------------------------------//
+    // Call or Put only; the args are as in "BSM::Px" (and so are the excep-
+    // tions):
+    //
+    double Px
+    (
+      // Option Spec:
+      PayoffType a_type,
+      bool       a_american,
+      double     a_K,     // Option Strike
+      double     a_T,     // Opton Expiration Time, as Year Fraction
+      // Market Data:
+      double     a_r,     // Risk-Free Interest Rate
+      double     a_D,     // Dividend Rate
+      double     a_sigma, // Volatility
+      // "Quick" variables:
+      double     a_t,     // Pricing Time (as Year Fraction)
+      double     a_St,    // Underlying Px at Time "a_t"
+      // Cash dividends (if any):
+      DivSchedule const* a_divs = nullptr
+    );
+
+    //-----------------------------------------------------------------------//
+    // "PxBatch": Options with Same Expiration and Underlying:               //
+    //-----------------------------------------------------------------------//
+    // "a_n" options of the same PayoffType, given by their Strikes and Vols,
+    // solved in one sweep on a common grid:
+    //
+    void PxBatch
+    (
+      // Option Specs:
+      PayoffType    a_type,
+      bool          a_american,
+      size_t        a_n,      // Number of Options
+      double const* a_K,      // [a_n] Option Strikes
+      double        a_T,      // Expiration Time (shared)
+      // Market Data:
+      double        a_r,      // Risk-Free Interest Rate (shared)
+      double        a_D,      // Dividend Rate           (shared)
+      double const* a_sigma,  // [a_n] Vols
+      // "Quick" variables:
+      double        a_t,      // Pricing Time            (shared)
+      double        a_St,     // Underlying Px           (shared)
+      // Output:
+      double*       a_px,     // [a_n] Option Pxs
+      // Cash dividends (if any):
+      DivSchedule const* a_divs = nullptr
+    );
+  };
+}
+// End namespace BSM
@@ -0,0 +1,102 @@
+// vim:ts=2:et
+//===========================================================================//
+//                                "Philox.hpp":                              //
+//             Counter-Based Random Number Generator "Philox4x32-10"         //
+//===========================================================================//
+// Salmon, Moraes, Dror, Shaw, "Parallel Random Numbers: As Easy as 1, 2, 3"
+// (SC'11). Unlike the conventional (eg Mersenne Twister) generators,  there
+// is no state to advance:  the output is a pure function of a 128-bit Counter
+// and a 64-bit Key,  so any element of the stream can be produced directly.
+// In Monte Carlo,  the Counter is made of the path number and the step num-
+// ber, so the numbers used by a path do not depend on which thread simulates
+// it, or in which order -- hence the results are bit-identical for any number
+// of threads. The Key is the user-provided seed.
+// Only integer multiplications and XORs are used, so loops generating many
+// numbers are vectorisable:
+//
+#pragma once
+#include "FastMath.hpp"
+#include <cmath>
+#include <cstdint>
+
+namespace RNG
+{
+  //=========================================================================//
+  // "Philox4x32":                                                           //
+  //=========================================================================//
+  // Produces 4 random 32-bit words  from the Counter "a_ctr"  (in place)  and
+  // the Key "a_key":
+  //
+  FASTMATH_INLINE void Philox4x32
+  (
+    uint32_t       a_ctr[4],
+    uint32_t const a_key[2]
+  )
+  {
+    constexpr uint32_t M0 = 0xD2511F53U;
+    constexpr uint32_t M1 = 0xCD9E8D57U;
+    constexpr uint32_t W0 = 0x9E3779B9U;  // The Key increments ("Weyl" seq)
+    constexpr uint32_t W1 = 0xBB67AE85U;
+
+    uint32_t c0 = a_ctr[0], c1 = a_ctr[1], c2 = a_ctr[2], c3 = a_ctr[3];
+    uint32_t k0 = a_key[0], k1 = a_key[1];
+
+    for (int i = 0; i < 10; ++i)
+    {
+      uint64_t p0 = uint64_t(M0) * c0;
+      uint64_t p1 = uint64_t(M1) * c2;
+      uint32_t n0 = uint32_t(p1 >> 32) ^ c1 ^ k0;
+      uint32_t n2 = uint32_t(p0 >> 32) ^ c3 ^ k1;
+      c0 = n0;
+      c1 = uint32_t(p1);
+      c2 = n2;
+      c3 = uint32_t(p0);
+      k0 += W0;
+      k1 += W1;
+    }
+    a_ctr[0] = c0; a_ctr[1] = c1; a_ctr[2] = c2; a_ctr[3] = c3;
+  }
+
+  //=========================================================================//
+  // "U01": Uniform (0, 1) from 2 Random 32-bit Words:                       //
+  //=========================================================================//
+  // Uses the top 53 bits,  and is offset by 1/2 ULP, so the result is never
+  // exactly 0 or 1 (as required by the log and the inverse normal CDF):
+  //
+  FASTMATH_INLINE double U01(uint32_t a_hi, uint32_t a_lo)
+  {
+    uint64_t x = (uint64_t(a_hi) << 32) | a_lo;
+    return (double(x >> 11) + 0.5) * 0x1.0p-53;
+  }
+
+  //=========================================================================//
+  // "PhiloxNormals": Standard Normal Variates for a Monte Carlo Path:       //
+  //=========================================================================//
+  // Fills "a_z[0 .. a_n-1]" with independent N(0,1) variates for path number
+  // "a_path", using the Box-Muller transform (2 variates per Philox call):
+  //
+  inline void PhiloxNormals
+  (
+    uint64_t a_seed,
+    uint64_t a_path,
+    int      a_n,
+    double*  a_z
+  )
+  {
+    uint32_t const key[2] { uint32_t(a_seed), uint32_t(a_seed >> 32) };
+
+    for (int j = 0; j < a_n; j += 2)
+    {
+      uint32_t ctr[4] { uint32_t(a_path), uint32_t(a_path >> 32),
+                        uint32_t(j),      0U };
+      Philox4x32(ctr, key);
+
+      double r   = sqrt(-2.0 * FastMath::Log(U01(ctr[0], ctr[1])));
+      double phi = 2.0 * M_PI * U01(ctr[2], ctr[3]);
+      a_z[j]     = r * cos(phi);
+      if (j + 1 < a_n)
+        a_z[j+1] = r * sin(phi);
+    }
+  }
+}
+// End namespace RNG
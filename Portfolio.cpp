@@ -0,0 +1,375 @@
+// vim:ts=2:et
+//===========================================================================//
+//                              "Portfolio.cpp":                             //
+//          Portfolio Px and Greeks Aggregation: Implementation              //
+//===========================================================================//
+#include "Portfolio.h"
+#include "FastMath.hpp"
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+namespace BSM
+{
+  namespace
+  {
+    //-----------------------------------------------------------------------//
+    // "PairwiseSum":                                                        //
+    //-----------------------------------------------------------------------//
+    // The result only depends on the values and "a_n" (NOT vectorised, as
+    // that would make it depend on the vector width). The error grows as
+    // O(log n) rather than O(n):
+    //
+    double PairwiseSum(double const* a_x, size_t a_n)
+    {
+      if (a_n <= 16)
+      {
+        double s = 0.0;
+        for (size_t i = 0; i < a_n; ++i)
+          s += a_x[i];
+        return s;
+      }
+      size_t h = a_n / 2;
+      return PairwiseSum(a_x, h) + PairwiseSum(a_x + h, a_n - h);
+    }
+
+    //-----------------------------------------------------------------------//
+    // "LaneSum": Sum of "float"s in "double", for the Mixed Precision:      //
+    //-----------------------------------------------------------------------//
+    // Value "i" goes into the lane (i % 16), each lane is summed sequentially,
+    // and the lanes pairwise. The order of the operations is fixed by the 16
+    // lanes (not by the vector width), so the result is deterministic as well;
+    // and unlike "PairwiseSum", the loop is vectorised (it would otherwise
+    // take as long as the "float" pricing itself). The error is negligible
+    // compared to that of the "float"s:
+    //
+    constexpr size_t NLanes = 16;
+
+    FASTMATH_SIMD_KERNEL
+    double LaneSum(float const* a_x, size_t a_n)
+    {
+      double lanes[NLanes] = {};
+      size_t nFull         = a_n / NLanes * NLanes;
+      for (size_t i = 0; i < nFull; i += NLanes)
+      {
+#       pragma omp simd
+        for (size_t j = 0; j < NLanes; ++j)
+          lanes[j] += double(a_x[i + j]);
+      }
+      for (size_t i = nFull; i < a_n; ++i)
+        lanes[i - nFull] += double(a_x[i]);
+      return PairwiseSum(lanes, NLanes);
+    }
+
+    //-----------------------------------------------------------------------//
+    // "ChunkKernel": Qty-Weighted Pxs and Greeks of a Chunk:                //
+    //-----------------------------------------------------------------------//
+    // For tau > 0 only. The formulas are as in "PxGreeks". The Chunk data
+    // and the per-Bucket terms are in "double"; the rest is in "Real" (with
+    // the "float" overloads of "FastMath" for "float"):
+    //
+    template<typename Real>
+    FASTMATH_SIMD_KERNEL
+    void ChunkKernel
+    (
+      size_t                   a_n,
+      double                   a_tau,
+      double                   a_r,
+      double                   a_D,
+      double                   a_St,
+      double const* __restrict a_K,
+      double const* __restrict a_lnK,
+      double const* __restrict a_sigma,
+      double const* __restrict a_w,
+      double const* __restrict a_qty,
+      Real*         __restrict a_px,
+      Real*         __restrict a_delta,
+      Real*         __restrict a_gamma,
+      Real*         __restrict a_vega,
+      Real*         __restrict a_theta,
+      Real*         __restrict a_rho
+    )
+    {
+      // The per-Bucket terms:
+      double lnSmu   = std::log(a_St) + (a_r - a_D) * a_tau;
+      Real   sqrtTau = Real(std::sqrt(a_tau));
+      Real   dfR     = Real(std::exp(- a_r * a_tau));
+      Real   dfD     = Real(std::exp(- a_D * a_tau));
+      Real   SD      = Real(a_St) * dfD;
+      Real   St2     = Real(a_St * a_St);
+      Real   tau     = Real(a_tau);
+      Real   r       = Real(a_r);
+      Real   D       = Real(a_D);
+
+#     pragma omp simd
+      for (size_t i = 0; i < a_n; ++i)
+      {
+        Real w     = Real(a_w[i]);
+        Real q     = Real(a_qty[i]);
+        Real sig   = Real(a_sigma[i]);
+        Real s     = sig * sqrtTau;
+        // NB: log(St/K) + mu is formed in "double" (cancellation):
+        Real d1    = Real(lnSmu - a_lnK[i]) / s + Real(0.5) * s;
+        Real d2    = d1 - s;
+        Real KD    = Real(a_K[i]) * dfR;
+        Real phi1  = FastMath::Phi(w * d1);
+        Real phi2  = FastMath::Phi(w * d2);
+        Real SDpdf = SD * FastMath::NormPDF(d1);
+
+        a_px   [i] = q * w * (SD * phi1 - KD * phi2);
+        a_delta[i] = q * w * dfD * phi1;
+        a_gamma[i] = q * SDpdf / (St2 * s);
+        a_vega [i] = q * SDpdf * sqrtTau;
+        a_theta[i] = q * (- Real(0.5) * SDpdf * sig / sqrtTau +
+                          w * (D * SD * phi1 - r * KD * phi2));
+        a_rho  [i] = q * w * tau * KD * phi2;
+      }
+    }
+  }
+
+  //=========================================================================//
+  // "Portfolio::Totals::At":                                                //
+  //=========================================================================//
+  Greeks Portfolio::Totals::At(size_t a_i) const
+  {
+    Greeks res;
+    res.m_px    = m_v[0 * m_n + a_i];
+    res.m_delta = m_v[1 * m_n + a_i];
+    res.m_gamma = m_v[2 * m_n + a_i];
+    res.m_vega  = m_v[3 * m_n + a_i];
+    res.m_theta = m_v[4 * m_n + a_i];
+    res.m_rho   = m_v[5 * m_n + a_i];
+    return res;
+  }
+
+  //=========================================================================//
+  // "Portfolio" Non-Default Ctor:                                           //
+  //=========================================================================//
+  Portfolio::Portfolio
+  (
+    size_t          a_n,
+    Position const* a_positions,
+    int             a_nUnds,
+    int             a_nThreads
+  )
+  : m_nUnds(a_nUnds),
+    m_pool (a_nThreads)
+  {
+    //-----------------------------------------------------------------------//
+    // Check the args:                                                       //
+    //-----------------------------------------------------------------------//
+    if (a_nUnds < 0)
+      throw std::invalid_argument("Portfolio: Negative NUnderlyings");
+
+    for (size_t i = 0; i < a_n; ++i)
+    {
+      Position const& p = a_positions[i];
+      if (p.m_und < 0 || p.m_und >= a_nUnds)
+        throw std::invalid_argument("Portfolio: Invalid Underlying Index");
+
+      if (p.m_type != PayoffType::Call && p.m_type != PayoffType::Put)
+        throw std::logic_error("Unsupported PayoffType");
+
+      if (!(p.m_K > 0.0 && p.m_sigma > 0.0))
+        throw std::invalid_argument
+              ("Non-Positive Strike / UnderlyingPx / Vol");
+
+      if (!(std::isfinite(p.m_T) && std::isfinite(p.m_qty)))
+        throw std::invalid_argument("Portfolio: Invalid Expiration / Qty");
+    }
+
+    //-----------------------------------------------------------------------//
+    // Partition into Buckets and Chunks:                                    //
+    //-----------------------------------------------------------------------//
+    // (A stable sort, so the order within each Bucket is that of the input):
+    std::vector<size_t> idx(a_n);
+    std::iota(idx.begin(), idx.end(), size_t(0));
+    std::stable_sort
+    (
+      idx.begin(), idx.end(),
+      [a_positions](size_t a_l, size_t a_r) -> bool
+      {
+        Position const& l = a_positions[a_l];
+        Position const& r = a_positions[a_r];
+        return (l.m_und != r.m_und) ? (l.m_und < r.m_und) : (l.m_T < r.m_T);
+      }
+    );
+
+    std::vector<size_t> chunkPos0;  // The 1st position (in "idx") of Chunks
+    m_undBucket0.assign(size_t(a_nUnds) + 1, 0);
+
+    for (size_t j = 0; j < a_n; )
+    {
+      Position const& p0 = a_positions[idx[j]];
+      size_t          e  = j;
+      while (e < a_n && a_positions[idx[e]].m_und == p0.m_und &&
+                        a_positions[idx[e]].m_T   == p0.m_T)
+        ++e;
+
+      Bucket b { p0.m_und, p0.m_T, m_chunks.size(), 0 };
+      for (size_t c = j; c < e; c += PFChunkSize)
+      {
+        m_chunks.push_back(Chunk{ m_buckets.size(),
+                                  std::min(PFChunkSize, e - c) });
+        chunkPos0.push_back(c);
+        ++b.m_nChunks;
+      }
+      m_buckets.push_back(b);
+      j = e;
+    }
+    // The 1st Bucket of each Underlying (Underlyings without positions get
+    // empty ranges):
+    for (int u = 0, b = 0; u <= a_nUnds; ++u)
+    {
+      while (b < int(m_buckets.size()) && m_buckets[size_t(b)].m_und < u)
+        ++b;
+      m_undBucket0[size_t(u)] = size_t(b);
+    }
+
+    //-----------------------------------------------------------------------//
+    // Lay out the Chunk data, first-touched by the pool:                    //
+    //-----------------------------------------------------------------------//
+    size_t nChunks = m_chunks.size();
+    size_t nVals   = std::max<size_t>(nChunks, 1) * 5 * PFChunkSize;
+    m_data.reset(static_cast<double*>
+                 (::operator new[](nVals * sizeof(double),
+                                   std::align_val_t(4096))));
+    m_pool.Run
+    (
+      nChunks,
+      [&](size_t a_c)
+      {
+        double* K     = m_data.get() + a_c * 5 * PFChunkSize;
+        double* lnK   = K     + PFChunkSize;
+        double* sigma = lnK   + PFChunkSize;
+        double* w     = sigma + PFChunkSize;
+        double* qty   = w     + PFChunkSize;
+        size_t  n     = m_chunks[a_c].m_n;
+        for (size_t i = 0; i < PFChunkSize; ++i)
+        {
+          if (i < n)
+          {
+            Position const& p = a_positions[idx[chunkPos0[a_c] + i]];
+            K    [i] = p.m_K;
+            lnK  [i] = std::log(p.m_K);
+            sigma[i] = p.m_sigma;
+            w    [i] = (p.m_type == PayoffType::Call) ? 1.0 : -1.0;
+            qty  [i] = p.m_qty;
+          }
+          else
+          {
+            // Padding (never used, but initialised):
+            K    [i] = 1.0;
+            lnK  [i] = 0.0;
+            sigma[i] = 1.0;
+            w    [i] = 1.0;
+            qty  [i] = 0.0;
+          }
+        }
+      }
+    );
+
+    m_chunkTots .Resize(nChunks);
+    m_bucketTots.Resize(m_buckets.size());
+    m_undTots   .Resize(size_t(a_nUnds));
+  }
+
+  //=========================================================================//
+  // "Portfolio::Run":                                                       //
+  //=========================================================================//
+  void Portfolio::Run
+  (
+    double        a_r,
+    double        a_t,
+    double const* a_St,
+    double const* a_D,
+    PFPrecision   a_prec
+  )
+  {
+    //-----------------------------------------------------------------------//
+    // Check the args:                                                       //
+    //-----------------------------------------------------------------------//
+    for (int u = 0; u < m_nUnds; ++u)
+      if (!(a_St[u] > 0.0))
+        throw std::invalid_argument
+              ("Non-Positive Strike / UnderlyingPx / Vol");
+
+    for (Bucket const& b: m_buckets)
+      if (b.m_T - a_t < 0.0)
+        throw std::invalid_argument("Negative Time to Expiration");
+
+    //-----------------------------------------------------------------------//
+    // The Chunk Totals (in parallel):                                       //
+    //-----------------------------------------------------------------------//
+    size_t nChunks = m_chunks.size();
+    m_pool.Run
+    (
+      nChunks,
+      [&](size_t a_c)
+      {
+        Chunk  const& ch    = m_chunks[a_c];
+        Bucket const& b     = m_buckets[ch.m_bucket];
+        double        tau   = b.m_T - a_t;
+        double        St    = a_St[b.m_und];
+        double        D     = a_D [b.m_und];
+        double const* K     = m_data.get() + a_c * 5 * PFChunkSize;
+        double const* lnK   = K     + PFChunkSize;
+        double const* sigma = lnK   + PFChunkSize;
+        double const* w     = sigma + PFChunkSize;
+        double const* qty   = w     + PFChunkSize;
+        size_t        n     = ch.m_n;
+
+        alignas(64) double vals[6][PFChunkSize];
+        if (tau > 0.0 && a_prec == PFPrecision::Mixed)
+        {
+          alignas(64) float valsF[6][PFChunkSize];
+          ChunkKernel<float>
+            (n, tau, a_r, D, St, K, lnK, sigma, w, qty,
+             valsF[0], valsF[1], valsF[2], valsF[3], valsF[4], valsF[5]);
+          for (int k = 0; k < 6; ++k)
+            m_chunkTots.Get(k)[a_c] = LaneSum(valsF[k], n);
+          return;
+        }
+        if (tau > 0.0)
+          ChunkKernel<double>
+            (n, tau, a_r, D, St, K, lnK, sigma, w, qty,
+             vals[0], vals[1], vals[2], vals[3], vals[4], vals[5]);
+        else
+          // At expiration time, the PayOff and its Delta (as in "PxGreeks"):
+          for (size_t i = 0; i < n; ++i)
+          {
+            double intr = w[i] * (St - K[i]);
+            vals[0][i]  = qty[i] * std::max(intr, 0.0);
+            vals[1][i]  = qty[i] * ((intr > 0.0) ? w[i] : 0.0);
+            for (int k = 2; k < 6; ++k)
+              vals[k][i] = 0.0;
+          }
+
+        for (int k = 0; k < 6; ++k)
+          m_chunkTots.Get(k)[a_c] = PairwiseSum(vals[k], n);
+      }
+    );
+
+    //-----------------------------------------------------------------------//
+    // Aggregate (sequentially, in a fixed order):                           //
+    //-----------------------------------------------------------------------//
+    for (int k = 0; k < 6; ++k)
+    {
+      for (size_t bi = 0; bi < m_buckets.size(); ++bi)
+        m_bucketTots.Get(k)[bi] =
+          PairwiseSum(m_chunkTots.Get(k) + m_buckets[bi].m_chunk0,
+                      m_buckets[bi].m_nChunks);
+
+      for (int u = 0; u < m_nUnds; ++u)
+        m_undTots.Get(k)[u] =
+          PairwiseSum(m_bucketTots.Get(k) + m_undBucket0[size_t(u)],
+                      m_undBucket0[size_t(u) + 1] - m_undBucket0[size_t(u)]);
+    }
+    Totals all;
+    all.Resize(1);
+    for (int k = 0; k < 6; ++k)
+      all.Get(k)[0] = PairwiseSum(m_undTots.Get(k), size_t(m_nUnds));
+    m_total = all.At(0);
+  }
+}
+// End namespace BSM
@@ -0,0 +1,344 @@
+// vim:ts=2:et
+//===========================================================================//
+//                                  "QMC.cpp":                               //
+//            Sobol Sequences and Brownian Bridge: Implementation            //
+//===========================================================================//
+#include "QMC.h"
+#include "FastMath.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+namespace RNG
+{
+  namespace
+  {
+    //-----------------------------------------------------------------------//
+    // Joe-Kuo Direction Numbers for Dims 2..16:                             //
+    //-----------------------------------------------------------------------//
+    // Degree "s" of the Primitive Polynomial, its inner coeffs "a", and the
+    // initial direction numbers m_1..m_s:
+    //
+    struct JoeKuo
+    {
+      int      m_s;
+      uint32_t m_a;
+      uint32_t m_m[6];
+    };
+
+    constexpr JoeKuo JoeKuoTable[]
+    {
+      { 1,  0, { 1                   } },
+      { 2,  1, { 1, 3                } },
+      { 3,  1, { 1, 3, 1             } },
+      { 3,  2, { 1, 1, 1             } },
+      { 4,  1, { 1, 1, 3, 3          } },
+      { 4,  4, { 1, 3, 5, 13         } },
+      { 5,  2, { 1, 1, 5, 5, 17      } },
+      { 5,  4, { 1, 1, 5, 5, 5       } },
+      { 5,  7, { 1, 1, 7, 11, 19     } },
+      { 5, 11, { 1, 1, 5, 1, 1       } },
+      { 5, 13, { 1, 1, 1, 3, 11      } },
+      { 5, 14, { 1, 3, 5, 5, 31      } },
+      { 6,  1, { 1, 3, 3, 9, 7, 49   } },
+      { 6, 13, { 1, 1, 1, 15, 21, 21 } },
+      { 6, 16, { 1, 3, 1, 13, 27, 49 } }
+    };
+    constexpr int NJoeKuo = int(sizeof(JoeKuoTable) / sizeof(JoeKuo));
+
+    //-----------------------------------------------------------------------//
+    // "SplitMix64": Hash for Seeds and Generated Direction Numbers:         //
+    //-----------------------------------------------------------------------//
+    inline uint64_t SplitMix64(uint64_t a_x)
+    {
+      a_x += 0x9E3779B97F4A7C15ULL;
+      a_x  = (a_x ^ (a_x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+      a_x  = (a_x ^ (a_x >> 27)) * 0x94D049BB133111EBULL;
+      return a_x ^ (a_x >> 31);
+    }
+
+    //-----------------------------------------------------------------------//
+    // Polynomials over GF(2) (as bit masks, degree < 32):                   //
+    //-----------------------------------------------------------------------//
+    // (a_x * a_y) mod a_p, where deg(a_x), deg(a_y) < deg(a_p) = a_s:
+    //
+    uint64_t MulMod(uint64_t a_x, uint64_t a_y, uint64_t a_p, int a_s)
+    {
+      uint64_t res = 0;
+      for (; a_y != 0; a_y >>= 1)
+      {
+        if (a_y & 1)
+          res ^= a_x;
+        a_x <<= 1;
+        if (a_x & (uint64_t(1) << a_s))
+          a_x ^= a_p;
+      }
+      return res;
+    }
+
+    // x^a_e mod a_p:
+    uint64_t PowXMod(uint64_t a_e, uint64_t a_p, int a_s)
+    {
+      uint64_t res  = 1;
+      uint64_t base = (a_s > 1) ? 2 : (2 ^ a_p);  // x mod a_p
+      for (; a_e != 0; a_e >>= 1)
+      {
+        if (a_e & 1)
+          res = MulMod(res, base, a_p, a_s);
+        base = MulMod(base, base, a_p, a_s);
+      }
+      return res;
+    }
+
+    // Whether "a_p" of degree "a_s" is primitive, ie "x" has the multiplic-
+    // ative order 2^s - 1 modulo it:
+    //
+    bool IsPrimitive(uint64_t a_p, int a_s)
+    {
+      uint64_t ord = (uint64_t(1) << a_s) - 1;
+      if (PowXMod(ord, a_p, a_s) != 1)
+        return false;
+
+      // Check all maximal proper divisors ord/q, q being the prime factors:
+      uint64_t rest = ord;
+      for (uint64_t q = 2; q * q <= rest; ++q)
+        if (rest % q == 0)
+        {
+          if (PowXMod(ord / q, a_p, a_s) == 1)
+            return false;
+          while (rest % q == 0)
+            rest /= q;
+        }
+      return (rest == 1 || rest == ord || PowXMod(ord / rest, a_p, a_s) != 1);
+    }
+
+    //-----------------------------------------------------------------------//
+    // Hash-Based Owen Scrambling (Burley 2020):                             //
+    //-----------------------------------------------------------------------//
+    inline uint32_t ReverseBits(uint32_t a_x)
+    {
+      a_x = ((a_x >> 1) & 0x55555555U) | ((a_x & 0x55555555U) << 1);
+      a_x = ((a_x >> 2) & 0x33333333U) | ((a_x & 0x33333333U) << 2);
+      a_x = ((a_x >> 4) & 0x0F0F0F0FU) | ((a_x & 0x0F0F0F0FU) << 4);
+      a_x = ((a_x >> 8) & 0x00FF00FFU) | ((a_x & 0x00FF00FFU) << 8);
+      return (a_x >> 16) | (a_x << 16);
+    }
+
+    // Laine-Karras permutation: each bit is flipped depending only on the
+    // lower bits, ie (after bit reversal) on the higher-order digits:
+    //
+    inline uint32_t OwenScramble(uint32_t a_x, uint32_t a_seed)
+    {
+      uint32_t x = ReverseBits(a_x);
+      x += a_seed;
+      x ^= x * 0x6C50B47CU;
+      x ^= x * 0xB82F1E52U;
+      x ^= x * 0xC7AFE638U;
+      x ^= x * 0x8D22F6E6U;
+      return ReverseBits(x);
+    }
+
+    //-----------------------------------------------------------------------//
+    // "SobolNormals": The Vectorised Kernel:                                //
+    //-----------------------------------------------------------------------//
+    FASTMATH_SIMD_KERNEL
+    void SobolNormals
+    (
+      int                      a_dims,
+      bool                     a_scramble,
+      uint32_t const* __restrict a_x,
+      uint32_t const* __restrict a_seeds,
+      double*         __restrict a_z
+    )
+    {
+#     pragma omp simd
+      for (int d = 0; d < a_dims; ++d)
+      {
+        uint32_t x = a_scramble ? OwenScramble(a_x[d], a_seeds[d]) : a_x[d];
+        double   u = (double(x) + 0.5) * 0x1.0p-32;
+        a_z[d]     = FastMath::InvPhi(u);
+      }
+    }
+  }
+
+  //=========================================================================//
+  // "Sobol" Non-Default Ctor:                                               //
+  //=========================================================================//
+  Sobol::Sobol(int a_dims, uint64_t a_seed, bool a_scramble)
+  : m_dims    (a_dims),
+    m_scramble(a_scramble),
+    m_dirs    (),
+    m_seeds   ()
+  {
+    if (a_dims <= 0)
+      throw std::invalid_argument("Sobol: Non-Positive Dims");
+
+    m_dirs .resize(size_t(a_dims) * Bits);
+    m_seeds.resize(size_t(a_dims));
+
+    // Dim 1: the van der Corput sequence, v_k = 2^(-k):
+    for (int k = 0; k < Bits; ++k)
+      m_dirs[size_t(k)] = uint32_t(1) << (Bits - 1 - k);
+
+    // Other dims:
+    int      s = 1;   // Degree of the current Primitive Polynomial
+    uint32_t a = 0;   // Its inner coeffs
+    for (int d = 1; d < a_dims; ++d)
+    {
+      uint32_t m[Bits];
+      if (d <= NJoeKuo)
+      {
+        JoeKuo const& jk = JoeKuoTable[d-1];
+        s = jk.m_s;
+        a = jk.m_a;
+        for (int k = 0; k < s; ++k)
+          m[k] = jk.m_m[k];
+      }
+      else
+      {
+        // Next Primitive Polynomial (by degree, then by "a"):
+        do
+        {
+          ++a;
+          if (a >= (uint32_t(1) << (s - 1)))
+          {
+            ++s;
+            a = 0;
+          }
+        }
+        while (!IsPrimitive((uint64_t(1) << s) | (uint64_t(a) << 1) | 1, s));
+
+        if (s > Bits)
+          throw std::invalid_argument("Sobol: Too Many Dims");
+
+        // Initial direction numbers: any odd m_k < 2^k:
+        for (int k = 0; k < s; ++k)
+        {
+          uint64_t h = SplitMix64((uint64_t(d) << 32) | uint64_t(k));
+          m[k]       = (uint32_t(h) & ((uint32_t(2) << k) - 1)) | 1;
+        }
+      }
+
+      // The recurrence (Bratley-Fox): v_k = m_k / 2^k:
+      uint32_t* v = m_dirs.data() + size_t(d) * Bits;
+      for (int k = 0; k < std::min(s, Bits); ++k)
+        v[k] = m[k] << (Bits - 1 - k);
+
+      for (int k = s; k < Bits; ++k)
+      {
+        v[k] = v[k-s] ^ (v[k-s] >> s);
+        for (int j = 1; j < s; ++j)
+          if ((a >> (s - 1 - j)) & 1)
+            v[k] ^= v[k-j];
+      }
+    }
+
+    // Transpose to [Bit][Dim], so that "Next" accesses contiguous memory:
+    std::vector<uint32_t> tr(m_dirs.size());
+    for (int d = 0; d < a_dims; ++d)
+      for (int k = 0; k < Bits; ++k)
+        tr[size_t(k) * size_t(a_dims) + size_t(d)] =
+          m_dirs[size_t(d) * Bits + size_t(k)];
+    m_dirs.swap(tr);
+
+    // Scrambling Seeds:
+    for (int d = 0; d < a_dims; ++d)
+      m_seeds[size_t(d)] =
+        uint32_t(SplitMix64(a_seed ^ SplitMix64(uint64_t(d))));
+  }
+
+  //=========================================================================//
+  // "Sobol::Seek":                                                          //
+  //=========================================================================//
+  void Sobol::Seek(uint64_t a_n, uint32_t* a_x) const
+  {
+    if (a_n >= (uint64_t(1) << Bits))
+      throw std::invalid_argument("Sobol::Seek: Index Too Large");
+
+    // The Gray code of "a_n" selects the direction numbers to be XORed:
+    uint64_t g = a_n ^ (a_n >> 1);
+    for (int d = 0; d < m_dims; ++d)
+      a_x[d] = 0;
+    for (int k = 0; g != 0; ++k, g >>= 1)
+      if (g & 1)
+      {
+        uint32_t const* v = m_dirs.data() + size_t(k) * size_t(m_dims);
+        for (int d = 0; d < m_dims; ++d)
+          a_x[d] ^= v[d];
+      }
+  }
+
+  //=========================================================================//
+  // "Sobol::Normals":                                                       //
+  //=========================================================================//
+  void Sobol::Normals(uint32_t const* a_x, double* a_z) const
+    { SobolNormals(m_dims, m_scramble, a_x, m_seeds.data(), a_z); }
+
+  //=========================================================================//
+  // "BrownianBridge" Non-Default Ctor:                                      //
+  //=========================================================================//
+  BrownianBridge::BrownianBridge(int a_nSteps)
+  : m_nSteps(a_nSteps),
+    m_idx   (size_t(a_nSteps)),
+    m_left  (size_t(a_nSteps)),
+    m_right (size_t(a_nSteps)),
+    m_wl    (size_t(a_nSteps)),
+    m_wr    (size_t(a_nSteps)),
+    m_sd    (size_t(a_nSteps))
+  {
+    if (a_nSteps <= 0)
+      throw std::invalid_argument("BrownianBridge: Non-Positive NSteps");
+
+    // Stage 0: the terminal point, W(n) = sqrt(n) * z[0]:
+    m_idx  [0] = a_nSteps;
+    m_left [0] = 0;
+    m_right[0] = 0;
+    m_wl   [0] = 0.0;
+    m_wr   [0] = 0.0;
+    m_sd   [0] = sqrt(double(a_nSteps));
+
+    // Then bisect the intervals breadth-first, so that the coarse structure
+    // is constructed first. "intervals" is used as a FIFO queue:
+    std::vector<std::pair<int, int>> intervals { { 0, a_nSteps } };
+    int stage = 1;
+    for (size_t q = 0; q < intervals.size(); ++q)
+    {
+      auto [l, r] = intervals[q];
+      if (r - l < 2)
+        continue;
+      int    mid = l + (r - l) / 2;
+      double len = double(r - l);
+      m_idx  [size_t(stage)] = mid;
+      m_left [size_t(stage)] = l;
+      m_right[size_t(stage)] = r;
+      m_wl   [size_t(stage)] = double(r - mid) / len;
+      m_wr   [size_t(stage)] = double(mid - l) / len;
+      m_sd   [size_t(stage)] = sqrt(double(mid - l) * double(r - mid) / len);
+      ++stage;
+      intervals.emplace_back(l,   mid);
+      intervals.emplace_back(mid, r);
+    }
+  }
+
+  //=========================================================================//
+  // "BrownianBridge::Build":                                                //
+  //=========================================================================//
+  void BrownianBridge::Build(double const* a_z, double* a_w, double* a_dw)
+  const
+  {
+    a_w[0]        = 0.0;
+    a_w[m_nSteps] = m_sd[0] * a_z[0];
+
+    for (int i = 1; i < m_nSteps; ++i)
+      a_w[m_idx[size_t(i)]] =
+        m_wl[size_t(i)] * a_w[m_left [size_t(i)]] +
+        m_wr[size_t(i)] * a_w[m_right[size_t(i)]] +
+        m_sd[size_t(i)] * a_z[i];
+
+#   pragma omp simd
+    for (int k = 0; k < m_nSteps; ++k)
+      a_dw[k] = a_w[k+1] - a_w[k];
+  }
+}
+// End namespace RNG
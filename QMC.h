@@ -0,0 +1,108 @@
+// vim:ts=2:et
+//===========================================================================//
+//                                   "QMC.h":                                //
+//         Quasi-Monte Carlo: Sobol Sequences and the Brownian Bridge        //
+//===========================================================================//
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace RNG
+{
+  //=========================================================================//
+  // "Sobol" Class: Sobol Low-Discrepancy Sequence:                          //
+  //=========================================================================//
+  // Points in [0, 1)^Dims,  generated in the Gray-code order (Antonov-Saleev)
+  // with 32-bit direction numbers, so up to 2^32 points are available.
+  // Direction numbers: for dims 1..16, those of S.Joe and F.Y.Kuo  ("new-joe-
+  // kuo-6.21201"); beyond that, the primitive polynomials are enumerated in
+  // the same order, and the initial direction numbers m_k (odd, < 2^k) are
+  // generated deterministically -- still a valid (t,s)-sequence, but without
+  // the optimised 2D projections.
+  // Optional scrambling: the hash-based approximation of Owen's nested uni-
+  // form scrambling (B.Burley, "Practical Hash-based Owen Scrambling", JCGT
+  // 2020), with independent per-dimension seeds derived from "a_seed". It
+  // preserves the net properties, and makes the estimator unbiased.
+  // The output is randomised by 1/2 of the last bit, so never exactly 0 or 1.
+  // The object is immutable after construction, so it can be shared by many
+  // threads (each one keeping its own current point "a_x"):
+  //
+  class Sobol
+  {
+  public:
+    constexpr static int Bits = 32;
+
+  private:
+    //-----------------------------------------------------------------------//
+    // Data Flds:                                                            //
+    //-----------------------------------------------------------------------//
+    int                   m_dims;
+    bool                  m_scramble;
+    std::vector<uint32_t> m_dirs;   // [Bits][m_dims]:  Direction Numbers
+    std::vector<uint32_t> m_seeds;  // [m_dims]: Scrambling Seeds
+
+  public:
+    //-----------------------------------------------------------------------//
+    // Non-Default Ctor:                                                     //
+    //-----------------------------------------------------------------------//
+    Sobol(int a_dims, uint64_t a_seed = 0, bool a_scramble = true);
+
+    int Dims() const { return m_dims; }
+
+    //-----------------------------------------------------------------------//
+    // Generation:                                                           //
+    //-----------------------------------------------------------------------//
+    // "Seek": Computes (directly) the integer point No "a_n" into "a_x":
+    void Seek(uint64_t a_n, uint32_t* a_x) const;
+
+    // "Next": Given the point No "a_n" in "a_x", moves it to No (a_n+1):
+    // (the Gray codes of n and n+1 differ in the lowest 0 bit of n only):
+    void Next(uint64_t a_n, uint32_t* a_x) const
+    {
+      int             b = __builtin_ctzll(~a_n);
+      uint32_t const* v = m_dirs.data() + size_t(b) * size_t(m_dims);
+      for (int d = 0; d < m_dims; ++d)
+        a_x[d] ^= v[d];
+    }
+
+    // "Normals": Transforms the integer point "a_x" into N(0,1) variates
+    // "a_z" (scrambling it first if configured), via the inverse Normal CDF:
+    void Normals(uint32_t const* a_x, double* a_z) const;
+  };
+
+  //=========================================================================//
+  // "BrownianBridge" Class:                                                 //
+  //=========================================================================//
+  // With QMC, the first dimensions of a point are much better distributed
+  // than the later ones. The Brownian Bridge construction uses "a_z[0]" for
+  // the terminal value of the Brownian motion, "a_z[1]" for the mid-point
+  // (conditional on the ends), and so on by bisection,  so the  most important
+  // (large-scale) features of the path come from the first dimensions.
+  // The time grid is 0, 1, .., NSteps (scaling is the caller's business):
+  //
+  class BrownianBridge
+  {
+  private:
+    int                 m_nSteps;
+    std::vector<int>    m_idx;      // Point to construct at each stage
+    std::vector<int>    m_left;     // Its left  neighbour (already known)
+    std::vector<int>    m_right;    // Its right neighbour (already known)
+    std::vector<double> m_wl;       // Weights of the neighbours
+    std::vector<double> m_wr;
+    std::vector<double> m_sd;       // Conditional StdDev
+
+  public:
+    explicit BrownianBridge(int a_nSteps);
+
+    int NSteps() const { return m_nSteps; }
+
+    // "Build": From "a_z[0 .. NSteps-1]" (independent N(0,1)), computes the
+    // increments "a_dw[0 .. NSteps-1]" of the Brownian motion over the unit
+    // steps (again independent N(0,1), but now re-ordered by importance);
+    // "a_w" is a work buffer of size (NSteps + 1):
+    //
+    void Build(double const* a_z, double* a_w, double* a_dw) const;
+  };
+}
+// End namespace RNG
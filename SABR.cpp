@@ -0,0 +1,534 @@
+// vim:ts=2:et
+//===========================================================================//
+//                                 "SABR.cpp":                               //
+//       SABR Implied Vols (Hagan / Obloj), Vectorised, and Calibration      //
+//===========================================================================//
+#include "SABR.h"
+#include "FastMath.hpp"
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+namespace BSM
+{
+  namespace
+  {
+    //=======================================================================//
+    // "Dual3": Forward-Mode Derivatives in (alpha, rho, nu):                //
+    //=======================================================================//
+    // Scalar flds (not an array), so that the vectoriser can keep each of
+    // them in a register:
+    //
+    struct Dual3
+    {
+      double m_v;
+      double m_d0;
+      double m_d1;
+      double m_d2;
+
+      Dual3(double a_v = 0.0, double a_d0 = 0.0, double a_d1 = 0.0,
+            double a_d2 = 0.0)
+      : m_v(a_v), m_d0(a_d0), m_d1(a_d1), m_d2(a_d2) {}
+    };
+
+    FASTMATH_INLINE Dual3 operator+(Dual3 const& a_x, Dual3 const& a_y)
+      { return Dual3(a_x.m_v  + a_y.m_v,  a_x.m_d0 + a_y.m_d0,
+                     a_x.m_d1 + a_y.m_d1, a_x.m_d2 + a_y.m_d2); }
+
+    FASTMATH_INLINE Dual3 operator-(Dual3 const& a_x, Dual3 const& a_y)
+      { return Dual3(a_x.m_v  - a_y.m_v,  a_x.m_d0 - a_y.m_d0,
+                     a_x.m_d1 - a_y.m_d1, a_x.m_d2 - a_y.m_d2); }
+
+    FASTMATH_INLINE Dual3 operator*(Dual3 const& a_x, Dual3 const& a_y)
+      { return Dual3(a_x.m_v * a_y.m_v,
+                     a_x.m_d0 * a_y.m_v + a_x.m_v * a_y.m_d0,
+                     a_x.m_d1 * a_y.m_v + a_x.m_v * a_y.m_d1,
+                     a_x.m_d2 * a_y.m_v + a_x.m_v * a_y.m_d2); }
+
+    FASTMATH_INLINE Dual3 operator/(Dual3 const& a_x, Dual3 const& a_y)
+    {
+      double q = a_x.m_v / a_y.m_v;
+      double r = 1.0 / a_y.m_v;
+      return Dual3(q, (a_x.m_d0 - q * a_y.m_d0) * r,
+                      (a_x.m_d1 - q * a_y.m_d1) * r,
+                      (a_x.m_d2 - q * a_y.m_d2) * r);
+    }
+
+    FASTMATH_INLINE double Val(double       a_x) { return a_x;     }
+    FASTMATH_INLINE double Val(Dual3 const& a_x) { return a_x.m_v; }
+
+    FASTMATH_INLINE double Log (double a_x) { return FastMath::Log(a_x); }
+    FASTMATH_INLINE double Sqrt(double a_x) { return std::sqrt(a_x);     }
+
+    FASTMATH_INLINE Dual3  Log (Dual3 const& a_x)
+    {
+      double r = 1.0 / a_x.m_v;
+      return Dual3(FastMath::Log(a_x.m_v),
+                   a_x.m_d0 * r, a_x.m_d1 * r, a_x.m_d2 * r);
+    }
+
+    FASTMATH_INLINE Dual3  Sqrt(Dual3 const& a_x)
+    {
+      double s = std::sqrt(a_x.m_v);
+      double h = 0.5 / s;
+      return Dual3(s, a_x.m_d0 * h, a_x.m_d1 * h, a_x.m_d2 * h);
+    }
+
+    FASTMATH_INLINE double Select(bool a_c, double a_x, double a_y)
+      { return a_c ? a_x : a_y; }
+
+    FASTMATH_INLINE Dual3  Select(bool a_c, Dual3 const& a_x,
+                                  Dual3 const& a_y)
+      { return Dual3(a_c ? a_x.m_v  : a_y.m_v,  a_c ? a_x.m_d0 : a_y.m_d0,
+                     a_c ? a_x.m_d1 : a_y.m_d1, a_c ? a_x.m_d2 : a_y.m_d2); }
+
+    //-----------------------------------------------------------------------//
+    // "ZOverX": z / x(z),  x(z) = log((sqrt(1 - 2 rho z + z^2) + z - rho) / //
+    // (1 - rho)), with the 2nd-order series near z = 0:                     //
+    //-----------------------------------------------------------------------//
+    template<typename Real>
+    FASTMATH_INLINE Real ZOverX(Real const& a_z, Real const& a_rho)
+    {
+      Real one(1.0);
+      Real D  = Sqrt(one - Real(2.0) * a_rho * a_z + a_z * a_z);
+      Real x  = Log((D + a_z - a_rho) / (one - a_rho));
+      Real s  = one - Real(0.5) * a_rho * a_z +
+                (Real(2.0) - Real(3.0) * a_rho * a_rho) * a_z * a_z /
+                Real(12.0);
+      return Select(std::fabs(Val(a_z)) < 1e-4, s, a_z / x);
+    }
+
+    //-----------------------------------------------------------------------//
+    // "Sigma1": The O(tau) Correction Coeff:                                //
+    //-----------------------------------------------------------------------//
+    template<typename Real>
+    FASTMATH_INLINE Real Sigma1
+    (
+      Real const& a_alpha,
+      Real const& a_rho,
+      Real const& a_nu,
+      double      a_beta,
+      double      a_FKb     // (F K)^((1 - beta) / 2)
+    )
+    {
+      double omb = 1.0 - a_beta;
+      return Real(omb * omb / (24.0 * a_FKb * a_FKb)) * a_alpha * a_alpha +
+             Real(0.25 * a_beta / a_FKb) * a_rho * a_nu * a_alpha +
+             (Real(2.0) - Real(3.0) * a_rho * a_rho) * a_nu * a_nu /
+             Real(24.0);
+    }
+
+    //-----------------------------------------------------------------------//
+    // "HaganVol" and "ObljVol": One Strike:                                 //
+    //-----------------------------------------------------------------------//
+    template<typename Real>
+    FASTMATH_INLINE Real HaganVol
+    (
+      Real const& a_alpha,
+      Real const& a_rho,
+      Real const& a_nu,
+      double      a_beta,
+      double      a_logF,
+      double      a_tau,
+      double      a_K
+    )
+    {
+      double lK  = FastMath::Log(a_K);
+      double lf  = a_logF - lK;
+      double omb = 1.0 - a_beta;
+      double FKb = FastMath::Exp(0.5 * omb * (a_logF + lK));
+      double l2  = lf * lf;
+      double ob2 = omb * omb;
+      double den =
+        FKb * (1.0 + ob2 * l2 / 24.0 + ob2 * ob2 * l2 * l2 / 1920.0);
+
+      Real z   = a_nu / a_alpha * Real(FKb * lf);
+      Real s1  = Sigma1(a_alpha, a_rho, a_nu, a_beta, FKb);
+      return a_alpha * Real(1.0 / den) * ZOverX(z, a_rho) *
+             (Real(1.0) + s1 * Real(a_tau));
+    }
+
+    template<typename Real>
+    FASTMATH_INLINE Real ObljVol
+    (
+      Real const& a_alpha,
+      Real const& a_rho,
+      Real const& a_nu,
+      double      a_beta,
+      double      a_logF,
+      double      a_tau,
+      double      a_K
+    )
+    {
+      double lK  = FastMath::Log(a_K);
+      double lf  = a_logF - lK;
+      double omb = 1.0 - a_beta;
+      double FKb = FastMath::Exp(0.5 * omb * (a_logF + lK));
+      double Kb  = FastMath::Exp(omb * lK);     // K^(1 - beta)
+
+      // g = u / (e^u - 1), u = (1 - beta) log(F/K), so that
+      // (F^(1-beta) - K^(1-beta)) / (1 - beta) = K^(1-beta) * lf / g:
+      double u   = omb * lf;
+      double u2  = u * u;
+      double g   = (std::fabs(u) < 1e-3)
+                   ? 1.0 - 0.5 * u + u2 / 12.0 - u2 * u2 / 720.0
+                   : u / (FastMath::Exp(u) - 1.0);
+
+      Real z   = a_nu / a_alpha * Real(Kb * lf / g);
+      Real s1  = Sigma1(a_alpha, a_rho, a_nu, a_beta, FKb);
+      return a_alpha * Real(g / Kb) * ZOverX(z, a_rho) *
+             (Real(1.0) + s1 * Real(a_tau));
+    }
+
+    //-----------------------------------------------------------------------//
+    // The Kernels:                                                          //
+    //-----------------------------------------------------------------------//
+    FASTMATH_SIMD_KERNEL
+    void VolKernel
+    (
+      bool                     a_obloj,
+      double                   a_alpha,
+      double                   a_beta,
+      double                   a_rho,
+      double                   a_nu,
+      double                   a_logF,
+      double                   a_tau,
+      size_t                   a_n,
+      double const* __restrict a_K,
+      double*       __restrict a_sigma
+    )
+    {
+      if (a_obloj)
+      {
+#       pragma omp simd
+        for (size_t i = 0; i < a_n; ++i)
+          a_sigma[i] = ObljVol<double>
+            (a_alpha, a_rho, a_nu, a_beta, a_logF, a_tau, a_K[i]);
+      }
+      else
+      {
+#       pragma omp simd
+        for (size_t i = 0; i < a_n; ++i)
+          a_sigma[i] = HaganVol<double>
+            (a_alpha, a_rho, a_nu, a_beta, a_logF, a_tau, a_K[i]);
+      }
+    }
+
+    FASTMATH_SIMD_KERNEL
+    void VolJacKernel
+    (
+      bool                     a_obloj,
+      double                   a_alpha,
+      double                   a_beta,
+      double                   a_rho,
+      double                   a_nu,
+      double                   a_logF,
+      double                   a_tau,
+      size_t                   a_n,
+      double const* __restrict a_K,
+      double*       __restrict a_sigma,
+      double*       __restrict a_dAlpha,
+      double*       __restrict a_dRho,
+      double*       __restrict a_dNu
+    )
+    {
+      Dual3 alpha(a_alpha, 1.0, 0.0, 0.0);
+      Dual3 rho  (a_rho,   0.0, 1.0, 0.0);
+      Dual3 nu   (a_nu,    0.0, 0.0, 1.0);
+
+      if (a_obloj)
+      {
+#       pragma omp simd
+        for (size_t i = 0; i < a_n; ++i)
+        {
+          Dual3 s = ObljVol<Dual3>
+            (alpha, rho, nu, a_beta, a_logF, a_tau, a_K[i]);
+          a_sigma [i] = s.m_v;
+          a_dAlpha[i] = s.m_d0;
+          a_dRho  [i] = s.m_d1;
+          a_dNu   [i] = s.m_d2;
+        }
+      }
+      else
+      {
+#       pragma omp simd
+        for (size_t i = 0; i < a_n; ++i)
+        {
+          Dual3 s = HaganVol<Dual3>
+            (alpha, rho, nu, a_beta, a_logF, a_tau, a_K[i]);
+          a_sigma [i] = s.m_v;
+          a_dAlpha[i] = s.m_d0;
+          a_dRho  [i] = s.m_d1;
+          a_dNu   [i] = s.m_d2;
+        }
+      }
+    }
+
+    //-----------------------------------------------------------------------//
+    // "CheckArgs":                                                          //
+    //-----------------------------------------------------------------------//
+    void CheckArgs
+    (
+      SABRParams const& a_params,
+      SABRFormula       a_formula,
+      double            a_F,
+      double            a_tau,
+      size_t            a_n,
+      double const*     a_K
+    )
+    {
+      if (!(a_params.m_alpha > 0.0 && a_params.m_beta >= 0.0 &&
+            a_params.m_beta  <= 1.0 && std::fabs(a_params.m_rho) < 1.0 &&
+            a_params.m_nu    >= 0.0 && std::isfinite(a_params.m_alpha) &&
+            std::isfinite(a_params.m_nu)))
+        throw std::invalid_argument("Invalid SABR Params");
+
+      if (a_formula != SABRFormula::Hagan && a_formula != SABRFormula::Obloj)
+        throw std::invalid_argument("Invalid SABRFormula");
+
+      if (a_tau < 0.0)
+        throw std::invalid_argument("Negative Time to Expiration");
+
+      if (!(a_F > 0.0))
+        throw std::invalid_argument
+              ("Non-Positive Strike / UnderlyingPx / Vol");
+
+      for (size_t i = 0; i < a_n; ++i)
+        if (!(a_K[i] > 0.0))
+          throw std::invalid_argument
+                ("Non-Positive Strike / UnderlyingPx / Vol");
+    }
+  }
+
+  //=========================================================================//
+  // "SABRVols":                                                             //
+  //=========================================================================//
+  void SABRVols
+  (
+    SABRParams const& a_params,
+    SABRFormula       a_formula,
+    double            a_F,
+    double            a_tau,
+    size_t            a_n,
+    double const*     a_K,
+    double*           a_sigma,
+    double*           a_dAlpha,
+    double*           a_dRho,
+    double*           a_dNu
+  )
+  {
+    CheckArgs(a_params, a_formula, a_F, a_tau, a_n, a_K);
+
+    bool jac = (a_dAlpha != nullptr);
+    if (jac != (a_dRho != nullptr) || jac != (a_dNu != nullptr))
+      throw std::invalid_argument("SABRVols: Some Derivative Ptrs are NULL");
+
+    bool   obloj = (a_formula == SABRFormula::Obloj);
+    double logF  = std::log(a_F);
+    if (jac)
+      VolJacKernel
+        (obloj, a_params.m_alpha, a_params.m_beta, a_params.m_rho,
+         a_params.m_nu, logF, a_tau, a_n, a_K, a_sigma, a_dAlpha, a_dRho,
+         a_dNu);
+    else
+      VolKernel
+        (obloj, a_params.m_alpha, a_params.m_beta, a_params.m_rho,
+         a_params.m_nu, logF, a_tau, a_n, a_K, a_sigma);
+  }
+
+  double SABRVol
+  (
+    SABRParams const& a_params,
+    SABRFormula       a_formula,
+    double            a_F,
+    double            a_tau,
+    double            a_K
+  )
+  {
+    double sigma;
+    SABRVols(a_params, a_formula, a_F, a_tau, 1, &a_K, &sigma);
+    return sigma;
+  }
+
+  //=========================================================================//
+  // "SABRCalibrate":                                                        //
+  //=========================================================================//
+  LMRes SABRCalibrate
+  (
+    SABRFormula       a_formula,
+    double            a_F,
+    double            a_tau,
+    size_t            a_n,
+    double const*     a_K,
+    double const*     a_vol,
+    double const*     a_weight,
+    SABRParams*       a_params,
+    LMParams const&   a_lmParams
+  )
+  {
+    //-----------------------------------------------------------------------//
+    // Check the args:                                                       //
+    //-----------------------------------------------------------------------//
+    constexpr size_t NP = 3;
+    if (a_n < NP)
+      throw std::invalid_argument("SABRCalibrate: Too Few Quotes");
+
+    double beta = a_params->m_beta;
+    if (!(beta >= 0.0 && beta <= 1.0))
+      throw std::invalid_argument("Invalid SABR Params");
+
+    if (!(a_tau > 0.0))
+      throw std::invalid_argument
+            ("SABRCalibrate: Non-Positive Time to Expiration");
+
+    // (F is used for the bounds below, before any "SABRVols" call):
+    if (!(a_F > 0.0 && std::isfinite(a_F)))
+      throw std::invalid_argument("Non-Positive Strike / UnderlyingPx / Vol");
+
+    for (size_t i = 0; i < a_n; ++i)
+    {
+      if (!(a_K[i] > 0.0 && a_vol[i] > 0.0))
+        throw std::invalid_argument
+              ("Non-Positive Strike / UnderlyingPx / Vol");
+      if (a_weight != nullptr &&
+          !(a_weight[i] >= 0.0 && std::isfinite(a_weight[i])))
+        throw std::invalid_argument("SABRCalibrate: Invalid Weight");
+    }
+
+    //-----------------------------------------------------------------------//
+    // Bounds and initial guess:                                             //
+    //-----------------------------------------------------------------------//
+    // x = (alpha, rho, nu); alpha is bounded by a 2000% ATM vol:
+    double Fb     = std::pow(a_F, 1.0 - beta);
+    double lo[NP] = { 1e-8,      -0.9999,  0.0 };
+    double hi[NP] = { 20.0 * Fb,  0.9999, 20.0 };
+    double x [NP];
+
+    SABRParams& p = *a_params;
+    if (p.m_alpha > 0.0 && std::isfinite(p.m_alpha) &&
+        std::fabs(p.m_rho) < 1.0 && p.m_nu >= 0.0 && std::isfinite(p.m_nu))
+    {
+      x[0] = p.m_alpha;
+      x[1] = p.m_rho;
+      x[2] = p.m_nu;
+    }
+    else
+    {
+      // The ATM vol, linearly interpolated in K (flat beyond the quotes):
+      std::vector<size_t> order(a_n);
+      std::iota(order.begin(), order.end(), size_t(0));
+      std::sort(order.begin(), order.end(),
+                [a_K](size_t a_i, size_t a_j) { return a_K[a_i] < a_K[a_j]; });
+
+      double atm = a_vol[order[0]];
+      if (a_K[order[a_n - 1]] <= a_F)
+        atm = a_vol[order[a_n - 1]];
+      else if (a_K[order[0]] < a_F)
+        for (size_t i = 1; i < a_n; ++i)
+        {
+          size_t j0 = order[i - 1];
+          size_t j1 = order[i];
+          if (a_K[j1] >= a_F)
+          {
+            double u = (a_F - a_K[j0]) / (a_K[j1] - a_K[j0]);
+            atm      = (1.0 - u) * a_vol[j0] + u * a_vol[j1];
+            break;
+          }
+        }
+      x[0] = atm * Fb;
+      x[1] = 0.0;
+      x[2] = 0.5;
+    }
+    for (size_t i = 0; i < NP; ++i)
+      x[i] = std::clamp(x[i], lo[i], hi[i]);
+
+    //-----------------------------------------------------------------------//
+    // Residuals and the analytic Jacobian:                                  //
+    //-----------------------------------------------------------------------//
+    std::vector<double> sigma(a_n);
+    std::vector<double> dA   (a_n);
+    std::vector<double> dR   (a_n);
+    std::vector<double> dN   (a_n);
+
+    auto wgt = [a_weight](size_t a_i)
+               { return (a_weight != nullptr) ? a_weight[a_i] : 1.0; };
+
+    LMResidFunc resid =
+      [&](double const* a_x, double* a_r)
+      {
+        SABRParams q{a_x[0], beta, a_x[1], a_x[2]};
+        SABRVols(q, a_formula, a_F, a_tau, a_n, a_K, sigma.data());
+        for (size_t i = 0; i < a_n; ++i)
+          a_r[i] = wgt(i) * (sigma[i] - a_vol[i]);
+      };
+
+    LMJacFunc jac =
+      [&](double const* a_x, double const*, double* a_J)
+      {
+        SABRParams q{a_x[0], beta, a_x[1], a_x[2]};
+        SABRVols(q, a_formula, a_F, a_tau, a_n, a_K, sigma.data(),
+                 dA.data(), dR.data(), dN.data());
+        for (size_t i = 0; i < a_n; ++i)
+        {
+          a_J[i * NP]     = wgt(i) * dA[i];
+          a_J[i * NP + 1] = wgt(i) * dR[i];
+          a_J[i * NP + 2] = wgt(i) * dN[i];
+        }
+      };
+
+    LMRes res = LevenbergMarquardt(NP, a_n, x, lo, hi, resid, jac, a_lmParams);
+
+    p.m_alpha = x[0];
+    p.m_rho   = x[1];
+    p.m_nu    = x[2];
+    return res;
+  }
+
+  //=========================================================================//
+  // "SABRPxBatch":                                                          //
+  //=========================================================================//
+  template<typename CDF>
+  void SABRPxBatch
+  (
+    SABRParams const& a_params,
+    SABRFormula       a_formula,
+    PayoffType        a_type,
+    double            a_T,
+    double            a_r,
+    double            a_D,
+    double            a_t,
+    double            a_St,
+    size_t            a_n,
+    double const*     a_K,
+    double*           a_px
+  )
+  {
+    double tau = a_T - a_t;
+    if (!(a_St > 0.0))
+      throw std::invalid_argument("Non-Positive Strike / UnderlyingPx / Vol");
+
+    std::vector<double> sigma(a_n);
+    std::vector<double> T    (a_n, a_T);
+    std::vector<double> St   (a_n, a_St);
+    SABRVols(a_params, a_formula, a_St * std::exp((a_r - a_D) * tau), tau,
+             a_n, a_K, sigma.data());
+    PxBatch<CDF>
+      (a_type, a_n, a_K, T.data(), a_r, a_D, sigma.data(), a_t, St.data(),
+       a_px);
+  }
+
+  //-------------------------------------------------------------------------//
+  // Explicit Instantiations:                                                //
+  //-------------------------------------------------------------------------//
+# define SABR_INSTANTIATE(CDF)                                                 \
+  template void SABRPxBatch<CDF>                                               \
+    (SABRParams const&, SABRFormula, PayoffType, double, double, double,       \
+     double, double, size_t, double const*, double*);
+
+  SABR_INSTANTIATE(CDFErf)
+  SABR_INSTANTIATE(CDFCody)
+  SABR_INSTANTIATE(CDFFast)
+# undef SABR_INSTANTIATE
+}
+// End namespace BSM
@@ -0,0 +1,118 @@
+// vim:ts=2:et
+//===========================================================================//
+//                                  "SABR.h":                                //
+//       SABR Implied Vols (Hagan / Obloj), Vectorised, and Calibration      //
+//===========================================================================//
+#pragma once
+#include "BSM.h"
+#include "Calibration.h"
+#include <cstddef>
+
+namespace BSM
+{
+  //-------------------------------------------------------------------------//
+  // "SABRParams":                                                           //
+  //-------------------------------------------------------------------------//
+  //   dF = alpha_t F^beta dW1,  d alpha_t = nu alpha_t dW2,  dW1 dW2 = rho dt,
+  // with alpha_0 = m_alpha:
+  //
+  struct SABRParams
+  {
+    double m_alpha = NAN;   // > 0
+    double m_beta  = NAN;   // in [0, 1]; normally fixed, not calibrated
+    double m_rho   = NAN;   // in (-1, 1)
+    double m_nu    = NAN;   // >= 0
+  };
+
+  //-------------------------------------------------------------------------//
+  // "SABRFormula": The Lognormal Implied Vol Approximation:                 //
+  //-------------------------------------------------------------------------//
+  // Both include the O(tau) correction (1 + sigma1 * tau) of Hagan et al:
+  //
+  enum class SABRFormula: int
+  {
+    Hagan = 0,  // Hagan et al (2002), with the log-moneyness series
+    Obloj = 1   // Obloj (2008): the leading term is exact in the wings
+  };
+
+  //-------------------------------------------------------------------------//
+  // "SABRVols": Implied Vols for a Whole Strike Grid (one expiry):          //
+  //-------------------------------------------------------------------------//
+  // The loop over the Strikes is vectorised  (the "FastMath" kernels; AVX-
+  // 512 / AVX2 / baseline dispatch); the ATM singularities (z / x(z) and, for
+  // Obloj,  log(F/K) / (F^(1-beta) - K^(1-beta))) are handled by series near
+  // K = F, selected branch-free.
+  // If the derivative ptrs are non-NULL, the analytic d sigma / d (alpha, rho,
+  // nu) are computed too (forward-mode, on the same formulas). Throws "std::
+  // invalid_argument" for invalid params, non-positive F, K or negative tau:
+  //
+  void SABRVols
+  (
+    SABRParams const& a_params,
+    SABRFormula       a_formula,
+    double            a_F,          // Fwd to the expiry
+    double            a_tau,        // Time to the expiry
+    size_t            a_n,          // Number of Strikes
+    double const*     a_K,          // [a_n]
+    double*           a_sigma,      // [a_n] Output
+    double*           a_dAlpha = nullptr,   // [a_n] Outputs (optional)
+    double*           a_dRho   = nullptr,
+    double*           a_dNu    = nullptr
+  );
+
+  // A single vol:
+  double SABRVol
+  (
+    SABRParams const& a_params,
+    SABRFormula       a_formula,
+    double            a_F,
+    double            a_tau,
+    double            a_K
+  );
+
+  //-------------------------------------------------------------------------//
+  // "SABRCalibrate": Fits (alpha, rho, nu) for One Expiry:                  //
+  //-------------------------------------------------------------------------//
+  // Levenberg-Marquardt on the (weighted) implied vol errors, with the ana-
+  // lytic Jacobian from "SABRVols". "a_params" is in/out: "m_beta" is fixed;
+  // if the other params are valid,  they are the initial guess (warm start,
+  // eg from the previous tick), otherwise alpha is guessed from the ATM vol,
+  // rho = 0 and nu = 0.5. Requires at least 3 quotes:
+  //
+  LMRes SABRCalibrate
+  (
+    SABRFormula       a_formula,
+    double            a_F,
+    double            a_tau,
+    size_t            a_n,
+    double const*     a_K,                  // [a_n] Strikes
+    double const*     a_vol,                // [a_n] Market implied vols
+    double const*     a_weight,             // [a_n] May be NULL (all 1)
+    SABRParams*       a_params,             // In/Out
+    LMParams const&   a_lmParams = LMParams()
+  );
+
+  //-------------------------------------------------------------------------//
+  // "SABRPxBatch": Option Pxs with the SABR Vols:                           //
+  //-------------------------------------------------------------------------//
+  // The Fwd is St * exp((r - D) * tau) (eg for FX, "a_D" is the foreign rate);
+  // the vols from "SABRVols" are fed into "PxBatch". Instantiated for the 3
+  // CDF Policies:
+  //
+  template<typename CDF = CDFCody>
+  void SABRPxBatch
+  (
+    SABRParams const& a_params,
+    SABRFormula       a_formula,
+    PayoffType        a_type,
+    double            a_T,
+    double            a_r,
+    double            a_D,
+    double            a_t,
+    double            a_St,
+    size_t            a_n,
+    double const*     a_K,          // [a_n]
+    double*           a_px          // [a_n]
+  );
+}
+// End namespace BSM
@@ -0,0 +1,265 @@
+// vim:ts=2:et
+//===========================================================================//
+//                              "Scenarios.cpp":                             //
+//             Spot x Vol Scenario Grid Repricing: Implementation            //
+//===========================================================================//
+#include "Scenarios.h"
+#include "FastMath.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace BSM
+{
+  namespace
+  {
+    //-----------------------------------------------------------------------//
+    // "UniformShocks": "a_n" points from -a_max to +a_max:                  //
+    //-----------------------------------------------------------------------//
+    std::vector<double> UniformShocks(size_t a_n, double a_max)
+    {
+      std::vector<double> res(a_n, 0.0);
+      if (a_n > 1)
+        for (size_t i = 0; i < a_n; ++i)
+          res[i] = a_max * (2.0 * double(i) / double(a_n - 1) - 1.0);
+      return res;
+    }
+
+    //-----------------------------------------------------------------------//
+    // "GridKernel": One Option on All Scenarios:                            //
+    //-----------------------------------------------------------------------//
+    // With the coeffs "a_a", "a_b" (as in "OptionChain"),
+    //   Px = S * a_a * Phi(w * d1) + a_b * Phi(w * d2).
+    // If "Accum", adds a_qty * Px to "a_out", otherwise stores Px:
+    //
+    template<typename CDF, bool Accum>
+    FASTMATH_SIMD_KERNEL
+    void GridKernel
+    (
+      size_t                   a_m,       // Number of Scenarios
+      double const* __restrict a_spotF,
+      double const* __restrict a_lnSpotF,
+      double const* __restrict a_volSh,
+      double                   a_St,
+      double                   a_x,       // log(St / K) + (r - D) * tau
+      double                   a_sqrtTau,
+      double                   a_sigma,
+      double                   a_w,
+      double                   a_a,
+      double                   a_b,
+      double                   a_K,
+      double                   a_dig,     // 1 for Digitals, 0 otherwise
+      double                   a_live,    // 1 if tau > 0, 0 otherwise
+      double                   a_qty,
+      double*       __restrict a_out
+    )
+    {
+#     pragma omp simd
+      for (size_t k = 0; k < a_m; ++k)
+      {
+        double S    = a_St * a_spotF[k];
+        double v    = a_sigma + a_volSh[k];
+        v           = (v > ScenVolFloor) ? v : ScenVolFloor;
+        double s    = v * a_sqrtTau;
+        double d1   = (a_x + a_lnSpotF[k]) / s + 0.5 * s;
+        double d2   = d1 - s;
+        double px   = S * a_a * CDF::Phi(a_w * d1) + a_b * CDF::Phi(a_w * d2);
+        px          = (px > 0.0) ? px : 0.0;
+
+        // At expiration time, the PayOff (the above is garbage then):
+        double intr = a_w * (S - a_K);
+        double pay  = (intr > 0.0) ? (intr + a_dig * (1.0 - intr)) : 0.0;
+        double res  = (a_live != 0.0) ? px : pay;
+
+        if constexpr (Accum)
+          a_out[k] += a_qty * res;
+        else
+          a_out[k]  = res;
+      }
+    }
+  }
+
+  //=========================================================================//
+  // "ScenarioGrid" Non-Default Ctors:                                       //
+  //=========================================================================//
+  ScenarioGrid::ScenarioGrid
+  (
+    size_t        a_nSpot,
+    double const* a_spotShocks,
+    size_t        a_nVol,
+    double const* a_volShocks
+  )
+  : m_nS     (a_nSpot),
+    m_nV     (a_nVol),
+    m_spotF  (a_nSpot * a_nVol),
+    m_lnSpotF(a_nSpot * a_nVol),
+    m_volSh  (a_nSpot * a_nVol)
+  {
+    for (size_t i = 0; i < a_nSpot; ++i)
+      if (!(a_spotShocks[i] > -1.0))
+        throw std::invalid_argument("ScenarioGrid: SpotShock <= -100%");
+
+    for (size_t j = 0; j < a_nVol; ++j)
+      for (size_t i = 0; i < a_nSpot; ++i)
+      {
+        size_t k     = j * a_nSpot + i;
+        m_spotF  [k] = 1.0 + a_spotShocks[i];
+        m_lnSpotF[k] = log1p(a_spotShocks[i]);
+        m_volSh  [k] = a_volShocks[j];
+      }
+  }
+
+  ScenarioGrid::ScenarioGrid
+  (
+    size_t a_nSpot,
+    double a_maxSpot,
+    size_t a_nVol,
+    double a_maxVol
+  )
+  : ScenarioGrid(a_nSpot, UniformShocks(a_nSpot, a_maxSpot).data(),
+                 a_nVol,  UniformShocks(a_nVol,  a_maxVol) .data())
+  {}
+
+  //=========================================================================//
+  // "ScenarioGrid::Run": Common Impl of "Px" and "BookPx":                  //
+  //=========================================================================//
+  template<typename CDF, bool Accum>
+  void ScenarioGrid::Run
+  (
+    size_t            a_n,
+    PayoffType const* a_types,
+    double const*     a_K,
+    double const*     a_T,
+    double            a_r,
+    double            a_D,
+    double const*     a_sigma,
+    double            a_t,
+    double const*     a_St,
+    double const*     a_qty,
+    double*           a_px
+  )
+  const
+  {
+    //-----------------------------------------------------------------------//
+    // Check the args (as in "PxBatch"):                                     //
+    //-----------------------------------------------------------------------//
+    for (size_t i = 0; i < a_n; ++i)
+    {
+      if (a_T[i] - a_t < 0.0)
+        throw std::invalid_argument("Negative Time to Expiration");
+
+      if (a_K[i] <= 0.0 || a_St[i] <= 0.0 || a_sigma[i] <= 0.0)
+        throw std::invalid_argument
+              ("Non-Positive Strike / UnderlyingPx / Vol");
+
+      if (a_types[i] != PayoffType::Call        &&
+          a_types[i] != PayoffType::Put         &&
+          a_types[i] != PayoffType::DigitalCall &&
+          a_types[i] != PayoffType::DigitalPut)
+        throw std::logic_error("Unsupported PayoffType");
+    }
+
+    size_t m = Size();
+    if constexpr (Accum)
+      std::fill_n(a_px, m, 0.0);
+
+    //-----------------------------------------------------------------------//
+    // For each option:                                                      //
+    //-----------------------------------------------------------------------//
+    // The per-expiration terms (re-computed only when the expiration changes,
+    // so it pays to sort the options by it):
+    double prevTau = NAN;
+    double sqrtTau = NAN;
+    double dfR     = NAN;
+    double dfD     = NAN;
+
+    for (size_t i = 0; i < a_n; ++i)
+    {
+      double tau = a_T[i] - a_t;
+      if (tau != prevTau)
+      {
+        prevTau = tau;
+        sqrtTau = sqrt(tau);
+        dfR     = exp(- a_r * tau);
+        dfD     = exp(- a_D * tau);
+      }
+      PayoffType type = a_types[i];
+      bool       dig  = (type == PayoffType::DigitalCall ||
+                         type == PayoffType::DigitalPut);
+      double     w    = (type == PayoffType::Call ||
+                         type == PayoffType::DigitalCall) ? 1.0 : -1.0;
+      double     a    = dig ? 0.0 : w * dfD;
+      double     b    = dig ? dfR : - w * a_K[i] * dfR;
+      double     x    = log(a_St[i] / a_K[i]) + (a_r - a_D) * tau;
+
+      GridKernel<CDF, Accum>
+      (
+        m, m_spotF.data(), m_lnSpotF.data(), m_volSh.data(),
+        a_St[i], x, sqrtTau, a_sigma[i], w, a, b, a_K[i], dig ? 1.0 : 0.0,
+        (tau > 0.0) ? 1.0 : 0.0,
+        Accum ? a_qty[i] : 1.0,
+        Accum ? a_px     : a_px + i * m
+      );
+    }
+  }
+
+  //=========================================================================//
+  // "ScenarioGrid::Px", "ScenarioGrid::BookPx":                             //
+  //=========================================================================//
+  template<typename CDF>
+  void ScenarioGrid::Px
+  (
+    size_t            a_n,
+    PayoffType const* a_types,
+    double const*     a_K,
+    double const*     a_T,
+    double            a_r,
+    double            a_D,
+    double const*     a_sigma,
+    double            a_t,
+    double const*     a_St,
+    double*           a_px
+  )
+  const
+  {
+    Run<CDF, false>
+      (a_n, a_types, a_K, a_T, a_r, a_D, a_sigma, a_t, a_St, nullptr, a_px);
+  }
+
+  template<typename CDF>
+  void ScenarioGrid::BookPx
+  (
+    size_t            a_n,
+    PayoffType const* a_types,
+    double const*     a_K,
+    double const*     a_T,
+    double            a_r,
+    double            a_D,
+    double const*     a_sigma,
+    double            a_t,
+    double const*     a_St,
+    double const*     a_qty,
+    double*           a_px
+  )
+  const
+  {
+    Run<CDF, true>
+      (a_n, a_types, a_K, a_T, a_r, a_D, a_sigma, a_t, a_St, a_qty, a_px);
+  }
+
+  //-------------------------------------------------------------------------//
+  // Explicit Instantiations:                                                //
+  //-------------------------------------------------------------------------//
+# define SCEN_INSTANTIATE(CDF)                                                 \
+  template void ScenarioGrid::Px<CDF>                                          \
+    (size_t, PayoffType const*, double const*, double const*, double, double,  \
+     double const*, double, double const*, double*) const;                     \
+  template void ScenarioGrid::BookPx<CDF>                                      \
+    (size_t, PayoffType const*, double const*, double const*, double, double,  \
+     double const*, double, double const*, double const*, double*) const;
+
+  SCEN_INSTANTIATE(CDFErf)
+  SCEN_INSTANTIATE(CDFCody)
+  SCEN_INSTANTIATE(CDFFast)
+# undef SCEN_INSTANTIATE
+}
+// End namespace BSM
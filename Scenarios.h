@@ -0,0 +1,138 @@
+// vim:ts=2:et
+//===========================================================================//
+//                               "Scenarios.h":                              //
+//                   Spot x Vol Scenario Grid Repricing                      //
+//===========================================================================//
+#pragma once
+#include "BSM.h"
+#include <cstddef>
+#include <vector>
+
+namespace BSM
+{
+  //=========================================================================//
+  // "ScenarioGrid" Class:                                                   //
+  //=========================================================================//
+  // A grid of NVol x NSpot scenarios: in scenario (j, i), the Underlying Px is
+  // St * (1 + SpotShock[i]) and the vol is sigma + VolShock[j] (floored at
+  // "ScenVolFloor").  Each option is repriced on the whole grid by a single
+  // vectorised loop over the (flattened) scenarios:  the log-shocks are pre-
+  // computed once per grid, and sqrt(tau) and the discount factors once per
+  // option (and re-used across options with the same expiration).
+  // The results for each option are stored as a compact row-major matrix
+  // [NVol][NSpot]. Call, Put, DigitalCall and DigitalPut are supported.
+  // The methods are "const", so a grid may be used by many threads at once.
+  // Instantiated (in "Scenarios.cpp") for the 3 CDF Policies:
+  //
+  constexpr double ScenVolFloor = 1e-4;
+
+  class ScenarioGrid
+  {
+  private:
+    //-----------------------------------------------------------------------//
+    // Data Flds:                                                            //
+    //-----------------------------------------------------------------------//
+    size_t              m_nS;
+    size_t              m_nV;
+    // Flattened [m_nV][m_nS]:
+    std::vector<double> m_spotF;    // 1 + SpotShock
+    std::vector<double> m_lnSpotF;  // log(1 + SpotShock)
+    std::vector<double> m_volSh;    // VolShock
+
+  public:
+    //-----------------------------------------------------------------------//
+    // Non-Default Ctors:                                                    //
+    //-----------------------------------------------------------------------//
+    // Throws "std::invalid_argument" if any SpotShock is <= -1:
+    //
+    ScenarioGrid
+    (
+      size_t        a_nSpot,
+      double const* a_spotShocks,   // [a_nSpot], relative, eg -0.2 = -20%
+      size_t        a_nVol,
+      double const* a_volShocks     // [a_nVol], absolute, eg 0.01 = +1 vol
+    );
+
+    // Uniform grid: SpotShocks from -a_maxSpot to +a_maxSpot, VolShocks from
+    // -a_maxVol to +a_maxVol (by default, 21 x 21: spot -20%..+20% by 2%, vol
+    // -10..+10 points by 1):
+    //
+    ScenarioGrid
+    (
+      size_t a_nSpot   = 21,
+      double a_maxSpot = 0.2,
+      size_t a_nVol    = 21,
+      double a_maxVol  = 0.1
+    );
+
+    size_t NSpot() const { return m_nS;        }
+    size_t NVol()  const { return m_nV;        }
+    size_t Size()  const { return m_nS * m_nV; }
+
+    //-----------------------------------------------------------------------//
+    // "Px": Scenario Pxs of Each Option:                                    //
+    //-----------------------------------------------------------------------//
+    // Inputs as in "PxBatch" (and so are the exceptions), but with per-option
+    // PayoffTypes. "a_px" receives "a_n" matrices of "Size()" values each.
+    // With "CDFCody", the results agree with "Px" within 1e-13 * max(K, St):
+    //
+    template<typename CDF = CDFCody>
+    void Px
+    (
+      size_t            a_n,      // Number of Options
+      PayoffType const* a_types,  // [a_n]
+      double const*     a_K,      // [a_n] Option Strikes
+      double const*     a_T,      // [a_n] Option Expiration Times
+      double            a_r,      // Risk-Free Interest Rate (shared)
+      double            a_D,      // Dividend Rate           (shared)
+      double const*     a_sigma,  // [a_n] Implied Vols
+      double            a_t,      // Pricing Time            (shared)
+      double const*     a_St,     // [a_n] Underlying Pxs
+      double*           a_px      // [a_n][NVol][NSpot]
+    )
+    const;
+
+    //-----------------------------------------------------------------------//
+    // "BookPx": Qty-Weighted Sum of the Scenario Pxs:                       //
+    //-----------------------------------------------------------------------//
+    // As "Px", but the matrices are multiplied by "a_qty" and summed up into a
+    // single [NVol][NSpot] matrix, so the memory used does not depend on the
+    // number of options:
+    //
+    template<typename CDF = CDFCody>
+    void BookPx
+    (
+      size_t            a_n,
+      PayoffType const* a_types,
+      double const*     a_K,
+      double const*     a_T,
+      double            a_r,
+      double            a_D,
+      double const*     a_sigma,
+      double            a_t,
+      double const*     a_St,
+      double const*     a_qty,    // [a_n] Position Qtys
+      double*           a_px      // [NVol][NSpot]
+    )
+    const;
+
+  private:
+    template<typename CDF, bool Accum>
+    void Run
+    (
+      size_t            a_n,
+      PayoffType const* a_types,
+      double const*     a_K,
+      double const*     a_T,
+      double            a_r,
+      double            a_D,
+      double const*     a_sigma,
+      double            a_t,
+      double const*     a_St,
+      double const*     a_qty,
+      double*           a_px
+    )
+    const;
+  };
+}
+// End namespace BSM
@@ -0,0 +1,285 @@
+// vim:ts=2:et
+//===========================================================================//
+//                              "ThreadPool.cpp":                            //
+//            Persistent NUMA-Aware Pool of Worker Threads: Implementation   //
+//===========================================================================//
+#include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+
+#ifdef __linux__
+#  include <pthread.h>
+#  include <sched.h>
+#endif
+
+namespace BSM
+{
+  namespace
+  {
+    //-----------------------------------------------------------------------//
+    // "ParseCPUList": Eg "0-3,8-11" -> {0, 1, 2, 3, 8, 9, 10, 11}:          //
+    //-----------------------------------------------------------------------//
+    std::vector<int> ParseCPUList(std::string const& a_str)
+    {
+      std::vector<int>  res;
+      std::stringstream in(a_str);
+      std::string       item;
+      while (std::getline(in, item, ','))
+      {
+        if (item.empty() || item[0] < '0' || item[0] > '9')
+          continue;
+        size_t dash = item.find('-');
+        int    from = std::stoi(item.substr(0, dash));
+        int    to   = (dash == std::string::npos)
+                      ? from
+                      : std::stoi(item.substr(dash + 1));
+        for (int c = from; c <= to; ++c)
+          res.push_back(c);
+      }
+      return res;
+    }
+
+    //-----------------------------------------------------------------------//
+    // "NUMANodes": The CPUs (usable by this process) of each NUMA Node:     //
+    //-----------------------------------------------------------------------//
+    // Falls back to a single node with CPUs 0 .. (hardware threads - 1):
+    //
+    std::vector<std::vector<int>> NUMANodes()
+    {
+      std::vector<std::vector<int>> res;
+#     ifdef __linux__
+      cpu_set_t allowed;
+      CPU_ZERO(&allowed);
+      bool haveMask =
+        sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+
+      // NB: Node numbers may have gaps:
+      for (int node = 0; node < 256; ++node)
+      {
+        std::ifstream in("/sys/devices/system/node/node" +
+                         std::to_string(node) + "/cpulist");
+        if (!in)
+          continue;
+        std::string line;
+        std::getline(in, line);
+
+        std::vector<int> cpus;
+        for (int c: ParseCPUList(line))
+          if (!haveMask || (c < CPU_SETSIZE && CPU_ISSET(c, &allowed)))
+            cpus.push_back(c);
+        if (!cpus.empty())
+          res.push_back(std::move(cpus));
+      }
+#     endif
+      if (res.empty())
+      {
+        int n = std::max<int>(int(std::thread::hardware_concurrency()), 1);
+        res.emplace_back();
+        for (int c = 0; c < n; ++c)
+          res.back().push_back(c);
+      }
+      return res;
+    }
+
+    //-----------------------------------------------------------------------//
+    // "PinToCPU": Best effort (errors are ignored):                         //
+    //-----------------------------------------------------------------------//
+    void PinToCPU([[maybe_unused]] std::thread& a_th,
+                  [[maybe_unused]] int          a_cpu)
+    {
+#     ifdef __linux__
+      if (a_cpu >= CPU_SETSIZE)
+        return;
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      CPU_SET(a_cpu, &set);
+      (void) pthread_setaffinity_np(a_th.native_handle(), sizeof(set), &set);
+#     endif
+    }
+  }
+
+  //=========================================================================//
+  // "ThreadPool::Job":                                                      //
+  //=========================================================================//
+  struct ThreadPool::Job
+  {
+    // Per-Node task counters, on separate cache lines:
+    struct alignas(64) Counter
+    {
+      std::atomic<size_t> m_next;
+    };
+
+    std::function<void(size_t)> const* m_task;
+    std::vector<size_t>                m_end;   // [NNodes]
+    std::unique_ptr<Counter[]>         m_next;  // [NNodes]
+    std::exception_ptr                 m_error;
+    std::mutex                         m_errorMtx;
+  };
+
+  //=========================================================================//
+  // "ThreadPool" Non-Default Ctor:                                          //
+  //=========================================================================//
+  ThreadPool::ThreadPool(int a_nThreads)
+  : m_job   (nullptr),
+    m_gen   (0),
+    m_active(0),
+    m_stop  (false)
+  {
+    std::vector<std::vector<int>> nodes = NUMANodes();
+
+    int nThreads = (a_nThreads > 0)
+                   ? a_nThreads
+                   : std::max<int>(int(std::thread::hardware_concurrency()),
+                                   1);
+
+    // Worker "i" goes to the node (i % NNodes) (but only the nodes which get
+    // at least 1 worker are counted), and within it, to the CPUs in turn:
+    int nNodes = std::min<int>(int(nodes.size()), nThreads);
+    m_nodeThreads.assign(size_t(nNodes), 0);
+    m_nodeOf.resize(size_t(nThreads));
+
+    for (int i = 0; i < nThreads; ++i)
+    {
+      int node    = i % nNodes;
+      m_nodeOf[size_t(i)] = node;
+      ++m_nodeThreads[size_t(node)];
+    }
+    m_threads.reserve(size_t(nThreads));
+    for (int i = 0; i < nThreads; ++i)
+    {
+      int                     node = m_nodeOf[size_t(i)];
+      std::vector<int> const& cpus = nodes[size_t(node)];
+      m_threads.emplace_back(&ThreadPool::Worker, this, node);
+      PinToCPU(m_threads.back(), cpus[size_t(i / nNodes) % cpus.size()]);
+    }
+  }
+
+  //=========================================================================//
+  // "ThreadPool" Dtor:                                                      //
+  //=========================================================================//
+  ThreadPool::~ThreadPool()
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_mtx);
+      m_stop = true;
+    }
+    m_wake.notify_all();
+    for (std::thread& th: m_threads)
+      th.join();
+  }
+
+  //=========================================================================//
+  // "ThreadPool::NodeBegin", "ThreadPool::HomeNode":                        //
+  //=========================================================================//
+  size_t ThreadPool::NodeBegin(int a_node, size_t a_nTasks) const
+  {
+    size_t before = 0;   // Workers on the nodes before "a_node"
+    for (int n = 0; n < a_node; ++n)
+      before += m_nodeThreads[size_t(n)];
+    return a_nTasks * before / m_threads.size();
+  }
+
+  int ThreadPool::HomeNode(size_t a_i, size_t a_nTasks) const
+  {
+    int node = 0;
+    while (node + 1 < NNodes() && a_i >= NodeBegin(node + 1, a_nTasks))
+      ++node;
+    return node;
+  }
+
+  //=========================================================================//
+  // "ThreadPool::Worker": The Main Loop of a Worker Thread:                 //
+  //=========================================================================//
+  void ThreadPool::Worker(int a_node)
+  {
+    uint64_t seen   = 0;
+    int      nNodes = NNodes();
+    for (;;)
+    {
+      Job* job = nullptr;
+      {
+        std::unique_lock<std::mutex> lock(m_mtx);
+        m_wake.wait(lock, [&]() { return m_stop || m_gen != seen; });
+        if (m_stop)
+          return;
+        seen = m_gen;
+        job  = m_job;
+      }
+
+      // Own node first, then the others:
+      for (int k = 0; k < nNodes; ++k)
+      {
+        size_t node = size_t((a_node + k) % nNodes);
+        for (;;)
+        {
+          size_t i = job->m_next[node].m_next.fetch_add(1);
+          if (i >= job->m_end[node])
+            break;
+          try
+          {
+            (*job->m_task)(i);
+          }
+          catch (...)
+          {
+            // Memoise the 1st exception, and make all workers stop:
+            std::lock_guard<std::mutex> lock(job->m_errorMtx);
+            if (!job->m_error)
+              job->m_error = std::current_exception();
+            for (int n = 0; n < nNodes; ++n)
+              job->m_next[size_t(n)].m_next = job->m_end[size_t(n)];
+          }
+        }
+      }
+
+      std::lock_guard<std::mutex> lock(m_mtx);
+      if (--m_active == 0)
+        m_done.notify_one();
+    }
+  }
+
+  //=========================================================================//
+  // "ThreadPool::Run":                                                      //
+  //=========================================================================//
+  void ThreadPool::Run
+  (
+    size_t                             a_nTasks,
+    std::function<void(size_t)> const& a_task
+  )
+  {
+    if (a_nTasks == 0)
+      return;
+    std::lock_guard<std::mutex> runLock(m_runMtx);
+
+    int nNodes = NNodes();
+    Job job;
+    job.m_task = &a_task;
+    job.m_end.resize(size_t(nNodes));
+    job.m_next.reset(new Job::Counter[size_t(nNodes)]);
+    for (int n = 0; n < nNodes; ++n)
+    {
+      job.m_next[size_t(n)].m_next = NodeBegin(n,     a_nTasks);
+      job.m_end [size_t(n)]        = NodeBegin(n + 1, a_nTasks);
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(m_mtx);
+      m_job    = &job;
+      m_active = m_threads.size();
+      ++m_gen;
+    }
+    m_wake.notify_all();
+    {
+      std::unique_lock<std::mutex> lock(m_mtx);
+      m_done.wait(lock, [&]() { return m_active == 0; });
+      m_job = nullptr;
+    }
+    if (job.m_error)
+      std::rethrow_exception(job.m_error);
+  }
+}
+// End namespace BSM
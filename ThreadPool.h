@@ -0,0 +1,89 @@
+// vim:ts=2:et
+//===========================================================================//
+//                               "ThreadPool.h":                             //
+//                  Persistent NUMA-Aware Pool of Worker Threads             //
+//===========================================================================//
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace BSM
+{
+  //=========================================================================//
+  // "ThreadPool" Class:                                                     //
+  //=========================================================================//
+  // Unlike "RunParallel" (which starts new threads on each call), the workers
+  // are created once, and each is pinned to a CPU (on Linux;  the CPUs of the
+  // NUMA nodes, as given by "/sys/devices/system/node", are used round-robin,
+  // so the workers are spread over all nodes).
+  // "Run(n, task)" splits the tasks [0 .. n-1] into contiguous ranges, one per
+  // node (proportional to the number of workers on it). The workers process
+  // the tasks of their own node first, then help the other nodes.  So if the
+  // data of task "i" is initialised (first touched) by a task run with the
+  // same "n" -- ie on the node "HomeNode(i, n)" --, it is mostly accessed by
+  // the CPUs of that node.
+  // The calling thread only waits. "Run" may be called from several threads,
+  // but the calls are serialised:
+  //
+  class ThreadPool
+  {
+  private:
+    struct Job;     // Defined in "ThreadPool.cpp"
+
+    //-----------------------------------------------------------------------//
+    // Data Flds:                                                            //
+    //-----------------------------------------------------------------------//
+    std::vector<std::thread> m_threads;
+    std::vector<int>         m_nodeOf;       // [NThreads]: Worker -> Node
+    std::vector<size_t>      m_nodeThreads;  // [NNodes]:   Workers per Node
+    std::mutex               m_runMtx;       // Serialises "Run"s
+    std::mutex               m_mtx;          // Protects the flds below
+    std::condition_variable  m_wake;
+    std::condition_variable  m_done;
+    Job*                     m_job;
+    uint64_t                 m_gen;          // Incremented for each Job
+    size_t                   m_active;       // Workers yet to finish the Job
+    bool                     m_stop;
+
+    void Worker(int a_node);
+
+  public:
+    //-----------------------------------------------------------------------//
+    // Non-Default Ctor, Dtor:                                               //
+    //-----------------------------------------------------------------------//
+    // "a_nThreads": 0 means all hardware threads:
+    //
+    explicit ThreadPool(int a_nThreads = 0);
+    ~ThreadPool();
+
+    ThreadPool(ThreadPool const&)            = delete;
+    ThreadPool& operator=(ThreadPool const&) = delete;
+
+    //-----------------------------------------------------------------------//
+    // "Run": Invokes "a_task(i)" for all i in [0 .. a_nTasks-1]:            //
+    //-----------------------------------------------------------------------//
+    // Returns when all tasks are done; the first exception thrown by any task
+    // is re-thrown (and the remaining tasks are skipped):
+    //
+    void Run(size_t a_nTasks, std::function<void(size_t)> const& a_task);
+
+    //-----------------------------------------------------------------------//
+    // Accessors:                                                            //
+    //-----------------------------------------------------------------------//
+    int    NThreads() const { return int(m_threads.size());     }
+    int    NNodes()   const { return int(m_nodeThreads.size()); }
+
+    // The node which the task "a_i" (of "a_nTasks") is assigned to:
+    int    HomeNode(size_t a_i, size_t a_nTasks) const;
+
+    // The first task of the node "a_node" (for "a_node" == NNodes(), returns
+    // "a_nTasks"):
+    size_t NodeBegin(int a_node, size_t a_nTasks) const;
+  };
+}
+// End namespace BSM
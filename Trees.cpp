@@ -0,0 +1,438 @@
+// vim:ts=2:et
+//===========================================================================//
+//                                 "Trees.cpp":                              //
+//               Binomial and Trinomial Tree Pricers: Implementation         //
+//===========================================================================//
+#include "Trees.h"
+#include "FastMath.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace BSM
+{
+  namespace
+  {
+    //-----------------------------------------------------------------------//
+    // "Lattice": Tree Params:                                               //
+    //-----------------------------------------------------------------------//
+    // Node (i, j) (i = step, j = 0 .. a_width * i) has the Underlying Px
+    //   S_{i,j} = S0 * exp(i * m_lnF + j * m_lnR),
+    // and its value is the discounted expectation over the nodes (i+1, j),
+    // (i+1, j+1) [and (i+1, j+2) for the trinomial tree], with the probabil-
+    // ities m_pd, m_pm [, m_pu]:
+    //
+    struct Lattice
+    {
+      int    m_width;  // 1 (binomial) or 2 (trinomial)
+      double m_lnF;
+      double m_lnR;
+      double m_pd;
+      double m_pm;
+      double m_pu;
+    };
+
+    //-----------------------------------------------------------------------//
+    // "MkLattice":                                                          //
+    //-----------------------------------------------------------------------//
+    Lattice MkLattice
+    (
+      TreeType a_type,
+      int      a_N,
+      double   a_tau,
+      double   a_r,
+      double   a_D,
+      double   a_sigma,
+      double   a_K,
+      double   a_St
+    )
+    {
+      double dt = a_tau / a_N;
+      double g  = exp((a_r - a_D) * dt);   // Growth factor over 1 step
+      Lattice res;
+
+      switch (a_type)
+      {
+        case TreeType::CRR:
+        {
+          double u    = exp(a_sigma * sqrt(dt));
+          double d    = 1.0 / u;
+          double p    = (g - d) / (u - d);
+          res.m_width = 1;
+          res.m_lnF   = log(d);
+          res.m_lnR   = 2.0 * log(u);
+          res.m_pd    = 1.0 - p;
+          res.m_pm    = p;
+          res.m_pu    = 0.0;
+          break;
+        }
+        case TreeType::LeisenReimer:
+        {
+          // Peizer-Pratt inversion (method 2) of the Binomial CDF, applied
+          // to d1 and d2, so that the tree is centred on the Strike:
+          double s  = a_sigma * sqrt(a_tau);
+          double d1 = (log(a_St / a_K) + (a_r - a_D) * a_tau) / s + 0.5 * s;
+          double d2 = d1 - s;
+          double n  = double(a_N);
+          auto   h  =
+            [n](double a_z) -> double
+            {
+              double y = a_z / (n + 1.0 / 3.0 + 0.1 / (n + 1.0));
+              return 0.5 + copysign(0.5, a_z) *
+                           sqrt(1.0 - exp(-y * y * (n + 1.0 / 6.0)));
+            };
+          double p    = h(d2);
+          double u    = g * h(d1) / p;
+          double d    = (g - p * u) / (1.0 - p);
+          res.m_width = 1;
+          res.m_lnF   = log(d);
+          res.m_lnR   = log(u / d);
+          res.m_pd    = 1.0 - p;
+          res.m_pm    = p;
+          res.m_pu    = 0.0;
+          break;
+        }
+        case TreeType::Trinomial:
+        {
+          // Boyle: u = exp(sigma * sqrt(2 dt)), m = 1, d = 1/u:
+          double a    = exp(0.5 * (a_r - a_D) * dt);
+          double b    = exp(a_sigma * sqrt(0.5 * dt));
+          double ib   = 1.0 / b;
+          double pu   = (a - ib) / (b - ib);
+          double pd   = (b - a)  / (b - ib);
+          res.m_width = 2;
+          res.m_lnF   = - 2.0 * log(b);
+          res.m_lnR   =   2.0 * log(b);
+          res.m_pu    = pu * pu;
+          res.m_pd    = pd * pd;
+          res.m_pm    = 1.0 - res.m_pu - res.m_pd;
+          break;
+        }
+        default:
+          throw std::logic_error("Unsupported TreeType");
+      }
+      return res;
+    }
+
+    //-----------------------------------------------------------------------//
+    // "FillPow": m_pow[j] = exp(j * lnR):                                   //
+    //-----------------------------------------------------------------------//
+    FASTMATH_SIMD_KERNEL
+    void FillPow(size_t a_n, double a_lnR, double* __restrict a_pow)
+    {
+#     pragma omp simd
+      for (size_t j = 0; j < a_n; ++j)
+        a_pow[j] = FastMath::Exp(double(j) * a_lnR);
+    }
+
+    //-----------------------------------------------------------------------//
+    // "Exercise": V_j = max(V_j, Payoff(S_{i,j})):                          //
+    //-----------------------------------------------------------------------//
+    FASTMATH_SIMD_KERNEL
+    void Exercise
+    (
+      int                      a_nI,
+      double                   a_w,
+      double                   a_K,
+      double                   a_Fi,
+      double const* __restrict a_pow,
+      double*       __restrict a_V
+    )
+    {
+#     pragma omp simd
+      for (int j = 0; j < a_nI; ++j)
+      {
+        double e = a_w * (a_Fi * a_pow[j] - a_K);
+        a_V[j]   = (a_V[j] < e) ? e : a_V[j];
+      }
+    }
+
+    //-----------------------------------------------------------------------//
+    // "DivJump": V_j = V(S_{i,j} - a_d):                                    //
+    //-----------------------------------------------------------------------//
+    // "a_V" holds the ex-dividend values at the "a_nI" (>= 2) nodes S_{i,j} =
+    // a_Fi * exp(j * a_lnR) of this step; they are replaced by the cum-divid-
+    // end ones, interpolated in S by the cubic Lagrange polynomial on the 4
+    // nodes around S_{i,j} - a_d (on all nodes if there are fewer), and ext-
+    // rapolated linearly below S_{i,0} (with the Px floored at 0).  A linear
+    // interpolation would make an O(dS^2) = O(dt) error at each jump,  which
+    // dominated the error of the whole tree. "a_tmp" ([a_nI]) is a work buf-
+    // fer:
+    //
+    void DivJump
+    (
+      int           a_nI,
+      double        a_Fi,
+      double        a_lnR,
+      double        a_d,
+      double const* a_pow,
+      double*       a_V,
+      double*       a_tmp
+    )
+    {
+      int    nP = std::min(a_nI, 4);   // Number of interpolation nodes
+      double S0 = a_Fi;
+      double S1 = a_Fi * a_pow[1];
+
+      for (int j = 0; j < a_nI; ++j)
+      {
+        double x = a_Fi * a_pow[j] - a_d;
+        if (x <= S0)
+        {
+          x        = std::max(x, 0.0);
+          a_tmp[j] = a_V[0] + (a_V[1] - a_V[0]) * (x - S0) / (S1 - S0);
+          continue;
+        }
+        // S_{i,k0} <= x < S_{i,k0+1}; the nodes used are k .. k+nP-1:
+        int k0 = std::min(int(log(x / a_Fi) / a_lnR), j - 1);
+        int k  = std::min(std::max(k0 - (nP / 2 - 1), 0), a_nI - nP);
+        double v = 0.0;
+        for (int p = 0; p < nP; ++p)
+        {
+          double Sp = a_Fi * a_pow[k + p];
+          double wp = 1.0;
+          for (int q = 0; q < nP; ++q)
+            if (q != p)
+            {
+              double Sq = a_Fi * a_pow[k + q];
+              wp       *= (x - Sq) / (Sp - Sq);
+            }
+          v += wp * a_V[k + p];
+        }
+        a_tmp[j] = v;
+      }
+      std::copy(a_tmp, a_tmp + a_nI, a_V);
+    }
+
+    //-----------------------------------------------------------------------//
+    // "Induction": The Backward Induction:                                  //
+    //-----------------------------------------------------------------------//
+    // Returns the option value at the root. "a_V" is the rolling array, with
+    // (a_width * a_N + 1) elements, as is "a_pow":
+    //
+    FASTMATH_SIMD_KERNEL
+    double Induction
+    (
+      int                      a_N,
+      Lattice const&           a_lat,
+      double                   a_disc,   // Discount Factor over 1 step
+      double                   a_w,      // +1 for Call, -1 for Put
+      double                   a_K,
+      double                   a_S0,
+      double const* __restrict a_pow,
+      uint8_t const* __restrict a_exer,
+      double const* __restrict a_div,    // [a_N+1], or NULL if no dividends
+      double*       __restrict a_V,
+      double*       __restrict a_tmp     // Work buffer for the dividends
+    )
+    {
+      int    width = a_lat.m_width;
+      double pd    = a_disc * a_lat.m_pd;
+      double pm    = a_disc * a_lat.m_pm;
+      double pu    = a_disc * a_lat.m_pu;
+
+      // The Payoff at expiration:
+      int    nN    = width * a_N + 1;
+      double FN    = a_S0 * exp(a_N * a_lat.m_lnF);
+      double dN    = (a_div != nullptr) ? a_div[a_N] : 0.0;
+#     pragma omp simd
+      for (int j = 0; j < nN; ++j)
+      {
+        double S = FN * a_pow[j] - dN;
+        double e = a_w * (((S > 0.0) ? S : 0.0) - a_K);
+        a_V[j]   = (e > 0.0) ? e : 0.0;
+      }
+
+      // Backward Induction. NB: the arrays are updated in place in the asc-
+      // ending order of "j", as node (i, j) only depends on the nodes (i+1, j)
+      // and higher, which are yet to be overwritten:
+      for (int i = a_N - 1; i >= 0; --i)
+      {
+        int nI = width * i + 1;
+        if (width == 1)
+        {
+#         pragma omp simd
+          for (int j = 0; j < nI; ++j)
+            a_V[j] = pd * a_V[j] + pm * a_V[j+1];
+        }
+        else
+        {
+#         pragma omp simd
+          for (int j = 0; j < nI; ++j)
+            a_V[j] = pd * a_V[j] + pm * a_V[j+1] + pu * a_V[j+2];
+        }
+
+        double Fi = a_S0 * exp(i * a_lat.m_lnF);
+        if (a_exer[i])
+          Exercise(nI, a_w, a_K, Fi, a_pow, a_V);
+
+        // The dividend paid at this step (if any), followed by exercise at
+        // the cum-dividend Pxs:
+        if (a_div != nullptr && a_div[i] > 0.0)
+        {
+          DivJump(nI, Fi, a_lat.m_lnR, a_div[i], a_pow, a_V, a_tmp);
+          if (a_exer[i])
+            Exercise(nI, a_w, a_K, Fi, a_pow, a_V);
+        }
+      }
+      return a_V[0];
+    }
+  }
+
+  //=========================================================================//
+  // "TreePricer" Non-Default Ctor:                                          //
+  //=========================================================================//
+  TreePricer::TreePricer(TreeType a_type, int a_nSteps)
+  : m_type  (a_type),
+    m_nSteps(a_nSteps)
+  {
+    if (a_nSteps < 1)
+      throw std::invalid_argument("TreePricer: Non-Positive NSteps");
+    // Leisen-Reimer requires an odd number of steps:
+    if (a_type == TreeType::LeisenReimer && a_nSteps % 2 == 0)
+      ++m_nSteps;
+  }
+
+  //=========================================================================//
+  // "TreePricer::Px":                                                       //
+  //=========================================================================//
+  double TreePricer::Px
+  (
+    PayoffType    a_type,
+    ExerStyle     a_style,
+    double        a_K,
+    double        a_T,
+    double        a_r,
+    double        a_D,
+    double        a_sigma,
+    double        a_t,
+    double        a_St,
+    double const*      a_exerTimes,
+    size_t             a_nExer,
+    DivSchedule const* a_divs
+  )
+  {
+    double px = NAN;
+    PxBatch(a_type, a_style, 1, &a_K, a_T, a_r, a_D, a_sigma, a_t, a_St, &px,
+            a_exerTimes, a_nExer, a_divs);
+    return px;
+  }
+
+  //=========================================================================//
+  // "TreePricer::PxBatch":                                                  //
+  //=========================================================================//
+  void TreePricer::PxBatch
+  (
+    PayoffType    a_type,
+    ExerStyle     a_style,
+    size_t        a_n,
+    double const* a_K,
+    double        a_T,
+    double        a_r,
+    double        a_D,
+    double        a_sigma,
+    double        a_t,
+    double        a_St,
+    double*            a_px,
+    double const*      a_exerTimes,
+    size_t             a_nExer,
+    DivSchedule const* a_divs
+  )
+  {
+    //-----------------------------------------------------------------------//
+    // Check the args:                                                       //
+    //-----------------------------------------------------------------------//
+    double tau = a_T - a_t;
+
+    if (tau <  0.0)
+      throw std::invalid_argument("Negative Time to Expiration");
+
+    double w = 0.0;   // +1 for Call, -1 for Put
+    switch (a_type)
+    {
+      case PayoffType::Call: w =  1.0; break;
+      case PayoffType::Put:  w = -1.0; break;
+      default:
+        throw std::logic_error("Unsupported PayoffType");
+    }
+
+    if (a_St <= 0.0 || a_sigma <= 0.0 ||
+        std::any_of(a_K, a_K + a_n, [](double a_k) { return a_k <= 0.0; }))
+      throw std::invalid_argument("Non-Positive Strike / UnderlyingPx / Vol");
+    if (a_n == 0)
+      return;
+
+    // At expiration time, return the PayOff:
+    if (tau == 0.0)
+    {
+      for (size_t k = 0; k < a_n; ++k)
+        a_px[k] = std::max(w * (a_St - a_K[k]), 0.0);
+      return;
+    }
+
+    //-----------------------------------------------------------------------//
+    // The Exercise Schedule:                                                //
+    //-----------------------------------------------------------------------//
+    int    N  = m_nSteps;
+    double dt = tau / N;
+    m_exer.assign(size_t(N), (a_style == ExerStyle::American) ? 1 : 0);
+
+    if (a_style == ExerStyle::Bermudan)
+      for (size_t e = 0; e < a_nExer; ++e)
+      {
+        long i = lround((a_exerTimes[e] - a_t) / dt);
+        if (0 <= i && i < N)
+          m_exer[size_t(i)] = 1;
+      }
+
+    //-----------------------------------------------------------------------//
+    // The Dividend Schedule (on the nearest steps, but not the root):       //
+    //-----------------------------------------------------------------------//
+    bool hasDivs = false;
+    if (a_divs != nullptr)
+    {
+      m_div.assign(size_t(N + 1), 0.0);
+      for (size_t e = 0; e < a_divs->Size(); ++e)
+      {
+        double te = a_divs->Time(e);
+        if (te <= a_t || te > a_T || a_divs->Amount(e) == 0.0)
+          continue;
+        long i = std::max(lround((te - a_t) / dt), 1L);
+        m_div[size_t(i)] += a_divs->Amount(e);
+        hasDivs           = true;
+      }
+    }
+
+    //-----------------------------------------------------------------------//
+    // Run the Trees:                                                        //
+    //-----------------------------------------------------------------------//
+    int    width  = (m_type == TreeType::Trinomial) ? 2 : 1;
+    size_t nNodes = size_t(width * N + 1);
+    double disc   = exp(-a_r * dt);
+    m_V  .resize(nNodes);
+    m_pow.resize(nNodes);
+    if (hasDivs)
+      m_tmp.resize(nNodes);
+
+    // Unless it is Leisen-Reimer, the lattice is the same for all Strikes:
+    bool    perK = (m_type == TreeType::LeisenReimer);
+    Lattice lat;
+    if (!perK)
+    {
+      lat = MkLattice(m_type, N, tau, a_r, a_D, a_sigma, a_K[0], a_St);
+      FillPow(nNodes, lat.m_lnR, m_pow.data());
+    }
+    for (size_t k = 0; k < a_n; ++k)
+    {
+      if (perK)
+      {
+        lat = MkLattice(m_type, N, tau, a_r, a_D, a_sigma, a_K[k], a_St);
+        FillPow(nNodes, lat.m_lnR, m_pow.data());
+      }
+      a_px[k] = Induction(N, lat, disc, w, a_K[k], a_St, m_pow.data(),
+                          m_exer.data(), hasDivs ? m_div.data() : nullptr,
+                          m_V.data(), m_tmp.data());
+    }
+  }
+}
+// End namespace BSM
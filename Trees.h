@@ -0,0 +1,140 @@
+// vim:ts=2:et
+//===========================================================================//
+//                                  "Trees.h":                               //
+//          Binomial (CRR, Leisen-Reimer) and Trinomial Tree Pricers         //
+//===========================================================================//
+#pragma once
+#include "BSM.h"
+#include "Dividends.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace BSM
+{
+  //-------------------------------------------------------------------------//
+  // Tree and Exercise Types:                                                //
+  //-------------------------------------------------------------------------//
+  enum class TreeType: int
+  {
+    CRR          = 0,  // Cox-Ross-Rubinstein binomial
+    LeisenReimer = 1,  // Leisen-Reimer binomial (Peizer-Pratt inversion 2);
+                       //   the number of steps is made odd
+    Trinomial    = 2   // Boyle's trinomial
+  };
+
+  enum class ExerStyle: int
+  {
+    European = 0,
+    American = 1,
+    Bermudan = 2       // On the given dates only (and at expiration)
+  };
+
+  //=========================================================================//
+  // "TreePricer" Class:                                                     //
+  //=========================================================================//
+  // Backward induction over rolling arrays (O(NSteps) memory per option): at
+  // each step, the values of all nodes are computed by a vectorised loop, and
+  // for the exercise dates, maxed with the exercise values (the node Pxs are
+  // products of a per-step factor and a per-node table, so no "pow" is eval-
+  // uated in the loop).
+  // Bermudan exercise dates are rounded to the nearest time steps.
+  // Cash dividends (if a "DivSchedule" is given) are exact jumps in the Un-
+  // derlying Px (Vellekoop-Nieuwenhuis): the lattice is that of the process
+  // without them, and at the step nearest to each ex-time (but not the root),
+  // the values are replaced by V(S) = V_ex(S - d),  cubically interpolated
+  // between the nodes of that step (and exercise is allowed both before and
+  // after the jump).  The extra cost is O(NSteps) per dividend.
+  // NB: with dividends, the error is O(1/NSteps) for all TreeTypes (Leisen-
+  // Reimer loses its 2nd order, as the shifted payoff kink is no longer cen-
+  // tred between the nodes; rounding the ex-times to the nearest steps is
+  // also O(1/NSteps)), but the cubic interpolation keeps its constant small:
+  // eg for a 1y ATM European Put (St = 100, vol = 25%, r = 5%) with 2 div-
+  // idends of 2, the error is below 2e-4 with Leisen-Reimer at 1000 steps
+  // (6e-4 at 100), and 2.5e-3 (CRR) or 1.5e-3 (Trinomial) at 1000 steps,
+  // halving as the steps double; for the American one, it is below 1e-3 at
+  // 1000 steps for all TreeTypes, but converges less regularly.
+  // The rolling arrays are owned by the object and re-used across calls, so
+  // it is NOT thread-safe; use one per thread.
+  // Call and Put only; the args are as in "BSM::Px" (and so are the excep-
+  // tions).
+  // A 1000-step tree takes a few 100s of microseconds:
+  //
+  class TreePricer
+  {
+  private:
+    //-----------------------------------------------------------------------//
+    // Data Flds:                                                            //
+    //-----------------------------------------------------------------------//
+    TreeType             m_type;
+    int                  m_nSteps;
+    std::vector<double>  m_V;      // Rolling array of option values
+    std::vector<double>  m_pow;    // Node Px ratios: S_{i,j} = F_i * m_pow[j]
+    std::vector<uint8_t> m_exer;   // [NSteps]: Can exercise at this step?
+    std::vector<double>  m_div;    // [NSteps+1]: Cash div paid at this step
+    std::vector<double>  m_tmp;    // Work buffer for the dividend jumps
+
+  public:
+    //-----------------------------------------------------------------------//
+    // Non-Default Ctor:                                                     //
+    //-----------------------------------------------------------------------//
+    TreePricer(TreeType a_type, int a_nSteps = 1000);
+
+    //-----------------------------------------------------------------------//
+    // "Px": Single Option:                                                  //
+    //-----------------------------------------------------------------------//
+    double Px
+    (
+      // Option Spec:
+      PayoffType    a_type,
+      ExerStyle     a_style,
+      double        a_K,            // Option Strike
+      double        a_T,            // Opton Expiration Time, as Year Fraction
+      // Market Data:
+      double        a_r,            // Risk-Free Interest Rate
+      double        a_D,            // Dividend Rate
+      double        a_sigma,        // Volatility
+      // "Quick" variables:
+      double        a_t,            // Pricing Time (as Year Fraction)
+      double        a_St,           // Underlying Px at Time "a_t"
+      // Bermudan exercise dates (as Year Fractions; ignored otherwise):
+      double const* a_exerTimes = nullptr,
+      size_t        a_nExer     = 0,
+      // Cash dividends (if any):
+      DivSchedule const* a_divs = nullptr
+    );
+
+    //-----------------------------------------------------------------------//
+    // "PxBatch": Options with Same Expiration, Vol and Underlying:          //
+    //-----------------------------------------------------------------------//
+    // "a_n" options of the same PayoffType, differing by Strike only.  The
+    // lattice (probabilities and node Pxs) and the exercise schedule are set
+    // up once and shared; for "LeisenReimer", the lattice depends on the
+    // Strike, so only the schedule is shared:
+    //
+    void PxBatch
+    (
+      // Option Specs:
+      PayoffType    a_type,
+      ExerStyle     a_style,
+      size_t        a_n,            // Number of Options
+      double const* a_K,            // [a_n] Option Strikes
+      double        a_T,            // Expiration Time (shared)
+      // Market Data:
+      double        a_r,            // Risk-Free Interest Rate (shared)
+      double        a_D,            // Dividend Rate           (shared)
+      double        a_sigma,        // Volatility              (shared)
+      // "Quick" variables:
+      double        a_t,            // Pricing Time            (shared)
+      double        a_St,           // Underlying Px           (shared)
+      // Output:
+      double*       a_px,           // [a_n] Option Pxs
+      // Bermudan exercise dates:
+      double const* a_exerTimes = nullptr,
+      size_t        a_nExer     = 0,
+      // Cash dividends (if any):
+      DivSchedule const* a_divs = nullptr
+    );
+  };
+}
+// End namespace BSM
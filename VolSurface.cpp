@@ -0,0 +1,576 @@
+// vim:ts=2:et
+//===========================================================================//
+//                              "VolSurface.cpp":                            //
+//           SVI / SSVI Implied Volatility Surface with Cached Lookups       //
+//===========================================================================//
+#include "VolSurface.h"
+#include "FastMath.hpp"
+#include <numeric>
+#include <stdexcept>
+
+namespace BSM
+{
+  namespace
+  {
+    //-----------------------------------------------------------------------//
+    // "SVIKernel": sigma_i = sqrt(c0 * w0(k_i) + c1 * w1(k_i)):             //
+    //-----------------------------------------------------------------------//
+    FASTMATH_SIMD_KERNEL
+    void SVIKernel
+    (
+      size_t                   a_n,
+      double const* __restrict a_K,
+      double                   a_logF,
+      double                   a_c0,
+      SVIParams                a_svi0,
+      double                   a_c1,
+      SVIParams                a_svi1,
+      double*       __restrict a_sigma
+    )
+    {
+      double a0 = a_svi0.m_a, b0 = a_svi0.m_b, r0 = a_svi0.m_rho,
+             m0 = a_svi0.m_m, s0 = a_svi0.m_s * a_svi0.m_s;
+      double a1 = a_svi1.m_a, b1 = a_svi1.m_b, r1 = a_svi1.m_rho,
+             m1 = a_svi1.m_m, s1 = a_svi1.m_s * a_svi1.m_s;
+
+#     pragma omp simd
+      for (size_t i = 0; i < a_n; ++i)
+      {
+        double k  = FastMath::Log(a_K[i]) - a_logF;
+        double x0 = k - m0;
+        double x1 = k - m1;
+        double w0 = a0 + b0 * (r0 * x0 + std::sqrt(x0 * x0 + s0));
+        double w1 = a1 + b1 * (r1 * x1 + std::sqrt(x1 * x1 + s1));
+        a_sigma[i] = std::sqrt(std::max(a_c0 * w0 + a_c1 * w1, 0.0));
+      }
+    }
+
+    void CheckStrikes(size_t a_n, double const* a_K)
+    {
+      for (size_t i = 0; i < a_n; ++i)
+        if (!(a_K[i] > 0.0))
+          throw std::invalid_argument
+                ("Non-Positive Strike / UnderlyingPx / Vol");
+    }
+
+    //-----------------------------------------------------------------------//
+    // "ATMTotalVar": Linear Interpolation of w at k = 0:                    //
+    //-----------------------------------------------------------------------//
+    // "a_k" must be sorted; beyond the Strike range, the nearest "w" is used:
+    //
+    double ATMTotalVar(size_t a_n, double const* a_k, double const* a_w)
+    {
+      if (a_k[0] >= 0.0)
+        return a_w[0];
+      if (a_k[a_n - 1] <= 0.0)
+        return a_w[a_n - 1];
+      size_t j = 1;
+      while (a_k[j] < 0.0)
+        ++j;
+      double u = -a_k[j - 1] / (a_k[j] - a_k[j - 1]);
+      return (1.0 - u) * a_w[j - 1] + u * a_w[j];
+    }
+
+    //-----------------------------------------------------------------------//
+    // SSVI Slice and its Raw SVI Equivalent:                                //
+    //-----------------------------------------------------------------------//
+    double SSVIPhi(SSVIParams const& a_p, double a_theta)
+    {
+      return a_p.m_eta / (std::pow(a_theta,       a_p.m_gamma) *
+                          std::pow(1.0 + a_theta, 1.0 - a_p.m_gamma));
+    }
+
+    SVIParams SSVIToRaw(SSVIParams const& a_p, double a_theta)
+    {
+      double phi = SSVIPhi(a_p, a_theta);
+      double rho = a_p.m_rho;
+      SVIParams res;
+      res.m_a   = 0.5 * a_theta * (1.0 - rho * rho);
+      res.m_b   = 0.5 * a_theta * phi;
+      res.m_rho = rho;
+      res.m_m   = -rho / phi;
+      res.m_s   = std::sqrt(1.0 - rho * rho) / phi;
+      return res;
+    }
+  }
+
+  //=========================================================================//
+  // Non-Default Ctor:                                                       //
+  //=========================================================================//
+  VolSurface::VolSurface(double a_r, double a_D, double a_t, double a_St)
+  : m_r   (a_r),
+    m_D   (a_D),
+    m_t   (a_t),
+    m_St  (a_St),
+    m_exps()
+  {
+    if (!(a_St > 0.0))
+      throw std::invalid_argument("Non-Positive Strike / UnderlyingPx / Vol");
+  }
+
+  //=========================================================================//
+  // "SetSlice":                                                             //
+  //=========================================================================//
+  void VolSurface::SetSlice(double a_T, SVIParams const& a_svi)
+  {
+    if (!(a_T > m_t))
+      throw std::invalid_argument
+            ("VolSurface: Non-Positive Time to Expiration");
+
+    if (!(std::isfinite(a_svi.m_a) && a_svi.m_b >= 0.0 &&
+          std::fabs(a_svi.m_rho) < 1.0 && std::isfinite(a_svi.m_m) &&
+          a_svi.m_s > 0.0))
+      throw std::invalid_argument("VolSurface: Invalid SVI Params");
+
+    auto it = std::lower_bound
+      (m_exps.begin(), m_exps.end(), a_T,
+       [](Expiry const& a_e, double a_x) { return a_e.m_T < a_x; });
+
+    if (it != m_exps.end() && it->m_T == a_T)
+      it->m_svi = a_svi;
+    else
+      m_exps.insert(it, Expiry{a_T, a_T - m_t, a_svi});
+  }
+
+  //=========================================================================//
+  // "CalibrateSlice":                                                       //
+  //=========================================================================//
+  LMRes VolSurface::CalibrateSlice
+  (
+    double          a_T,
+    size_t          a_n,
+    double const*   a_K,
+    double const*   a_vol,
+    double const*   a_weight,
+    LMParams const& a_params
+  )
+  {
+    //-----------------------------------------------------------------------//
+    // Check the args, get the log-moneyness and market total vars:          //
+    //-----------------------------------------------------------------------//
+    constexpr size_t NP = 5;
+    if (a_n < NP)
+      throw std::invalid_argument("VolSurface: Too Few Quotes");
+
+    double tau = a_T - m_t;
+    if (!(tau > 0.0))
+      throw std::invalid_argument
+            ("VolSurface: Non-Positive Time to Expiration");
+
+    CheckStrikes(a_n, a_K);
+    for (size_t i = 0; i < a_n; ++i)
+    {
+      if (!(a_vol[i] > 0.0))
+        throw std::invalid_argument
+              ("Non-Positive Strike / UnderlyingPx / Vol");
+      if (a_weight != nullptr &&
+          !(a_weight[i] >= 0.0 && std::isfinite(a_weight[i])))
+        throw std::invalid_argument("VolSurface: Invalid Weight");
+    }
+
+    // Sorted by "k":
+    std::vector<size_t> order(a_n);
+    std::iota(order.begin(), order.end(), size_t(0));
+    std::sort(order.begin(), order.end(),
+              [a_K](size_t a_i, size_t a_j) { return a_K[a_i] < a_K[a_j]; });
+
+    double              logF = LogFwd(tau);
+    std::vector<double> k  (a_n);
+    std::vector<double> vol(a_n);
+    std::vector<double> w  (a_n);
+    std::vector<double> wgt(a_n);
+    double              wMax = 0.0;
+    for (size_t i = 0; i < a_n; ++i)
+    {
+      size_t j = order[i];
+      k  [i]   = std::log(a_K[j]) - logF;
+      vol[i]   = a_vol[j];
+      w  [i]   = vol[i] * vol[i] * tau;
+      wgt[i]   = (a_weight != nullptr) ? a_weight[j] : 1.0;
+      wMax     = std::max(wMax, w[i]);
+    }
+    double kMin  = k[0];
+    double kMax  = k[a_n - 1];
+    double kSpan = std::max(kMax - kMin, 0.01);
+
+    //-----------------------------------------------------------------------//
+    // Bounds and initial guess:                                             //
+    //-----------------------------------------------------------------------//
+    // x = (a, b, rho, m, s); b <= 2 as the wing slopes are at most 2 (Lee):
+    //
+    double lo[NP] = { -wMax, 0.0, -0.999, kMin - kSpan, 1e-4         };
+    double hi[NP] = {  wMax, 2.0,  0.999, kMax + kSpan, 2.0 * kSpan  };
+    double x [NP];
+
+    auto it = std::lower_bound
+      (m_exps.begin(), m_exps.end(), a_T,
+       [](Expiry const& a_e, double a_x) { return a_e.m_T < a_x; });
+
+    if (it != m_exps.end() && it->m_T == a_T)
+    {
+      SVIParams const& p = it->m_svi;
+      x[0] = p.m_a;  x[1] = p.m_b;  x[2] = p.m_rho;  x[3] = p.m_m;
+      x[4] = p.m_s;
+    }
+    else
+    {
+      // The wing slopes from the outermost quotes give b and rho; then "a"
+      // matches the ATM total var (with m = 0):
+      double wATM = ATMTotalVar(a_n, k.data(), w.data());
+      double sL   = (kMin < 0.0) ? (w[0]       - wATM) / kMin : 0.0;
+      double sR   = (kMax > 0.0) ? (w[a_n - 1] - wATM) / kMax : 0.0;
+      double b    = std::max(0.5 * (sR - sL), 1e-3);
+      x[1] = b;
+      x[2] = std::clamp((sR + sL) / (2.0 * b), -0.9, 0.9);
+      x[3] = 0.0;
+      x[4] = 0.1;
+      x[0] = wATM - b * x[4];
+    }
+    for (size_t i = 0; i < NP; ++i)
+      x[i] = std::clamp(x[i], lo[i], hi[i]);
+
+    //-----------------------------------------------------------------------//
+    // Residuals and the analytic Jacobian:                                  //
+    //-----------------------------------------------------------------------//
+    double rTau = 1.0 / tau;
+
+    LMResidFunc resid =
+      [&](double const* a_x, double* a_r)
+      {
+        SVIParams p{a_x[0], a_x[1], a_x[2], a_x[3], a_x[4]};
+        for (size_t i = 0; i < a_n; ++i)
+        {
+          double wi = std::max(SVITotalVar(p, k[i]), 0.0);
+          a_r[i]    = wgt[i] * (std::sqrt(wi * rTau) - vol[i]);
+        }
+      };
+
+    // d sigma = d w / (2 sigma tau):
+    LMJacFunc jac =
+      [&](double const* a_x, double const*, double* a_J)
+      {
+        SVIParams p{a_x[0], a_x[1], a_x[2], a_x[3], a_x[4]};
+        for (size_t i = 0; i < a_n; ++i)
+        {
+          double  xm  = k[i] - p.m_m;
+          double  R   = std::sqrt(xm * xm + p.m_s * p.m_s);
+          double  wi  = p.m_a + p.m_b * (p.m_rho * xm + R);
+          double* row = a_J + i * NP;
+          if (wi <= 0.0)
+          {
+            std::fill_n(row, NP, 0.0);
+            continue;
+          }
+          double c = wgt[i] / (2.0 * std::sqrt(wi * tau));
+          row[0]   = c;
+          row[1]   = c * (p.m_rho * xm + R);
+          row[2]   = c * p.m_b * xm;
+          row[3]   = c * p.m_b * (-p.m_rho - xm / R);
+          row[4]   = c * p.m_b * p.m_s / R;
+        }
+      };
+
+    LMRes res = LevenbergMarquardt(NP, a_n, x, lo, hi, resid, jac, a_params);
+
+    SetSlice(a_T, SVIParams{x[0], x[1], x[2], x[3], x[4]});
+    return res;
+  }
+
+  //=========================================================================//
+  // "CalibrateSSVI":                                                        //
+  //=========================================================================//
+  LMRes VolSurface::CalibrateSSVI
+  (
+    size_t            a_n,
+    CalibQuote const* a_quotes,
+    SSVIParams*       a_res,
+    LMParams const&   a_params
+  )
+  {
+    constexpr size_t NP = 3;
+    if (a_n < NP)
+      throw std::invalid_argument("VolSurface: Too Few Quotes");
+
+    for (size_t q = 0; q < a_n; ++q)
+    {
+      CalibQuote const& quote = a_quotes[q];
+      if (!(quote.m_K > 0.0 && quote.m_vol > 0.0))
+        throw std::invalid_argument
+              ("Non-Positive Strike / UnderlyingPx / Vol");
+      if (!(quote.m_T > m_t))
+        throw std::invalid_argument
+              ("VolSurface: Non-Positive Time to Expiration");
+      if (!(quote.m_weight >= 0.0 && std::isfinite(quote.m_weight)))
+        throw std::invalid_argument("VolSurface: Invalid Weight");
+    }
+
+    //-----------------------------------------------------------------------//
+    // Sort by (T, K), get theta(T):                                         //
+    //-----------------------------------------------------------------------//
+    std::vector<size_t> order(a_n);
+    std::iota(order.begin(), order.end(), size_t(0));
+    std::sort(order.begin(), order.end(),
+              [a_quotes](size_t a_i, size_t a_j)
+              {
+                CalibQuote const& qi = a_quotes[a_i];
+                CalibQuote const& qj = a_quotes[a_j];
+                return qi.m_T < qj.m_T ||
+                      (qi.m_T == qj.m_T && qi.m_K < qj.m_K);
+              });
+
+    std::vector<double> k  (a_n);
+    std::vector<double> w  (a_n);
+    std::vector<size_t> expOf(a_n);   // Quote (sorted) -> expiry
+    std::vector<double> Ts;
+    std::vector<double> thetas;
+
+    for (size_t i = 0, from = 0; i < a_n; ++i)
+    {
+      CalibQuote const& quote = a_quotes[order[i]];
+      double tau = quote.m_T - m_t;
+      k[i] = std::log(quote.m_K) - LogFwd(tau);
+      w[i] = quote.m_vol * quote.m_vol * tau;
+
+      bool last = (i + 1 == a_n || a_quotes[order[i + 1]].m_T != quote.m_T);
+      if (!last)
+        continue;
+      if (i == from)
+        throw std::invalid_argument
+              ("VolSurface: Fewer Than 2 Quotes for an Expiry");
+
+      double theta =
+        ATMTotalVar(i + 1 - from, k.data() + from, w.data() + from);
+      if (!thetas.empty())
+        theta = std::max(theta, thetas.back());
+      if (!(theta > 0.0))
+        throw std::invalid_argument("VolSurface: Zero ATM Variance");
+
+      for (size_t j = from; j <= i; ++j)
+        expOf[j] = Ts.size();
+      Ts    .push_back(quote.m_T);
+      thetas.push_back(theta);
+      from = i + 1;
+    }
+
+    //-----------------------------------------------------------------------//
+    // Fit (rho, eta, gamma):                                                //
+    //-----------------------------------------------------------------------//
+    // The bounds ensure no butterfly arbitrage: eta (1 + |rho|) <= 2 and
+    // gamma <= 1/2. The Jacobian is by forward differences (3 columns):
+    //
+    double lo[NP] = { -0.999, 1e-3, 1e-3 };
+    double hi[NP] = {  0.999, 1.0,  0.5  };
+    double x [NP] = { -0.5,   0.5,  0.3  };
+
+    LMResidFunc resid =
+      [&](double const* a_x, double* a_r)
+      {
+        SSVIParams p{a_x[0], a_x[1], a_x[2]};
+        for (size_t i = 0; i < a_n; ++i)
+        {
+          CalibQuote const& quote = a_quotes[order[i]];
+          double theta = thetas[expOf[i]];
+          double phi   = SSVIPhi(p, theta);
+          double pk    = phi * k[i] + p.m_rho;
+          double wi    = 0.5 * theta *
+                         (1.0 + p.m_rho * phi * k[i] +
+                          std::sqrt(pk * pk + 1.0 - p.m_rho * p.m_rho));
+          a_r[i] = quote.m_weight *
+                   (std::sqrt(std::max(wi, 0.0) / (quote.m_T - m_t)) -
+                    quote.m_vol);
+        }
+      };
+
+    std::vector<double> rb(a_n);
+    LMJacFunc jac =
+      [&](double const* a_x, double const* a_r, double* a_J)
+      {
+        for (size_t c = 0; c < NP; ++c)
+        {
+          double xb[NP] = { a_x[0], a_x[1], a_x[2] };
+          double h      = 1e-7 * std::max(std::fabs(a_x[c]), 1.0);
+          if (xb[c] + h > hi[c])
+            h = -h;
+          xb[c] += h;
+          resid(xb, rb.data());
+          for (size_t i = 0; i < a_n; ++i)
+            a_J[i * NP + c] = (rb[i] - a_r[i]) / h;
+        }
+      };
+
+    LMRes res = LevenbergMarquardt(NP, a_n, x, lo, hi, resid, jac, a_params);
+
+    //-----------------------------------------------------------------------//
+    // Replace the slices:                                                   //
+    //-----------------------------------------------------------------------//
+    SSVIParams p{x[0], x[1], x[2]};
+    m_exps.clear();
+    for (size_t j = 0; j < Ts.size(); ++j)
+      m_exps.push_back(Expiry{Ts[j], Ts[j] - m_t, SSVIToRaw(p, thetas[j])});
+
+    if (a_res != nullptr)
+      *a_res = p;
+    return res;
+  }
+
+  //=========================================================================//
+  // "At":                                                                   //
+  //=========================================================================//
+  VolSurface::ExpiryView VolSurface::At(double a_T) const
+  {
+    if (m_exps.empty())
+      throw std::logic_error("VolSurface: No Expiries");
+
+    double tau = a_T - m_t;
+    if (tau < 0.0)
+      throw std::invalid_argument("Negative Time to Expiration");
+
+    auto it = std::lower_bound
+      (m_exps.begin(), m_exps.end(), a_T,
+       [](Expiry const& a_e, double a_x) { return a_e.m_T < a_x; });
+
+    ExpiryView view;
+    view.m_logF = LogFwd(tau);
+    view.m_tau  = tau;
+
+    if (it == m_exps.begin() || it == m_exps.end() || it->m_T == a_T)
+    {
+      // Flat vol extrapolation at constant "k", or an exact expiry (then
+      // dw/dtau is taken from the left, ie from the flat extrapolation for
+      // the 1st expiry):
+      Expiry const& e = (it == m_exps.end()) ? m_exps.back() : *it;
+      view.m_c0   = 1.0 / e.m_tau;
+      view.m_c1   = 0.0;
+      view.m_d0   = view.m_c0;
+      view.m_d1   = 0.0;
+      view.m_svi0 = e.m_svi;
+      view.m_svi1 = e.m_svi;
+
+      if (it != m_exps.begin() && it != m_exps.end())
+      {
+        Expiry const& e0 = *(it - 1);
+        view.m_d0   = -1.0 / (e.m_tau - e0.m_tau);
+        view.m_d1   = -view.m_d0;
+        view.m_svi0 = e0.m_svi;
+        view.m_c1   = view.m_c0;
+        view.m_c0   = 0.0;
+      }
+    }
+    else
+    {
+      Expiry const& e0 = *(it - 1);
+      Expiry const& e1 = *it;
+      double        d  = e1.m_tau - e0.m_tau;
+      view.m_c0   = (e1.m_tau - tau) / (d * tau);
+      view.m_c1   = (tau - e0.m_tau) / (d * tau);
+      view.m_d0   = -1.0 / d;
+      view.m_d1   =  1.0 / d;
+      view.m_svi0 = e0.m_svi;
+      view.m_svi1 = e1.m_svi;
+    }
+    return view;
+  }
+
+  //=========================================================================//
+  // "ExpiryView::TotalVarDerivs":                                           //
+  //=========================================================================//
+  void VolSurface::ExpiryView::TotalVarDerivs
+  (
+    double  a_k,
+    double* a_w,
+    double* a_wk,
+    double* a_wkk,
+    double* a_wT
+  )
+  const
+  {
+    double wk0, wkk0, wk1, wkk1;
+    double w0 = SVITotalVar(m_svi0, a_k, &wk0, &wkk0);
+    double w1 = SVITotalVar(m_svi1, a_k, &wk1, &wkk1);
+    *a_w      = m_tau * (m_c0 * w0   + m_c1 * w1);
+    *a_wk     = m_tau * (m_c0 * wk0  + m_c1 * wk1);
+    *a_wkk    = m_tau * (m_c0 * wkk0 + m_c1 * wkk1);
+    *a_wT     = m_d0 * w0 + m_d1 * w1;
+  }
+
+  //=========================================================================//
+  // "Sigma", "ChainSigmas" and "Sigmas":                                    //
+  //=========================================================================//
+  double VolSurface::Sigma(double a_K, double a_T) const
+  {
+    CheckStrikes(1, &a_K);
+    return At(a_T).Sigma(a_K);
+  }
+
+  void VolSurface::ChainSigmas
+  (
+    double        a_T,
+    size_t        a_n,
+    double const* a_K,
+    double*       a_sigma
+  )
+  const
+  {
+    CheckStrikes(a_n, a_K);
+    ExpiryView v = At(a_T);
+    SVIKernel
+      (a_n, a_K, v.m_logF, v.m_c0, v.m_svi0, v.m_c1, v.m_svi1, a_sigma);
+  }
+
+  void VolSurface::Sigmas
+  (
+    size_t        a_n,
+    double const* a_K,
+    double const* a_T,
+    double*       a_sigma
+  )
+  const
+  {
+    CheckStrikes(a_n, a_K);
+    for (size_t from = 0; from < a_n; )
+    {
+      size_t to = from + 1;
+      while (to < a_n && a_T[to] == a_T[from])
+        ++to;
+      ExpiryView v = At(a_T[from]);
+      SVIKernel
+        (to - from, a_K + from, v.m_logF, v.m_c0, v.m_svi0, v.m_c1, v.m_svi1,
+         a_sigma + from);
+      from = to;
+    }
+  }
+
+  //=========================================================================//
+  // "PxBatch":                                                              //
+  //=========================================================================//
+  template<typename CDF>
+  void VolSurface::PxBatch
+  (
+    PayoffType    a_type,
+    size_t        a_n,
+    double const* a_K,
+    double const* a_T,
+    double*       a_px
+  )
+  const
+  {
+    std::vector<double> sigma(a_n);
+    std::vector<double> St   (a_n, m_St);
+    Sigmas(a_n, a_K, a_T, sigma.data());
+    BSM::PxBatch<CDF>
+      (a_type, a_n, a_K, a_T, m_r, m_D, sigma.data(), m_t, St.data(), a_px);
+  }
+
+  //-------------------------------------------------------------------------//
+  // Explicit Instantiations:                                                //
+  //-------------------------------------------------------------------------//
+# define VOLSURF_INSTANTIATE(CDF)                                              \
+  template void VolSurface::PxBatch<CDF>                                       \
+    (PayoffType, size_t, double const*, double const*, double*) const;
+
+  VOLSURF_INSTANTIATE(CDFErf)
+  VOLSURF_INSTANTIATE(CDFCody)
+  VOLSURF_INSTANTIATE(CDFFast)
+# undef VOLSURF_INSTANTIATE
+}
+// End namespace BSM
@@ -0,0 +1,247 @@
+// vim:ts=2:et
+//===========================================================================//
+//                               "VolSurface.h":                             //
+//           SVI / SSVI Implied Volatility Surface with Cached Lookups       //
+//===========================================================================//
+#pragma once
+#include "BSM.h"
+#include "Calibration.h"
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace BSM
+{
+  //-------------------------------------------------------------------------//
+  // "SVIParams": Raw SVI Parameterisation of One Expiry:                    //
+  //-------------------------------------------------------------------------//
+  // The total implied variance w = sigma^2 * tau as a function of the log-fwd-
+  // moneyness k = log(K / F):
+  //   w(k) = a + b * (rho * (k - m) + sqrt((k - m)^2 + s^2)):
+  //
+  struct SVIParams
+  {
+    double m_a   = NAN;
+    double m_b   = NAN;   // >= 0
+    double m_rho = NAN;   // in (-1, 1)
+    double m_m   = NAN;
+    double m_s   = NAN;   // > 0
+  };
+
+  inline double SVITotalVar(SVIParams const& a_p, double a_k)
+  {
+    double x = a_k - a_p.m_m;
+    return a_p.m_a +
+           a_p.m_b * (a_p.m_rho * x + std::sqrt(x * x + a_p.m_s * a_p.m_s));
+  }
+
+  // w(k) and its 1st and 2nd derivatives in "k":
+  inline double SVITotalVar
+    (SVIParams const& a_p, double a_k, double* a_wk, double* a_wkk)
+  {
+    double x  = a_k - a_p.m_m;
+    double R  = std::sqrt(x * x + a_p.m_s * a_p.m_s);
+    *a_wk     = a_p.m_b * (a_p.m_rho + x / R);
+    *a_wkk    = a_p.m_b * a_p.m_s * a_p.m_s / (R * R * R);
+    return a_p.m_a + a_p.m_b * (a_p.m_rho * x + R);
+  }
+
+  //-------------------------------------------------------------------------//
+  // "SSVIParams": Surface SVI (Gatheral-Jacquier), Power-Law "phi":         //
+  //-------------------------------------------------------------------------//
+  //   w(k, theta) = theta / 2 * (1 + rho phi k + sqrt((phi k + rho)^2 + 1 -
+  //                 rho^2)),  phi(theta) = eta / (theta^gamma (1 + theta)^
+  //                 (1 - gamma)),
+  // where theta(T) is the ATM total variance. With eta (1 + |rho|) <= 2 and
+  // gamma in (0, 1/2] (ensured by the calibration bounds), the surface is
+  // free of static arbitrage as long as theta(T) is non-decreasing:
+  //
+  struct SSVIParams
+  {
+    double m_rho   = NAN;
+    double m_eta   = NAN;
+    double m_gamma = NAN;
+  };
+
+  //=========================================================================//
+  // "VolSurface" Class:                                                     //
+  //=========================================================================//
+  // Holds a raw SVI slice per expiry (SSVI fits are converted into them),
+  // for fixed market data (r, D, t, St); the log-moneyness is relative to the
+  // fwd St * exp((r - D) * tau).  Between the expiries, the total variance is
+  // interpolated linearly in "tau" at constant "k";  before the first one and
+  // after the last one, the implied vol is that of the nearest slice at the
+  // same "k".
+  // "At(T)" gives an "ExpiryView" holding the interpolation coeffs for "T" (a
+  // binary search over the expiries), after which each "Sigma(K)" is O(1):
+  // one log, 2 SVI evaluations and a sqrt.  "ChainSigmas" does this for all
+  // Strikes of an expiry in one vectorised loop,  and "Sigmas" for arbitrary
+  // (K, T) pairs, re-using the view over runs of equal "T".
+  // The "const" methods may be used by many threads at once:
+  //
+  class VolSurface
+  {
+  public:
+    //-----------------------------------------------------------------------//
+    // "ExpiryView": Cached Interpolation Coeffs for One Expiration Time:    //
+    //-----------------------------------------------------------------------//
+    // sigma^2(K) = m_c0 * w0(k) + m_c1 * w1(k),  k = log(K) - m_logF, and
+    // dw/dtau = m_d0 * w0(k) + m_d1 * w1(k) (at constant "k"). NB: "Sigma"
+    // does not check "a_K" (which must be positive):
+    //
+    struct ExpiryView
+    {
+      double    m_logF;
+      double    m_tau;
+      double    m_c0;
+      double    m_c1;
+      double    m_d0;
+      double    m_d1;
+      SVIParams m_svi0;
+      SVIParams m_svi1;
+
+      double Sigma(double a_K) const
+      {
+        double k = std::log(a_K) - m_logF;
+        double v = m_c0 * SVITotalVar(m_svi0, k) +
+                   m_c1 * SVITotalVar(m_svi1, k);
+        return std::sqrt(std::max(v, 0.0));
+      }
+
+      // The total var w(k, tau) and its analytic derivatives (as needed by
+      // Dupire's formula):
+      void TotalVarDerivs
+      (
+        double  a_k,
+        double* a_w,      // w
+        double* a_wk,     // dw/dk
+        double* a_wkk,    // d2w/dk2
+        double* a_wT      // dw/dtau
+      )
+      const;
+    };
+
+  private:
+    //-----------------------------------------------------------------------//
+    // Data Flds:                                                            //
+    //-----------------------------------------------------------------------//
+    struct Expiry
+    {
+      double    m_T;
+      double    m_tau;
+      SVIParams m_svi;
+    };
+
+    double              m_r;
+    double              m_D;
+    double              m_t;
+    double              m_St;
+    std::vector<Expiry> m_exps;   // Sorted by "m_T"
+
+    double LogFwd(double a_tau) const
+      { return std::log(m_St) + (m_r - m_D) * a_tau; }
+
+  public:
+    //-----------------------------------------------------------------------//
+    // Non-Default Ctor:                                                     //
+    //-----------------------------------------------------------------------//
+    // Throws "std::invalid_argument" if "a_St" is non-positive:
+    //
+    VolSurface(double a_r, double a_D, double a_t, double a_St);
+
+    //-----------------------------------------------------------------------//
+    // Building the Surface:                                                 //
+    //-----------------------------------------------------------------------//
+    // Adds (or replaces) the slice for "a_T":
+    //
+    void SetSlice(double a_T, SVIParams const& a_svi);
+
+    // "CalibrateSlice": Fits the raw SVI slice for "a_T" to implied vols (the
+    // residuals are the vol errors, multiplied by the weights) by Levenberg-
+    // Marquardt with the analytic Jacobian. If a slice for "a_T" is already
+    // present, it is the initial guess (warm start); otherwise, the guess is
+    // derived from the ATM level and the wing slopes of the quotes. Requires
+    // at least 5 quotes:
+    //
+    LMRes CalibrateSlice
+    (
+      double          a_T,
+      size_t          a_n,
+      double const*   a_K,                  // [a_n] Strikes
+      double const*   a_vol,                // [a_n] Market implied vols
+      double const*   a_weight = nullptr,   // [a_n] (optional, default 1)
+      LMParams const& a_params = LMParams()
+    );
+
+    // "CalibrateSSVI": Fits SSVI to quotes with any expiries: theta(T) is
+    // the ATM total variance of each expiry (interpolated between the near-
+    // est Strikes, and made non-decreasing in T),  and (rho, eta, gamma) are
+    // fitted to all quotes jointly. All slices are replaced (by the equivalent
+    // raw SVI ones). Requires at least 2 quotes per expiry,  and 3 in total:
+    //
+    LMRes CalibrateSSVI
+    (
+      size_t            a_n,
+      CalibQuote const* a_quotes,
+      SSVIParams*       a_res    = nullptr, // Output (optional)
+      LMParams const&   a_params = LMParams()
+    );
+
+    //-----------------------------------------------------------------------//
+    // Lookups:                                                              //
+    //-----------------------------------------------------------------------//
+    // Throw "std::logic_error" if the surface is empty,  and "std::invalid_
+    // argument" for non-positive Strikes or "a_T" before the pricing time:
+    //
+    ExpiryView At   (double a_T)              const;
+    double     Sigma(double a_K, double a_T) const;
+
+    // The market data of the surface:
+    double Rate()    const { return m_r;  }
+    double DivRate() const { return m_D;  }
+    double Time()    const { return m_t;  }
+    double Spot()    const { return m_St; }
+
+    // Vols for all Strikes of one expiry (vectorised):
+    void ChainSigmas
+    (
+      double        a_T,
+      size_t        a_n,
+      double const* a_K,      // [a_n]
+      double*       a_sigma   // [a_n]
+    )
+    const;
+
+    // Vols for arbitrary (K, T) pairs (fastest if sorted by "T"):
+    void Sigmas
+    (
+      size_t        a_n,
+      double const* a_K,      // [a_n]
+      double const* a_T,      // [a_n]
+      double*       a_sigma   // [a_n]
+    )
+    const;
+
+    // "PxBatch": The vols from the surface are fed into "BSM::PxBatch" (with
+    // the surface's market data). Instantiated for the 3 CDF Policies:
+    //
+    template<typename CDF = CDFCody>
+    void PxBatch
+    (
+      PayoffType    a_type,
+      size_t        a_n,
+      double const* a_K,      // [a_n]
+      double const* a_T,      // [a_n]
+      double*       a_px      // [a_n]
+    )
+    const;
+
+    //-----------------------------------------------------------------------//
+    // Accessors:                                                            //
+    //-----------------------------------------------------------------------//
+    size_t           NExpiries()          const { return m_exps.size();      }
+    double           ExpiryT  (size_t a_i) const { return m_exps[a_i].m_T;   }
+    SVIParams const& Slice    (size_t a_i) const { return m_exps[a_i].m_svi; }
+  };
+}
+// End namespace BSM